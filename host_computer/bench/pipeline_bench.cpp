@@ -0,0 +1,513 @@
+// 采集与推理链路基准：数据包解码、帧平均、黑白校正、CSV / 归档读写、记录存储、日志追加、各预测插件的推理延迟
+//
+// 用法：pipeline_bench [--json <file>] [--quick] [--records N] [--batch N] [--filter <子串>]
+// 结果逐行打印；--json 时同时写出 JSON，便于跟踪回归（各项的 nsPerOp 越小越好）
+// 预测插件从 <程序目录>/plugins 加载（与 calc_app 相同），需要默认模型路径下有模型，否则该项标记为 skipped
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtEndian>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "link_stats.h"
+#include "log_manager.h"
+#include "spectral_calibration.h"
+#include "spectral_math.h"
+#include "spectrum_accumulator.h"
+#include "spectrum_archive.h"
+#include "spectrum_file_manager.h"
+#include "spectrum_frame.h"
+#include "spectrum_predictor_manager.h"
+#include "spectrum_record_store.h"
+#include "udp_receiver.h"
+
+namespace {
+
+constexpr int kPixels = SpectrumFrame::kPixelCount;
+
+// 防止编译器把结果优化掉
+volatile double g_sink = 0.0;
+
+struct BenchConfig {
+  bool quick = false;
+  int records = 1000;  // CSV / 归档记录数
+  int batch = 64;      // 批量推理条数
+  QString filter;
+};
+
+class BenchReport {
+ public:
+  // nsPerOp：每次操作（帧、记录、消息、批次……，见 unit）的平均耗时
+  void add(const QString &name, const QString &unit, qint64 ops, double nsPerOp,
+           const QJsonObject &extra = QJsonObject()) {
+    QJsonObject o = extra;
+    o.insert(QStringLiteral("name"), name);
+    o.insert(QStringLiteral("unit"), unit);
+    o.insert(QStringLiteral("ops"), static_cast<double>(ops));
+    o.insert(QStringLiteral("nsPerOp"), nsPerOp);
+    o.insert(QStringLiteral("opsPerSecond"), nsPerOp > 0.0 ? 1e9 / nsPerOp : 0.0);
+    results_.append(o);
+    std::printf("%-28s %12.1f ns/%s %14.0f %s/s\n", name.toUtf8().constData(), nsPerOp,
+                unit.toUtf8().constData(), nsPerOp > 0.0 ? 1e9 / nsPerOp : 0.0, unit.toUtf8().constData());
+  }
+
+  void skip(const QString &name, const QString &reason) {
+    QJsonObject o;
+    o.insert(QStringLiteral("name"), name);
+    o.insert(QStringLiteral("skipped"), reason);
+    results_.append(o);
+    std::printf("%-28s skipped: %s\n", name.toUtf8().constData(), reason.toUtf8().constData());
+  }
+
+  QJsonArray results() const { return results_; }
+
+ private:
+  QJsonArray results_;
+};
+
+double elapsedNs(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 预热 iterations / 10 次后计时，返回每次的平均纳秒数
+template <typename Fn>
+double measure(qint64 iterations, Fn &&fn) {
+  for (qint64 i = 0; i < iterations / 10 + 1; i++) {
+    fn(i);
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  for (qint64 i = 0; i < iterations; i++) {
+    fn(i);
+  }
+  return elapsedNs(t0) / static_cast<double>(iterations);
+}
+
+QJsonObject latencyJson(const LatencyHistogram &h) {
+  QJsonObject o;
+  o.insert(QStringLiteral("p50Ns"), h.percentileNs(50.0));
+  o.insert(QStringLiteral("p99Ns"), h.percentileNs(99.0));
+  o.insert(QStringLiteral("maxNs"), static_cast<double>(h.maxNs()));
+  return o;
+}
+
+std::vector<uint16_t> randomFrames(int count, std::mt19937 &rng) {
+  std::uniform_int_distribution<int> pixel(0, 65535);
+  std::vector<uint16_t> frames(static_cast<size_t>(count) * kPixels);
+  for (auto &v : frames) {
+    v = static_cast<uint16_t>(pixel(rng));
+  }
+  return frames;
+}
+
+// 与 UdpBatchReader::receive 相同的原地字节序转换
+void benchPacketDecode(const BenchConfig &config, BenchReport *report) {
+  std::mt19937 rng(1);
+  const std::vector<uint16_t> packet = randomFrames(1, rng);
+  SpectrumFrame frame;
+  const qint64 iterations = config.quick ? 200000 : 2000000;
+  const double ns = measure(iterations, [&](qint64 i) {
+    std::memcpy(frame.data, packet.data(), sizeof(frame.data));
+    for (int k = 0; k < kPixels; ++k) {
+      frame.data[k] = qFromBigEndian<quint16>(frame.data[k]);
+    }
+    g_sink = g_sink + frame.data[i & (kPixels - 1)];
+  });
+  QJsonObject extra;
+  extra.insert(QStringLiteral("MBps"), sizeof(frame.data) / ns * 1e3);
+  report->add(QStringLiteral("packet_decode"), QStringLiteral("packet"), iterations, ns, extra);
+}
+
+// 真实的接收路径：UdpBatchReader 在数据报 socketpair 上 recvmmsg + 解码（不含网络协议栈）
+void benchBatchReader(const BenchConfig &config, BenchReport *report) {
+  int fds[2] = {-1, -1};
+  if (::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0, fds) != 0) {
+    report->skip(QStringLiteral("udp_batch_reader"), QStringLiteral("socketpair 失败"));
+    return;
+  }
+  std::mt19937 rng(2);
+  const std::vector<uint16_t> packet = randomFrames(1, rng);
+  const int batchSize = UdpReceiverThread::kDefaultBatchSize;
+  LinkStats stats;
+  UdpBatchReader reader(batchSize, false, false, &stats);
+  std::vector<SpectrumFramePtr> batch;
+  batch.reserve(batchSize);
+
+  const int rounds = config.quick ? 2000 : 20000;
+  double receiveNs = 0.0;
+  qint64 packets = 0;
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < batchSize; i++) {
+      if (::send(fds[0], packet.data(), packet.size() * sizeof(uint16_t), 0) < 0) {
+        break;
+      }
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    int received = 0;
+    while (received < batchSize) {
+      const int n = reader.receive(fds[1], &batch);
+      if (n <= 0) {
+        break;
+      }
+      received += n;
+    }
+    receiveNs += elapsedNs(t0);
+    packets += static_cast<qint64>(batch.size());
+    batch.clear();
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+  if (packets == 0) {
+    report->skip(QStringLiteral("udp_batch_reader"), QStringLiteral("没有收到数据包"));
+    return;
+  }
+  QJsonObject extra;
+  extra.insert(QStringLiteral("batchSize"), batchSize);
+  report->add(QStringLiteral("udp_batch_reader"), QStringLiteral("packet"), packets, receiveNs / packets, extra);
+}
+
+// 与预测 / 黑白参考相同的窗口长度：spectrumThreshold（3950）与 referenceThreshold（39500）
+void benchAveraging(const BenchConfig &config, BenchReport *report) {
+  std::mt19937 rng(3);
+  const int pool = 64;
+  const std::vector<uint16_t> frames = randomFrames(pool, rng);
+  std::vector<double> mean(kPixels);
+  for (int window : {3950, 39500}) {
+    for (bool squares : {false, true}) {
+      SpectrumAccumulator accumulator(squares);
+      const int reps = config.quick ? 2 : 10;
+      const auto t0 = std::chrono::steady_clock::now();
+      for (int r = 0; r < reps; r++) {
+        accumulator.reset();
+        for (int f = 0; f < window; f++) {
+          accumulator.add(frames.data() + static_cast<size_t>(f % pool) * kPixels);
+        }
+        accumulator.mean(mean.data());
+        if (squares) {
+          accumulator.stdDev(mean.data());
+        }
+        g_sink = g_sink + mean[r & (kPixels - 1)];
+      }
+      const double nsPerFrame = elapsedNs(t0) / (static_cast<double>(reps) * window);
+      QJsonObject extra;
+      extra.insert(QStringLiteral("window"), window);
+      extra.insert(QStringLiteral("msPerWindow"), nsPerFrame * window / 1e6);
+      report->add(QStringLiteral("averaging_%1%2").arg(window).arg(squares ? QStringLiteral("_stddev") : QString()),
+                  QStringLiteral("frame"), static_cast<qint64>(reps) * window, nsPerFrame, extra);
+    }
+  }
+}
+
+void benchCalibration(const BenchConfig &config, BenchReport *report) {
+  std::mt19937 rng(4);
+  std::uniform_real_distribution<double> dist(0.0, 1000.0);
+  std::vector<double> black(kPixels), white(kPixels), raw(kPixels), out(kPixels);
+  for (int i = 0; i < kPixels; i++) {
+    black[i] = 1000.0 + dist(rng);
+    white[i] = 40000.0 + 10.0 * dist(rng);
+    raw[i] = black[i] + 20.0 * dist(rng);
+  }
+  const SpectralCalibration::Options options;
+  const qint64 builds = config.quick ? 200 : 2000;
+  std::shared_ptr<const SpectralCalibration> calibration;
+  const double buildNs = measure(builds, [&](qint64) {
+    calibration = SpectralCalibration::build(black.data(), white.data(), options);
+  });
+  report->add(QStringLiteral("calibration_build"), QStringLiteral("build"), builds, buildNs);
+
+  const qint64 iterations = config.quick ? 200000 : 2000000;
+  const double applyNs = measure(iterations, [&](qint64 i) {
+    calibration->apply(raw.data(), out.data());
+    g_sink = g_sink + out[i & (kPixels - 1)];
+  });
+  QJsonObject extra;
+  extra.insert(QStringLiteral("isa"), QString::fromLatin1(SpectralMath::isaName(SpectralMath::activeIsa())));
+  report->add(QStringLiteral("calibration_apply"), QStringLiteral("spectrum"), iterations, applyNs, extra);
+}
+
+QVariantList makeRecords(int count) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  QVariantList records;
+  const QDateTime start = QDateTime::currentDateTime();
+  for (int r = 0; r < count; r++) {
+    QVariantList spectrum;
+    spectrum.reserve(kPixels);
+    for (int i = 0; i < kPixels; i++) {
+      spectrum.append(dist(rng));
+    }
+    QVariantMap record;
+    record.insert(QStringLiteral("index"), r);
+    record.insert(QStringLiteral("label"), QStringLiteral("bench_%1").arg(r));
+    record.insert(QStringLiteral("time"), start.addMSecs(r * 100));
+    record.insert(QStringLiteral("length"), kPixels);
+    record.insert(QStringLiteral("minVal"), 0.0);
+    record.insert(QStringLiteral("maxVal"), 1.0);
+    record.insert(QStringLiteral("moisture"), 10.0 + dist(rng));
+    record.insert(QStringLiteral("spectrum"), spectrum);
+    records.append(record);
+  }
+  return records;
+}
+
+void benchFiles(const BenchConfig &config, BenchReport *report) {
+  QTemporaryDir dir;
+  if (!dir.isValid()) {
+    report->skip(QStringLiteral("csv_save"), QStringLiteral("无法创建临时目录"));
+    return;
+  }
+  const int count = config.quick ? qMin(config.records, 200) : config.records;
+  const QVariantList records = makeRecords(count);
+  SpectrumFileManager files;
+
+  const QString csvPath = dir.filePath(QStringLiteral("bench.csv"));
+  auto t0 = std::chrono::steady_clock::now();
+  files.saveAllSpectraTableToCsv(records, csvPath);
+  double ns = elapsedNs(t0);
+  QJsonObject extra;
+  extra.insert(QStringLiteral("records"), count);
+  extra.insert(QStringLiteral("fileMB"), QFileInfo(csvPath).size() / 1048576.0);
+  report->add(QStringLiteral("csv_save"), QStringLiteral("record"), count, ns / count, extra);
+
+  t0 = std::chrono::steady_clock::now();
+  const QVariantList loaded = files.loadAllSpectraTableFromCsv(csvPath);
+  ns = elapsedNs(t0);
+  extra.insert(QStringLiteral("loaded"), static_cast<int>(loaded.size()));
+  report->add(QStringLiteral("csv_load"), QStringLiteral("record"), count, ns / count, extra);
+
+  const QString archivePath = dir.filePath(QStringLiteral("bench.spa"));
+  t0 = std::chrono::steady_clock::now();
+  const bool written = SpectrumArchive::write(archivePath, records, SpectrumArchive::Float32Samples);
+  ns = elapsedNs(t0);
+  if (!written) {
+    report->skip(QStringLiteral("archive_write"), QStringLiteral("写入失败"));
+    return;
+  }
+  QJsonObject archiveExtra;
+  archiveExtra.insert(QStringLiteral("records"), count);
+  archiveExtra.insert(QStringLiteral("fileMB"), QFileInfo(archivePath).size() / 1048576.0);
+  report->add(QStringLiteral("archive_write"), QStringLiteral("record"), count, ns / count, archiveExtra);
+
+  SpectrumArchive archive;
+  std::vector<double> spectrum(kPixels);
+  t0 = std::chrono::steady_clock::now();
+  if (archive.open(archivePath)) {
+    for (qint64 i = 0; i < archive.recordCount(); i++) {
+      archive.readSpectrum(i, spectrum.data(), kPixels);
+      g_sink = g_sink + spectrum[0];
+    }
+  }
+  ns = elapsedNs(t0);
+  report->add(QStringLiteral("archive_read"), QStringLiteral("record"), count, ns / count, archiveExtra);
+}
+
+// 单次采集记录存储：内存上限为记录数的 1/4，追加时持续溢出到磁盘，再从池与溢出段流式导出
+void benchRecordStore(const BenchConfig &config, BenchReport *report) {
+  QTemporaryDir dir;
+  if (!dir.isValid()) {
+    report->skip(QStringLiteral("store_append"), QStringLiteral("无法创建临时目录"));
+    return;
+  }
+  const int count = config.quick ? qMin(config.records, 200) : config.records;
+  const QVariantList records = makeRecords(count);
+  SpectrumRecordStore store;
+  store.setSpillDirectory(dir.filePath(QStringLiteral("spill")));
+  store.setMemoryCapacity(qMax(1, count / 4));
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (const QVariant &record : records) {
+    const QVariantMap recMap = record.toMap();
+    store.append(recMap.value(QStringLiteral("spectrum")).toList(), recMap.value(QStringLiteral("label")).toString(),
+                 recMap.value(QStringLiteral("moisture")).toDouble());
+  }
+  double ns = elapsedNs(t0);
+  QJsonObject extra;
+  extra.insert(QStringLiteral("records"), count);
+  extra.insert(QStringLiteral("memoryCapacity"), store.memoryCapacity());
+  extra.insert(QStringLiteral("inMemory"), store.inMemoryCount());
+  report->add(QStringLiteral("store_append"), QStringLiteral("record"), count, ns / count, extra);
+
+  const QString csvPath = dir.filePath(QStringLiteral("store.csv"));
+  t0 = std::chrono::steady_clock::now();
+  store.exportCsv(csvPath);
+  ns = elapsedNs(t0);
+  report->add(QStringLiteral("store_export_csv"), QStringLiteral("record"), count, ns / count, extra);
+
+  const QString archivePath = dir.filePath(QStringLiteral("store.spa"));
+  t0 = std::chrono::steady_clock::now();
+  store.exportArchive(archivePath);
+  ns = elapsedNs(t0);
+  report->add(QStringLiteral("store_export_archive"), QStringLiteral("record"), count, ns / count, extra);
+}
+
+// LogManager::append 的调用方开销（格式化 + 投递到写盘线程）与写完全部日志的总耗时
+void benchLog(const BenchConfig &config, BenchReport *report) {
+  const int messages = config.quick ? 20000 : 200000;
+  const int threads = qBound(1, QThread::idealThreadCount(), 4);
+  std::vector<int> writerCounts = {1};
+  if (threads > 1) {
+    writerCounts.push_back(threads);
+  }
+  for (int writers : writerCounts) {
+    auto t0 = std::chrono::steady_clock::now();
+    double appendNs = 0.0;
+    {
+      LogManager log;
+      const int perWriter = messages / writers;
+      std::vector<std::unique_ptr<QThread>> workers;
+      for (int w = 0; w < writers; w++) {
+        workers.emplace_back(QThread::create([&log, perWriter, w]() {
+          for (int i = 0; i < perWriter; i++) {
+            log.logInfo(QStringLiteral("bench"), QStringLiteral("writer %1 message %2").arg(w).arg(i));
+          }
+        }));
+        workers.back()->start();
+      }
+      for (auto &worker : workers) {
+        worker->wait();
+      }
+      appendNs = elapsedNs(t0);
+      t0 = std::chrono::steady_clock::now();
+    }  // 析构时写完队列中的全部日志
+    const double flushNs = elapsedNs(t0);
+    QJsonObject extra;
+    extra.insert(QStringLiteral("threads"), writers);
+    extra.insert(QStringLiteral("flushMs"), flushNs / 1e6);
+    report->add(QStringLiteral("log_append_%1t").arg(writers), QStringLiteral("message"), messages,
+                appendNs / messages, extra);
+  }
+}
+
+// 每个预测插件：单条（batch 1）与批量（batch N）推理延迟，输入为预处理之后的长度
+void benchPredictors(const BenchConfig &config, BenchReport *report) {
+  SpectrumPredictorManager manager;
+  const int count = static_cast<int>(manager.predictorNames().size());
+  if (count == 0) {
+    report->skip(QStringLiteral("predict"), QStringLiteral("plugins 目录下没有预测插件"));
+    return;
+  }
+  std::mt19937 rng(6);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  for (int index = 0; index < count; index++) {
+    const QString algorithm = manager.getAlgorithm(index);
+    if (!manager.loadModelAuto(index)) {
+      report->skip(QStringLiteral("predict_%1").arg(algorithm), QStringLiteral("默认模型加载失败"));
+      continue;
+    }
+    const SpectralPreprocessorPtr chain = manager.preprocessor(index);
+    const size_t cols = chain ? static_cast<size_t>(chain->outputSize()) : static_cast<size_t>(kPixels);
+    for (int rows : {1, qMax(2, config.batch)}) {
+      std::vector<float> data(cols * static_cast<size_t>(rows));
+      for (float &v : data) {
+        v = dist(rng);
+      }
+      std::vector<float> out(static_cast<size_t>(rows));
+      const int iterations = (rows == 1 ? 2000 : 200) / (config.quick ? 10 : 1);
+      LatencyHistogram latency;
+      int failures = 0;
+      for (int i = 0; i < iterations / 10 + 1; i++) {
+        manager.predictBatch(index, data.data(), static_cast<size_t>(rows), cols, out.data());
+      }
+      const auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < iterations; i++) {
+        const qint64 startNs = SpectrumFrame::nowNs();
+        if (!manager.predictBatch(index, data.data(), static_cast<size_t>(rows), cols, out.data())) {
+          failures++;
+        }
+        latency.record(SpectrumFrame::nowNs() - startNs);
+      }
+      const double nsPerBatch = elapsedNs(t0) / iterations;
+      QJsonObject extra = latencyJson(latency);
+      extra.insert(QStringLiteral("batch"), rows);
+      extra.insert(QStringLiteral("nsPerRow"), nsPerBatch / rows);
+      extra.insert(QStringLiteral("failures"), failures);
+      extra.insert(QStringLiteral("interfaceVersion"), manager.interfaceVersion(index));
+      report->add(QStringLiteral("predict_%1_b%2").arg(algorithm).arg(rows), QStringLiteral("batch"), iterations,
+                  nsPerBatch, extra);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName(QStringLiteral("pipeline_bench"));
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QStringLiteral("采集与推理链路基准"));
+  parser.addHelpOption();
+  QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("把结果写为 JSON"), QStringLiteral("file"));
+  QCommandLineOption quickOption(QStringLiteral("quick"), QStringLiteral("减少迭代次数（冒烟测试）"));
+  QCommandLineOption recordsOption(QStringLiteral("records"), QStringLiteral("CSV / 归档记录数（默认 1000）"),
+                                   QStringLiteral("n"), QStringLiteral("1000"));
+  QCommandLineOption batchOption(QStringLiteral("batch"), QStringLiteral("批量推理条数（默认 64）"),
+                                 QStringLiteral("n"), QStringLiteral("64"));
+  QCommandLineOption filterOption(QStringLiteral("filter"),
+                                  QStringLiteral("只运行名称包含该子串的分组：decode、averaging、calibration、"
+                                                 "files、store、log、predict"),
+                                  QStringLiteral("text"));
+  parser.addOption(jsonOption);
+  parser.addOption(quickOption);
+  parser.addOption(recordsOption);
+  parser.addOption(batchOption);
+  parser.addOption(filterOption);
+  parser.process(app);
+
+  BenchConfig config;
+  config.quick = parser.isSet(quickOption);
+  config.records = qMax(1, parser.value(recordsOption).toInt());
+  config.batch = qMax(1, parser.value(batchOption).toInt());
+  config.filter = parser.value(filterOption);
+
+  std::printf("pipeline_bench: %d cpus, isa %s%s\n", QThread::idealThreadCount(),
+              SpectralMath::isaName(SpectralMath::activeIsa()), config.quick ? ", quick" : "");
+
+  struct Group {
+    const char *name;
+    void (*run)(const BenchConfig &, BenchReport *);
+  };
+  const Group groups[] = {
+      {"decode", benchPacketDecode},    {"decode", benchBatchReader}, {"averaging", benchAveraging},
+      {"calibration", benchCalibration}, {"files", benchFiles},        {"store", benchRecordStore},
+      {"log", benchLog},                {"predict", benchPredictors},
+  };
+  BenchReport report;
+  for (const Group &group : groups) {
+    if (config.filter.isEmpty() || QString::fromLatin1(group.name).contains(config.filter)) {
+      group.run(config, &report);
+    }
+  }
+
+  if (parser.isSet(jsonOption)) {
+    QJsonObject root;
+    root.insert(QStringLiteral("benchmark"), QStringLiteral("pipeline_bench"));
+    root.insert(QStringLiteral("time"), QDateTime::currentDateTime().toString(Qt::ISODate));
+    root.insert(QStringLiteral("cpus"), QThread::idealThreadCount());
+    root.insert(QStringLiteral("isa"), QString::fromLatin1(SpectralMath::isaName(SpectralMath::activeIsa())));
+    root.insert(QStringLiteral("quick"), config.quick);
+    root.insert(QStringLiteral("results"), report.results());
+    QFile file(parser.value(jsonOption));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      std::fprintf(stderr, "无法写入 %s\n", parser.value(jsonOption).toUtf8().constData());
+      return 1;
+    }
+    file.write(QJsonDocument(root).toJson());
+  }
+  return 0;
+}
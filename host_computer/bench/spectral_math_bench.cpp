@@ -0,0 +1,193 @@
+// 光谱向量化内核微基准：对每个可用指令集测量每帧（1024 像素）耗时与周期数
+//
+// 用法：spectral_math_bench [迭代次数]
+// x86 上周期数来自 TSC（rdtsc），其它平台按纳秒输出
+
+#include "spectral_math.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+namespace {
+
+constexpr int kPixels = 1024;
+
+struct Timing {
+  double nsPerFrame;
+  double cyclesPerFrame;  // 无 TSC 时为 -1
+};
+
+template <typename Fn>
+Timing measure(int iterations, Fn &&fn) {
+  // 预热
+  for (int i = 0; i < iterations / 10 + 1; i++) {
+    fn(i);
+  }
+#ifdef BENCH_HAVE_TSC
+  const unsigned long long c0 = __rdtsc();
+#endif
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    fn(i);
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  Timing t;
+  t.nsPerFrame = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+#ifdef BENCH_HAVE_TSC
+  t.cyclesPerFrame = static_cast<double>(__rdtsc() - c0) / iterations;
+#else
+  t.cyclesPerFrame = -1.0;
+#endif
+  return t;
+}
+
+void printRow(const char *isa, const char *kernel, const Timing &t) {
+  if (t.cyclesPerFrame >= 0) {
+    std::printf("%-8s %-22s %10.1f ns/frame %10.1f cycles/frame\n", isa, kernel,
+                t.nsPerFrame, t.cyclesPerFrame);
+  } else {
+    std::printf("%-8s %-22s %10.1f ns/frame\n", isa, kernel, t.nsPerFrame);
+  }
+}
+
+// 防止编译器把结果优化掉
+volatile double g_sink = 0.0;
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+
+  // 准备若干帧随机数据（模拟 16 位探测器输出）
+  const int frameCount = 64;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<int> pixelDist(0, 65535);
+  std::vector<uint16_t> frames(static_cast<size_t>(frameCount) * kPixels);
+  for (auto &v : frames) {
+    v = static_cast<uint16_t>(pixelDist(rng));
+  }
+  std::vector<double> raw(kPixels), black(kPixels), white(kPixels);
+  std::uniform_real_distribution<double> realDist(0.0, 1000.0);
+  for (int i = 0; i < kPixels; i++) {
+    black[i] = realDist(rng);
+    white[i] = black[i] + (i % 97 == 0 ? 0.0 : 1000.0 + realDist(rng));  // 部分像素触发分母保护
+    raw[i] = black[i] + realDist(rng);
+  }
+  // 与 SpectralCalibration 相同的系数：gain = 1 / (white - black)，offset = -black * gain；
+  // 分母过小的像素 gain = 1、offset = 0
+  std::vector<float> gain(kPixels), offset(kPixels);
+  for (int i = 0; i < kPixels; i++) {
+    const double span = white[i] - black[i];
+    const bool bad = std::fabs(span) < 1e-6;
+    gain[i] = bad ? 1.0f : static_cast<float>(1.0 / span);
+    offset[i] = bad ? 0.0f : static_cast<float>(-black[i] / span);
+  }
+  std::vector<double> out(kPixels);
+
+  // 标量结果作为参考，用于校验各指令集实现
+  std::vector<uint32_t> refSums(kPixels, 0);
+  std::vector<uint64_t> refSquares(kPixels, 0);
+  std::vector<double> refEma(kPixels, 0.0);
+  std::vector<double> refCorrected(kPixels);
+  double refMin = 0.0, refMax = 0.0;
+  SpectralMath::setActiveIsa(SpectralMath::Isa::Scalar);
+  for (int f = 0; f < frameCount; f++) {
+    SpectralMath::accumulateU16(refSums.data(), frames.data() + f * kPixels, kPixels);
+    SpectralMath::accumulateSquaresU16(refSquares.data(), frames.data() + f * kPixels, kPixels);
+    SpectralMath::emaUpdateU16(refEma.data(), frames.data() + f * kPixels, 0.01, kPixels);
+  }
+  // 减去一半的帧，验证滑动窗口移出
+  for (int f = 0; f < frameCount / 2; f++) {
+    SpectralMath::subtractU16(refSums.data(), frames.data() + f * kPixels, kPixels);
+    SpectralMath::subtractSquaresU16(refSquares.data(), frames.data() + f * kPixels, kPixels);
+  }
+  SpectralMath::applyGainOffset(raw.data(), gain.data(), offset.data(), refCorrected.data(), kPixels);
+  SpectralMath::minMax(refCorrected.data(), kPixels, &refMin, &refMax);
+
+  std::printf("spectral_math_bench: %d pixels/frame, %d iterations\n", kPixels, iterations);
+
+  const SpectralMath::Isa isas[] = {SpectralMath::Isa::Scalar, SpectralMath::Isa::Avx2,
+                                    SpectralMath::Isa::Neon};
+  int failures = 0;
+  for (SpectralMath::Isa isa : isas) {
+    if (!SpectralMath::setActiveIsa(isa)) {
+      continue;
+    }
+    const char *name = SpectralMath::isaName(isa);
+
+    // 正确性校验
+    std::vector<uint32_t> sums(kPixels, 0);
+    std::vector<uint64_t> squares(kPixels, 0);
+    std::vector<double> ema(kPixels, 0.0);
+    for (int f = 0; f < frameCount; f++) {
+      SpectralMath::accumulateU16(sums.data(), frames.data() + f * kPixels, kPixels);
+      SpectralMath::accumulateSquaresU16(squares.data(), frames.data() + f * kPixels, kPixels);
+      SpectralMath::emaUpdateU16(ema.data(), frames.data() + f * kPixels, 0.01, kPixels);
+    }
+    for (int f = 0; f < frameCount / 2; f++) {
+      SpectralMath::subtractU16(sums.data(), frames.data() + f * kPixels, kPixels);
+      SpectralMath::subtractSquaresU16(squares.data(), frames.data() + f * kPixels, kPixels);
+    }
+    // NEON 实现使用 FMA，EMA 结果允许微小舍入差异
+    bool emaOk = true;
+    for (int i = 0; i < kPixels; i++) {
+      if (std::fabs(ema[i] - refEma[i]) > 1e-9 * (1.0 + std::fabs(refEma[i]))) {
+        emaOk = false;
+      }
+    }
+    // 校正使用融合乘加，同样允许微小舍入差异
+    SpectralMath::applyGainOffset(raw.data(), gain.data(), offset.data(), out.data(), kPixels);
+    bool correctionOk = true;
+    for (int i = 0; i < kPixels; i++) {
+      if (std::fabs(out[i] - refCorrected[i]) > 1e-9 * (1.0 + std::fabs(refCorrected[i]))) {
+        correctionOk = false;
+      }
+    }
+    double minVal = 0.0, maxVal = 0.0;
+    SpectralMath::minMax(refCorrected.data(), kPixels, &minVal, &maxVal);
+    const bool ok = sums == refSums && squares == refSquares && emaOk && correctionOk &&
+                    minVal == refMin && maxVal == refMax;
+    if (!ok) {
+      std::printf("%-8s MISMATCH against scalar reference\n", name);
+      failures++;
+    }
+
+    std::vector<uint32_t> benchSums(kPixels, 0);
+    std::vector<uint64_t> benchSquares(kPixels, 0);
+    printRow(name, "accumulateU16", measure(iterations, [&](int i) {
+      SpectralMath::accumulateU16(benchSums.data(), frames.data() + (i % frameCount) * kPixels, kPixels);
+    }));
+    printRow(name, "accumulateSquaresU16", measure(iterations, [&](int i) {
+      SpectralMath::accumulateSquaresU16(benchSquares.data(),
+                                         frames.data() + (i % frameCount) * kPixels, kPixels);
+    }));
+    printRow(name, "subtractU16", measure(iterations, [&](int i) {
+      SpectralMath::subtractU16(benchSums.data(), frames.data() + (i % frameCount) * kPixels, kPixels);
+    }));
+    std::vector<double> benchEma(kPixels, 0.0);
+    printRow(name, "emaUpdateU16", measure(iterations, [&](int i) {
+      SpectralMath::emaUpdateU16(benchEma.data(), frames.data() + (i % frameCount) * kPixels, 0.01, kPixels);
+    }));
+    printRow(name, "applyGainOffset", measure(iterations, [&](int) {
+      SpectralMath::applyGainOffset(raw.data(), gain.data(), offset.data(), out.data(), kPixels);
+    }));
+    printRow(name, "minMax", measure(iterations, [&](int) {
+      double mn, mx;
+      SpectralMath::minMax(out.data(), kPixels, &mn, &mx);
+      g_sink = g_sink + mn + mx;
+    }));
+    g_sink = g_sink + static_cast<double>(benchSums[0] + benchSquares[0]) + benchEma[0];
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+// 合成 UDP 发包器：以设定的包速率向 UdpReceiverThread 发送 2050 字节的光谱包（1024 点大端 + 16 位帧计数），
+// 报告接收端实际收到的帧数、按帧计数检测的丢帧 / 乱序与内核接收队列丢包
+//
+// 用法：udp_blaster [--rate 8000,20000,50000] [--duration 5] [--port 18888] [--batch 32] [--json <file>]
+//       udp_blaster --target 192.168.1.20:8888 --rate 8000 ...   向外部进程（calc_app / calc_daemon）发包，
+//                                                                 不启动进程内接收端，丢包在对端的链路统计中查看
+// 进程内模式下接收端直接统计帧数，不经过处理线程，测得的是接收线程本身的上限
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QtEndian>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "link_stats.h"
+#include "spectrum_frame.h"
+#include "udp_receiver.h"
+
+namespace {
+
+constexpr int kPixels = SpectrumFrame::kPixelCount;
+constexpr int kPacketBytes = kPixels * 2 + 2;
+
+// 只计数的接收端（由接收线程调用）
+class CountingSink : public SpectrumFrameSink {
+ public:
+  void pushFrames(const SpectrumFramePtr *, int count) override {
+    frames_.fetch_add(static_cast<quint64>(count), std::memory_order_relaxed);
+  }
+  quint64 frames() const { return frames_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<quint64> frames_{0};
+};
+
+struct SendResult {
+  quint64 sent = 0;
+  quint64 sendErrors = 0;  // sendto 失败（通常是发送缓冲区满）
+  double seconds = 0.0;
+};
+
+void addNs(struct timespec *ts, qint64 ns) {
+  ts->tv_nsec += ns;
+  while (ts->tv_nsec >= 1000000000L) {
+    ts->tv_nsec -= 1000000000L;
+    ts->tv_sec++;
+  }
+}
+
+// 按绝对截止时间节拍发送：每 burst 个包睡眠到下一个截止时间，避免 sleep 误差累积
+SendResult blast(int fd, const sockaddr_in &target, int rate, double duration, quint16 *counter) {
+  std::vector<uint16_t> payload(kPacketBytes / 2);
+  for (int i = 0; i < kPixels; i++) {
+    payload[i] = qToBigEndian<quint16>(static_cast<quint16>((i * 61) & 0xFFFF));
+  }
+  // 高速率时一次突发多个包，使睡眠间隔不低于约 50 us
+  const int burst = qMax(1, rate / 20000);
+  const qint64 intervalNs = static_cast<qint64>(1e9 * burst / rate);
+  const quint64 total = static_cast<quint64>(rate * duration);
+
+  SendResult result;
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  const qint64 startNs = SpectrumFrame::nowNs();
+  while (result.sent < total) {
+    for (int b = 0; b < burst && result.sent < total; b++) {
+      payload[kPixels] = qToBigEndian<quint16>((*counter)++);
+      const ssize_t n = ::sendto(fd, payload.data(), kPacketBytes, 0, reinterpret_cast<const sockaddr *>(&target),
+                                 sizeof(target));
+      if (n != kPacketBytes) {
+        result.sendErrors++;
+      }
+      result.sent++;
+    }
+    addNs(&deadline, intervalNs);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+  }
+  result.seconds = (SpectrumFrame::nowNs() - startNs) / 1e9;
+  return result;
+}
+
+bool parseTarget(const QString &text, sockaddr_in *addr) {
+  const int colon = text.lastIndexOf(QLatin1Char(':'));
+  bool ok = false;
+  const int port = colon > 0 ? text.mid(colon + 1).toInt(&ok) : 0;
+  if (!ok || port <= 0 || port > 65535) {
+    return false;
+  }
+  addr->sin_family = AF_INET;
+  addr->sin_port = htons(static_cast<uint16_t>(port));
+  return inet_pton(AF_INET, text.left(colon).toLatin1().constData(), &addr->sin_addr) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName(QStringLiteral("udp_blaster"));
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QStringLiteral("合成 UDP 光谱包发包器，测量接收线程的丢包"));
+  parser.addHelpOption();
+  QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("每秒包数，逗号分隔时依次测试（默认 8000）"),
+                                QStringLiteral("pps"), QStringLiteral("8000"));
+  QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("每个速率的发送时长，秒（默认 5）"),
+                                    QStringLiteral("s"), QStringLiteral("5"));
+  QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("进程内接收端端口（默认 18888）"),
+                                QStringLiteral("port"), QStringLiteral("18888"));
+  QCommandLineOption batchOption(QStringLiteral("batch"), QStringLiteral("接收端 recvmmsg 批大小（默认 32）"),
+                                 QStringLiteral("n"), QString::number(UdpReceiverThread::kDefaultBatchSize));
+  QCommandLineOption kernelTimestampsOption(QStringLiteral("kernel-timestamps"),
+                                            QStringLiteral("接收端启用 SO_TIMESTAMPNS"));
+  QCommandLineOption targetOption(QStringLiteral("target"),
+                                  QStringLiteral("向外部接收端 host:port 发包，不启动进程内接收端"),
+                                  QStringLiteral("host:port"));
+  QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("把结果写为 JSON"), QStringLiteral("file"));
+  parser.addOption(rateOption);
+  parser.addOption(durationOption);
+  parser.addOption(portOption);
+  parser.addOption(batchOption);
+  parser.addOption(kernelTimestampsOption);
+  parser.addOption(targetOption);
+  parser.addOption(jsonOption);
+  parser.process(app);
+
+  std::vector<int> rates;
+  for (const QString &part : parser.value(rateOption).split(QLatin1Char(','))) {
+    const int rate = part.trimmed().toInt();
+    if (rate > 0) {
+      rates.push_back(rate);
+    }
+  }
+  const double duration = qMax(0.1, parser.value(durationOption).toDouble());
+  const int port = parser.value(portOption).toInt();
+  const bool external = parser.isSet(targetOption);
+  if (rates.empty()) {
+    std::fprintf(stderr, "--rate 需要至少一个正整数\n");
+    return 1;
+  }
+
+  sockaddr_in target = {};
+  if (external) {
+    if (!parseTarget(parser.value(targetOption), &target)) {
+      std::fprintf(stderr, "无法解析 --target（应为 IPv4 地址:端口）\n");
+      return 1;
+    }
+  } else {
+    target.sin_family = AF_INET;
+    target.sin_port = htons(static_cast<uint16_t>(port));
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  }
+  const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    std::fprintf(stderr, "无法创建 UDP 套接字\n");
+    return 1;
+  }
+
+  QJsonArray results;
+  quint16 counter = 0;
+  int exitCode = 0;
+  for (int rate : rates) {
+    UdpReceiverThread receiver;
+    auto sink = std::make_shared<CountingSink>();
+    std::atomic<bool> receiverFailed{false};
+    if (!external) {
+      QObject::connect(&receiver, &SpectrumFrameSource::errorOccurred, &receiver,
+                       [&receiverFailed](const QString &error) {
+                         std::fprintf(stderr, "接收端错误: %s\n", error.toUtf8().constData());
+                         receiverFailed = true;
+                       },
+                       Qt::DirectConnection);
+      receiver.setFrameCounterTrailer(true);
+      receiver.addFrameSink(sink);
+      receiver.startReceiving(port, QStringLiteral("127.0.0.1"), parser.value(batchOption).toInt(),
+                              parser.isSet(kernelTimestampsOption));
+      // 套接字在接收线程中创建与绑定
+      QThread::msleep(200);
+      if (receiverFailed) {
+        exitCode = 1;
+        break;
+      }
+    }
+
+    const SendResult sent = blast(fd, target, rate, duration, &counter);
+
+    QJsonObject o;
+    o.insert(QStringLiteral("rate"), rate);
+    o.insert(QStringLiteral("sent"), static_cast<double>(sent.sent));
+    o.insert(QStringLiteral("sendErrors"), static_cast<double>(sent.sendErrors));
+    o.insert(QStringLiteral("sendRate"), sent.seconds > 0.0 ? sent.sent / sent.seconds : 0.0);
+    if (external) {
+      std::printf("rate %8d pps: sent %10llu (%.0f pps), send errors %llu\n", rate,
+                  static_cast<unsigned long long>(sent.sent), sent.seconds > 0.0 ? sent.sent / sent.seconds : 0.0,
+                  static_cast<unsigned long long>(sent.sendErrors));
+      results.append(o);
+      continue;
+    }
+
+    // 等接收线程取完套接字队列中剩余的包
+    QThread::msleep(200);
+    const quint64 received = sink->frames();
+    const LinkStats::Snapshot link = receiver.linkStats()->snapshot();
+    receiver.stopReceiving();
+
+    const quint64 delivered = sent.sent - sent.sendErrors;
+    const double lossPercent = delivered > 0 && received < delivered ? 100.0 * (delivered - received) / delivered : 0.0;
+    o.insert(QStringLiteral("received"), static_cast<double>(received));
+    o.insert(QStringLiteral("receiveRate"), sent.seconds > 0.0 ? received / sent.seconds : 0.0);
+    o.insert(QStringLiteral("lossPercent"), lossPercent);
+    o.insert(QStringLiteral("lostFrames"), static_cast<double>(link.lostFrames));
+    o.insert(QStringLiteral("gapEvents"), static_cast<double>(link.gapEvents));
+    o.insert(QStringLiteral("reordered"), static_cast<double>(link.reordered));
+    o.insert(QStringLiteral("kernelDrops"), static_cast<double>(link.kernelDrops));
+    o.insert(QStringLiteral("jitterUs"), link.jitterUs);
+    results.append(o);
+    std::printf("rate %8d pps: sent %10llu, received %10llu, loss %6.3f%%, lost %llu, kernel drops %llu, "
+                "reordered %llu\n",
+                rate, static_cast<unsigned long long>(sent.sent), static_cast<unsigned long long>(received),
+                lossPercent, static_cast<unsigned long long>(link.lostFrames),
+                static_cast<unsigned long long>(link.kernelDrops), static_cast<unsigned long long>(link.reordered));
+  }
+  ::close(fd);
+
+  if (parser.isSet(jsonOption)) {
+    QJsonObject root;
+    root.insert(QStringLiteral("benchmark"), QStringLiteral("udp_blaster"));
+    root.insert(QStringLiteral("time"), QDateTime::currentDateTime().toString(Qt::ISODate));
+    root.insert(QStringLiteral("target"), external ? parser.value(targetOption)
+                                                   : QStringLiteral("127.0.0.1:%1").arg(port));
+    root.insert(QStringLiteral("durationSeconds"), duration);
+    root.insert(QStringLiteral("results"), results);
+    QFile file(parser.value(jsonOption));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      std::fprintf(stderr, "无法写入 %s\n", parser.value(jsonOption).toUtf8().constData());
+      return 1;
+    }
+    file.write(QJsonDocument(root).toJson());
+  }
+  return exitCode;
+}
@@ -0,0 +1,437 @@
+// 随机森林 / 支持向量机插件共用的 ONNX Runtime 预测器
+#pragma once
+
+#include <QDebug>
+#include <QString>
+#include <QVariantMap>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <onnxruntime/onnxruntime_cxx_api.h>
+
+#include "spectrum_predictor_interface.h"
+
+// ONNX Runtime 会话配置（通过 SpectrumPredictorManager::setPredictorOptions 按插件设置）
+struct OnnxRuntimeOptions {
+    int intraOpThreads = 1;  // 算子内线程数（0 表示由 ONNX Runtime 决定）
+    int interOpThreads = 1;  // 算子间线程数（仅 parallel 执行模式有效）
+    bool parallelExecution = false;  // 执行模式：false 顺序执行，true 并行执行
+    QString graphOptimization = QStringLiteral("all");  // disable / basic / extended / all
+    QString executionProvider = QStringLiteral("cpu");  // cpu / xnnpack / cuda
+    bool useIoBinding = true;  // 单条预测是否走预绑定快速路径
+
+    static OnnxRuntimeOptions fromVariantMap(const QVariantMap &map, const OnnxRuntimeOptions &base) {
+        OnnxRuntimeOptions o = base;
+        if (map.contains(QStringLiteral("intraOpThreads"))) {
+            o.intraOpThreads = qMax(0, map.value(QStringLiteral("intraOpThreads")).toInt());
+        }
+        if (map.contains(QStringLiteral("interOpThreads"))) {
+            o.interOpThreads = qMax(0, map.value(QStringLiteral("interOpThreads")).toInt());
+        }
+        if (map.contains(QStringLiteral("executionMode"))) {
+            o.parallelExecution = map.value(QStringLiteral("executionMode")).toString() == QStringLiteral("parallel");
+        }
+        if (map.contains(QStringLiteral("graphOptimization"))) {
+            o.graphOptimization = map.value(QStringLiteral("graphOptimization")).toString().toLower();
+        }
+        if (map.contains(QStringLiteral("executionProvider"))) {
+            o.executionProvider = map.value(QStringLiteral("executionProvider")).toString().toLower();
+        }
+        if (map.contains(QStringLiteral("useIoBinding"))) {
+            o.useIoBinding = map.value(QStringLiteral("useIoBinding")).toBool();
+        }
+        return o;
+    }
+
+    QVariantMap toVariantMap() const {
+        QVariantMap map;
+        map.insert(QStringLiteral("intraOpThreads"), intraOpThreads);
+        map.insert(QStringLiteral("interOpThreads"), interOpThreads);
+        map.insert(QStringLiteral("executionMode"),
+                   parallelExecution ? QStringLiteral("parallel") : QStringLiteral("sequential"));
+        map.insert(QStringLiteral("graphOptimization"), graphOptimization);
+        map.insert(QStringLiteral("executionProvider"), executionProvider);
+        map.insert(QStringLiteral("useIoBinding"), useIoBinding);
+        return map;
+    }
+};
+
+// ONNX 预测器类
+// - detectInputSize 为 true 时从模型输入形状动态检测输入维度（支持向量机），否则固定1024输入（随机森林）
+// - 模型的批维度为动态时一次 [N, cols] 推理完成整批预测，否则逐条推理
+// - 单条预测走预绑定快速路径：输入/输出缓冲区与 Ort::IoBinding 在会话生命周期内常驻，
+//   每次只把光谱写入输入缓冲区后调用 Run，不再分配张量、MemoryInfo 和名称数组
+// - 加载模型 / 修改配置时在调用线程上完整构建新会话（不持有推理锁），完成后在锁内整体替换，
+//   推理线程最多等待一次指针交换，不会读到构建到一半的会话
+// - int8 量化（QDQ / QOperator）与半精度模型按普通模型加载，输入输出须为 float32
+// - 设置了宿主运行时（setRuntime）时，进程内所有 ONNX 插件共用一个带全局线程池的 Ort::Env，
+//   会话不再各自创建线程池，线程数由宿主预算决定（intraOpThreads / interOpThreads 配置不再生效）
+class OnnxSpectrumPredictor {
+public:
+    OnnxSpectrumPredictor(const char *logId, bool detectInputSize)
+        : logId_(logId), detectInputSize_(detectInputSize),
+          memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {}
+    
+    // 接入宿主的共享运行时（在加载模型之前调用，见 SpectrumPredictorRuntimeInit）
+    void setRuntime(InferenceRuntimeService *runtime) {
+        std::lock_guard<std::mutex> loadLock(loadMutex_);
+        runtime_ = runtime;
+    }
+    
+    bool loadModel(const std::string& model_path) {
+        std::lock_guard<std::mutex> loadLock(loadMutex_);
+        OnnxRuntimeOptions options;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            options = options_;
+        }
+        return rebuild(model_path, options);
+    }
+    
+    // 修改会话配置；模型已加载时用新配置重新创建会话
+    bool setRuntimeOptions(const QVariantMap &options) {
+        std::lock_guard<std::mutex> loadLock(loadMutex_);
+        OnnxRuntimeOptions merged;
+        std::string model_path;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            options_ = OnnxRuntimeOptions::fromVariantMap(options, options_);
+            merged = options_;
+            if (state_) {
+                model_path = state_->model_path;
+            }
+        }
+        if (model_path.empty()) {
+            return true;
+        }
+        return rebuild(model_path, merged);
+    }
+    
+    QVariantMap runtimeOptions() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        QVariantMap map = options_.toVariantMap();
+        map.insert(QStringLiteral("sharedThreadPool"), state_ && state_->sharedEnv);
+        return map;
+    }
+    
+    // 批量预测：data 为 rows × input_size 的行优先矩阵，结果写入 out[0..rows)
+    void predictBatch(const float *data, size_t rows, float *out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!state_) {
+            throw std::invalid_argument("模型未加载");
+        }
+        if (rows == 0) {
+            return;
+        }
+        Session &s = *state_;
+        
+        // 单条预测：预绑定快速路径
+        if (rows == 1 && s.binding) {
+            std::memcpy(s.bound_input.data(), data, sizeof(float) * s.input_size);
+            s.session->Run(run_options_, *s.binding);
+            out[0] = s.bound_output[0];
+            return;
+        }
+        
+        if (!s.dynamicBatch) {
+            for (size_t r = 0; r < rows; r++) {
+                runOnce(s, data + r * s.input_size, 1, out + r);
+            }
+            return;
+        }
+        runOnce(s, data, rows, out);
+    }
+    
+    float predict(const std::vector<float>& spectrum_data) {
+        if (spectrum_data.size() != getInputSize()) {
+            throw std::invalid_argument("数据长度不正确，期望" + std::to_string(getInputSize()) + 
+                                       "，实际" + std::to_string(spectrum_data.size()));
+        }
+        float result = 0.0f;
+        predictBatch(spectrum_data.data(), 1, &result);
+        return result;
+    }
+    
+    bool isModelLoaded() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_ != nullptr;
+    }
+    
+    size_t getInputSize() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_ ? state_->input_size : 1024;
+    }
+
+private:
+    // 一个完整的会话及其常驻推理资源，构建完成后只由推理路径（持有 mutex_）使用
+    struct Session {
+        std::shared_ptr<Ort::Env> env;  // 最先声明、最后释放：会话依赖环境
+        bool sharedEnv = false;  // 使用宿主共享的环境与全局线程池
+        std::string model_path;
+        std::unique_ptr<Ort::Session> session;
+        std::vector<std::string> input_names;
+        std::vector<std::string> output_names;
+        std::vector<const char*> input_node_names;
+        std::vector<const char*> output_node_names;
+        std::vector<std::vector<int64_t>> input_shapes;
+        std::vector<std::vector<int64_t>> output_shapes;
+        size_t input_size = 1024;
+        bool dynamicBatch = true;  // 模型批维度是否为动态
+        
+        std::vector<float> bound_input;  // 预绑定的输入缓冲区
+        std::vector<float> bound_output;  // 预绑定的输出缓冲区
+        Ort::Value bound_input_tensor{nullptr};
+        Ort::Value bound_output_tensor{nullptr};
+        std::unique_ptr<Ort::IoBinding> binding;
+        
+        ~Session() {
+            // 绑定依赖会话，先于会话释放
+            binding.reset();
+        }
+    };
+    
+    // 在调用线程上构建新会话，成功后替换当前会话（调用方持有 loadMutex_）
+    // 失败时保留原会话，正在使用的模型不受影响
+    bool rebuild(const std::string& model_path, const OnnxRuntimeOptions& options) {
+        std::unique_ptr<Session> next = buildSession(model_path, options);
+        if (!next) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(state_, next);
+        }
+        // 旧会话在锁外释放
+        next.reset();
+        return true;
+    }
+    
+    std::unique_ptr<Session> buildSession(const std::string& model_path, const OnnxRuntimeOptions& options) {
+        try {
+            auto s = std::make_unique<Session>();
+            s->env = acquireEnv(&s->sharedEnv);
+            
+            // 创建会话选项
+            Ort::SessionOptions session_options = makeSessionOptions(options, s->sharedEnv);
+            
+            // 创建会话（加载模型）
+            s->session = std::make_unique<Ort::Session>(*s->env, model_path.c_str(), session_options);
+            s->model_path = model_path;
+            
+            // 获取输入输出信息
+            Ort::AllocatorWithDefaultOptions allocator;
+            
+            // 输入信息
+            size_t num_input_nodes = s->session->GetInputCount();
+            s->input_names.resize(num_input_nodes);
+            s->input_shapes.resize(num_input_nodes);
+            
+            for (size_t i = 0; i < num_input_nodes; i++) {
+                auto input_name = s->session->GetInputNameAllocated(i, allocator);
+                s->input_names[i] = input_name.get();
+                
+                Ort::TypeInfo input_type_info = s->session->GetInputTypeInfo(i);
+                auto input_tensor_info = input_type_info.GetTensorTypeAndShapeInfo();
+                s->input_shapes[i] = input_tensor_info.GetShape();
+                // int8 量化与半精度模型的输入仍须为 float32（半精度导出时保留 float32 输入输出）
+                if (i == 0 && input_tensor_info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+                    throw std::runtime_error("模型输入类型不是 float32");
+                }
+            }
+            
+            // 输出信息
+            size_t num_output_nodes = s->session->GetOutputCount();
+            s->output_names.resize(num_output_nodes);
+            s->output_shapes.resize(num_output_nodes);
+            
+            for (size_t i = 0; i < num_output_nodes; i++) {
+                auto output_name = s->session->GetOutputNameAllocated(i, allocator);
+                s->output_names[i] = output_name.get();
+                
+                Ort::TypeInfo output_type_info = s->session->GetOutputTypeInfo(i);
+                s->output_shapes[i] = output_type_info.GetTensorTypeAndShapeInfo().GetShape();
+            }
+            
+            // 名称指针在会话生命周期内保持不变，只构建一次
+            for (const auto& name : s->input_names) {
+                s->input_node_names.push_back(name.c_str());
+            }
+            for (const auto& name : s->output_names) {
+                s->output_node_names.push_back(name.c_str());
+            }
+            
+            if (!s->input_shapes.empty() && !s->input_shapes[0].empty()) {
+                // 动态检测输入大小
+                if (detectInputSize_ && s->input_shapes[0].back() > 0) {
+                    s->input_size = static_cast<size_t>(s->input_shapes[0].back());
+                }
+                // 批维度固定为 1 的模型只能逐条推理
+                s->dynamicBatch = s->input_shapes[0].size() < 2 || s->input_shapes[0][0] <= 0;
+            }
+            
+            if (options.useIoBinding) {
+                setupBinding(*s);
+            }
+            return s;
+        } catch (const std::exception& e) {
+            qWarning() << "加载模型失败:" << e.what();
+            return nullptr;
+        }
+    }
+    
+    // 取得 ONNX Runtime 环境（只在持有 loadMutex_ 时调用）
+    // 有宿主运行时时使用进程内共享的环境：第一个请求的插件按宿主线程预算创建全局线程池，
+    // 之后所有插件、所有会话共用；否则创建本预测器独占的环境（只创建一次，之后只读）
+    std::shared_ptr<Ort::Env> acquireEnv(bool *shared) {
+        *shared = false;
+        if (runtime_) {
+            InferenceRuntimeService *runtime = runtime_;
+            auto factory = [runtime]() -> std::shared_ptr<void> {
+                Ort::ThreadingOptions threading;
+                threading.SetGlobalIntraOpNumThreads(runtime->intraOpThreads());
+                threading.SetGlobalInterOpNumThreads(runtime->interOpThreads());
+                threading.SetGlobalSpinControl(runtime->allowSpinning() ? 1 : 0);
+                return std::make_shared<Ort::Env>(threading, ORT_LOGGING_LEVEL_WARNING, "SpectrumPredictor");
+            };
+            // key 带上 API 版本：只有链接同一版本 ONNX Runtime 的插件才共用环境
+            std::shared_ptr<Ort::Env> env = std::static_pointer_cast<Ort::Env>(runtime_->sharedObject(
+                QStringLiteral("onnxruntime/env/%1").arg(ORT_API_VERSION), factory));
+            if (env) {
+                *shared = true;
+                return env;
+            }
+        }
+        if (!ownedEnv_) {
+            ownedEnv_ = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, logId_.c_str());
+        }
+        return ownedEnv_;
+    }
+    
+    Ort::SessionOptions makeSessionOptions(const OnnxRuntimeOptions& options, bool sharedEnv) const {
+        Ort::SessionOptions session_options;
+        if (sharedEnv) {
+            // 使用环境的全局线程池
+            session_options.DisablePerSessionThreads();
+        } else {
+            session_options.SetIntraOpNumThreads(options.intraOpThreads);
+            session_options.SetInterOpNumThreads(options.interOpThreads);
+        }
+        session_options.SetExecutionMode(options.parallelExecution ? ORT_PARALLEL : ORT_SEQUENTIAL);
+        
+        GraphOptimizationLevel level = ORT_ENABLE_ALL;
+        if (options.graphOptimization == QStringLiteral("disable")) {
+            level = ORT_DISABLE_ALL;
+        } else if (options.graphOptimization == QStringLiteral("basic")) {
+            level = ORT_ENABLE_BASIC;
+        } else if (options.graphOptimization == QStringLiteral("extended")) {
+            level = ORT_ENABLE_EXTENDED;
+        }
+        session_options.SetGraphOptimizationLevel(level);
+        
+        // 执行提供者：添加失败时回退到默认 CPU
+        try {
+            if (options.executionProvider == QStringLiteral("xnnpack")) {
+                const int xnnpackThreads = sharedEnv && runtime_ ? runtime_->intraOpThreads()
+                                                                 : qMax(1, options.intraOpThreads);
+                session_options.AppendExecutionProvider(
+                    "XNNPACK", {{"intra_op_num_threads", std::to_string(xnnpackThreads)}});
+            } else if (options.executionProvider == QStringLiteral("cuda")) {
+                OrtCUDAProviderOptions cuda_options{};
+                session_options.AppendExecutionProvider_CUDA(cuda_options);
+            }
+        } catch (const std::exception& e) {
+            qWarning() << "执行提供者" << options.executionProvider << "不可用，使用 CPU:" << e.what();
+        }
+        return session_options;
+    }
+    
+    // 建立单条预测的预绑定：输入/输出缓冲区在会话生命周期内常驻
+    void setupBinding(Session &s) {
+        if (s.input_names.empty() || s.output_names.empty() || s.output_shapes.empty()) {
+            return;
+        }
+        
+        // 输出形状中的动态维度按批大小 1 处理
+        size_t output_count = 1;
+        std::vector<int64_t> output_shape = s.output_shapes[0];
+        for (auto &dim : output_shape) {
+            if (dim <= 0) {
+                dim = 1;
+            }
+            output_count *= static_cast<size_t>(dim);
+        }
+        if (output_shape.empty()) {
+            output_shape.push_back(1);
+        }
+        
+        try {
+            std::vector<int64_t> input_shape = {1, static_cast<int64_t>(s.input_size)};
+            s.bound_input.assign(s.input_size, 0.0f);
+            s.bound_output.assign(output_count, 0.0f);
+            s.bound_input_tensor = Ort::Value::CreateTensor<float>(
+                memory_info_, s.bound_input.data(), s.bound_input.size(),
+                input_shape.data(), input_shape.size());
+            s.bound_output_tensor = Ort::Value::CreateTensor<float>(
+                memory_info_, s.bound_output.data(), s.bound_output.size(),
+                output_shape.data(), output_shape.size());
+            
+            s.binding = std::make_unique<Ort::IoBinding>(*s.session);
+            s.binding->BindInput(s.input_node_names[0], s.bound_input_tensor);
+            s.binding->BindOutput(s.output_node_names[0], s.bound_output_tensor);
+            
+            // 试运行一次，确认模型输出形状与预绑定缓冲区一致，否则退回普通路径
+            Ort::RunOptions run_options;
+            s.session->Run(run_options, *s.binding);
+        } catch (const std::exception& e) {
+            qWarning() << "IoBinding 预绑定失败，使用普通推理路径:" << e.what();
+            s.binding.reset();
+            s.bound_input_tensor = Ort::Value(nullptr);
+            s.bound_output_tensor = Ort::Value(nullptr);
+        }
+    }
+    
+    // 一次会话调用完成 rows 条预测
+    void runOnce(Session &s, const float *data, size_t rows, float *out) {
+        std::vector<int64_t> input_shape = {static_cast<int64_t>(rows), static_cast<int64_t>(s.input_size)};
+        
+        // 创建输入张量（直接引用调用方的数据，不复制）
+        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
+            memory_info_, const_cast<float*>(data), rows * s.input_size,
+            input_shape.data(), input_shape.size());
+        
+        // 运行推理
+        auto output_tensors = s.session->Run(
+            run_options_,
+            s.input_node_names.data(), &input_tensor, 1,
+            s.output_node_names.data(), 1);
+        
+        // 获取输出结果（形状为 [N] 或 [N, 1]）
+        auto output_info = output_tensors.front().GetTensorTypeAndShapeInfo();
+        if (output_info.GetElementCount() < rows) {
+            throw std::runtime_error("模型输出数量少于输入行数");
+        }
+        const float* float_array = output_tensors.front().GetTensorData<float>();
+        for (size_t r = 0; r < rows; r++) {
+            out[r] = float_array[r];
+        }
+    }
+
+    std::string logId_;
+    bool detectInputSize_;
+    std::mutex loadMutex_;  // 串行化会话构建（加载模型、修改配置），不阻塞推理
+    mutable std::mutex mutex_;  // 串行化推理与会话替换，保护 state_ 与 options_
+    OnnxRuntimeOptions options_;
+    
+    // 常驻的推理资源
+    Ort::MemoryInfo memory_info_;
+    Ort::RunOptions run_options_;
+    
+    InferenceRuntimeService *runtime_ = nullptr;  // 宿主运行时（不持有），只在持有 loadMutex_ 时访问
+    // 会话各自持有所用环境的引用，声明顺序只是保证独占环境最后释放
+    std::shared_ptr<Ort::Env> ownedEnv_;  // 没有宿主运行时时使用，只在持有 loadMutex_ 时创建
+    std::unique_ptr<Session> state_;  // 当前会话，未加载时为空
+};
@@ -3,6 +3,9 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QVariantMap>
+#include <algorithm>
+#include <mutex>
 #include <vector>
 #include <memory>
 
@@ -20,44 +23,86 @@
 // #define slots
 
 // PyTorch 预测器类（使用 libtorch，固定1024输入）
+// libtorch 的线程数是进程级设置：有宿主运行时时按宿主线程预算在进程内只设置一次，
+// 否则在第一次加载模型时按本实例的配置设置
+// 快速模型：precision（float32 / float16 / bfloat16）在加载时转换权重，推理时输入随之转换、输出转回 float32；
+// optimizeForInference 在加载时冻结模块并做推理优化（算子融合、常量折叠）；int8 动态量化模型直接加载
 class LibTorchSpectrumPredictor {
 public:
-    LibTorchSpectrumPredictor() : modelLoaded_(false), input_size_(1024) {}
+    LibTorchSpectrumPredictor()
+        : modelLoaded_(false), input_size_(1024), intraOpThreads_(1), interOpThreads_(1),
+          threadsApplied_(false), runtime_(nullptr), precision_(torch::kFloat32), optimizeForInference_(false),
+          modelPrecision_(torch::kFloat32) {}
     
+    // 接入宿主的共享运行时（在加载模型之前调用，见 SpectrumPredictorRuntimeInit）
+    void setRuntime(InferenceRuntimeService *runtime) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        runtime_ = runtime;
+        if (runtime_) {
+            intraOpThreads_ = runtime_->intraOpThreads();
+            interOpThreads_ = runtime_->interOpThreads();
+        }
+    }
+    
+    // 在锁外加载模型并切换到推理模式，完成后在锁内替换：推理线程不等待模型加载，
+    // 加载失败时保留原模型
     bool loadModel(const std::string& model_path) {
+        ensureThreadSettings();
+        torch::ScalarType precision = torch::kFloat32;
+        bool optimize = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            precision = precision_;
+            optimize = optimizeForInference_;
+        }
+        torch::jit::script::Module model;
         try {
             // 加载 JIT 模型
-            model_ = torch::jit::load(model_path);
-            model_.eval();
-            
-            modelLoaded_ = true;
-            qDebug() << "PyTorch 模型加载成功:" << model_path.c_str();
-            return true;
+            model = torch::jit::load(model_path);
+            model.eval();
+            if (precision != torch::kFloat32) {
+                model.to(precision);
+            }
+            if (optimize) {
+                // 未冻结的模块先冻结（权重变为常量），再做推理优化
+                model = torch::jit::optimize_for_inference(model);
+            }
         } catch (const std::exception& e) {
             qWarning() << "加载 PyTorch 模型失败:" << e.what();
-            modelLoaded_ = false;
             return false;
         }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(model_, model);
+            modelPrecision_ = precision;
+            modelLoaded_ = true;
+        }
+        qDebug() << "PyTorch 模型加载成功:" << model_path.c_str() << "精度:" << precisionName(precision)
+                 << (optimize ? "（已做推理优化）" : "");
+        return true;
     }
     
-    float predict(const std::vector<float>& spectrum_data) {
+    // 批量预测：data 为 rows × input_size_ 的行优先矩阵，一次前向计算，结果写入 out[0..rows)
+    void predictBatch(const float *data, size_t rows, float *out) {
+        std::lock_guard<std::mutex> lock(mutex_);
         if (!modelLoaded_) {
             throw std::invalid_argument("模型未加载");
         }
-        
-        if (spectrum_data.size() != static_cast<size_t>(input_size_)) {
-            throw std::invalid_argument("数据长度不正确，期望" + std::to_string(input_size_) + 
-                                       "，实际" + std::to_string(spectrum_data.size()));
+        if (rows == 0) {
+            return;
         }
         
         try {
-            // 创建输入张量 (1, 1024)
+            // 创建输入张量 (N, 1024)，直接引用调用方的数据，不复制
             std::vector<torch::jit::IValue> inputs;
             torch::Tensor input_tensor = torch::from_blob(
-                const_cast<float*>(spectrum_data.data()),
-                {1, static_cast<int64_t>(input_size_)},
+                const_cast<float*>(data),
+                {static_cast<int64_t>(rows), static_cast<int64_t>(input_size_)},
                 torch::kFloat32
             );
+            if (modelPrecision_ != torch::kFloat32) {
+                input_tensor = input_tensor.to(modelPrecision_);
+            }
             
             inputs.push_back(input_tensor);
             
@@ -65,25 +110,91 @@ public:
             torch::NoGradGuard no_grad;
             auto output = model_.forward(inputs);
             
-            // 获取输出值
-            float result = 0.0f;
+            // 获取输出值（形状为 [N] 或 [N, 1]）
             if (output.isTensor()) {
-                auto output_tensor = output.toTensor();
-                result = output_tensor.item<float>();
-            } else if (output.isScalar()) {
-                result = output.toScalar().toFloat();
+                auto output_tensor = output.toTensor().to(torch::kFloat32).contiguous().view({-1});
+                if (output_tensor.numel() < static_cast<int64_t>(rows)) {
+                    throw std::runtime_error("模型输出数量少于输入行数");
+                }
+                const float *values = output_tensor.data_ptr<float>();
+                for (size_t r = 0; r < rows; r++) {
+                    out[r] = values[r];
+                }
+            } else if (output.isScalar() && rows == 1) {
+                out[0] = output.toScalar().toFloat();
             } else {
                 throw std::runtime_error("无法解析模型输出");
             }
-            
-            return result;
         } catch (const std::exception& e) {
             qWarning() << "PyTorch 预测失败:" << e.what();
             throw;
         }
     }
     
+    float predict(const std::vector<float>& spectrum_data) {
+        if (spectrum_data.size() != static_cast<size_t>(input_size_)) {
+            throw std::invalid_argument("数据长度不正确，期望" + std::to_string(input_size_) + 
+                                       "，实际" + std::to_string(spectrum_data.size()));
+        }
+        float result = 0.0f;
+        predictBatch(spectrum_data.data(), 1, &result);
+        return result;
+    }
+    
+    // 线程配置：intraOpThreads（算子内并行）、interOpThreads（算子间并行，进程内只能设置一次）
+    // 使用宿主运行时时线程数由宿主统一决定，这里的线程配置被忽略
+    // precision / optimizeForInference 在下一次 loadModel 时生效
+    bool setRuntimeOptions(const QVariantMap &options) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (options.contains(QStringLiteral("precision"))) {
+            const QString name = options.value(QStringLiteral("precision")).toString().toLower();
+            if (name == QStringLiteral("float32") || name == QStringLiteral("fp32")) {
+                precision_ = torch::kFloat32;
+            } else if (name == QStringLiteral("float16") || name == QStringLiteral("fp16")) {
+                precision_ = torch::kFloat16;
+            } else if (name == QStringLiteral("bfloat16") || name == QStringLiteral("bf16")) {
+                precision_ = torch::kBFloat16;
+            } else {
+                qWarning() << "不支持的 PyTorch 推理精度:" << name;
+                return false;
+            }
+        }
+        if (options.contains(QStringLiteral("optimizeForInference"))) {
+            optimizeForInference_ = options.value(QStringLiteral("optimizeForInference")).toBool();
+        }
+        if (runtime_) {
+            const bool changed =
+                options.value(QStringLiteral("intraOpThreads"), intraOpThreads_).toInt() != intraOpThreads_ ||
+                options.value(QStringLiteral("interOpThreads"), interOpThreads_).toInt() != interOpThreads_;
+            if (changed) {
+                qWarning() << "PyTorch 线程数由宿主推理运行时统一设置，忽略插件线程配置";
+            }
+            return true;
+        }
+        if (options.contains(QStringLiteral("intraOpThreads"))) {
+            intraOpThreads_ = qMax(1, options.value(QStringLiteral("intraOpThreads")).toInt());
+        }
+        if (options.contains(QStringLiteral("interOpThreads"))) {
+            interOpThreads_ = qMax(1, options.value(QStringLiteral("interOpThreads")).toInt());
+        }
+        threadsApplied_ = true;
+        applyProcessSettings(intraOpThreads_, interOpThreads_);
+        return true;
+    }
+    
+    QVariantMap runtimeOptions() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        QVariantMap map;
+        map.insert(QStringLiteral("intraOpThreads"), intraOpThreads_);
+        map.insert(QStringLiteral("interOpThreads"), interOpThreads_);
+        map.insert(QStringLiteral("sharedThreadPool"), runtime_ != nullptr);
+        map.insert(QStringLiteral("precision"), precisionName(precision_));
+        map.insert(QStringLiteral("optimizeForInference"), optimizeForInference_);
+        return map;
+    }
+    
     bool isModelLoaded() const {
+        std::lock_guard<std::mutex> lock(mutex_);
         return modelLoaded_;
     }
     
@@ -92,16 +203,82 @@ public:
     }
 
 private:
+    void ensureThreadSettings() {
+        InferenceRuntimeService *runtime = nullptr;
+        int intra = 1;
+        int inter = 1;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            runtime = runtime_;
+            if (!runtime && threadsApplied_) {
+                return;
+            }
+            threadsApplied_ = true;
+            intra = intraOpThreads_;
+            inter = interOpThreads_;
+        }
+        if (runtime) {
+            // 所有 libtorch 插件实例（包括影子模型）共用一次设置
+            runtime->runOnce(QStringLiteral("libtorch/threads"), [intra, inter]() {
+                applyProcessSettings(intra, inter);
+            });
+        } else {
+            applyProcessSettings(intra, inter);
+        }
+    }
+    
+    static QString precisionName(torch::ScalarType type) {
+        switch (type) {
+            case torch::kFloat16:
+                return QStringLiteral("float16");
+            case torch::kBFloat16:
+                return QStringLiteral("bfloat16");
+            default:
+                return QStringLiteral("float32");
+        }
+    }
+    
+    static void applyProcessSettings(int intraOpThreads, int interOpThreads) {
+        // int8 动态量化模型：没有 FBGEMM 的平台（ARM）使用 QNNPACK 量化后端
+        const auto engines = at::globalContext().supportedQEngines();
+        const bool hasFbgemm = std::find(engines.begin(), engines.end(), at::QEngine::FBGEMM) != engines.end();
+        const bool hasQnnpack = std::find(engines.begin(), engines.end(), at::QEngine::QNNPACK) != engines.end();
+        if (!hasFbgemm && hasQnnpack) {
+            at::globalContext().setQEngine(at::QEngine::QNNPACK);
+        }
+
+        torch::set_num_threads(intraOpThreads);
+        try {
+            // 算子间线程池启动后不能再修改，此时保留原设置
+            torch::set_num_interop_threads(interOpThreads);
+        } catch (const std::exception& e) {
+            qWarning() << "PyTorch 算子间线程数已生效，无法修改:" << e.what();
+        }
+    }
+
+    mutable std::mutex mutex_;  // 串行化推理与模型加载
     torch::jit::script::Module model_;
     bool modelLoaded_;
     size_t input_size_;
+    int intraOpThreads_;
+    int interOpThreads_;
+    bool threadsApplied_;  // 无宿主运行时时是否已设置过线程数
+    InferenceRuntimeService *runtime_;  // 宿主运行时（不持有）
+    torch::ScalarType precision_;  // 下一次加载使用的精度
+    bool optimizeForInference_;
+    torch::ScalarType modelPrecision_;  // 当前模型的精度
 };
 
 // PyTorch 预测插件
-class PyTorchPredictorPlugin : public QObject, public SpectrumPredictorPlugin {
+class PyTorchPredictorPlugin : public QObject,
+                               public SpectrumPredictorPluginV2,
+                               public SpectrumPredictorFactory,
+                               public SpectrumPredictorRuntimeOptions,
+                               public SpectrumPredictorRuntimeInit {
   Q_OBJECT
-  Q_PLUGIN_METADATA(IID SpectrumPredictorPlugin_iid)
-  Q_INTERFACES(SpectrumPredictorPlugin)
+  Q_PLUGIN_METADATA(IID SpectrumPredictorPluginV2_iid)
+  Q_INTERFACES(SpectrumPredictorPlugin SpectrumPredictorPluginV2 SpectrumPredictorFactory
+               SpectrumPredictorRuntimeOptions SpectrumPredictorRuntimeInit)
 
  public:
   PyTorchPredictorPlugin() : predictor_(std::make_unique<LibTorchSpectrumPredictor>()) {}
@@ -170,17 +347,51 @@ class PyTorchPredictorPlugin : public QObject, public SpectrumPredictorPlugin {
       data.push_back(static_cast<float>(v.toDouble()));
     }
     
+    float result = 0.0f;
+    if (!predictBatch(data.data(), 1, expectedSize, &result)) {
+      return 0.0;
+    }
+    return static_cast<double>(result);
+  }
+  
+  size_t inputSize() const override {
+    return predictor_->getInputSize();
+  }
+  
+  bool predictBatch(const float *data, size_t rows, size_t cols, float *out) override {
+    if (cols != predictor_->getInputSize()) {
+      qWarning() << "光谱数据长度不正确，期望" << predictor_->getInputSize() << "，实际:" << cols;
+      return false;
+    }
+    
     try {
-      return static_cast<double>(predictor_->predict(data));
+      predictor_->predictBatch(data, rows, out);
+      return true;
     } catch (const std::exception& e) {
       qWarning() << "预测失败:" << e.what();
-      return 0.0;
+      return false;
     }
   }
   
+  bool setRuntimeOptions(const QVariantMap &options) override {
+    return predictor_->setRuntimeOptions(options);
+  }
+  
+  QVariantMap runtimeOptions() const override {
+    return predictor_->runtimeOptions();
+  }
+  
   bool isModelLoaded() const override {
     return predictor_->isModelLoaded();
   }
+  
+  QObject *createInstance() const override {
+    return new PyTorchPredictorPlugin();
+  }
+  
+  void initialize(InferenceRuntimeService *runtime) override {
+    predictor_->setRuntime(runtime);
+  }
 
  private:
   std::unique_ptr<LibTorchSpectrumPredictor> predictor_;
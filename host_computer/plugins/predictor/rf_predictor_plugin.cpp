@@ -7,114 +7,21 @@
 #include <memory>
 
 #include "spectrum_predictor_interface.h"
-#include <onnxruntime/onnxruntime_cxx_api.h>
-
-// ONNX 预测器类（随机森林算法版本，固定1024输入）
-class OnnxSpectrumPredictor {
-public:
-    OnnxSpectrumPredictor() : modelLoaded_(false) {}
-    
-    bool loadModel(const std::string& model_path) {
-        try {
-            // 初始化 ONNX Runtime 环境
-            env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "RFPredictor");
-            
-            // 创建会话选项
-            Ort::SessionOptions session_options;
-            session_options.SetIntraOpNumThreads(1);
-            
-            // 创建会话（加载模型）
-            session_ = std::make_unique<Ort::Session>(*env_, model_path.c_str(), session_options);
-            
-            // 获取输入输出信息
-            Ort::AllocatorWithDefaultOptions allocator;
-            
-            // 输入信息
-            size_t num_input_nodes = session_->GetInputCount();
-            input_names_.resize(num_input_nodes);
-            
-            for (size_t i = 0; i < num_input_nodes; i++) {
-                auto input_name = session_->GetInputNameAllocated(i, allocator);
-                input_names_[i] = input_name.get();
-            }
-            
-            // 输出信息
-            size_t num_output_nodes = session_->GetOutputCount();
-            output_names_.resize(num_output_nodes);
-            
-            for (size_t i = 0; i < num_output_nodes; i++) {
-                auto output_name = session_->GetOutputNameAllocated(i, allocator);
-                output_names_[i] = output_name.get();
-            }
-            
-            modelLoaded_ = true;
-            return true;
-        } catch (const std::exception& e) {
-            qWarning() << "加载模型失败:" << e.what();
-            modelLoaded_ = false;
-            return false;
-        }
-    }
-    
-    float predict(const std::vector<float>& spectrum_data) {
-        if (!modelLoaded_ || spectrum_data.size() != 1024) {
-            throw std::invalid_argument("模型未加载或数据长度不正确");
-        }
-        
-        // 准备输入数据
-        std::vector<int64_t> input_shape = {1, 1024};
-        std::vector<float> input_values = spectrum_data;
-        
-        // 创建输入张量
-        Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(
-            OrtArenaAllocator, OrtMemTypeDefault);
-        
-        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
-            memory_info, input_values.data(), input_values.size(),
-            input_shape.data(), input_shape.size());
-        
-        // 准备输入输出名称
-        std::vector<const char*> input_node_names;
-        for (const auto& name : input_names_) {
-            input_node_names.push_back(name.c_str());
-        }
-        
-        std::vector<const char*> output_node_names;
-        for (const auto& name : output_names_) {
-            output_node_names.push_back(name.c_str());
-        }
-        
-        // 运行推理
-        auto output_tensors = session_->Run(
-            Ort::RunOptions{nullptr},
-            input_node_names.data(), &input_tensor, 1,
-            output_node_names.data(), 1);
-        
-        // 获取输出结果
-        float* float_array = output_tensors.front().GetTensorMutableData<float>();
-        return float_array[0];
-    }
-    
-    bool isModelLoaded() const {
-        return modelLoaded_;
-    }
-
-private:
-    std::unique_ptr<Ort::Env> env_;
-    std::unique_ptr<Ort::Session> session_;
-    std::vector<std::string> input_names_;
-    std::vector<std::string> output_names_;
-    bool modelLoaded_;
-};
+#include "onnx_spectrum_predictor.h"
 
 // 随机森林预测插件
-class RFPredictorPlugin : public QObject, public SpectrumPredictorPlugin {
+class RFPredictorPlugin : public QObject,
+                          public SpectrumPredictorPluginV2,
+                          public SpectrumPredictorFactory,
+                          public SpectrumPredictorRuntimeOptions,
+                          public SpectrumPredictorRuntimeInit {
   Q_OBJECT
-  Q_PLUGIN_METADATA(IID SpectrumPredictorPlugin_iid)
-  Q_INTERFACES(SpectrumPredictorPlugin)
+  Q_PLUGIN_METADATA(IID SpectrumPredictorPluginV2_iid)
+  Q_INTERFACES(SpectrumPredictorPlugin SpectrumPredictorPluginV2 SpectrumPredictorFactory
+               SpectrumPredictorRuntimeOptions SpectrumPredictorRuntimeInit)
 
  public:
-  RFPredictorPlugin() : predictor_(std::make_unique<OnnxSpectrumPredictor>()) {}
+  RFPredictorPlugin() : predictor_(std::make_unique<OnnxSpectrumPredictor>("RFPredictor", false)) {}
   
   QString name() const override { 
     return QStringLiteral("随机森林预测器 (Random Forest)"); 
@@ -167,29 +74,64 @@ class RFPredictorPlugin : public QObject, public SpectrumPredictorPlugin {
   }
   
   double predict(const QVariantList &spectrumData) override {
-    if (spectrumData.size() != 1024) {
-      qWarning() << "光谱数据长度不正确，期望1024，实际:" << spectrumData.size();
+    size_t expectedSize = predictor_->getInputSize();
+    if (spectrumData.size() != static_cast<int>(expectedSize)) {
+      qWarning() << "光谱数据长度不正确，期望" << expectedSize << "，实际:" << spectrumData.size();
       return 0.0;
     }
     
     // 转换为 std::vector<float>
     std::vector<float> data;
-    data.reserve(1024);
+    data.reserve(expectedSize);
     for (const QVariant &v : spectrumData) {
       data.push_back(static_cast<float>(v.toDouble()));
     }
     
+    float result = 0.0f;
+    if (!predictBatch(data.data(), 1, expectedSize, &result)) {
+      return 0.0;
+    }
+    return static_cast<double>(result);
+  }
+  
+  size_t inputSize() const override {
+    return predictor_->getInputSize();
+  }
+  
+  bool predictBatch(const float *data, size_t rows, size_t cols, float *out) override {
+    if (cols != predictor_->getInputSize()) {
+      qWarning() << "光谱数据长度不正确，期望" << predictor_->getInputSize() << "，实际:" << cols;
+      return false;
+    }
+    
     try {
-      return static_cast<double>(predictor_->predict(data));
+      predictor_->predictBatch(data, rows, out);
+      return true;
     } catch (const std::exception& e) {
       qWarning() << "预测失败:" << e.what();
-      return 0.0;
+      return false;
     }
   }
   
+  bool setRuntimeOptions(const QVariantMap &options) override {
+    return predictor_->setRuntimeOptions(options);
+  }
+  
+  QVariantMap runtimeOptions() const override {
+    return predictor_->runtimeOptions();
+  }
+  
   bool isModelLoaded() const override {
     return predictor_->isModelLoaded();
   }
+  
+  QObject *createInstance() const override {
+    return new RFPredictorPlugin();
+  }
+  
+  void initialize(InferenceRuntimeService *runtime) override {
+    predictor_->setRuntime(runtime);
+  }
 
  private:
   std::unique_ptr<OnnxSpectrumPredictor> predictor_;
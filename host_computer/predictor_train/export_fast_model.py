@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+导出模型的快速版本（int8 量化 / 半精度 / 推理优化），并生成上位机读取的 <模型名>.fast.json
+
+上位机加载原模型后，会在参考集上比较快速模型与原模型的预测，误差在容差内才用快速模型上线
+（见上级目录 README.md 第 11.7 节和 src/fast_model_spec.h）。
+
+用法示例：
+  # ONNX：int8 动态量化（对含 MatMul / Gemm 的网络有效；随机森林、SVM 的 ai.onnx.ml 算子不会被量化）
+  python3 export_fast_model.py rf_predictor/spectrum_model.onnx --mode int8 --reference reference.csv
+
+  # ONNX：fp16（保留 float32 输入输出）
+  python3 export_fast_model.py svm_predictor/spectrum_model.onnx --mode fp16 --reference reference.csv
+
+  # TorchScript：上位机加载时转换为 bfloat16 并做推理优化（不生成新模型文件）
+  python3 export_fast_model.py pytorch_predictor/spectrum_model.jit --mode bf16 --optimize --reference reference.csv
+
+参考集为 CSV，每行一条校正后的光谱（与上位机推理时的输入相同）。
+"""
+
+import argparse
+import json
+import os
+import sys
+
+import numpy as np
+
+
+def base_path(model_path: str) -> str:
+    """<目录>/<模型文件名去掉最后一个扩展名>，与上位机的 QFileInfo::completeBaseName 一致"""
+    directory, name = os.path.split(os.path.abspath(model_path))
+    return os.path.join(directory, name.rsplit('.', 1)[0] if '.' in name else name)
+
+
+def write_reference_csv(path: str, X: np.ndarray, max_rows: int = 256):
+    """写出参考集：每行一条光谱"""
+    rows = np.asarray(X, dtype=np.float32)[:max_rows]
+    np.savetxt(path, rows, delimiter=',', fmt='%.7g')
+    print(f"参考集已保存: {path}（{rows.shape[0]} 条）")
+
+
+def write_fast_spec(model_path: str, fast_model: str, reference: str, max_abs_error: float,
+                    max_mean_abs_error: float = 0.0, options: dict = None) -> str:
+    """在原模型旁边写出 <模型名>.fast.json，路径写成相对配置文件所在目录的形式"""
+    spec_path = base_path(model_path) + '.fast.json'
+    directory = os.path.dirname(spec_path)
+    spec = {
+        'referenceSet': os.path.relpath(os.path.abspath(reference), directory),
+        'maxAbsError': float(max_abs_error),
+    }
+    if fast_model and os.path.abspath(fast_model) != os.path.abspath(model_path):
+        spec['model'] = os.path.relpath(os.path.abspath(fast_model), directory)
+    if max_mean_abs_error > 0:
+        spec['maxMeanAbsError'] = float(max_mean_abs_error)
+    if options:
+        spec['options'] = options
+    with open(spec_path, 'w', encoding='utf-8') as f:
+        json.dump(spec, f, ensure_ascii=False, indent=2)
+    print(f"快速模型配置已保存: {spec_path}")
+    return spec_path
+
+
+def export_onnx(model_path: str, mode: str) -> str:
+    output = f"{base_path(model_path)}.{mode}.onnx"
+    if mode == 'int8':
+        from onnxruntime.quantization import QuantType, quantize_dynamic
+        quantize_dynamic(model_path, output, weight_type=QuantType.QInt8)
+    elif mode == 'fp16':
+        import onnx
+        from onnxconverter_common import float16
+        model = onnx.load(model_path)
+        onnx.save(float16.convert_float_to_float16(model, keep_io_types=True), output)
+    else:
+        raise ValueError(f"ONNX 模型不支持模式: {mode}")
+    print(f"快速模型已保存: {output}")
+    return output
+
+
+def check_onnx(model_path: str, fast_path: str, X: np.ndarray) -> np.ndarray:
+    import onnxruntime as ort
+    outputs = []
+    for path in (model_path, fast_path):
+        session = ort.InferenceSession(path)
+        name = session.get_inputs()[0].name
+        # 逐条推理：与上位机一致，兼容批维度固定为 1 的模型
+        values = [np.asarray(session.run(None, {name: row[np.newaxis, :]})[0]).reshape(-1)[0] for row in X]
+        outputs.append(np.asarray(values, dtype=np.float64))
+    return np.abs(outputs[1] - outputs[0])
+
+
+def check_jit(model_path: str, mode: str, optimize: bool, X: np.ndarray) -> np.ndarray:
+    import torch
+    dtype = {'fp32': torch.float32, 'fp16': torch.float16, 'bf16': torch.bfloat16}[mode]
+    inputs = torch.from_numpy(X)
+    with torch.no_grad():
+        baseline = torch.jit.load(model_path).eval()
+        expected = baseline(inputs).float().reshape(-1)
+        fast = torch.jit.load(model_path).eval().to(dtype)
+        if optimize:
+            fast = torch.jit.optimize_for_inference(torch.jit.freeze(fast))
+        actual = fast(inputs.to(dtype)).float().reshape(-1)
+    return (actual - expected).abs().double().numpy()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='导出快速模型并生成精度守卫配置')
+    parser.add_argument('model', help='原（float32）模型：.onnx 或 .jit')
+    parser.add_argument('--mode', choices=['int8', 'fp16', 'bf16', 'fp32'], required=True,
+                        help='ONNX：int8 / fp16；TorchScript：fp16 / bf16 / fp32（配合 --optimize）')
+    parser.add_argument('--optimize', action='store_true', help='TorchScript：加载时冻结并做推理优化')
+    parser.add_argument('--reference', required=True, help='参考集 CSV（每行一条光谱）')
+    parser.add_argument('--max-abs-error', type=float, default=0.5, help='允许的最大绝对误差')
+    parser.add_argument('--max-mean-abs-error', type=float, default=0.0, help='允许的平均绝对误差（0 表示不检查）')
+    args = parser.parse_args()
+
+    X = np.loadtxt(args.reference, delimiter=',', dtype=np.float32, ndmin=2)
+
+    if args.model.endswith('.onnx'):
+        fast_model = export_onnx(args.model, args.mode)
+        options = None
+        errors = check_onnx(args.model, fast_model, X)
+    elif args.model.endswith('.jit') or args.model.endswith('.pt'):
+        if args.mode == 'int8':
+            print("TorchScript 模型无法离线量化，请在 pytorch_predictor/spectrum_predictor.py 中使用 --export-int8")
+            return 1
+        fast_model = args.model
+        options = {'precision': {'fp32': 'float32', 'fp16': 'float16', 'bf16': 'bfloat16'}[args.mode],
+                   'optimizeForInference': bool(args.optimize)}
+        errors = check_jit(args.model, args.mode, args.optimize, X)
+    else:
+        print(f"不支持的模型格式: {args.model}")
+        return 1
+
+    print(f"参考集 {len(errors)} 条：最大绝对误差 {errors.max():.6g}，平均绝对误差 {errors.mean():.6g}")
+    if errors.max() > args.max_abs_error:
+        print("警告: 误差超出容差，上位机将拒绝该快速模型")
+    write_fast_spec(args.model, fast_model, args.reference, args.max_abs_error, args.max_mean_abs_error, options)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -265,6 +265,26 @@ class SpectrumPredictor:
         print(f"模型已保存为 JIT 格式: {filepath}")
         print(f"注意：导出的 JIT 模型是 CPU 兼容的，可以在任何设备上加载使用")
     
+    def save_int8_jit_model(self, filepath: str):
+        """
+        保存 int8 动态量化的 JIT 模型（Linear 层权重量化为 int8，激活在运行时量化）
+        
+        上位机在 ARM 上使用 QNNPACK 后端运行，加载前会在参考集上与 float32 模型比较误差
+        """
+        if not self.is_trained:
+            raise ValueError("模型尚未训练")
+        
+        original_device = next(self.model.parameters()).device
+        model = self.model.cpu().eval()
+        if 'qnnpack' in torch.backends.quantized.supported_engines:
+            torch.backends.quantized.engine = 'qnnpack'
+        quantized = torch.ao.quantization.quantize_dynamic(model, {nn.Linear}, dtype=torch.qint8)
+        example_input = torch.FloatTensor(self.scaler.transform(np.zeros((1, self.input_size))))
+        torch.jit.trace(quantized, example_input).save(filepath)
+        if original_device.type == 'cuda':
+            self.model = self.model.to(original_device)
+        print(f"int8 量化模型已保存为 JIT 格式: {filepath}")
+    
     def predict(self, X: np.ndarray) -> np.ndarray:
         """
         预测
@@ -297,6 +317,9 @@ def main():
     parser.add_argument('--lr', type=float, default=0.001, help='学习率')
     parser.add_argument('--n-samples', type=int, default=10000, help='训练样本数')
     parser.add_argument('--output', type=str, default='spectrum_model.jit', help='输出模型文件名')
+    parser.add_argument('--export-int8', action='store_true',
+                        help='同时导出 int8 量化模型、参考集与 .fast.json（上位机按精度守卫决定是否采用）')
+    parser.add_argument('--fast-max-abs-error', type=float, default=0.5, help='int8 模型允许的最大绝对误差')
     
     args = parser.parse_args()
     
@@ -327,6 +350,17 @@ def main():
     output_path = os.path.join(os.path.dirname(__file__), args.output)
     predictor.save_jit_model(output_path)
     
+    if args.export_int8:
+        sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+        from export_fast_model import base_path, write_fast_spec, write_reference_csv
+        base = base_path(output_path)
+        int8_path = base + '.int8.jit'
+        reference_path = base + '.reference.csv'
+        predictor.save_int8_jit_model(int8_path)
+        # 参考集取自测试集，与上位机推理时的输入形式相同
+        write_reference_csv(reference_path, X_test)
+        write_fast_spec(output_path, int8_path, reference_path, args.fast_max_abs_error)
+    
     print(f"\n训练完成！模型已保存到: {output_path}")
     print(f"模型评估指标: R2={metrics['R2']:.4f}, RMSE={metrics['RMSE']:.4f}")
 
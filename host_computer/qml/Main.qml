@@ -131,6 +131,13 @@ ApplicationWindow {
     }
 
     Component.onCompleted: {
+        // 从标定缓存恢复的黑白参考视为已获取
+        if (udpComm.blackReference.length > 0) {
+            blackReferenceData = udpComm.blackReference
+        }
+        if (udpComm.whiteReference.length > 0) {
+            whiteReferenceData = udpComm.whiteReference
+        }
         // 初始化时延迟调整窗口大小
         Qt.callLater(function() {
             if (root.visibility !== Window.Maximized) {
@@ -215,7 +222,7 @@ ApplicationWindow {
                     anchors.fill: parent
                     anchors.margins: 8
                     clip: true
-                    model: logManager.entries
+                    model: logManager.model
 
                     delegate: ColumnLayout {
                         width: ListView.view.width
@@ -226,7 +233,7 @@ ApplicationWindow {
                             spacing: 8
 
                             Label {
-                                text: modelData.timestamp
+                                text: model.timestamp
                                 color: "#7f8c8d"
                                 font.pixelSize: 11
                                 Layout.preferredWidth: 160
@@ -234,16 +241,16 @@ ApplicationWindow {
 
                             Rectangle {
                                 radius: 4
-                                color: modelData.level === "ERROR" || modelData.level === "FATAL"
+                                color: model.level === "ERROR" || model.level === "FATAL"
                                        ? "#e74c3c"
-                                       : (modelData.level === "WARN" ? "#f39c12"
-                                                                     : (modelData.level === "INFO" ? "#3498db" : "#95a5a6"))
+                                       : (model.level === "WARN" ? "#f39c12"
+                                                                 : (model.level === "INFO" ? "#3498db" : "#95a5a6"))
                                 Layout.preferredWidth: 52
                                 Layout.alignment: Qt.AlignVCenter
 
                                 Label {
                                     anchors.centerIn: parent
-                                    text: modelData.level
+                                    text: model.level
                                     color: "#ffffff"
                                     font.pixelSize: 10
                                     font.bold: true
@@ -251,7 +258,7 @@ ApplicationWindow {
                             }
 
                             Label {
-                                text: modelData.message
+                                text: model.message
                                 color: "#2c3e50"
                                 font.pixelSize: 11
                                 wrapMode: Text.Wrap
@@ -282,7 +289,7 @@ ApplicationWindow {
     Window {
         id: systemMonitorWindow
         width: 500
-        height: 320
+        height: 560
         minimumWidth: 420
         minimumHeight: 260
         title: "系统监控"
@@ -517,6 +524,68 @@ ApplicationWindow {
                         }
                     }
 
+                    // 本进程
+                    RowLayout {
+                        Layout.fillWidth: true
+                        spacing: 8
+                        Label {
+                            text: "本进程:"
+                            color: "#555555"
+                            Layout.preferredWidth: 100
+                        }
+                        Label {
+                            text: "CPU " + systemMonitor.processCpuUsage.toFixed(1) + " %  内存 "
+                                  + systemMonitor.processRssMb.toFixed(1) + " MB  切换 "
+                                  + systemMonitor.voluntarySwitchesPerSecond.toFixed(0) + " / "
+                                  + systemMonitor.involuntarySwitchesPerSecond.toFixed(0) + " 次/秒  UDP 队列 "
+                                  + (systemMonitor.udpReceiveQueueBytes / 1024).toFixed(1) + " KB"
+                            color: "#2c3e50"
+                            font.pixelSize: 13
+                            Layout.fillWidth: true
+                        }
+                    }
+
+                    // 逐线程 CPU（单核百分比，取占用最高的若干线程）
+                    Label {
+                        text: "线程 CPU（单核 %）:"
+                        color: "#555555"
+                    }
+                    Repeater {
+                        model: systemMonitor.threadStats.slice(0, 8)
+                        delegate: RowLayout {
+                            Layout.fillWidth: true
+                            spacing: 8
+                            Label {
+                                text: modelData.name + " (" + modelData.tid + ")"
+                                color: "#2c3e50"
+                                font.pixelSize: 12
+                                elide: Text.ElideRight
+                                Layout.preferredWidth: 180
+                            }
+                            Label {
+                                text: modelData.cpu.toFixed(1) + " %"
+                                color: "#2c3e50"
+                                font.pixelSize: 12
+                                Layout.preferredWidth: 60
+                                horizontalAlignment: Text.AlignRight
+                            }
+                            Rectangle {
+                                Layout.fillWidth: true
+                                height: 8
+                                radius: 4
+                                color: "#ecf0f1"
+
+                                Rectangle {
+                                    anchors.verticalCenter: parent.verticalCenter
+                                    height: parent.height
+                                    width: Math.max(2, parent.width * Math.min(100, modelData.cpu) / 100.0)
+                                    radius: 4
+                                    color: modelData.cpu < 60 ? "#2ecc71" : (modelData.cpu < 85 ? "#f1c40f" : "#e74c3c")
+                                }
+                            }
+                        }
+                    }
+
                     Item { Layout.fillHeight: true }
                 }
             }
@@ -1252,7 +1321,7 @@ ApplicationWindow {
                         }
                         Label {
                             id: blackReferenceProgressLabel
-                            text: blackReferenceData !== null ? "已经成功获取" : (udpComm.blackReferenceProgress.toString() + " / 39500")
+                            text: blackReferenceData !== null ? "已经成功获取" : (udpComm.blackReferenceProgress.toString() + " / " + udpComm.referenceThreshold)
                             color: blackReferenceData !== null ? "#27ae60" : (udpComm.blackReferenceAccumulating ? "#3498db" : "#7f8c8d")
                             font.bold: blackReferenceData !== null || udpComm.blackReferenceAccumulating
                             font.pixelSize: 12
@@ -1310,13 +1379,23 @@ ApplicationWindow {
                         }
                         Label {
                             id: whiteReferenceProgressLabel
-                            text: whiteReferenceData !== null ? "已经成功获取" : (udpComm.whiteReferenceProgress.toString() + " / 39500")
+                            text: whiteReferenceData !== null ? "已经成功获取" : (udpComm.whiteReferenceProgress.toString() + " / " + udpComm.referenceThreshold)
                             color: whiteReferenceData !== null ? "#27ae60" : (udpComm.whiteReferenceAccumulating ? "#3498db" : "#7f8c8d")
                             font.bold: whiteReferenceData !== null || udpComm.whiteReferenceAccumulating
                             font.pixelSize: 12
                             Layout.fillWidth: true
                         }
                     }
+
+                    Label {
+                        visible: udpComm.calibrationFromCache
+                        text: (udpComm.calibrationStale ? "标定缓存已过期，请重新采集（采集于 " : "使用缓存的标定（采集于 ") +
+                              udpComm.calibrationCapturedAt + "）"
+                        color: udpComm.calibrationStale ? "#e74c3c" : "#7f8c8d"
+                        font.pixelSize: 11
+                        Layout.fillWidth: true
+                        wrapMode: Text.WordWrap
+                    }
                 }
             }
 
@@ -1503,25 +1582,14 @@ ApplicationWindow {
                                 predictorStatusLabel.text = "正在加载模型: " + modelPath
                                 predictorStatusLabel.color = "#0066cc"
                                 
-                                // 延迟加载，确保界面更新
-                                Qt.callLater(function() {
-                                    const success = predictorManager.loadModelAuto(currentIndex)
-                                    if (success) {
-                                        predictorStatusLabel.text = "✓ 模型自动加载成功"
-                                        predictorStatusLabel.color = "#006600"
-                                        
-                                        // 如果之前有预测器在运行，自动启用新的预测器
-                                        if (wasPredicting && success) {
-                                            udpComm.setPredictorIndex(currentIndex)
-                                            currentPredictorIndex = currentIndex
-                                            predictionResultLabel.text = "预测已切换到新算法，等待数据..."
-                                            predictionResultLabel.color = "#0066cc"
-                                        }
-                                    } else {
-                                        predictorStatusLabel.text = "✗ 模型自动加载失败: " + modelPath
-                                        predictorStatusLabel.color = "#cc0000"
-                                    }
-                                })
+                                // 后台加载并预热模型，完成后在 onModelLoaded 中更新状态（采集与推理不暂停）
+                                // 如果之前有预测器在运行，加载成功后自动启用新的预测器
+                                autoEnablePredictorIndex = wasPredicting ? currentIndex : -1
+                                if (!predictorManager.loadModelAutoAsync(currentIndex)) {
+                                    autoEnablePredictorIndex = -1
+                                    predictorStatusLabel.text = "✗ 模型正在加载中，请稍候再试"
+                                    predictorStatusLabel.color = "#cc0000"
+                                }
                             } else {
                                 predictorStatusLabel.text = "✗ 无法找到默认模型路径"
                                 predictorStatusLabel.color = "#cc0000"
@@ -1682,12 +1750,41 @@ ApplicationWindow {
                         Layout.fillHeight: true
                         spacing: 4
 
-                        Label {
-                            text: "光谱曲线 (每3950条数据更新一次)"
-                            font.bold: true
-                            color: "#34495e"
-                            font.pixelSize: 12
+                        RowLayout {
                             Layout.fillWidth: true
+                            spacing: 8
+
+                            Label {
+                                text: udpComm.averagingMode === 1
+                                      ? "光谱曲线 (最近" + udpComm.spectrumThreshold + "条滑动平均，每" + udpComm.outputInterval + "条数据更新一次)"
+                                      : udpComm.averagingMode === 2
+                                        ? "光谱曲线 (指数平均 τ=" + udpComm.emaTimeConstant + "条，每" + udpComm.outputInterval + "条数据更新一次)"
+                                        : udpComm.averagingMode === 3
+                                          ? "光谱曲线 (自适应 目标SNR " + udpComm.adaptiveTargetSnr + "，本条" + spectrumPacketCount + "条，SNR " + spectrumAchievedSnr.toFixed(0) + ")"
+                                          : "光谱曲线 (每" + udpComm.spectrumThreshold + "条数据更新一次)"
+                                font.bold: true
+                                color: "#34495e"
+                                font.pixelSize: 12
+                                Layout.fillWidth: true
+                            }
+
+                            ComboBox {
+                                id: averagingModeCombo
+                                model: ["分块平均", "滑动窗口", "指数平均", "自适应"]
+                                currentIndex: udpComm.averagingMode
+                                font.pixelSize: 11
+                                Layout.preferredWidth: 100
+                                Layout.preferredHeight: 24
+                                onActivated: udpComm.averagingMode = currentIndex
+                            }
+
+                            CheckBox {
+                                text: "实时帧"
+                                checked: udpComm.displayFeed.liveFrameEnabled
+                                font.pixelSize: 11
+                                Layout.preferredHeight: 24
+                                onToggled: udpComm.displayFeed.liveFrameEnabled = checked
+                            }
                         }
 
                         Rectangle {
@@ -1703,24 +1800,40 @@ ApplicationWindow {
                                 id: spectrumCanvas
                                 anchors.fill: parent
 
+                                // 显示数据源按绘图区宽度抽取（与下方 leftMargin + rightMargin 保持一致）
+                                function updatePlotWidth() {
+                                    udpComm.displayFeed.plotWidth = Math.max(2, Math.round(width - 95))
+                                }
+                                onWidthChanged: updatePlotWidth()
+                                Component.onCompleted: updatePlotWidth()
+
+                                // 显示数据源每个显示周期最多通知一次，与光谱输出频率无关
+                                Connections {
+                                    target: udpComm.displayFeed
+                                    function onSpectrumUpdated() { spectrumCanvas.requestPaint() }
+                                    function onLiveFrameUpdated() { spectrumCanvas.requestPaint() }
+                                }
+
                                 onPaint: {
                                     var ctx = getContext("2d")
                                     ctx.clearRect(0, 0, width, height)
-                                    
-                                    if (!spectrumData || spectrumData.length === 0) {
+
+                                    var feed = udpComm.displayFeed
+                                    // 抽取后的光谱：每列一对 [最小值, 最大值]
+                                    var envelope = feed.spectrumEnvelope
+                                    var columns = envelope ? envelope.byteLength / 8 : 0
+                                    if (columns === 0) {
                                         ctx.fillStyle = "#95a5a6"
                                         ctx.font = "13px sans-serif"
                                         ctx.textAlign = "center"
                                         ctx.fillText("等待数据...", width / 2, height / 2)
                                         return
                                     }
-
-                                    var dataPoints = spectrumData.length
-                                    if (dataPoints === 0) return
+                                    var points = new Float32Array(envelope)
 
                                     // 使用后台线程处理好的数据
-                                    var minVal = spectrumMinVal
-                                    var maxVal = spectrumMaxVal
+                                    var minVal = feed.spectrumMin
+                                    var maxVal = feed.spectrumMax
                                     var range = maxVal - minVal
                                     if (range === 0) range = 1  // 避免除零
 
@@ -1836,23 +1949,52 @@ ApplicationWindow {
                                     ctx.fillText("强度值", 0, 0)
                                     ctx.restore()
 
-                                    // 绘制曲线
+                                    // 实时原始帧（按自身的最小/最大值缩放，作为浅色背景曲线）
+                                    var liveEnvelope = feed.liveFrameEnabled ? feed.liveEnvelope : null
+                                    var liveColumns = liveEnvelope ? liveEnvelope.byteLength / 8 : 0
+                                    if (liveColumns > 1) {
+                                        var livePoints = new Float32Array(liveEnvelope)
+                                        var liveRange = feed.liveMax - feed.liveMin
+                                        if (liveRange === 0) liveRange = 1
+                                        var liveStepX = plotWidth / (liveColumns - 1)
+                                        ctx.strokeStyle = "#c8d6e5"
+                                        ctx.lineWidth = 1
+                                        ctx.beginPath()
+                                        for (var c = 0; c < liveColumns; c++) {
+                                            var lx = plotLeft + c * liveStepX
+                                            var ly0 = plotBottom - (livePoints[2 * c] - feed.liveMin) / liveRange * plotHeight
+                                            var ly1 = plotBottom - (livePoints[2 * c + 1] - feed.liveMin) / liveRange * plotHeight
+                                            if (c === 0) {
+                                                ctx.moveTo(lx, ly0)
+                                            } else {
+                                                ctx.lineTo(lx, ly0)
+                                            }
+                                            if (ly1 !== ly0) {
+                                                ctx.lineTo(lx, ly1)
+                                            }
+                                        }
+                                        ctx.stroke()
+                                    }
+
+                                    // 绘制曲线：每个像素列从该列最小值画到最大值，保留窄峰
                                     ctx.strokeStyle = "#0066cc"
                                     ctx.lineWidth = 2
                                     ctx.beginPath()
                                     
-                                    var stepX = plotWidth / (dataPoints - 1)
-                                    for (var i = 0; i < dataPoints; i++) {
+                                    var stepX = columns > 1 ? plotWidth / (columns - 1) : 0
+                                    for (var i = 0; i < columns; i++) {
                                         var x = plotLeft + i * stepX
-                                        var value = spectrumData[i]
                                         // 归一化到0-plotHeight范围，并翻转Y轴（因为Canvas的Y轴向下）
-                                        var normalized = (value - minVal) / range
-                                        var y = plotBottom - normalized * plotHeight
+                                        var y0 = plotBottom - (points[2 * i] - minVal) / range * plotHeight
+                                        var y1 = plotBottom - (points[2 * i + 1] - minVal) / range * plotHeight
                                         
                                         if (i === 0) {
-                                            ctx.moveTo(x, y)
+                                            ctx.moveTo(x, y0)
                                         } else {
-                                            ctx.lineTo(x, y)
+                                            ctx.lineTo(x, y0)
+                                        }
+                                        if (y1 !== y0) {
+                                            ctx.lineTo(x, y1)
                                         }
                                     }
                                     ctx.stroke()
@@ -1863,7 +2005,7 @@ ApplicationWindow {
                                     ctx.textAlign = "left"
                                     ctx.fillText("最小值: " + minVal.toFixed(0), plotLeft + 5, plotTop + 15)
                                     ctx.fillText("最大值: " + maxVal.toFixed(0), plotLeft + 5, plotTop + 30)
-                                    ctx.fillText("数据包数: " + spectrumPacketCount, plotLeft + 5, plotTop + 45)
+                                    ctx.fillText("数据包数: " + feed.spectrumPacketCount, plotLeft + 5, plotTop + 45)
                                     ctx.fillText("SNR: " + currentSpectrumSnr.toFixed(2), plotLeft + 5, plotTop + 60)
 
                                     // 如果光谱信噪比过低且已启用自检，在图上给出明显警告
@@ -2335,7 +2477,118 @@ ApplicationWindow {
                                 color: "#555555"
                                 font.pixelSize: 12
                             }
+                            Label {
+                                text: "|"
+                                color: "#cccccc"
+                            }
+                            Label {
+                                text: "丢弃:"
+                                color: "#555555"
+                                font.pixelSize: 12
+                            }
+                            Label {
+                                id: droppedLabel
+                                text: udpComm.droppedFrames.toString()
+                                color: udpComm.droppedFrames > 0 ? "#cc0000" : "#555555"
+                                font.bold: true
+                                font.pixelSize: 13
+                                horizontalAlignment: Text.AlignRight
+                            }
+                            Item { Layout.fillWidth: true }
+                        }
+
+                        // 链路质量（丢帧、乱序、短包、内核丢包与到达间隔抖动）
+                        RowLayout {
+                            spacing: 8
+                            Label {
+                                text: "链路质量:"
+                                color: "#555555"
+                                font.pixelSize: 12
+                                Layout.preferredWidth: 80
+                            }
+                            Label {
+                                text: "丢帧 " + udpComm.lostFrames + "  乱序 " + udpComm.reorderedPackets
+                                      + "  短包 " + udpComm.runtPackets + "  内核丢包 " + udpComm.kernelDrops
+                                color: (udpComm.lostFrames + udpComm.kernelDrops + udpComm.runtPackets) > 0
+                                       ? "#cc0000" : "#555555"
+                                font.pixelSize: 12
+                            }
+                            Label {
+                                text: udpComm.framePeriodUs > 0
+                                      ? ("|  帧周期 " + udpComm.framePeriodUs.toFixed(1) + " us  抖动 "
+                                         + udpComm.jitterUs.toFixed(1) + " us")
+                                      : ""
+                                color: "#555555"
+                                font.pixelSize: 12
+                            }
                             Item { Layout.fillWidth: true }
+                            CheckBox {
+                                text: "帧计数"
+                                checked: udpComm.frameCounterTrailer
+                                font.pixelSize: 11
+                                onToggled: udpComm.frameCounterTrailer = checked
+                            }
+                        }
+
+                        // 流水线延迟（数据报到达 → 预测结果送达，各阶段 p50 / p99）
+                        RowLayout {
+                            spacing: 8
+                            Label {
+                                text: "流水线延迟:"
+                                color: "#555555"
+                                font.pixelSize: 12
+                                Layout.preferredWidth: 80
+                            }
+                            Label {
+                                function stageText(name, label) {
+                                    var stages = pipelineStats.stages
+                                    for (var i = 0; i < stages.length; i++) {
+                                        if (stages[i].name === name && stages[i].count > 0) {
+                                            return label + " " + stages[i].p50Us.toFixed(0) + "/" + stages[i].p99Us.toFixed(0) + " us"
+                                        }
+                                    }
+                                    return label + " -"
+                                }
+                                text: stageText("receive", "接收") + "  " + stageText("handoff", "交接") + "  "
+                                      + stageText("preprocess", "预处理") + "  " + stageText("inference", "推理") + "  " + stageText("delivery", "送达") + "  "
+                                      + stageText("end_to_end", "端到端")
+                                color: "#555555"
+                                font.pixelSize: 12
+                                elide: Text.ElideRight
+                                Layout.fillWidth: true
+                            }
+                            CheckBox {
+                                text: "跟踪" + (pipelineStats.tracing ? " (" + pipelineStats.traceEventCount + ")" : "")
+                                checked: pipelineStats.tracing
+                                font.pixelSize: 11
+                                onToggled: pipelineStats.tracing = checked
+                            }
+                            Button {
+                                text: "导出跟踪"
+                                font.pixelSize: 11
+                                enabled: pipelineStats.traceEventCount > 0
+                                onClicked: traceFileDialog.open()
+                            }
+                            Button {
+                                text: "清零"
+                                font.pixelSize: 11
+                                onClicked: pipelineStats.reset()
+                            }
+
+                            FileDialog {
+                                id: traceFileDialog
+                                title: "导出流水线跟踪（chrome://tracing / Perfetto）"
+                                fileMode: FileDialog.SaveFile
+                                nameFilters: [ "Chrome trace (*.json)", "所有文件 (*)" ]
+                                onAccepted: {
+                                    var urlStr = traceFileDialog.selectedFile.toString()
+                                    var path = urlStr
+                                    if (urlStr.startsWith("file://")) {
+                                        path = urlStr.substring(7)
+                                    }
+                                    pipelineStats.dumpChromeTrace(path)
+                                }
+                            }
                         }
                         
                         // UDP数据包信息
@@ -2356,6 +2609,110 @@ ApplicationWindow {
                                 Layout.fillWidth: true
                             }
                         }
+
+                        // 原始帧录制（离线训练数据采集）
+                        RowLayout {
+                            spacing: 8
+                            Label {
+                                text: "原始帧录制:"
+                                color: "#555555"
+                                font.pixelSize: 12
+                                Layout.preferredWidth: 80
+                            }
+                            Button {
+                                text: udpComm.recording ? "停止录制" : "开始录制"
+                                Layout.preferredWidth: 80
+                                background: Rectangle {
+                                    color: udpComm.recording
+                                           ? (parent.pressed ? "#c0392b" : "#e74c3c")
+                                           : (parent.pressed ? "#95a5a6" : (parent.hovered ? "#bdc3c7" : "#ecf0f1"))
+                                    radius: 6
+                                    border.color: udpComm.recording ? "#c0392b" : "#bdc3c7"
+                                    border.width: 1
+                                }
+                                contentItem: Text {
+                                    text: parent.text
+                                    color: udpComm.recording ? "#ffffff" : "#2c3e50"
+                                    horizontalAlignment: Text.AlignHCenter
+                                    verticalAlignment: Text.AlignVCenter
+                                    font.pixelSize: 12
+                                }
+                                onClicked: {
+                                    if (udpComm.recording) {
+                                        udpComm.stopRecording()
+                                    } else {
+                                        udpComm.startRecording("record/raw_" + Qt.formatDateTime(new Date(), "yyyyMMdd_hhmmss"))
+                                    }
+                                }
+                            }
+                            Label {
+                                text: udpComm.recording
+                                      ? ("已录制 " + udpComm.recordedFrames + " 帧，丢弃 " + udpComm.recordingDroppedFrames
+                                         + " 帧  " + udpComm.recordingFile)
+                                      : "未录制"
+                                color: udpComm.recordingDroppedFrames > 0 ? "#cc0000" : "#666666"
+                                elide: Text.ElideMiddle
+                                font.pixelSize: 12
+                                Layout.fillWidth: true
+                            }
+                        }
+
+                        // 录制回放（无光谱仪时调参与吞吐测试）
+                        RowLayout {
+                            spacing: 8
+                            Label {
+                                text: "录制回放:"
+                                color: "#555555"
+                                font.pixelSize: 12
+                                Layout.preferredWidth: 80
+                            }
+                            ComboBox {
+                                id: replaySpeedBox
+                                model: [ "1x", "10x", "100x", "不限速" ]
+                                enabled: !udpComm.replaying
+                                Layout.preferredWidth: 90
+                                // 0 表示不限速
+                                function speed() {
+                                    return [ 1, 10, 100, 0 ][currentIndex]
+                                }
+                            }
+                            Button {
+                                text: udpComm.replaying ? "停止回放" : "选择文件回放"
+                                enabled: udpComm.replaying || !udpComm.receiving
+                                Layout.preferredWidth: 100
+                                onClicked: {
+                                    if (udpComm.replaying) {
+                                        udpComm.stopReplay()
+                                    } else {
+                                        replayFileDialog.open()
+                                    }
+                                }
+                            }
+                            Label {
+                                text: udpComm.receiving
+                                      ? ("处理 " + udpComm.processedFramesPerSecond + " 帧/s，预测 "
+                                         + udpComm.predictionsPerSecond + " 次/s")
+                                      : ""
+                                color: "#666666"
+                                font.pixelSize: 12
+                                Layout.fillWidth: true
+                            }
+
+                            FileDialog {
+                                id: replayFileDialog
+                                title: "选择要回放的原始帧录制或 CSV 表格"
+                                fileMode: FileDialog.OpenFile
+                                nameFilters: [ "原始帧录制 (*.sfr)", "CSV 文件 (*.csv)", "所有文件 (*)" ]
+                                onAccepted: {
+                                    var urlStr = replayFileDialog.selectedFile.toString()
+                                    var path = urlStr
+                                    if (urlStr.startsWith("file://")) {
+                                        path = urlStr.substring(7)
+                                    }
+                                    udpComm.startReplay(path, replaySpeedBox.speed(), false)
+                                }
+                            }
+                        }
                     }
                 }
             }
@@ -2443,24 +2800,25 @@ ApplicationWindow {
             logManager.logInfo("UDP", message)
         }
 
-        function onPacketReceived(data) {
+        function onPacketReceived(dataLength) {
             // 使用Timer延迟更新，避免高频更新导致界面卡顿
             if (!updateTimer.running) {
                 updateTimer.start()
             }
             // 保存最新的数据包信息
             lastPacketInfo = {
-                dataLength: data.length
+                dataLength: dataLength
             }
         }
 
-        function onSpectrumReady(averagedSpectrum, minVal, maxVal, packetCount) {
+        function onSpectrumReady(averagedSpectrum, minVal, maxVal, packetCount, snr) {
             // 接收到后台线程处理好的光谱数据，更新显示（在主线程中执行，不阻塞）
             console.log("onSpectrumReady - 数据大小:", averagedSpectrum ? averagedSpectrum.length : 0, "minVal:", minVal, "maxVal:", maxVal)
             spectrumData = averagedSpectrum
             spectrumMinVal = minVal
             spectrumMaxVal = maxVal
             spectrumPacketCount = packetCount
+            spectrumAchievedSnr = snr || 0
 
             // 计算当前平均光谱的简单信噪比：峰峰值 / 标准差
             if (averagedSpectrum && averagedSpectrum.length > 0) {
@@ -2496,9 +2854,7 @@ ApplicationWindow {
                 currentSpectrumSnr = 0
                 spectrumSnrWarning = false
             }
-            // 强制刷新图表
-            spectrumCanvas.requestPaint()
-            // 同步刷新预测结果曲线
+            // 光谱曲线由 displayFeed 按显示帧率刷新，这里只刷新预测结果曲线
             predictionCanvas.requestPaint()
 
             // 如果单次采集窗口处于等待状态，则记录（或跳过）光谱
@@ -2514,33 +2870,10 @@ ApplicationWindow {
                     // 第 2 条光谱：真正记录这一条，然后结束本次等待
                     singleCaptureWaiting = false
 
-                    // 复制一份当前光谱数据，作为这一条记录的独立数据
-                    var spectrumCopy = []
-                    if (averagedSpectrum && averagedSpectrum.length) {
-                        for (var i = 0; i < averagedSpectrum.length; ++i) {
-                            spectrumCopy.push(averagedSpectrum[i])
-                        }
-                    }
-
-                    // 更新矩阵列数（取第一次采集的长度为标准）
-                    if (singleSpectrumLength === 0 && spectrumCopy.length > 0) {
-                        singleSpectrumLength = spectrumCopy.length
-                    }
-
-                    var recordIndex = singleSpectrumRecords.length
-                    singleSpectrumRecords.push({
-                        time: new Date(),
-                        index: recordIndex + 1,
-                        spectrum: spectrumCopy,
-                        length: spectrumCopy.length,
-                        minVal: minVal,
-                        maxVal: maxVal,
-                        label: singleSpectrumLabelInput.text,
-                        moisture: Number(singleSpectrumMoistureInput.text)
-                    })
-
-                    // 显式增加计数，触发界面中所有 model 重新计算
-                    singleSpectrumRecordCount = singleSpectrumRecordCount + 1
+                    // 光谱复制进记录存储（超过内存上限的旧记录会溢出到磁盘）
+                    var recordIndex = spectrumRecords.append(averagedSpectrum,
+                                                             singleSpectrumLabelInput.text,
+                                                             Number(singleSpectrumMoistureInput.text))
 
                     singleSpectrumStatusLabel.text = "已成功采集到第 " + (recordIndex + 1) + " 条光谱数据（本次采集使用的是第 2 条光谱）"
                     singleSpectrumStatusLabel.color = "#006600"
@@ -2669,14 +3002,30 @@ ApplicationWindow {
         function onModelLoaded(index, success) {
             // 如果加载的是当前选中的预测器，更新界面状态
             if (index === predictorComboBox.currentIndex) {
-                currentModelLoaded = success
-                if (success) {
+                currentModelLoaded = predictorManager.isModelLoaded(index)
+                if (currentModelLoaded) {
                     modelLoadedLabel.text = "模型已加载"
                     modelLoadedLabel.color = "#006600"
                 } else {
                     modelLoadedLabel.text = "模型未加载"
                     modelLoadedLabel.color = "#cc0000"
                 }
+                if (success) {
+                    predictorStatusLabel.text = "✓ 模型加载成功"
+                    predictorStatusLabel.color = "#006600"
+                } else {
+                    predictorStatusLabel.text = "✗ 模型加载失败: " + predictorManager.getDefaultModelPath(index)
+                    predictorStatusLabel.color = "#cc0000"
+                }
+                if (success && autoEnablePredictorIndex === index) {
+                    udpComm.setPredictorIndex(index)
+                    currentPredictorIndex = index
+                    predictionResultLabel.text = "预测已切换到新算法，等待数据..."
+                    predictionResultLabel.color = "#0066cc"
+                }
+            }
+            if (autoEnablePredictorIndex === index) {
+                autoEnablePredictorIndex = -1
             }
         }
     }
@@ -2696,6 +3045,7 @@ ApplicationWindow {
     property double spectrumMinVal: 0
     property double spectrumMaxVal: 0
     property int spectrumPacketCount: 0
+    property double spectrumAchievedSnr: 0  // 自适应平均实际达到的中位数信噪比（其它模式为 0）
     property var blackReferenceData: null  // 存储黑参考数据
     property double blackReferenceMinVal: 0
     property double blackReferenceMaxVal: 0
@@ -2704,6 +3054,7 @@ ApplicationWindow {
     property double whiteReferenceMaxVal: 0
     property int currentPredictorIndex: -1  // 当前使用的预测器索引（-1表示未启用）
     property bool currentModelLoaded: false  // 当前选中预测器的模型加载状态
+    property int autoEnablePredictorIndex: -1  // 后台加载完成后需要自动启用的预测器（-1 表示不自动启用）
     property var predictionHistory: []  // 存储预测结果历史（最多10个）
 
     // 光谱波长范围（例如 1000~1600nm, 共1024个点）
@@ -2714,6 +3065,14 @@ ApplicationWindow {
     property bool predictionMonitorEnabled: false
     property double predictionLowerLimit: 0.0
     property double predictionUpperLimit: 0.0
+    // 网络发布的预测状态与界面的异常监控保持一致（上下限无效时按未启用处理）
+    function syncPublisherMonitorLimits() {
+        resultPublisher.setMonitorLimits(predictionMonitorEnabled && predictionUpperLimit > predictionLowerLimit,
+                                         predictionLowerLimit, predictionUpperLimit)
+    }
+    onPredictionMonitorEnabledChanged: syncPublisherMonitorLimits()
+    onPredictionLowerLimitChanged: syncPublisherMonitorLimits()
+    onPredictionUpperLimitChanged: syncPublisherMonitorLimits()
 
     // 光谱异常自检（信噪比监控）
     property bool spectrumSnrMonitorEnabled: false
@@ -2730,18 +3089,13 @@ ApplicationWindow {
 
     // 单次光谱采集相关属性
     property bool singleCaptureWaiting: false          // 是否正在等待一条新的光谱
-    // 每条记录包含: time（时间）、index（第几次）、spectrum（该次完整光谱数据数组）
-    property var singleSpectrumRecords: []
-    // 单次采集的光谱长度（列数），用于构建“索引 + 多条光谱”的矩阵表
-    property int singleSpectrumLength: 0
-    // 已采集的单次光谱条数（专门用于刷新界面）
-    property int singleSpectrumRecordCount: 0
+    // 已采集的记录保存在 spectrumRecords（SpectrumRecordStore）中，列表只显示元数据，光谱按需读取
     // 当前这次“单次采集”已经接收到的光谱条数（用于跳过第一条，记录第二条）
     property int singleCaptureReceivedCount: 0
     // 当前要进行 CSV 保存/加载操作的记录索引（-1 表示未选择）
     property int csvTargetRecordIndex: -1
-    // 从 CSV 导入时暂存的新记录列表，供用户选择覆盖或追加
-    property var pendingImportedRecords: []
+    // 待导入的文件路径，供用户选择覆盖或追加后再导入
+    property string pendingImportPath: ""
 
     Connections {
         target: serialComm
@@ -2790,6 +3144,29 @@ ApplicationWindow {
         visible: false
         modality: Qt.ApplicationModal
 
+        // 导入 CSV 表格或 .spa 归档（归档以 mmap 挂载，光谱在需要时才读取）
+        function importRecords(path, append) {
+            const count = spectrumRecords.importFile(path, append)
+            if (count <= 0) {
+                singleSpectrumStatusLabel.text = "✗ 导入记录失败或无有效数据"
+                singleSpectrumStatusLabel.color = "#cc0000"
+                return
+            }
+            singleSpectrumStatusLabel.text = "✓ 已" + (append ? "追加" : "覆盖") + "导入 " + count + " 条记录"
+            singleSpectrumStatusLabel.color = "#006600"
+        }
+
+        // 溢出段写不出去时记录全部留在内存中，提示一次（恢复后清空）
+        Connections {
+            target: spectrumRecords
+            function onSpillErrorChanged() {
+                if (spectrumRecords.spillError.length > 0) {
+                    singleSpectrumStatusLabel.text = "✗ " + spectrumRecords.spillError + "，超出上限的记录暂存在内存中"
+                    singleSpectrumStatusLabel.color = "#cc0000"
+                }
+            }
+        }
+
         ColumnLayout {
             anchors.fill: parent
             anchors.margins: 16
@@ -2802,9 +3179,9 @@ ApplicationWindow {
                 nameFilters: [ "CSV 文件 (*.csv)", "所有文件 (*)" ]
                 onAccepted: {
                     if (csvTargetRecordIndex >= 0 &&
-                            csvTargetRecordIndex < singleSpectrumRecords.length) {
-                        const rec = singleSpectrumRecords[csvTargetRecordIndex]
-                        const ok = spectrumFileManager.saveSpectrumToCsv(rec.spectrum, selectedFile)
+                            csvTargetRecordIndex < spectrumRecords.count) {
+                        const ok = spectrumFileManager.saveSpectrumToCsv(spectrumRecords.spectrum(csvTargetRecordIndex),
+                                                                         selectedFile)
                         if (ok) {
                             singleSpectrumStatusLabel.text = "✓ 已将第 " + (csvTargetRecordIndex + 1) + " 条光谱保存到: " + selectedFile
                             singleSpectrumStatusLabel.color = "#006600"
@@ -2827,23 +3204,14 @@ ApplicationWindow {
                 nameFilters: [ "CSV 文件 (*.csv)", "所有文件 (*)" ]
                 onAccepted: {
                     if (csvTargetRecordIndex >= 0 &&
-                            csvTargetRecordIndex < singleSpectrumRecords.length) {
+                            csvTargetRecordIndex < spectrumRecords.count) {
                         const newSpectrum = spectrumFileManager.loadSpectrumFromCsv(selectedFile)
                         if (!newSpectrum || newSpectrum.length === 0) {
                             singleSpectrumStatusLabel.text = "✗ 从 CSV 导入光谱失败或文件为空"
                             singleSpectrumStatusLabel.color = "#cc0000"
                         } else {
-                            // 用导入的光谱替换当前记录的光谱，并更新统计信息
-                            var minVal = newSpectrum[0]
-                            var maxVal = newSpectrum[0]
-                            for (var i = 1; i < newSpectrum.length; ++i) {
-                                if (newSpectrum[i] < minVal) minVal = newSpectrum[i]
-                                if (newSpectrum[i] > maxVal) maxVal = newSpectrum[i]
-                            }
-                            singleSpectrumRecords[csvTargetRecordIndex].spectrum = newSpectrum
-                            singleSpectrumRecords[csvTargetRecordIndex].length = newSpectrum.length
-                            singleSpectrumRecords[csvTargetRecordIndex].minVal = minVal
-                            singleSpectrumRecords[csvTargetRecordIndex].maxVal = maxVal
+                            // 用导入的光谱替换当前记录的光谱（长度与最小/最大值由存储重新计算）
+                            spectrumRecords.setSpectrum(csvTargetRecordIndex, newSpectrum)
 
                             singleSpectrumStatusLabel.text = "✓ 已从 CSV 导入并更新第 " + (csvTargetRecordIndex + 1) + " 条光谱数据"
                             singleSpectrumStatusLabel.color = "#006600"
@@ -2858,11 +3226,11 @@ ApplicationWindow {
 
             FileDialog {
                 id: saveAllCsvDialog
-                title: "选择要保存全部记录的 CSV 表格路径"
+                title: "选择要保存全部记录的 CSV 表格或光谱归档路径"
                 fileMode: FileDialog.SaveFile
-                nameFilters: [ "CSV 文件 (*.csv)", "所有文件 (*)" ]
+                nameFilters: [ "CSV 文件 (*.csv)", "光谱归档 (*.spa)", "所有文件 (*)" ]
                 onAccepted: {
-                    if (singleSpectrumRecordCount <= 0) {
+                    if (spectrumRecords.count <= 0) {
                         singleSpectrumStatusLabel.text = "✗ 当前没有可导出的记录"
                         singleSpectrumStatusLabel.color = "#cc0000"
                         return
@@ -2874,16 +3242,18 @@ ApplicationWindow {
                         // 在 Linux 下通常是 file:///home/xxx，去掉前缀得到 /home/xxx
                         path = urlStr.substring(7)
                     }
-                    // 如果用户没有手动加 .csv 后缀，则自动补上
-                    if (!path.toLowerCase().endsWith(".csv")) {
+                    // 选择 .spa 时保存为二进制归档，否则导出 CSV（没有后缀时自动补上 .csv）
+                    const isArchive = path.toLowerCase().endsWith(".spa")
+                    if (!isArchive && !path.toLowerCase().endsWith(".csv")) {
                         path = path + ".csv"
                     }
-                    const ok = spectrumFileManager.saveAllSpectraTableToCsv(singleSpectrumRecords, path)
+                    // 由存储逐条写出，光谱不经过 QML
+                    const ok = isArchive ? spectrumRecords.exportArchive(path) : spectrumRecords.exportCsv(path)
                     if (ok) {
-                        singleSpectrumStatusLabel.text = "✓ 已将全部 " + singleSpectrumRecordCount + " 条记录导出到: " + path
+                        singleSpectrumStatusLabel.text = "✓ 已将全部 " + spectrumRecords.count + " 条记录导出到: " + path
                         singleSpectrumStatusLabel.color = "#006600"
                     } else {
-                        singleSpectrumStatusLabel.text = "✗ 导出全部记录到 CSV 失败，请检查路径权限"
+                        singleSpectrumStatusLabel.text = "✗ 导出全部记录失败，请检查路径权限"
                         singleSpectrumStatusLabel.color = "#cc0000"
                     }
                 }
@@ -2891,9 +3261,9 @@ ApplicationWindow {
 
             FileDialog {
                 id: loadAllCsvDialog
-                title: "选择要从中导入全部记录的 CSV 表格"
+                title: "选择要从中导入全部记录的 CSV 表格或光谱归档"
                 fileMode: FileDialog.OpenFile
-                nameFilters: [ "CSV 文件 (*.csv)", "所有文件 (*)" ]
+                nameFilters: [ "CSV 文件 (*.csv)", "光谱归档 (*.spa)", "所有文件 (*)" ]
                 onAccepted: {
                     // FileDialog 返回的是一个 URL，需要转换为本地文件系统路径
                     var urlStr = loadAllCsvDialog.selectedFile.toString()
@@ -2902,16 +3272,15 @@ ApplicationWindow {
                         path = urlStr.substring(7)
                     }
 
-                    const recs = spectrumFileManager.loadAllSpectraTableFromCsv(path)
-                    if (!recs || recs.length === 0) {
-                        singleSpectrumStatusLabel.text = "✗ 从 CSV 导入记录失败或无有效数据"
-                        singleSpectrumStatusLabel.color = "#cc0000"
+                    // 没有现有记录时直接导入，否则先让用户选择覆盖还是追加
+                    if (spectrumRecords.count === 0) {
+                        singleSpectrumWindow.importRecords(path, false)
                         return
                     }
 
-                    pendingImportedRecords = recs
+                    pendingImportPath = path
                     // 弹出提示对话框，让用户选择覆盖现有记录还是在后面追加
-                    importModeDialog.infoText = "从 CSV 读取到 " + recs.length + " 条记录。\n\n" +
+                    importModeDialog.infoText = "将从文件导入记录：" + path + "\n\n" +
                                                 "是否覆盖当前已有记录？\n" +
                                                 "选择“覆盖导入”将清空现有记录后再导入；\n" +
                                                 "选择“追加导入”则会在现有记录之后追加导入的记录。"
@@ -2981,23 +3350,9 @@ ApplicationWindow {
                                 font.bold: true
                             }
                             onClicked: {
-                                if (!pendingImportedRecords || pendingImportedRecords.length === 0) {
-                                    importModeDialog.close()
-                                    return
-                                }
-                                var recs = pendingImportedRecords
                                 // 覆盖模式
-                                singleSpectrumRecords = recs
-                                singleSpectrumRecordCount = recs.length
-
-                                if (singleSpectrumRecords.length > 0 &&
-                                        singleSpectrumRecords[0].length !== undefined) {
-                                    singleSpectrumLength = singleSpectrumRecords[0].length
-                                }
-
-                                pendingImportedRecords = []
-                                singleSpectrumStatusLabel.text = "✓ 已从 CSV 覆盖导入 " + recs.length + " 条记录"
-                                singleSpectrumStatusLabel.color = "#006600"
+                                singleSpectrumWindow.importRecords(pendingImportPath, false)
+                                pendingImportPath = ""
                                 importModeDialog.close()
                             }
                         }
@@ -3019,25 +3374,9 @@ ApplicationWindow {
                                 font.bold: true
                             }
                             onClicked: {
-                                if (!pendingImportedRecords || pendingImportedRecords.length === 0) {
-                                    importModeDialog.close()
-                                    return
-                                }
-                                var recs = pendingImportedRecords
                                 // 追加模式
-                                for (var i = 0; i < recs.length; ++i) {
-                                    singleSpectrumRecords.push(recs[i])
-                                }
-                                singleSpectrumRecordCount = singleSpectrumRecordCount + recs.length
-
-                                if (singleSpectrumRecords.length > 0 &&
-                                        singleSpectrumRecords[0].length !== undefined) {
-                                    singleSpectrumLength = singleSpectrumRecords[0].length
-                                }
-
-                                pendingImportedRecords = []
-                                singleSpectrumStatusLabel.text = "✓ 已从 CSV 追加导入 " + recs.length + " 条记录"
-                                singleSpectrumStatusLabel.color = "#006600"
+                                singleSpectrumWindow.importRecords(pendingImportPath, true)
+                                pendingImportPath = ""
                                 importModeDialog.close()
                             }
                         }
@@ -3059,7 +3398,7 @@ ApplicationWindow {
                                 font.bold: true
                             }
                             onClicked: {
-                                pendingImportedRecords = []
+                                pendingImportPath = ""
                                 importModeDialog.close()
                             }
                         }
@@ -3295,9 +3634,9 @@ ApplicationWindow {
                         font.pixelSize: 12
                         font.bold: true
                     }
-                    enabled: singleSpectrumRecordCount > 0
+                    enabled: spectrumRecords.count > 0
                     onClicked: {
-                        if (singleSpectrumRecordCount <= 0) {
+                        if (spectrumRecords.count <= 0) {
                             singleSpectrumStatusLabel.text = "当前没有可导出的记录"
                             singleSpectrumStatusLabel.color = "#cc0000"
                             return
@@ -3345,10 +3684,9 @@ ApplicationWindow {
                         font.pixelSize: 12
                         font.bold: true
                     }
-                    enabled: singleSpectrumRecordCount > 0
+                    enabled: spectrumRecords.count > 0
                     onClicked: {
-                        singleSpectrumRecords = []
-                        singleSpectrumRecordCount = 0
+                        spectrumRecords.clear()
                         singleSpectrumStatusLabel.text = "已清空全部单次采集记录"
                         singleSpectrumStatusLabel.color = "#666666"
                     }
@@ -3361,8 +3699,8 @@ ApplicationWindow {
                 Layout.fillWidth: true
                 Layout.fillHeight: true
                 clip: true
-                // 使用单独的计数属性触发 model 更新
-                model: singleSpectrumRecordCount
+                // 记录存储按行发出增删通知，委托只读取元数据角色
+                model: spectrumRecords
 
                 delegate: Rectangle {
                     width: ListView.view.width
@@ -3392,7 +3730,7 @@ ApplicationWindow {
                             }
                             TextField {
                                 id: recordLabelEditor
-                                text: singleSpectrumRecords[index].label
+                                text: model.label
                                 placeholderText: "(可编辑标签)"
                                 font.pixelSize: 11
                                 Layout.fillWidth: true
@@ -3404,29 +3742,29 @@ ApplicationWindow {
                                     radius: 4
                                 }
                                 onEditingFinished: {
-                                    singleSpectrumRecords[index].label = text
+                                    model.label = text
                                 }
                             }
                         }
                         Label {
                             // 采集时间
-                            text: Qt.formatDateTime(singleSpectrumRecords[index].time,
+                            text: Qt.formatDateTime(model.time,
                                                      "yyyy-MM-dd hh:mm:ss")
                             color: "#555555"
                             Layout.preferredWidth: 130
                         }
                         Label {
-                            text: "长度: " + singleSpectrumRecords[index].length
+                            text: "长度: " + model.length
                             color: "#555555"
                             Layout.preferredWidth: 90
                         }
                         Label {
-                            text: "最小值: " + Number(singleSpectrumRecords[index].minVal).toFixed(2)
+                            text: "最小值: " + Number(model.minVal).toFixed(2)
                             color: "#555555"
                             Layout.preferredWidth: 110
                         }
                         Label {
-                            text: "最大值: " + Number(singleSpectrumRecords[index].maxVal).toFixed(2)
+                            text: "最大值: " + Number(model.maxVal).toFixed(2)
                             color: "#555555"
                             Layout.preferredWidth: 110
                         }
@@ -3440,9 +3778,9 @@ ApplicationWindow {
                             }
                             TextField {
                                 id: recordMoistureEditor
-                                text: isNaN(singleSpectrumRecords[index].moisture)
+                                text: isNaN(model.moisture)
                                       ? ""
-                                      : Number(singleSpectrumRecords[index].moisture).toFixed(2)
+                                      : Number(model.moisture).toFixed(2)
                                 placeholderText: "12.34"
                                 font.pixelSize: 11
                                 inputMethodHints: Qt.ImhFormattedNumbersOnly
@@ -3457,7 +3795,7 @@ ApplicationWindow {
                                 onEditingFinished: {
                                     var v = Number(text)
                                     if (!isNaN(v)) {
-                                        singleSpectrumRecords[index].moisture = v
+                                        model.moisture = v
                                     }
                                 }
                             }
@@ -3484,11 +3822,10 @@ ApplicationWindow {
                                 font.bold: true
                             }
                             onClicked: {
-                                if (singleSpectrumRecordCount <= 0) return
-                                // 删除当前这一条记录
-                                singleSpectrumRecords.splice(index, 1)
-                                singleSpectrumRecordCount = singleSpectrumRecordCount - 1
-                                singleSpectrumStatusLabel.text = "已删除第 " + (index + 1) + " 条记录"
+                                // 删除当前这一条记录（先记下行号，删除后委托即被销毁）
+                                const row = index
+                                spectrumRecords.remove(row)
+                                singleSpectrumStatusLabel.text = "已删除第 " + (row + 1) + " 条记录"
                                 singleSpectrumStatusLabel.color = "#666666"
                             }
                         }
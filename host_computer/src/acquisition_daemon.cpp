@@ -0,0 +1,353 @@
+#include "acquisition_daemon.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonArray>
+
+AcquisitionDaemon::AcquisitionDaemon(const DaemonConfig &config, QObject *parent)
+    : QObject(parent), config_(config), lastSpectrumPackets_(0), lastSpectrumSnr_(0.0), predictionCount_(0),
+      abnormalCount_(0) {
+  udp_.setPredictorManager(&predictorManager_);
+  // 没有界面时不需要实时原始帧，显示定时器降到最低频率
+  udp_.displayFeed()->setLiveFrameEnabled(false);
+  udp_.displayFeed()->setMaxFps(1);
+
+  // 影子模式的对比结果与界面程序一样写入 log/shadow.csv
+  connect(predictorManager_.inferenceExecutor(), &InferenceExecutor::shadowPredictionReady, &logManager_,
+          [this](int index, const QVariant &liveValue, const QVariant &shadowValue, qint64 windowTimestampNs) {
+            logManager_.logShadowPrediction(index, liveValue, shadowValue, windowTimestampNs,
+                                            predictorManager_.modelPath(index),
+                                            predictorManager_.shadowModelPath(index));
+          });
+  connect(&serial_, &SerialCommunicator::stateChanged, this, &AcquisitionDaemon::onSerialStateChanged);
+  connect(&udp_, &UdpCommunicator::spectrumReady, this, &AcquisitionDaemon::onSpectrumReady);
+  connect(&udp_, &UdpCommunicator::predictionReady, this, &AcquisitionDaemon::onPredictionReady);
+  connect(&udp_, &UdpCommunicator::statusChanged, this, [](const QString &message) {
+    qDebug() << "UDP:" << message;
+  });
+  connect(&serial_, &SerialCommunicator::statusChanged, this, [](const QString &message) {
+    qDebug() << "串口:" << message;
+  });
+  connect(&udp_, &UdpCommunicator::replayFinished, this, [](int frames, double fps, double pps) {
+    qDebug() << "回放完成:" << frames << "帧" << fps << "帧/秒" << pps << "预测/秒";
+  });
+
+  registerCommands();
+}
+
+AcquisitionDaemon::~AcquisitionDaemon() {
+  stop();
+}
+
+bool AcquisitionDaemon::initialize(QString *error) {
+  if (!config_.deviceId.isEmpty()) {
+    udp_.setDeviceId(config_.deviceId);
+  }
+  applyProcessingConfig(&udp_, config_.processing);
+
+  // 没有可用的黑白参考时只输出原始光谱、不做预测，可通过控制命令 black / white 重新采集
+  if (!udp_.loadCalibrationCache()) {
+    qWarning() << "没有可用的标定缓存，需要采集黑白参考后才会输出预测";
+  }
+
+  if (!selectPredictors(error)) {
+    return false;
+  }
+
+  if (!startPublisher(error)) {
+    return false;
+  }
+
+  if (!configureDevices(error)) {
+    return false;
+  }
+
+  if (!config_.controlSocket.isEmpty()) {
+    QString listenError;
+    if (!control_.listen(config_.controlSocket, &listenError)) {
+      if (error) {
+        *error = QStringLiteral("控制套接字 %1 监听失败: %2").arg(config_.controlSocket, listenError);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AcquisitionDaemon::selectPredictors(QString *error) {
+  predictorIndices_.clear();
+  for (const DaemonConfig::Predictor &p : config_.predictors) {
+    int index = p.index;
+    if (!p.algorithm.isEmpty()) {
+      index = -1;
+      const int count = static_cast<int>(predictorManager_.predictorNames().size());
+      for (int i = 0; i < count; i++) {
+        if (predictorManager_.getAlgorithm(i) == p.algorithm) {
+          index = i;
+          break;
+        }
+      }
+    }
+    if (index < 0 || index >= static_cast<int>(predictorManager_.predictorNames().size())) {
+      if (error) {
+        *error = QStringLiteral("找不到预测器: %1").arg(p.algorithm.isEmpty() ? QString::number(p.index) : p.algorithm);
+      }
+      return false;
+    }
+    // 启动时同步加载：加载完成之前不开始采集
+    const bool loaded = p.model.isEmpty() ? predictorManager_.loadModelAuto(index)
+                                          : predictorManager_.loadModel(index, p.model);
+    if (!loaded) {
+      if (error) {
+        *error = QStringLiteral("预测器 %1 模型加载失败").arg(index);
+      }
+      return false;
+    }
+    if (!predictorIndices_.contains(index)) {
+      predictorIndices_.append(index);
+    }
+  }
+
+  QVariantList indices;
+  for (int index : predictorIndices_) {
+    indices.append(index);
+  }
+  udp_.setPredictorIndices(indices);
+  return true;
+}
+
+bool AcquisitionDaemon::startPublisher(QString *error) {
+  const QString path = config_.publisherConfig.isEmpty() ? ResultPublisher::Config::defaultConfigPath()
+                                                         : config_.publisherConfig;
+  ResultPublisher::Config publisherConfig;
+  QString loadError;
+  if (!publisherConfig.load(path, &loadError)) {
+    if (error) {
+      *error = QStringLiteral("发布配置 %1 无效: %2").arg(path, loadError);
+    }
+    return false;
+  }
+  if (!publisherConfig.enabled()) {
+    return true;
+  }
+
+  publisher_ = std::make_unique<ResultPublisher>(publisherConfig);
+  publisher_->setMonitorLimits(config_.monitorEnabled(), config_.lowerLimit, config_.upperLimit);
+  // 推理线程直接投递到发布队列，不经过主线程事件循环
+  connect(predictorManager_.inferenceExecutor(), &InferenceExecutor::predictionReady, publisher_.get(),
+          [publisher = publisher_.get()](int index, double value, qint64 windowTimestampNs, qint64, int streamId) {
+            publisher->publishPrediction(index, value, windowTimestampNs, streamId);
+          },
+          Qt::DirectConnection);
+  connect(&udp_, &UdpCommunicator::spectrumReady, publisher_.get(), &ResultPublisher::onSpectrumReady);
+  QString startError;
+  if (!publisher_->startPublishing(&startError)) {
+    if (error) {
+      *error = QStringLiteral("网络发布启动失败: %1").arg(startError);
+    }
+    publisher_.reset();
+    return false;
+  }
+  qDebug() << "预测结果网络发布:" << publisherConfig.describe();
+  return true;
+}
+
+bool AcquisitionDaemon::configureDevices(QString *error) {
+  const QString path = config_.devicesConfig.isEmpty() ? DeviceRegistry::Config::defaultConfigPath()
+                                                       : config_.devicesConfig;
+  DeviceRegistry::Config devicesConfig;
+  QString loadError;
+  if (!devicesConfig.load(path, &loadError) ||
+      !devicesConfig.checkPrimaryConflicts(config_.udpPort, config_.serialPort, &loadError) ||
+      !devices_.configure(devicesConfig, &loadError)) {
+    if (error) {
+      *error = QStringLiteral("多设备配置 %1 无效: %2").arg(path, loadError);
+    }
+    return false;
+  }
+  if (devices_.count() == 0) {
+    return true;
+  }
+  connect(&devices_, &DeviceRegistry::statusChanged, this, [](const QString &deviceId, const QString &message) {
+    qDebug() << deviceId << ":" << message;
+  });
+  if (publisher_) {
+    connect(&devices_, &DeviceRegistry::spectrumReady, publisher_.get(), &ResultPublisher::onStreamSpectrumReady);
+  }
+  qDebug() << "多设备:" << devicesConfig.describe();
+  return true;
+}
+
+bool AcquisitionDaemon::start(QString *error) {
+  if (isRunning()) {
+    return true;
+  }
+  bool ok = false;
+  if (!config_.replayPath.isEmpty()) {
+    ok = udp_.startReplay(config_.replayPath, config_.replaySpeed, config_.replayLoop);
+  } else if (!config_.serialPort.isEmpty()) {
+    // 启动命令发送成功后由 onSerialStateChanged 开始 UDP 接收（与界面程序相同）
+    ok = serial_.sendStartCommand(config_.serialPort) && udp_.isReceiving();
+  } else {
+    ok = udp_.startReceiving(config_.udpPort, config_.bindAddress, config_.batchSize, config_.kernelTimestamps);
+  }
+  if (!ok) {
+    if (error) {
+      *error = QStringLiteral("采集启动失败");
+    }
+    return false;
+  }
+  if (!config_.recordingBasePath.isEmpty() && !udp_.isRecording()) {
+    const QString basePath = config_.recordingBasePath + QDateTime::currentDateTime().toString(
+                                                             QStringLiteral("_yyyyMMdd_HHmmss"));
+    if (!udp_.startRecording(basePath, config_.recordingMaxFileMB, config_.recordingDirectIo)) {
+      qWarning() << "原始帧录制启动失败:" << basePath;
+    }
+  }
+  devices_.startAll();
+  qDebug() << "采集已开始";
+  return true;
+}
+
+void AcquisitionDaemon::stop() {
+  devices_.stopAll();
+  if (udp_.isRecording()) {
+    udp_.stopRecording();
+  }
+  if (udp_.isReplaying()) {
+    udp_.stopReplay();
+  }
+  if (serial_.isStarted()) {
+    serial_.sendStopCommand(config_.serialPort);
+  }
+  if (udp_.isReceiving()) {
+    udp_.stopReceiving();
+  }
+}
+
+void AcquisitionDaemon::onSerialStateChanged(bool started) {
+  if (started) {
+    udp_.startReceiving(config_.udpPort, config_.bindAddress, config_.batchSize, config_.kernelTimestamps);
+  } else {
+    udp_.stopReceiving();
+  }
+}
+
+void AcquisitionDaemon::onSpectrumReady(const QVariantList &averagedSpectrum, double, double, int packetCount,
+                                        double snr) {
+  lastSpectrumPackets_ = packetCount;
+  lastSpectrumSnr_ = snr;
+  if (config_.logSpectrum) {
+    lastSpectrum_ = averagedSpectrum;
+  }
+}
+
+void AcquisitionDaemon::onPredictionReady(int predictorIndex, double predictionValue) {
+  // 与界面的异常监控一致：启用上下限时标记正常 / 异常
+  const bool monitorEnabled = config_.monitorEnabled();
+  QString status = QStringLiteral("未启用异常监控");
+  if (monitorEnabled) {
+    const bool abnormal = predictionValue < config_.lowerLimit || predictionValue > config_.upperLimit;
+    status = abnormal ? QStringLiteral("异常") : QStringLiteral("正常");
+    if (abnormal) {
+      abnormalCount_++;
+    }
+  }
+  predictionCount_++;
+  LastPrediction &last = lastPredictions_[predictorIndex];
+  last.value = predictionValue;
+  last.status = status;
+  last.timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+  logManager_.logPredictionResult(predictorIndex, predictionValue, status, monitorEnabled, config_.lowerLimit,
+                                  config_.upperLimit, lastSpectrum_);
+}
+
+QJsonObject AcquisitionDaemon::status() const {
+  QJsonObject s;
+  s.insert(QStringLiteral("running"), isRunning());
+  s.insert(QStringLiteral("replaying"), udp_.isReplaying());
+  s.insert(QStringLiteral("recording"), udp_.isRecording());
+  s.insert(QStringLiteral("recordingFile"), udp_.recordingFile());
+  s.insert(QStringLiteral("recordedFrames"), udp_.recordedFrames());
+  s.insert(QStringLiteral("packetCount"), udp_.packetCount());
+  s.insert(QStringLiteral("packetsPerSecond"), udp_.packetsPerSecond());
+  s.insert(QStringLiteral("processedFramesPerSecond"), udp_.processedFramesPerSecond());
+  s.insert(QStringLiteral("predictionsPerSecond"), udp_.predictionsPerSecond());
+  s.insert(QStringLiteral("droppedFrames"), udp_.droppedFrames());
+  s.insert(QStringLiteral("lostFrames"), udp_.lostFrames());
+  s.insert(QStringLiteral("kernelDrops"), udp_.kernelDrops());
+  s.insert(QStringLiteral("blackReferenceAccumulating"), udp_.isBlackReferenceAccumulating());
+  s.insert(QStringLiteral("whiteReferenceAccumulating"), udp_.isWhiteReferenceAccumulating());
+  s.insert(QStringLiteral("calibrationFromCache"), udp_.calibrationFromCache());
+  s.insert(QStringLiteral("calibrationStale"), udp_.calibrationStale());
+  s.insert(QStringLiteral("calibrationCapturedAt"), udp_.calibrationCapturedAt());
+  s.insert(QStringLiteral("averagingMode"), udp_.averagingMode());
+  s.insert(QStringLiteral("lastSpectrumPackets"), lastSpectrumPackets_);
+  s.insert(QStringLiteral("lastSpectrumSnr"), lastSpectrumSnr_);
+  s.insert(QStringLiteral("predictionCount"), static_cast<double>(predictionCount_));
+  s.insert(QStringLiteral("abnormalCount"), static_cast<double>(abnormalCount_));
+
+  QJsonArray predictors;
+  for (int index : predictorIndices_) {
+    QJsonObject p;
+    p.insert(QStringLiteral("index"), index);
+    p.insert(QStringLiteral("algorithm"), predictorManager_.getAlgorithm(index));
+    p.insert(QStringLiteral("model"), predictorManager_.modelPath(index));
+    auto it = lastPredictions_.constFind(index);
+    if (it != lastPredictions_.constEnd()) {
+      p.insert(QStringLiteral("value"), it.value().value);
+      p.insert(QStringLiteral("status"), it.value().status);
+      p.insert(QStringLiteral("timestampMs"), static_cast<double>(it.value().timestampMs));
+    }
+    predictors.append(p);
+  }
+  s.insert(QStringLiteral("predictors"), predictors);
+  s.insert(QStringLiteral("pipeline"), pipelineStats_.summary());
+  if (publisher_) {
+    s.insert(QStringLiteral("publisher"), QJsonObject::fromVariantMap(publisher_->stats()));
+  }
+  if (devices_.count() > 0) {
+    s.insert(QStringLiteral("devices"), QJsonArray::fromVariantList(devices_.status()));
+    s.insert(QStringLiteral("deviceThreads"), QJsonObject::fromVariantMap(devices_.threads()));
+  }
+  return s;
+}
+
+void AcquisitionDaemon::registerCommands() {
+  control_.addCommand(QStringLiteral("status"), QStringLiteral("采集状态与统计"),
+                      [this](const QStringList &, QString *) { return status(); });
+  control_.addCommand(QStringLiteral("start"), QStringLiteral("开始采集"),
+                      [this](const QStringList &, QString *error) {
+                        start(error);
+                        return QJsonObject();
+                      });
+  control_.addCommand(QStringLiteral("stop"), QStringLiteral("停止采集"), [this](const QStringList &, QString *) {
+    stop();
+    return QJsonObject();
+  });
+  control_.addCommand(QStringLiteral("black"), QStringLiteral("采集黑参考（需在采集中）"),
+                      [this](const QStringList &, QString *error) {
+                        if (!isRunning()) {
+                          *error = QStringLiteral("未在采集");
+                        } else {
+                          udp_.startBlackReference();
+                        }
+                        return QJsonObject();
+                      });
+  control_.addCommand(QStringLiteral("white"), QStringLiteral("采集白参考（需在采集中）"),
+                      [this](const QStringList &, QString *error) {
+                        if (!isRunning()) {
+                          *error = QStringLiteral("未在采集");
+                        } else {
+                          udp_.startWhiteReference();
+                        }
+                        return QJsonObject();
+                      });
+  control_.addCommand(QStringLiteral("quit"), QStringLiteral("停止采集并退出"),
+                      [this](const QStringList &, QString *) {
+                        // 先回复再退出
+                        QMetaObject::invokeMethod(this, &AcquisitionDaemon::quitRequested, Qt::QueuedConnection);
+                        return QJsonObject();
+                      });
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QVariantList>
+#include <QVector>
+#include <memory>
+
+#include "control_server.h"
+#include "daemon_config.h"
+#include "device_registry.h"
+#include "log_manager.h"
+#include "pipeline_stats.h"
+#include "result_publisher.h"
+#include "serial_communicator.h"
+#include "spectrum_predictor_manager.h"
+#include "udp_communicator.h"
+
+// 无界面采集守护进程：不创建 QML 引擎，按 DaemonConfig 组装与界面程序相同的
+// SerialCommunicator → UdpCommunicator → SpectrumProcessor → 预测器 链路
+// - 预测结果（含异常监控状态与光谱）写入 log/result.csv，原始帧按配置录制
+// - 按 publisherConfig 启用时，预测结果同时经 ResultPublisher 发布到组播 / TCP 订阅端
+// - devicesConfig 中的其他光谱仪由 DeviceRegistry 创建各自的流水线，随 start / stop 一起启停，
+//   结果按 streamId 区分发布（不写入 result.csv）
+// - 本地控制套接字（ControlServer）提供 status / start / stop / black / white / quit 命令，
+//   界面或运维脚本可以作为独立进程连接
+class AcquisitionDaemon : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit AcquisitionDaemon(const DaemonConfig &config, QObject *parent = nullptr);
+  ~AcquisitionDaemon() override;
+
+  // 恢复标定缓存、加载模型并选择预测器、打开控制套接字；配置中的预测器无法加载时返回 false
+  bool initialize(QString *error);
+
+  // 开始采集（串口启动命令 → UDP 接收，或回放录制文件），按配置同时开始录制
+  bool start(QString *error = nullptr);
+  // 停止采集与录制
+  void stop();
+  bool isRunning() const { return udp_.isReceiving(); }
+
+  QJsonObject status() const;
+
+ signals:
+  void quitRequested();
+
+ private slots:
+  void onSerialStateChanged(bool started);
+  void onSpectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount,
+                       double snr);
+  void onPredictionReady(int predictorIndex, double predictionValue);
+
+ private:
+  bool selectPredictors(QString *error);
+  bool startPublisher(QString *error);
+  bool configureDevices(QString *error);
+  void registerCommands();
+
+  struct LastPrediction {
+    double value = 0.0;
+    QString status;
+    qint64 timestampMs = 0;
+  };
+
+  DaemonConfig config_;
+  // 声明顺序即构造顺序：日志最先创建、最后销毁；预测器管理器在 UDP 通信器之后销毁
+  // 发布器在预测器管理器之后销毁：推理线程停止后才不会再调用 publishPrediction
+  LogManager logManager_;
+  PipelineStats pipelineStats_;
+  std::unique_ptr<ResultPublisher> publisher_;  // 未启用网络发布时为空
+  SerialCommunicator serial_;
+  SpectrumPredictorManager predictorManager_;
+  UdpCommunicator udp_;
+  DeviceRegistry devices_{&predictorManager_};
+  ControlServer control_;
+
+  QVector<int> predictorIndices_;
+  QVariantList lastSpectrum_;  // 最新一条光谱（写入 result.csv）
+  int lastSpectrumPackets_;  // 最新一条光谱的数据包数与信噪比（自适应平均时有意义）
+  double lastSpectrumSnr_;
+  QMap<int, LastPrediction> lastPredictions_;
+  quint64 predictionCount_;
+  quint64 abnormalCount_;
+};
@@ -0,0 +1,180 @@
+#include "async_log_writer.h"
+
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+
+namespace {
+
+constexpr int kPopChunk = 256;  // 每次从队列取出的最大行数
+constexpr int kIdleTimeoutMs = 500;  // 无唤醒时的最长等待，兼作停止检查周期
+
+}  // namespace
+
+AsyncLogWriter::AsyncLogWriter(size_t queueCapacity, QObject *parent)
+    : QThread(parent), ring_(queueCapacity), eventFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      consumerWaiting_(false), stopRequested_(false), dropped_(0) {
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+  stopWriting();
+  if (eventFd_ >= 0) {
+    close(eventFd_);
+    eventFd_ = -1;
+  }
+}
+
+int AsyncLogWriter::addTarget(const QString &path, qint64 maxBytes, int maxBackups, const QByteArray &header) {
+  Target target;
+  target.path = path;
+  target.maxBytes = maxBytes;
+  target.maxBackups = qMax(0, maxBackups);
+  target.header = header;
+  targets_.push_back(std::move(target));
+  return static_cast<int>(targets_.size()) - 1;
+}
+
+bool AsyncLogWriter::post(int target, QByteArray line) {
+  if (target < 0 || target >= static_cast<int>(targets_.size())) {
+    return false;
+  }
+  Line entry;
+  entry.target = target;
+  entry.bytes = std::move(line);
+  if (!ring_.push(std::move(entry))) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  // 与写盘线程的“置等待标志 → 再检查队列”配对，保证不会丢失唤醒
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumerWaiting_.load(std::memory_order_relaxed)) {
+    wake();
+  }
+  return true;
+}
+
+void AsyncLogWriter::stopWriting() {
+  if (!isRunning()) {
+    return;
+  }
+  stopRequested_ = true;
+  wake();
+  wait();
+}
+
+void AsyncLogWriter::wake() {
+  if (eventFd_ >= 0) {
+    uint64_t one = 1;
+    ssize_t ret = write(eventFd_, &one, sizeof(one));
+    (void)ret;
+  }
+}
+
+void AsyncLogWriter::waitForLines() {
+  consumerWaiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring_.emptyApprox() && !stopRequested_ && eventFd_ >= 0) {
+    struct pollfd pfd;
+    pfd.fd = eventFd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, kIdleTimeoutMs) > 0) {
+      uint64_t counter = 0;
+      ssize_t ret = read(eventFd_, &counter, sizeof(counter));
+      (void)ret;
+    }
+  }
+  consumerWaiting_.store(false, std::memory_order_relaxed);
+}
+
+void AsyncLogWriter::run() {
+  for (Target &target : targets_) {
+    openTarget(target);
+  }
+
+  while (!stopRequested_) {
+    waitForLines();
+    drain();
+  }
+  // 退出前写完剩余的行
+  drain();
+
+  for (Target &target : targets_) {
+    if (target.file) {
+      target.file->close();
+      target.file.reset();
+    }
+  }
+}
+
+void AsyncLogWriter::drain() {
+  Line lines[kPopChunk];
+  size_t n = 0;
+  while ((n = ring_.pop(lines, kPopChunk)) > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      Target &target = targets_[static_cast<size_t>(lines[i].target)];
+      target.pending.append(lines[i].bytes);
+      lines[i].bytes.clear();
+      // 单批次内容已足以触发滚动时先写一次，保证按行边界切分文件
+      if (target.maxBytes > 0 && target.size + target.pending.size() >= target.maxBytes) {
+        writePending(target);
+      }
+    }
+  }
+  for (Target &target : targets_) {
+    writePending(target);
+  }
+}
+
+void AsyncLogWriter::writePending(Target &target) {
+  if (target.pending.isEmpty()) {
+    return;
+  }
+  if (target.file || openTarget(target)) {
+    const qint64 written = target.file->write(target.pending);
+    target.file->flush();
+    if (written > 0) {
+      target.size += written;
+    }
+    if (target.maxBytes > 0 && target.size >= target.maxBytes) {
+      rotateTarget(target);
+    }
+  }
+  target.pending.clear();
+}
+
+bool AsyncLogWriter::openTarget(Target &target) {
+  target.file = std::make_unique<QFile>(target.path);
+  if (!target.file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+    // 写盘线程内不能再走 qWarning（会回到日志系统），直接输出到 stderr
+    fprintf(stderr, "[AsyncLogWriter] Failed to open %s: %s\n",
+            qPrintable(target.path), qPrintable(target.file->errorString()));
+    target.file.reset();
+    return false;
+  }
+  target.size = target.file->size();
+  if (target.size == 0 && !target.header.isEmpty()) {
+    target.size += target.file->write(target.header);
+  }
+  return true;
+}
+
+void AsyncLogWriter::rotateTarget(Target &target) {
+  target.file->close();
+  target.file.reset();
+  if (target.maxBackups > 0) {
+    // app.log.(N-1) → app.log.N … app.log → app.log.1
+    QFile::remove(target.path + QStringLiteral(".%1").arg(target.maxBackups));
+    for (int i = target.maxBackups - 1; i >= 1; --i) {
+      QFile::rename(target.path + QStringLiteral(".%1").arg(i),
+                    target.path + QStringLiteral(".%1").arg(i + 1));
+    }
+    QFile::rename(target.path, target.path + QStringLiteral(".1"));
+  } else {
+    QFile::remove(target.path);
+  }
+  openTarget(target);
+}
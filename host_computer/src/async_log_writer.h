@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mpsc_ring.h"
+
+// 异步日志写盘线程：
+// - 任意线程通过 post() 把已格式化好的一行投递到无锁 MPSC 队列，不加锁、不做文件 I/O
+// - 后台线程保持文件常开，每次唤醒把队列中的全部行按文件合并为一次写入
+// - 文件超过大小上限时滚动：app.log → app.log.1 → … → app.log.N（最旧的删除）
+// 队列满时丢弃新行并计数，日志永远不会阻塞调用方
+class AsyncLogWriter : public QThread {
+  Q_OBJECT
+
+ public:
+  static const int DEFAULT_QUEUE_CAPACITY = 16384;
+
+  explicit AsyncLogWriter(size_t queueCapacity = DEFAULT_QUEUE_CAPACITY, QObject *parent = nullptr);
+  ~AsyncLogWriter();
+
+  // 注册输出文件（须在 start() 之前调用），返回 post() 使用的目标编号
+  // maxBytes: 单个文件大小上限，<= 0 表示不滚动；maxBackups: 保留的历史文件数
+  // header: 新建文件（包括滚动后）时先写入的表头，例如 CSV 列名
+  int addTarget(const QString &path, qint64 maxBytes, int maxBackups, const QByteArray &header = QByteArray());
+
+  // 任意线程调用：投递一行（调用方负责换行符），队列已满时返回 false
+  bool post(int target, QByteArray line);
+
+  // 停止线程：先把队列中剩余的行全部写盘并关闭文件
+  void stopWriting();
+
+  quint64 droppedLines() const { return dropped_.load(std::memory_order_relaxed); }
+
+ protected:
+  void run() override;
+
+ private:
+  struct Line {
+    int target = -1;
+    QByteArray bytes;
+  };
+
+  struct Target {
+    QString path;
+    qint64 maxBytes = 0;
+    int maxBackups = 0;
+    QByteArray header;
+    std::unique_ptr<QFile> file;
+    qint64 size = 0;
+    QByteArray pending;  // 本批次待写入的内容
+  };
+
+  // 以下仅在写盘线程中调用
+  void drain();
+  void writePending(Target &target);
+  bool openTarget(Target &target);
+  void rotateTarget(Target &target);
+  void waitForLines();
+  void wake();
+
+  MpscRing<Line> ring_;
+  std::vector<Target> targets_;
+  int eventFd_;
+  std::atomic<bool> consumerWaiting_;
+  std::atomic<bool> stopRequested_;
+  std::atomic<quint64> dropped_;
+};
@@ -0,0 +1,178 @@
+#include "calibration_cache.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFile>
+#include <QSaveFile>
+#include <cstring>
+
+namespace CalibrationCache {
+
+namespace {
+
+constexpr int kPixelCount = SpectrumFrame::kPixelCount;
+
+// CRC-32（IEEE 802.3 多项式），缓存文件很小，逐字节查表即可
+struct Crc32Table {
+  uint32_t entries[256];
+  Crc32Table() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      entries[i] = c;
+    }
+  }
+};
+
+uint32_t crc32(const char *data, qsizetype size) {
+  static const Crc32Table table;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (qsizetype i = 0; i < size; i++) {
+    crc = table.entries[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+void appendReference(QByteArray &out, const CalibrationReference &reference) {
+  ReferenceHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.capturedWallMs = reference.capturedWallMs;
+  header.frameCount = static_cast<uint32_t>(qMax(0, reference.frameCount));
+  header.hasStdDev = reference.stdDev.size() == kPixelCount ? 1 : 0;
+  header.integrationUs = reference.integrationUs;
+  out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.append(reinterpret_cast<const char *>(reference.mean.constData()), sizeof(double) * kPixelCount);
+  if (header.hasStdDev) {
+    out.append(reinterpret_cast<const char *>(reference.stdDev.constData()), sizeof(double) * kPixelCount);
+  } else {
+    out.append(QByteArray(static_cast<qsizetype>(sizeof(double) * kPixelCount), '\0'));
+  }
+}
+
+// 从 data[offset] 读取一条参考，offset 前移
+void readReference(const QByteArray &data, qsizetype &offset, CalibrationReference *reference) {
+  ReferenceHeader header;
+  std::memcpy(&header, data.constData() + offset, sizeof(header));
+  offset += sizeof(header);
+  reference->capturedWallMs = header.capturedWallMs;
+  reference->frameCount = static_cast<int>(header.frameCount);
+  reference->integrationUs = header.integrationUs;
+  reference->mean.resize(kPixelCount);
+  std::memcpy(reference->mean.data(), data.constData() + offset, sizeof(double) * kPixelCount);
+  offset += sizeof(double) * kPixelCount;
+  if (header.hasStdDev) {
+    reference->stdDev.resize(kPixelCount);
+    std::memcpy(reference->stdDev.data(), data.constData() + offset, sizeof(double) * kPixelCount);
+  } else {
+    reference->stdDev.clear();
+  }
+  offset += sizeof(double) * kPixelCount;
+}
+
+}  // namespace
+
+QString defaultPath() {
+  return QCoreApplication::applicationDirPath() + QStringLiteral("/calibration_cache.bin");
+}
+
+bool save(const QString &path, const CalibrationCacheContents &contents, QString *error) {
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(header.magic));
+  header.version = kVersion;
+  header.pixelCount = kPixelCount;
+  if (contents.black.isValid()) {
+    header.referenceMask |= kBlackReference;
+  }
+  if (contents.white.isValid()) {
+    header.referenceMask |= kWhiteReference;
+  }
+  const QByteArray deviceId = contents.deviceId.toUtf8().left(sizeof(header.deviceId) - 1);
+  std::memcpy(header.deviceId, deviceId.constData(), static_cast<size_t>(deviceId.size()));
+
+  QByteArray out;
+  out.reserve(sizeof(header) + 2 * (sizeof(ReferenceHeader) + 2 * sizeof(double) * kPixelCount) + 4);
+  out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (header.referenceMask & kBlackReference) {
+    appendReference(out, contents.black);
+  }
+  if (header.referenceMask & kWhiteReference) {
+    appendReference(out, contents.white);
+  }
+  const uint32_t crc = crc32(out.constData(), out.size());
+  out.append(reinterpret_cast<const char *>(&crc), sizeof(crc));
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  return true;
+}
+
+bool load(const QString &path, CalibrationCacheContents *contents, QString *error) {
+  QFile file(path);
+  if (!file.exists()) {
+    if (error) {
+      error->clear();
+    }
+    return false;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  const QByteArray data = file.readAll();
+  auto fail = [error](const QString &message) {
+    if (error) {
+      *error = message;
+    }
+    return false;
+  };
+
+  if (data.size() < static_cast<qsizetype>(sizeof(FileHeader) + sizeof(uint32_t))) {
+    return fail(QStringLiteral("文件过短"));
+  }
+  FileHeader header;
+  std::memcpy(&header, data.constData(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return fail(QStringLiteral("不是标定缓存文件"));
+  }
+  if (header.version != kVersion || header.pixelCount != static_cast<uint32_t>(kPixelCount)) {
+    return fail(QStringLiteral("版本或像素数不匹配"));
+  }
+  const int referenceCount = ((header.referenceMask & kBlackReference) ? 1 : 0) +
+                             ((header.referenceMask & kWhiteReference) ? 1 : 0);
+  const qsizetype expected = static_cast<qsizetype>(sizeof(FileHeader)) +
+                             referenceCount * static_cast<qsizetype>(sizeof(ReferenceHeader) +
+                                                                     2 * sizeof(double) * kPixelCount) +
+                             static_cast<qsizetype>(sizeof(uint32_t));
+  if (data.size() != expected) {
+    return fail(QStringLiteral("文件长度不符"));
+  }
+  uint32_t storedCrc = 0;
+  std::memcpy(&storedCrc, data.constData() + data.size() - sizeof(storedCrc), sizeof(storedCrc));
+  if (crc32(data.constData(), data.size() - static_cast<qsizetype>(sizeof(storedCrc))) != storedCrc) {
+    return fail(QStringLiteral("校验和错误"));
+  }
+
+  CalibrationCacheContents parsed;
+  parsed.deviceId = QString::fromUtf8(header.deviceId, static_cast<int>(strnlen(header.deviceId, sizeof(header.deviceId))));
+  qsizetype offset = sizeof(FileHeader);
+  if (header.referenceMask & kBlackReference) {
+    readReference(data, offset, &parsed.black);
+  }
+  if (header.referenceMask & kWhiteReference) {
+    readReference(data, offset, &parsed.white);
+  }
+  *contents = parsed;
+  return true;
+}
+
+}  // namespace CalibrationCache
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <cstdint>
+
+#include "spectrum_frame.h"
+
+// 一条已完成的黑/白参考：逐像素平均值与流式累加器给出的标准差
+struct CalibrationReference {
+  QVector<double> mean;       // 逐像素平均值（kPixelCount 个）
+  QVector<double> stdDev;     // 逐像素标准差（可为空）
+  qint64 capturedWallMs = 0;  // 累积完成的墙上时间（UTC 毫秒）
+  int frameCount = 0;         // 累积的数据包数
+  double integrationUs = 0.0; // 采集时的积分时间（微秒，0 表示未知）
+
+  bool isValid() const { return mean.size() == SpectrumFrame::kPixelCount; }
+};
+
+struct CalibrationCacheContents {
+  QString deviceId;  // 光谱仪标识（空表示未设置）
+  CalibrationReference black;
+  CalibrationReference white;
+};
+
+// 黑白参考的持久化缓存，启动时由 UdpCommunicator::loadCalibrationCache 读取，
+// 省去每次启动重新累积黑白参考（默认各 39500 个数据包）
+//
+// 文件布局（小端，约 32 KB）：
+//   FileHeader
+//   每个存在的参考（按 black、white 顺序，由 referenceMask 指明）：
+//     ReferenceHeader + double mean[pixelCount] + double stdDev[pixelCount]
+//   uint32 CRC-32（覆盖之前的全部字节）
+// 写入使用 QSaveFile，先写临时文件再原子替换，异常退出不会留下半个文件
+namespace CalibrationCache {
+
+constexpr char kMagic[8] = {'S', 'P', 'E', 'C', 'C', 'A', 'L', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kBlackReference = 0x1;
+constexpr uint32_t kWhiteReference = 0x2;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t pixelCount;     // 每条参考的像素数（SpectrumFrame::kPixelCount）
+  uint32_t referenceMask;  // kBlackReference | kWhiteReference
+  uint32_t reserved;
+  char deviceId[40];       // UTF-8，不足补 0
+};
+
+struct ReferenceHeader {
+  int64_t capturedWallMs;
+  uint32_t frameCount;
+  uint32_t hasStdDev;
+  double integrationUs;
+  double reserved;
+};
+
+static_assert(sizeof(FileHeader) == 64, "calibration cache header layout changed");
+static_assert(sizeof(ReferenceHeader) == 32, "calibration cache reference layout changed");
+
+// 默认缓存文件：<程序目录>/calibration_cache.bin
+QString defaultPath();
+
+// 写入缓存（只写入 isValid() 的参考），失败返回 false 并写入 error
+bool save(const QString &path, const CalibrationCacheContents &contents, QString *error = nullptr);
+
+// 读取缓存：文件不存在、格式或校验和不符时返回 false 并写入 error（文件不存在时 error 为空）
+bool load(const QString &path, CalibrationCacheContents *contents, QString *error = nullptr);
+
+}  // namespace CalibrationCache
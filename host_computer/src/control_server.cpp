@@ -0,0 +1,126 @@
+#include "control_server.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace {
+
+constexpr int kProbeTimeoutMs = 500;  // 探测已有实例时等待连接的时间
+
+}  // namespace
+
+ControlServer::ControlServer(QObject *parent) : QObject(parent), server_(new QLocalServer(this)) {
+  connect(server_, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+  addCommand(QStringLiteral("help"), QStringLiteral("列出可用命令"),
+             [this](const QStringList &, QString *) {
+               QJsonObject commands;
+               for (auto it = commands_.constBegin(); it != commands_.constEnd(); ++it) {
+                 commands.insert(it.key(), it.value().help);
+               }
+               QJsonObject reply;
+               reply.insert(QStringLiteral("commands"), commands);
+               return reply;
+             });
+}
+
+ControlServer::~ControlServer() {
+  close();
+}
+
+void ControlServer::addCommand(const QString &name, const QString &help, Handler handler) {
+  commands_.insert(name, Command{help, std::move(handler)});
+}
+
+bool ControlServer::listen(const QString &name, QString *error) {
+  close();
+  // 只允许同一用户连接
+  server_->setSocketOptions(QLocalServer::UserAccessOption);
+  bool listening = server_->listen(name);
+  if (!listening && server_->serverError() == QAbstractSocket::AddressInUseError) {
+    // 套接字文件已存在：能连上说明另一个实例正在运行，不能删除它的套接字
+    // 连接被拒绝时才是上次异常退出留下的残留文件，删除后重新监听
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(kProbeTimeoutMs)) {
+      probe.disconnectFromServer();
+      if (error) {
+        *error = QStringLiteral("已有实例在运行（%1）").arg(name);
+      }
+      return false;
+    }
+    if (probe.error() == QLocalSocket::ConnectionRefusedError || probe.error() == QLocalSocket::ServerNotFoundError) {
+      QLocalServer::removeServer(name);
+      listening = server_->listen(name);
+    }
+  }
+  if (!listening) {
+    if (error) {
+      *error = server_->errorString();
+    }
+    return false;
+  }
+  qDebug() << "控制套接字已监听:" << server_->fullServerName();
+  return true;
+}
+
+void ControlServer::close() {
+  if (server_->isListening()) {
+    server_->close();
+  }
+}
+
+QString ControlServer::fullServerName() const {
+  return server_->fullServerName();
+}
+
+void ControlServer::onNewConnection() {
+  while (QLocalSocket *socket = server_->nextPendingConnection()) {
+    connect(socket, &QLocalSocket::readyRead, this, &ControlServer::onReadyRead);
+    connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+  }
+}
+
+void ControlServer::onReadyRead() {
+  auto *socket = qobject_cast<QLocalSocket *>(sender());
+  if (!socket) {
+    return;
+  }
+  while (socket->canReadLine()) {
+    const QString line = QString::fromUtf8(socket->readLine()).trimmed();
+    if (line.isEmpty()) {
+      continue;
+    }
+    const QJsonObject reply = execute(line);
+    socket->write(QJsonDocument(reply).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+  }
+  // 没有换行的超长输入直接断开，避免无限缓存
+  if (socket->bytesAvailable() > kMaxLineBytes) {
+    qWarning() << "控制命令过长，断开连接";
+    socket->disconnectFromServer();
+  }
+}
+
+QJsonObject ControlServer::execute(const QString &line) {
+  QStringList args = line.split(QChar(' '), Qt::SkipEmptyParts);
+  const QString name = args.takeFirst();
+  QJsonObject reply;
+  auto it = commands_.constFind(name);
+  if (it == commands_.constEnd()) {
+    reply.insert(QStringLiteral("ok"), false);
+    reply.insert(QStringLiteral("error"), QStringLiteral("未知命令: %1").arg(name));
+    return reply;
+  }
+  QString error;
+  const QJsonObject fields = it.value().handler(args, &error);
+  if (!error.isEmpty()) {
+    reply.insert(QStringLiteral("ok"), false);
+    reply.insert(QStringLiteral("error"), error);
+    return reply;
+  }
+  reply = fields;
+  reply.insert(QStringLiteral("ok"), true);
+  return reply;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QStringList>
+#include <functional>
+
+class QLocalServer;
+class QLocalSocket;
+
+// 本地控制 / 指标套接字（QLocalServer，Unix 域套接字）
+// - 文本行协议：客户端每行发送一条命令（命令名 + 空格分隔的参数），服务端每条命令回复一行 JSON
+//   成功：{"ok": true, ...处理函数返回的字段}；失败：{"ok": false, "error": "..."}
+// - 命令由宿主通过 addCommand() 注册，处理函数在主线程执行
+// - 供无界面守护进程使用：启动 / 停止采集、读取状态统计，界面可以作为独立进程连接
+//
+// 例：echo status | socat - UNIX-CONNECT:/tmp/spectrum_daemon
+class ControlServer : public QObject {
+  Q_OBJECT
+
+ public:
+  // 返回回复中的附加字段；写入 error 表示命令失败
+  using Handler = std::function<QJsonObject(const QStringList &args, QString *error)>;
+
+  explicit ControlServer(QObject *parent = nullptr);
+  ~ControlServer() override;
+
+  // 注册命令（同名覆盖），help 显示在 help 命令的回复中
+  void addCommand(const QString &name, const QString &help, Handler handler);
+
+  // 在给定名称上监听（相对名称位于系统临时目录）
+  // 同名套接字仍有实例在监听时失败（已有实例在运行），无人监听的残留套接字会被移除
+  bool listen(const QString &name, QString *error = nullptr);
+  void close();
+  QString fullServerName() const;
+
+  static const int kMaxLineBytes = 4096;
+
+ private slots:
+  void onNewConnection();
+  void onReadyRead();
+
+ private:
+  QJsonObject execute(const QString &line);
+
+  struct Command {
+    QString help;
+    Handler handler;
+  };
+
+  QLocalServer *server_;
+  QHash<QString, Command> commands_;
+};
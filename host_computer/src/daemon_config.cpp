@@ -0,0 +1,117 @@
+#include "daemon_config.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+QString DaemonConfig::defaultConfigPath() {
+  return QCoreApplication::applicationDirPath() + QStringLiteral("/daemon.json");
+}
+
+bool DaemonConfig::load(const QString &path, QString *error) {
+  QFile file(path);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (document.isNull() || !document.isObject()) {
+    if (error) {
+      *error = parseError.errorString();
+    }
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  DaemonConfig parsed = *this;
+  parsed.serialPort = root.value(QStringLiteral("serialPort")).toString(parsed.serialPort);
+
+  const QJsonObject udp = root.value(QStringLiteral("udp")).toObject();
+  parsed.udpPort = udp.value(QStringLiteral("port")).toInt(parsed.udpPort);
+  parsed.bindAddress = udp.value(QStringLiteral("bindAddress")).toString(parsed.bindAddress);
+  parsed.batchSize = qBound(1, udp.value(QStringLiteral("batchSize")).toInt(parsed.batchSize), 1024);
+  parsed.kernelTimestamps = udp.value(QStringLiteral("kernelTimestamps")).toBool(parsed.kernelTimestamps);
+  if (parsed.udpPort <= 0 || parsed.udpPort > 65535) {
+    if (error) {
+      *error = QStringLiteral("\"udp.port\" 无效");
+    }
+    return false;
+  }
+
+  const QJsonObject replay = root.value(QStringLiteral("replay")).toObject();
+  parsed.replayPath = replay.value(QStringLiteral("path")).toString(parsed.replayPath);
+  parsed.replaySpeed = qMax(0.0, replay.value(QStringLiteral("speed")).toDouble(parsed.replaySpeed));
+  parsed.replayLoop = replay.value(QStringLiteral("loop")).toBool(parsed.replayLoop);
+
+  parsed.processing.load(root.value(QStringLiteral("processing")).toObject());
+  parsed.deviceId = root.value(QStringLiteral("deviceId")).toString(parsed.deviceId);
+
+  if (root.contains(QStringLiteral("predictors"))) {
+    parsed.predictors.clear();
+    const QJsonArray predictors = root.value(QStringLiteral("predictors")).toArray();
+    for (const QJsonValue &value : predictors) {
+      const QJsonObject object = value.toObject();
+      Predictor predictor;
+      predictor.algorithm = object.value(QStringLiteral("algorithm")).toString();
+      predictor.index = object.value(QStringLiteral("index")).toInt(-1);
+      predictor.model = object.value(QStringLiteral("model")).toString();
+      if (predictor.algorithm.isEmpty() && predictor.index < 0) {
+        if (error) {
+          *error = QStringLiteral("\"predictors\" 的每一项需要 algorithm 或 index");
+        }
+        return false;
+      }
+      parsed.predictors.append(predictor);
+    }
+  }
+
+  const QJsonObject monitor = root.value(QStringLiteral("monitor")).toObject();
+  parsed.lowerLimit = monitor.value(QStringLiteral("lowerLimit")).toDouble(parsed.lowerLimit);
+  parsed.upperLimit = monitor.value(QStringLiteral("upperLimit")).toDouble(parsed.upperLimit);
+  parsed.logSpectrum = root.value(QStringLiteral("logSpectrum")).toBool(parsed.logSpectrum);
+
+  const QJsonObject recording = root.value(QStringLiteral("recording")).toObject();
+  parsed.recordingBasePath = recording.value(QStringLiteral("basePath")).toString(parsed.recordingBasePath);
+  parsed.recordingMaxFileMB = qMax(1, recording.value(QStringLiteral("maxFileMB")).toInt(parsed.recordingMaxFileMB));
+  parsed.recordingDirectIo = recording.value(QStringLiteral("directIo")).toBool(parsed.recordingDirectIo);
+
+  parsed.controlSocket = root.value(QStringLiteral("controlSocket")).toString(parsed.controlSocket);
+  parsed.publisherConfig = root.value(QStringLiteral("publisherConfig")).toString(parsed.publisherConfig);
+  parsed.devicesConfig = root.value(QStringLiteral("devicesConfig")).toString(parsed.devicesConfig);
+  parsed.autoStart = root.value(QStringLiteral("autoStart")).toBool(parsed.autoStart);
+
+  *this = parsed;
+  return true;
+}
+
+QString DaemonConfig::describe() const {
+  QStringList parts;
+  if (!replayPath.isEmpty()) {
+    parts << QStringLiteral("replay=%1@%2x").arg(replayPath).arg(replaySpeed);
+  } else {
+    parts << QStringLiteral("serial=%1").arg(serialPort.isEmpty() ? QStringLiteral("-") : serialPort)
+          << QStringLiteral("udp=%1:%2").arg(bindAddress).arg(udpPort);
+  }
+  QStringList predictorNames;
+  for (const Predictor &p : predictors) {
+    predictorNames << (p.algorithm.isEmpty() ? QString::number(p.index) : p.algorithm);
+  }
+  parts << QStringLiteral("predictors=[%1]").arg(predictorNames.join(QStringLiteral(",")));
+  if (monitorEnabled()) {
+    parts << QStringLiteral("monitor=%1~%2").arg(lowerLimit).arg(upperLimit);
+  }
+  if (!recordingBasePath.isEmpty()) {
+    parts << QStringLiteral("record=%1").arg(recordingBasePath);
+  }
+  parts << QStringLiteral("control=%1").arg(controlSocket.isEmpty() ? QStringLiteral("-") : controlSocket);
+  return parts.join(QStringLiteral(" "));
+}
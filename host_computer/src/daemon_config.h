@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include "processing_config.h"
+
+// 无界面采集守护进程（calc_daemon）的配置
+// - 配置文件为 JSON（默认 <程序目录>/daemon.json），不存在时使用默认值（与界面程序的默认串口、UDP 参数相同）
+// - 未列出的处理参数保持 UdpCommunicator 的默认值；黑白参考从标定缓存恢复（见 CalibrationCache）
+//
+// 配置示例：
+// {
+//   "serialPort": "/dev/ttyUSB0",
+//   "udp": { "port": 1234, "bindAddress": "192.168.1.102", "batchSize": 32, "kernelTimestamps": false },
+//   "replay": { "path": "", "speed": 1.0, "loop": false },
+//   "processing": { "spectrumThreshold": 100, "averagingMode": 0, "outputInterval": 10, "emaTimeConstant": 50,
+//                   "adaptiveTargetSnr": 1000, "adaptiveTargetStdError": 0, "adaptiveMinPackets": 400,
+//                   "adaptiveMaxPackets": 15800, "referenceTargetStdError": 0 },
+//   "deviceId": "line1",
+//   "predictors": [ { "algorithm": "random_forest", "model": "" }, { "index": 1 } ],
+//   "monitor": { "lowerLimit": 10.0, "upperLimit": 20.0 },
+//   "logSpectrum": true,
+//   "recording": { "basePath": "", "maxFileMB": 1024, "directIo": false },
+//   "controlSocket": "spectrum_daemon",
+//   "publisherConfig": "",
+//   "devicesConfig": "",
+//   "autoStart": true
+// }
+// - serialPort 为空时不发送串口启动命令，直接开始 UDP 接收（光谱仪已在发送数据）
+// - replay.path 非空时用录制文件代替光谱仪输入（联调、离线测量吞吐）
+// - processing.averagingMode 为 3 时按 adaptive* 自适应决定每条光谱的数据包数（见 SpectrumProcessor::AdaptiveMode）
+// - predictors：按 algorithm（插件的 algorithm()）或 index 选择预测器，model 为空时加载默认模型
+// - monitor：lowerLimit < upperLimit 时启用异常监控，结果状态写入 log/result.csv
+// - recording.basePath 非空时开始采集的同时录制原始帧
+// - publisherConfig：预测结果网络发布的配置文件（见 ResultPublisher），为空时使用 <程序目录>/publisher.json
+// - devicesConfig：其余光谱仪的配置文件（见 DeviceRegistry），为空时使用 <程序目录>/devices.json，
+//   文件不存在时只采集上面的一台设备
+struct DaemonConfig {
+  struct Predictor {
+    QString algorithm;
+    int index = -1;
+    QString model;
+  };
+
+  QString serialPort = QStringLiteral("/dev/ttyUSB0");
+  int udpPort = 1234;
+  QString bindAddress = QStringLiteral("192.168.1.102");
+  int batchSize = 32;
+  bool kernelTimestamps = false;
+
+  QString replayPath;
+  double replaySpeed = 1.0;
+  bool replayLoop = false;
+
+  ProcessingConfig processing;
+  QString deviceId;
+
+  QVector<Predictor> predictors;
+
+  double lowerLimit = 0.0;
+  double upperLimit = 0.0;
+  bool logSpectrum = true;
+
+  QString recordingBasePath;
+  int recordingMaxFileMB = 1024;
+  bool recordingDirectIo = false;
+
+  QString controlSocket = QStringLiteral("spectrum_daemon");
+  QString publisherConfig;
+  QString devicesConfig;
+  bool autoStart = true;
+
+  bool monitorEnabled() const { return upperLimit > lowerLimit; }
+
+  static QString defaultConfigPath();
+
+  // 读取配置文件；文件不存在返回 true 并保留默认值，格式错误返回 false 并写入 error
+  bool load(const QString &path, QString *error = nullptr);
+  QString describe() const;
+};
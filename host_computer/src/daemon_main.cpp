@@ -0,0 +1,83 @@
+// 无界面采集守护进程入口：calc_daemon [--config <daemon.json>]
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "acquisition_daemon.h"
+#include "daemon_config.h"
+
+namespace {
+
+// SIGINT / SIGTERM 经 socketpair 转到事件循环中处理（信号处理函数里只做 write）
+int g_signalFds[2] = {-1, -1};
+
+void onSignal(int) {
+  const char byte = 1;
+  const ssize_t written = ::write(g_signalFds[0], &byte, 1);
+  Q_UNUSED(written);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName(QStringLiteral("calc_daemon"));
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QStringLiteral("光谱采集与预测守护进程（无界面）"));
+  parser.addHelpOption();
+  QCommandLineOption configOption(QStringList() << QStringLiteral("c") << QStringLiteral("config"),
+                                  QStringLiteral("配置文件路径（默认 <程序目录>/daemon.json）"),
+                                  QStringLiteral("path"));
+  parser.addOption(configOption);
+  parser.process(app);
+
+  DaemonConfig config;
+  const QString configPath = parser.isSet(configOption) ? parser.value(configOption)
+                                                        : DaemonConfig::defaultConfigPath();
+  QString error;
+  if (!config.load(configPath, &error)) {
+    qCritical() << "配置文件无效:" << configPath << error;
+    return 1;
+  }
+
+  AcquisitionDaemon daemon(config);
+  LogManager::installGlobalHandler();
+  qDebug() << "守护进程配置:" << config.describe();
+
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, g_signalFds) == 0) {
+    auto *notifier = new QSocketNotifier(g_signalFds[1], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, &QSocketNotifier::activated, &app, [notifier]() {
+      notifier->setEnabled(false);
+      char byte = 0;
+      const ssize_t count = ::read(g_signalFds[1], &byte, 1);
+      Q_UNUSED(count);
+      qDebug() << "收到退出信号";
+      QCoreApplication::quit();
+    });
+    struct sigaction action = {};
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+  }
+
+  QObject::connect(&daemon, &AcquisitionDaemon::quitRequested, &app, &QCoreApplication::quit);
+  // 退出前停止采集（串口停止命令、结束录制），日志在 LogManager 析构时写完
+  QObject::connect(&app, &QCoreApplication::aboutToQuit, &daemon, [&daemon]() { daemon.stop(); });
+
+  if (!daemon.initialize(&error)) {
+    qCritical() << "守护进程初始化失败:" << error;
+    return 1;
+  }
+  if (config.autoStart && !daemon.start(&error)) {
+    // 光谱仪可能还没上电：保持运行，等待控制命令 start
+    qWarning() << "自动开始采集失败，等待控制命令:" << error;
+  }
+  return app.exec();
+}
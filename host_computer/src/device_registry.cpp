@@ -0,0 +1,369 @@
+#include "device_registry.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+
+#include "serial_communicator.h"
+#include "spectrum_predictor_manager.h"
+#include "spectrum_worker_pool.h"
+#include "udp_communicator.h"
+#include "udp_receiver_hub.h"
+
+QString DeviceRegistry::Config::defaultConfigPath() {
+  return QCoreApplication::applicationDirPath() + QStringLiteral("/devices.json");
+}
+
+bool DeviceRegistry::Config::load(const QString &path, QString *error) {
+  QFile file(path);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (document.isNull() || !document.isObject()) {
+    if (error) {
+      *error = parseError.errorString();
+    }
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  Config parsed = *this;
+  parsed.processingWorkers =
+      qBound(0, root.value(QStringLiteral("processingWorkers")).toInt(parsed.processingWorkers), 64);
+  parsed.autoStart = root.value(QStringLiteral("autoStart")).toBool(parsed.autoStart);
+
+  if (root.contains(QStringLiteral("devices"))) {
+    parsed.devices.clear();
+    QSet<QString> ids;
+    QSet<int> ports;
+    const QJsonArray devices = root.value(QStringLiteral("devices")).toArray();
+    for (const QJsonValue &value : devices) {
+      const QJsonObject object = value.toObject();
+      DeviceConfig device;
+      device.id = object.value(QStringLiteral("id")).toString();
+      device.port = object.value(QStringLiteral("port")).toInt(device.port);
+      device.bindAddress = object.value(QStringLiteral("bindAddress")).toString();
+      device.serialPort = object.value(QStringLiteral("serialPort")).toString();
+      device.batchSize = qBound(1, object.value(QStringLiteral("batchSize")).toInt(device.batchSize), 1024);
+      device.kernelTimestamps = object.value(QStringLiteral("kernelTimestamps")).toBool(device.kernelTimestamps);
+      device.frameCounterTrailer =
+          object.value(QStringLiteral("frameCounterTrailer")).toBool(device.frameCounterTrailer);
+      device.predictors = object.value(QStringLiteral("predictors")).toArray().toVariantList();
+
+      device.processing.load(object.value(QStringLiteral("processing")).toObject());
+      device.calibrationCache = object.value(QStringLiteral("calibrationCache")).toString();
+
+      // 每台设备需要唯一的 id 与端口：数据包来源只能按接收端口区分
+      QString invalid;
+      if (device.id.isEmpty()) {
+        invalid = QStringLiteral("\"devices\" 的每一项需要 id");
+      } else if (ids.contains(device.id)) {
+        invalid = QStringLiteral("设备 id 重复: %1").arg(device.id);
+      } else if (device.port <= 0 || device.port > 65535) {
+        invalid = QStringLiteral("设备 %1 的 port 无效").arg(device.id);
+      } else if (ports.contains(device.port)) {
+        invalid = QStringLiteral("设备 %1 的 port %2 与其他设备重复").arg(device.id).arg(device.port);
+      }
+      if (!invalid.isEmpty()) {
+        if (error) {
+          *error = invalid;
+        }
+        return false;
+      }
+      ids.insert(device.id);
+      ports.insert(device.port);
+      parsed.devices.append(device);
+    }
+  }
+
+  *this = parsed;
+  return true;
+}
+
+bool DeviceRegistry::Config::checkPrimaryConflicts(int primaryPort, const QString &primarySerialPort,
+                                                  QString *error) const {
+  for (const DeviceConfig &device : devices) {
+    QString invalid;
+    if (device.port == primaryPort) {
+      invalid = QStringLiteral("设备 %1 的 port %2 与主设备的 UDP 端口相同").arg(device.id).arg(device.port);
+    } else if (!primarySerialPort.isEmpty() && device.serialPort == primarySerialPort) {
+      invalid = QStringLiteral("设备 %1 的 serialPort %2 与主设备的串口相同").arg(device.id, device.serialPort);
+    }
+    if (!invalid.isEmpty()) {
+      if (error) {
+        *error = invalid;
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+QString DeviceRegistry::Config::describe() const {
+  QStringList parts;
+  for (const DeviceConfig &device : devices) {
+    const QString address = device.bindAddress.isEmpty() ? QStringLiteral("*") : device.bindAddress;
+    parts << QStringLiteral("%1=%2:%3").arg(device.id, address).arg(device.port);
+  }
+  parts << QStringLiteral("workers=%1").arg(processingWorkers > 0 ? processingWorkers
+                                                                   : SpectrumWorkerPool::defaultWorkerCount());
+  return parts.join(QStringLiteral(" "));
+}
+
+DeviceRegistry::DeviceRegistry(SpectrumPredictorManager *predictorManager, QObject *parent)
+    : QObject(parent), predictorManager_(predictorManager) {}
+
+DeviceRegistry::~DeviceRegistry() {
+  clearDevices();
+}
+
+bool DeviceRegistry::configure(const Config &config, QString *error) {
+  // 先解析全部预测器：任意一台设备的配置无效时不改变当前设备
+  QVector<QVariantList> indices(config.devices.size());
+  for (int i = 0; i < config.devices.size(); i++) {
+    if (!resolvePredictors(config.devices[i], &indices[i], error)) {
+      return false;
+    }
+  }
+
+  clearDevices();
+  if (config.devices.isEmpty()) {
+    workerPool_.reset();
+    receiverHub_.reset();
+    emit devicesChanged();
+    return true;
+  }
+
+  const int workers = config.processingWorkers > 0 ? config.processingWorkers
+                                                    : SpectrumWorkerPool::defaultWorkerCount();
+  if (!workerPool_ || workerPool_->workerCount() != workers) {
+    workerPool_ = std::make_unique<SpectrumWorkerPool>(workers);
+  }
+  if (!receiverHub_) {
+    receiverHub_ = std::make_unique<UdpReceiverHub>();
+  }
+
+  for (int i = 0; i < config.devices.size(); i++) {
+    const DeviceConfig &deviceConfig = config.devices[i];
+    auto device = std::make_unique<Device>();
+    device->config = deviceConfig;
+    device->streamId = i + 1;
+    device->udp = std::make_unique<UdpCommunicator>();
+    UdpCommunicator *udp = device->udp.get();
+
+    udp->setStreamId(device->streamId);
+    udp->setWorkerPool(workerPool_.get());
+    udp->setReceiverHub(receiverHub_.get());
+    udp->setPredictorManager(predictorManager_);
+    udp->setDeviceId(deviceConfig.id);
+    udp->setCalibrationCachePath(deviceConfig.calibrationCache.isEmpty()
+                                     ? QCoreApplication::applicationDirPath() +
+                                           QStringLiteral("/calibration_cache_%1.bin").arg(deviceConfig.id)
+                                     : deviceConfig.calibrationCache);
+    udp->setFrameCounterTrailer(deviceConfig.frameCounterTrailer);
+    applyProcessingConfig(udp, deviceConfig.processing);
+    if (!udp->loadCalibrationCache()) {
+      qWarning() << "设备" << deviceConfig.id << "没有可用的标定缓存，需要采集黑白参考后才会输出预测";
+    }
+    udp->setPredictorIndices(indices[i]);
+
+    const QString id = deviceConfig.id;
+    const int streamId = device->streamId;
+    connect(udp, &UdpCommunicator::spectrumReady, this,
+            [this, id, streamId](const QVariantList &averagedSpectrum, double, double, int, double) {
+              emit spectrumReady(id, streamId, averagedSpectrum);
+            });
+    connect(udp, &UdpCommunicator::predictionReady, this,
+            [this, id, streamId](int predictorIndex, double predictionValue) {
+              emit predictionReady(id, streamId, predictorIndex, predictionValue);
+            });
+    connect(udp, &UdpCommunicator::statusChanged, this,
+            [this, id](const QString &message) { emit statusChanged(id, message); });
+
+    if (!deviceConfig.serialPort.isEmpty()) {
+      device->serial = std::make_unique<SerialCommunicator>();
+      // 与单设备相同：启动命令发送成功后开始 UDP 接收
+      Device *raw = device.get();
+      connect(device->serial.get(), &SerialCommunicator::stateChanged, this, [raw](bool started) {
+        if (started) {
+          raw->udp->startReceiving(raw->config.port, raw->config.bindAddress, raw->config.batchSize,
+                                   raw->config.kernelTimestamps);
+        } else {
+          raw->udp->stopReceiving();
+        }
+      });
+      connect(device->serial.get(), &SerialCommunicator::statusChanged, this,
+              [this, id](const QString &message) { emit statusChanged(id, message); });
+    }
+    devices_.push_back(std::move(device));
+  }
+  emit devicesChanged();
+  return true;
+}
+
+bool DeviceRegistry::resolvePredictors(const DeviceConfig &config, QVariantList *indices, QString *error) {
+  indices->clear();
+  const int count = static_cast<int>(predictorManager_->predictorNames().size());
+  for (const QVariant &entry : config.predictors) {
+    bool isIndex = false;
+    int index = entry.toInt(&isIndex);
+    if (!isIndex) {
+      index = -1;
+      const QString algorithm = entry.toString();
+      for (int i = 0; i < count; i++) {
+        if (predictorManager_->getAlgorithm(i) == algorithm) {
+          index = i;
+          break;
+        }
+      }
+    }
+    if (index < 0 || index >= count) {
+      if (error) {
+        *error = QStringLiteral("设备 %1 找不到预测器: %2").arg(config.id, entry.toString());
+      }
+      return false;
+    }
+    // 多台设备可以共用同一个预测器，已加载的模型不重复加载
+    if (!predictorManager_->isModelLoaded(index) && !predictorManager_->loadModelAuto(index)) {
+      if (error) {
+        *error = QStringLiteral("设备 %1 的预测器 %2 模型加载失败").arg(config.id).arg(index);
+      }
+      return false;
+    }
+    if (!indices->contains(index)) {
+      indices->append(index);
+    }
+  }
+  return true;
+}
+
+QStringList DeviceRegistry::deviceIds() const {
+  QStringList ids;
+  for (const auto &device : devices_) {
+    ids << device->config.id;
+  }
+  return ids;
+}
+
+int DeviceRegistry::indexOf(const QString &id) const {
+  for (size_t i = 0; i < devices_.size(); i++) {
+    if (devices_[i]->config.id == id) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+UdpCommunicator *DeviceRegistry::device(const QString &id) const {
+  return deviceAt(indexOf(id));
+}
+
+UdpCommunicator *DeviceRegistry::deviceAt(int index) const {
+  if (index < 0 || index >= count()) {
+    return nullptr;
+  }
+  return devices_[index]->udp.get();
+}
+
+int DeviceRegistry::streamId(const QString &id) const {
+  const int index = indexOf(id);
+  return index < 0 ? -1 : devices_[index]->streamId;
+}
+
+bool DeviceRegistry::startDevice(Device &device) {
+  if (device.udp->isReceiving()) {
+    return true;
+  }
+  if (device.serial) {
+    return device.serial->sendStartCommand(device.config.serialPort) && device.udp->isReceiving();
+  }
+  return device.udp->startReceiving(device.config.port, device.config.bindAddress, device.config.batchSize,
+                                    device.config.kernelTimestamps);
+}
+
+void DeviceRegistry::stopDevice(Device &device) {
+  if (device.serial && device.serial->isStarted()) {
+    device.serial->sendStopCommand(device.config.serialPort);
+  }
+  if (device.udp->isReceiving()) {
+    device.udp->stopReceiving();
+  }
+}
+
+bool DeviceRegistry::start(const QString &id) {
+  const int index = indexOf(id);
+  return index >= 0 && startDevice(*devices_[index]);
+}
+
+void DeviceRegistry::stop(const QString &id) {
+  const int index = indexOf(id);
+  if (index >= 0) {
+    stopDevice(*devices_[index]);
+  }
+}
+
+bool DeviceRegistry::startAll() {
+  // 某台设备启动失败不影响其他设备
+  bool ok = true;
+  for (auto &device : devices_) {
+    if (!startDevice(*device)) {
+      qWarning() << "设备" << device->config.id << "启动失败";
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+void DeviceRegistry::stopAll() {
+  for (auto &device : devices_) {
+    stopDevice(*device);
+  }
+}
+
+void DeviceRegistry::clearDevices() {
+  stopAll();
+  // 通信器析构时从接收线程与工作线程池注销，之后才能销毁这两个共享对象
+  devices_.clear();
+}
+
+QVariantList DeviceRegistry::status() const {
+  QVariantList list;
+  for (const auto &device : devices_) {
+    const UdpCommunicator *udp = device->udp.get();
+    QVariantMap s;
+    s.insert(QStringLiteral("id"), device->config.id);
+    s.insert(QStringLiteral("streamId"), device->streamId);
+    s.insert(QStringLiteral("port"), device->config.port);
+    s.insert(QStringLiteral("receiving"), udp->isReceiving());
+    s.insert(QStringLiteral("packetCount"), udp->packetCount());
+    s.insert(QStringLiteral("packetsPerSecond"), udp->packetsPerSecond());
+    s.insert(QStringLiteral("processedFramesPerSecond"), udp->processedFramesPerSecond());
+    s.insert(QStringLiteral("predictionsPerSecond"), udp->predictionsPerSecond());
+    s.insert(QStringLiteral("droppedFrames"), udp->droppedFrames());
+    s.insert(QStringLiteral("lostFrames"), udp->lostFrames());
+    s.insert(QStringLiteral("kernelDrops"), udp->kernelDrops());
+    s.insert(QStringLiteral("calibrationFromCache"), udp->calibrationFromCache());
+    s.insert(QStringLiteral("calibrationStale"), udp->calibrationStale());
+    list.append(s);
+  }
+  return list;
+}
+
+QVariantMap DeviceRegistry::threads() const {
+  QVariantMap t;
+  t.insert(QStringLiteral("processingWorkers"), workerPool_ ? workerPool_->workerCount() : 0);
+  t.insert(QStringLiteral("receiverEndpoints"), receiverHub_ ? receiverHub_->endpointCount() : 0);
+  return t;
+}
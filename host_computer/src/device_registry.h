@@ -0,0 +1,131 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+#include "processing_config.h"
+
+class SerialCommunicator;
+class SpectrumPredictorManager;
+class SpectrumWorkerPool;
+class UdpCommunicator;
+class UdpReceiverHub;
+
+// 多台光谱仪：按 <程序目录>/devices.json 为每台设备创建一条独立的 UdpCommunicator 流水线
+// - 每台设备使用自己的 UDP 端口（以及可选的串口），标定缓存、处理参数与预测器选择互相独立
+// - 所有设备的套接字由一个 UdpReceiverHub 线程通过 epoll 接收（不再每台设备一个接收线程），
+//   平均与预测由固定大小的 SpectrumWorkerPool 处理（不再每台设备一个处理线程）
+// - 所有设备共用一个 SpectrumPredictorManager 与推理执行器；请求带 streamId（设备序号 + 1），
+//   执行器按 streamId 分别限长，结果只回到发出请求的设备（见 InferenceExecutor）
+//
+// {
+//   "processingWorkers": 0,
+//   "autoStart": false,
+//   "devices": [
+//     { "id": "line1", "port": 1235, "bindAddress": "192.168.1.102", "serialPort": "/dev/ttyUSB1",
+//       "batchSize": 32, "kernelTimestamps": false, "frameCounterTrailer": false,
+//       "predictors": [0, "random_forest"],
+//       "processing": { "spectrumThreshold": 0, "referenceThreshold": 0, "averagingMode": -1,
+//                       "outputInterval": 0, "emaTimeConstant": 0, "adaptiveTargetSnr": -1,
+//                       "adaptiveTargetStdError": -1, "adaptiveMinPackets": 0, "adaptiveMaxPackets": 0,
+//                       "referenceTargetStdError": -1 },
+//       "calibrationCache": "" }
+//   ]
+// }
+// - processingWorkers 为 0 时使用 SpectrumWorkerPool::defaultWorkerCount()
+// - predictors：预测器索引或插件的 algorithm()，未加载模型的预测器按默认路径加载
+// - processing 中 <= 0（averagingMode 与 adaptive / reference 目标项 < 0）的项保持默认值
+// - calibrationCache 为空时使用 <程序目录>/calibration_cache_<id>.bin
+class DeviceRegistry : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(int count READ count NOTIFY devicesChanged)
+  Q_PROPERTY(QStringList deviceIds READ deviceIds NOTIFY devicesChanged)
+
+ public:
+  struct DeviceConfig {
+    QString id;
+    int port = 1234;
+    QString bindAddress;
+    QString serialPort;  // 为空时不发送串口启动命令，直接开始 UDP 接收
+    int batchSize = 32;
+    bool kernelTimestamps = false;
+    bool frameCounterTrailer = false;
+    QVariantList predictors;  // int 索引或 algorithm 字符串
+
+    ProcessingConfig processing;
+
+    QString calibrationCache;
+  };
+
+  struct Config {
+    int processingWorkers = 0;
+    bool autoStart = false;
+    QVector<DeviceConfig> devices;
+
+    static QString defaultConfigPath();
+    // 文件不存在时返回 true 并保持默认值（不配置多设备）
+    bool load(const QString &path, QString *error = nullptr);
+    // 主流水线占用的 UDP 端口与串口不能再分配给其他设备：串口启停命令相同（再次发送会关闭光谱仪），
+    // 同一端口上的两个套接字会分走彼此的数据报；primarySerialPort 为空时只检查端口
+    bool checkPrimaryConflicts(int primaryPort, const QString &primarySerialPort, QString *error = nullptr) const;
+    QString describe() const;
+  };
+
+  explicit DeviceRegistry(SpectrumPredictorManager *predictorManager, QObject *parent = nullptr);
+  ~DeviceRegistry() override;
+
+  // 按配置重建所有设备的流水线（已有设备先停止并销毁）；预测器无法解析或加载时返回 false
+  bool configure(const Config &config, QString *error = nullptr);
+
+  int count() const { return static_cast<int>(devices_.size()); }
+  QStringList deviceIds() const;
+
+  // 设备的通信器（界面可直接绑定其属性），找不到时返回空
+  Q_INVOKABLE UdpCommunicator *device(const QString &id) const;
+  Q_INVOKABLE UdpCommunicator *deviceAt(int index) const;
+  // 设备序号对应的 streamId（设备序号 + 1；0 保留给单设备的主通信器）
+  Q_INVOKABLE int streamId(const QString &id) const;
+
+  Q_INVOKABLE bool start(const QString &id);
+  Q_INVOKABLE void stop(const QString &id);
+  Q_INVOKABLE bool startAll();
+  Q_INVOKABLE void stopAll();
+
+  // 每台设备一项：id、streamId、port、receiving、packetCount、packetsPerSecond、processedFramesPerSecond、
+  // predictionsPerSecond、droppedFrames、lostFrames、kernelDrops、calibrationFromCache、calibrationStale
+  Q_INVOKABLE QVariantList status() const;
+  // 共享线程：processingWorkers、receiverEndpoints
+  Q_INVOKABLE QVariantMap threads() const;
+
+ signals:
+  void devicesChanged();
+  // 任一设备的光谱与预测结果（主线程）
+  void spectrumReady(const QString &deviceId, int streamId, const QVariantList &averagedSpectrum);
+  void predictionReady(const QString &deviceId, int streamId, int predictorIndex, double predictionValue);
+  void statusChanged(const QString &deviceId, const QString &message);
+
+ private:
+  struct Device {
+    DeviceConfig config;
+    int streamId = 0;
+    std::unique_ptr<UdpCommunicator> udp;
+    std::unique_ptr<SerialCommunicator> serial;  // 未配置串口时为空
+  };
+
+  bool resolvePredictors(const DeviceConfig &config, QVariantList *indices, QString *error);
+  int indexOf(const QString &id) const;
+  bool startDevice(Device &device);
+  void stopDevice(Device &device);
+  void clearDevices();
+
+  SpectrumPredictorManager *predictorManager_;
+  // 声明顺序：设备在接收线程与工作线程池之前销毁
+  std::unique_ptr<SpectrumWorkerPool> workerPool_;
+  std::unique_ptr<UdpReceiverHub> receiverHub_;
+  std::vector<std::unique_ptr<Device>> devices_;
+};
@@ -0,0 +1,187 @@
+#include "display_feed.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+// 接收线程 → 显示的“最新帧”槽位：覆盖写入，不排队，显示跟不上时自然丢弃中间帧
+class DisplayFeed::LatestFrameSink : public SpectrumFrameSink {
+ public:
+  explicit LatestFrameSink(const std::atomic<bool> &enabled) : enabled_(enabled), version_(0) {}
+
+  void pushFrames(const SpectrumFramePtr *frames, int count) override {
+    if (count <= 0 || !enabled_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    std::atomic_store_explicit(&latest_, frames[count - 1], std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  SpectrumFramePtr latest() const { return std::atomic_load_explicit(&latest_, std::memory_order_acquire); }
+  quint64 version() const { return version_.load(std::memory_order_acquire); }
+  void reset() { std::atomic_store(&latest_, SpectrumFramePtr()); }
+
+ private:
+  const std::atomic<bool> &enabled_;
+  SpectrumFramePtr latest_;
+  std::atomic<quint64> version_;
+};
+
+namespace {
+
+template <typename T>
+void decimate(const T *data, int count, int buckets, float *out) {
+  // 第 b 列覆盖 [b * count / buckets, (b + 1) * count / buckets)，每列至少一个点
+  for (int b = 0; b < buckets; ++b) {
+    const int begin = static_cast<int>(static_cast<qint64>(b) * count / buckets);
+    const int end = std::max(begin + 1, static_cast<int>(static_cast<qint64>(b + 1) * count / buckets));
+    T lo = data[begin];
+    T hi = data[begin];
+    for (int i = begin + 1; i < end; ++i) {
+      lo = std::min(lo, data[i]);
+      hi = std::max(hi, data[i]);
+    }
+    out[2 * b] = static_cast<float>(lo);
+    out[2 * b + 1] = static_cast<float>(hi);
+  }
+}
+
+}  // namespace
+
+DisplayFeed::DisplayFeed(QObject *parent)
+    : QObject(parent), plotWidth_(DEFAULT_PLOT_WIDTH), maxFps_(DEFAULT_MAX_FPS),
+      liveFrameEnabled_(false), shownFrameVersion_(0),
+      pendingMin_(0.0), pendingMax_(0.0), pendingPacketCount_(0), spectrumPending_(false),
+      spectrumPoints_(0), spectrumMin_(0.0), spectrumMax_(0.0), spectrumPacketCount_(0),
+      liveMin_(0.0), liveMax_(0.0) {
+  frameSink_ = std::make_shared<LatestFrameSink>(liveFrameEnabled_);
+
+  displayTimer_ = new QTimer(this);
+  displayTimer_->setTimerType(Qt::PreciseTimer);
+  displayTimer_->setInterval(1000 / maxFps_);
+  connect(displayTimer_, &QTimer::timeout, this, &DisplayFeed::onDisplayTimer);
+}
+
+std::shared_ptr<SpectrumFrameSink> DisplayFeed::frameSink() const {
+  return frameSink_;
+}
+
+void DisplayFeed::setPlotWidth(int pixels) {
+  pixels = qMax(2, pixels);
+  if (pixels == plotWidth_) {
+    return;
+  }
+  plotWidth_ = pixels;
+  emit plotWidthChanged(pixels);
+  // 按新的宽度重新抽取当前显示的光谱，不必等下一条数据
+  if (!shownSpectrum_.isEmpty()) {
+    rebuildSpectrumEnvelope();
+    emit spectrumUpdated();
+  }
+}
+
+void DisplayFeed::setMaxFps(int fps) {
+  fps = qBound(1, fps, 240);
+  if (fps == maxFps_) {
+    return;
+  }
+  maxFps_ = fps;
+  displayTimer_->setInterval(1000 / fps);
+  emit maxFpsChanged(fps);
+}
+
+void DisplayFeed::setLiveFrameEnabled(bool enabled) {
+  if (enabled == liveFrameEnabled()) {
+    return;
+  }
+  liveFrameEnabled_.store(enabled, std::memory_order_relaxed);
+  if (!enabled) {
+    frameSink_->reset();
+    liveEnvelope_.clear();
+    emit liveFrameUpdated();
+  }
+  emit liveFrameEnabledChanged(enabled);
+}
+
+void DisplayFeed::submitSpectrum(const QVector<double> &spectrum, double minVal, double maxVal, int packetCount) {
+  QMutexLocker locker(&mutex_);
+  pendingSpectrum_ = spectrum;
+  pendingMin_ = minVal;
+  pendingMax_ = maxVal;
+  pendingPacketCount_ = packetCount;
+  spectrumPending_ = true;
+}
+
+void DisplayFeed::start() {
+  shownFrameVersion_ = frameSink_->version();
+  displayTimer_->start();
+}
+
+void DisplayFeed::stop() {
+  displayTimer_->stop();
+  // 停止前把最后一条光谱显示出来
+  onDisplayTimer();
+  frameSink_->reset();
+}
+
+void DisplayFeed::onDisplayTimer() {
+  bool spectrumChanged = false;
+  {
+    QMutexLocker locker(&mutex_);
+    if (spectrumPending_) {
+      spectrumPending_ = false;
+      shownSpectrum_ = pendingSpectrum_;
+      pendingSpectrum_ = QVector<double>();
+      spectrumMin_ = pendingMin_;
+      spectrumMax_ = pendingMax_;
+      spectrumPacketCount_ = pendingPacketCount_;
+      spectrumChanged = true;
+    }
+  }
+  if (spectrumChanged) {
+    rebuildSpectrumEnvelope();
+    emit spectrumUpdated();
+  }
+
+  if (!liveFrameEnabled()) {
+    return;
+  }
+  const quint64 version = frameSink_->version();
+  if (version == shownFrameVersion_) {
+    return;
+  }
+  shownFrameVersion_ = version;
+  const SpectrumFramePtr frame = frameSink_->latest();
+  if (!frame || frame->count <= 0) {
+    return;
+  }
+  const int count = qMin(frame->count, SpectrumFrame::kPixelCount);
+  const int buckets = qMin(plotWidth_, count);
+  liveEnvelope_.resize(static_cast<qsizetype>(2 * buckets * sizeof(float)));
+  float *out = reinterpret_cast<float *>(liveEnvelope_.data());
+  decimateMinMax(frame->data, count, buckets, out);
+  const auto range = std::minmax_element(frame->data, frame->data + count);
+  liveMin_ = *range.first;
+  liveMax_ = *range.second;
+  emit liveFrameUpdated();
+}
+
+void DisplayFeed::rebuildSpectrumEnvelope() {
+  const int count = static_cast<int>(shownSpectrum_.size());
+  spectrumPoints_ = count;
+  if (count == 0) {
+    spectrumEnvelope_.clear();
+    return;
+  }
+  const int buckets = qMin(plotWidth_, count);
+  spectrumEnvelope_.resize(static_cast<qsizetype>(2 * buckets * sizeof(float)));
+  decimateMinMax(shownSpectrum_.constData(), count, buckets, reinterpret_cast<float *>(spectrumEnvelope_.data()));
+}
+
+void DisplayFeed::decimateMinMax(const double *data, int count, int buckets, float *out) {
+  decimate(data, count, buckets, out);
+}
+
+void DisplayFeed::decimateMinMax(const uint16_t *data, int count, int buckets, float *out) {
+  decimate(data, count, buckets, out);
+}
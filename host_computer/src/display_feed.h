@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "spectrum_frame.h"
+#include "spectrum_frame_queue.h"
+
+// 实时曲线的显示数据源（主线程对象）
+// - 处理线程提交的平均光谱、接收线程送来的原始帧都只保留最新一份，按显示帧率合并
+// - 每个显示周期把最新数据按绘图区像素宽度做最小/最大值抽取（保留尖峰），
+//   以 float32 交错数组 [min0, max0, min1, max1, ...] 的 QByteArray 整体替换
+//   （QML 中为 ArrayBuffer，可直接用 Float32Array 读取），不再逐点构造 QVariantList
+class DisplayFeed : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(int plotWidth READ plotWidth WRITE setPlotWidth NOTIFY plotWidthChanged)
+  Q_PROPERTY(int maxFps READ maxFps WRITE setMaxFps NOTIFY maxFpsChanged)
+  Q_PROPERTY(bool liveFrameEnabled READ liveFrameEnabled WRITE setLiveFrameEnabled NOTIFY liveFrameEnabledChanged)
+  Q_PROPERTY(QByteArray spectrumEnvelope READ spectrumEnvelope NOTIFY spectrumUpdated)
+  Q_PROPERTY(int spectrumPoints READ spectrumPoints NOTIFY spectrumUpdated)
+  Q_PROPERTY(double spectrumMin READ spectrumMin NOTIFY spectrumUpdated)
+  Q_PROPERTY(double spectrumMax READ spectrumMax NOTIFY spectrumUpdated)
+  Q_PROPERTY(int spectrumPacketCount READ spectrumPacketCount NOTIFY spectrumUpdated)
+  Q_PROPERTY(QByteArray liveEnvelope READ liveEnvelope NOTIFY liveFrameUpdated)
+  Q_PROPERTY(double liveMin READ liveMin NOTIFY liveFrameUpdated)
+  Q_PROPERTY(double liveMax READ liveMax NOTIFY liveFrameUpdated)
+
+ public:
+  static const int DEFAULT_MAX_FPS = 60;
+  static const int DEFAULT_PLOT_WIDTH = 1024;
+
+  explicit DisplayFeed(QObject *parent = nullptr);
+
+  // 绘图区像素宽度：抽取后的列数不超过该值
+  int plotWidth() const { return plotWidth_; }
+  void setPlotWidth(int pixels);
+
+  // 显示刷新上限（帧/秒）
+  int maxFps() const { return maxFps_; }
+  void setMaxFps(int fps);
+
+  // 是否显示实时原始帧（关闭时接收线程只做一次标志判断）
+  bool liveFrameEnabled() const { return liveFrameEnabled_.load(std::memory_order_relaxed); }
+  void setLiveFrameEnabled(bool enabled);
+
+  // 接收线程的帧接收端：只保存每批的最后一帧
+  std::shared_ptr<SpectrumFrameSink> frameSink() const;
+
+  // 任意线程调用：提交一条处理完成的光谱（只保留最新一条，等下一个显示周期合并绘制）
+  void submitSpectrum(const QVector<double> &spectrum, double minVal, double maxVal, int packetCount);
+
+  // 启动/停止显示定时器（由 UdpCommunicator 随接收开始/停止调用）
+  void start();
+  void stop();
+
+  QByteArray spectrumEnvelope() const { return spectrumEnvelope_; }
+  int spectrumPoints() const { return spectrumPoints_; }
+  double spectrumMin() const { return spectrumMin_; }
+  double spectrumMax() const { return spectrumMax_; }
+  int spectrumPacketCount() const { return spectrumPacketCount_; }
+  QByteArray liveEnvelope() const { return liveEnvelope_; }
+  double liveMin() const { return liveMin_; }
+  double liveMax() const { return liveMax_; }
+
+  // 把 count 个点按最小/最大值抽取为 buckets 列，写入 out（2 * buckets 个 float）
+  static void decimateMinMax(const double *data, int count, int buckets, float *out);
+  static void decimateMinMax(const uint16_t *data, int count, int buckets, float *out);
+
+ signals:
+  void plotWidthChanged(int pixels);
+  void maxFpsChanged(int fps);
+  void liveFrameEnabledChanged(bool enabled);
+  // 每个显示周期最多发送一次
+  void spectrumUpdated();
+  void liveFrameUpdated();
+
+ private slots:
+  void onDisplayTimer();
+
+ private:
+  class LatestFrameSink;
+
+  void rebuildSpectrumEnvelope();
+
+  QTimer *displayTimer_;
+  int plotWidth_;
+  int maxFps_;
+  std::atomic<bool> liveFrameEnabled_;
+  std::shared_ptr<LatestFrameSink> frameSink_;
+  quint64 shownFrameVersion_;
+
+  // 最新提交的光谱（受 mutex_ 保护，每次提交只增加 QVector 的引用计数）
+  QMutex mutex_;
+  QVector<double> pendingSpectrum_;
+  double pendingMin_;
+  double pendingMax_;
+  int pendingPacketCount_;
+  bool spectrumPending_;
+
+  // 以下仅主线程访问
+  QVector<double> shownSpectrum_;  // 最近显示的光谱（绘图宽度变化时重新抽取）
+  QByteArray spectrumEnvelope_;
+  int spectrumPoints_;
+  double spectrumMin_;
+  double spectrumMax_;
+  int spectrumPacketCount_;
+  QByteArray liveEnvelope_;
+  double liveMin_;
+  double liveMax_;
+};
@@ -0,0 +1,162 @@
+#include "fast_model_spec.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int kMaxReferenceRows = 4096;
+
+bool setError(QString *error, const QString &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+// 每行一条光谱，逗号 / 空白分隔；空行和以 # 开头的行忽略
+bool readReferenceSet(const QString &path, int inputSize, std::vector<float> *out, int *rows, QString *error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    return setError(error, QStringLiteral("%1: %2").arg(path, file.errorString()));
+  }
+  out->clear();
+  *rows = 0;
+  QTextStream stream(&file);
+  int lineNumber = 0;
+  while (!stream.atEnd()) {
+    const QString line = stream.readLine().trimmed();
+    lineNumber++;
+    if (line.isEmpty() || line.startsWith(QChar('#'))) {
+      continue;
+    }
+    QString normalized = line;
+    normalized.replace(QChar(','), QChar(' '));
+    const QStringList fields = normalized.split(QChar(' '), Qt::SkipEmptyParts);
+    if (fields.size() != inputSize) {
+      return setError(error, QStringLiteral("%1 第 %2 行: 期望 %3 个值，实际 %4 个")
+                                 .arg(path)
+                                 .arg(lineNumber)
+                                 .arg(inputSize)
+                                 .arg(static_cast<int>(fields.size())));
+    }
+    for (const QString &field : fields) {
+      bool ok = false;
+      const float value = field.toFloat(&ok);
+      if (!ok || !std::isfinite(value)) {
+        return setError(error, QStringLiteral("%1 第 %2 行: 无效数值 %3").arg(path).arg(lineNumber).arg(field));
+      }
+      out->push_back(value);
+    }
+    if (++*rows >= kMaxReferenceRows) {
+      break;
+    }
+  }
+  if (*rows == 0) {
+    return setError(error, QStringLiteral("%1: 参考集为空").arg(path));
+  }
+  return true;
+}
+
+}  // namespace
+
+QString FastModelSpec::Report::describe() const {
+  return QStringLiteral("%1 条参考光谱，最大绝对误差 %2，平均绝对误差 %3")
+      .arg(rows)
+      .arg(maxAbsError, 0, 'g', 4)
+      .arg(meanAbsError, 0, 'g', 4);
+}
+
+QVariantMap FastModelSpec::Report::toVariantMap() const {
+  QVariantMap map;
+  map.insert(QStringLiteral("rows"), rows);
+  map.insert(QStringLiteral("maxAbsError"), maxAbsError);
+  map.insert(QStringLiteral("meanAbsError"), meanAbsError);
+  map.insert(QStringLiteral("passed"), passed);
+  return map;
+}
+
+QString FastModelSpec::metadataPathForModel(const QString &modelPath) {
+  const QFileInfo info(modelPath);
+  return info.absolutePath() + QChar('/') + info.completeBaseName() + QStringLiteral(".fast.json");
+}
+
+std::shared_ptr<const FastModelSpec> FastModelSpec::loadForModel(const QString &modelPath, int inputSize,
+                                                                 QString *error) {
+  if (error) {
+    error->clear();
+  }
+  const QString path = metadataPathForModel(modelPath);
+  QFile file(path);
+  if (!file.exists()) {
+    return nullptr;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    setError(error, QStringLiteral("%1: %2").arg(path, file.errorString()));
+    return nullptr;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+    setError(error, QStringLiteral("%1: %2").arg(path, parseError.errorString()));
+    return nullptr;
+  }
+  const QJsonObject root = document.object();
+  const QDir dir = QFileInfo(path).absoluteDir();
+
+  std::shared_ptr<FastModelSpec> spec(new FastModelSpec());
+  const QString model = root.value(QStringLiteral("model")).toString();
+  spec->modelPath_ = model.isEmpty() ? QFileInfo(modelPath).absoluteFilePath() : dir.absoluteFilePath(model);
+  spec->options_ = root.value(QStringLiteral("options")).toObject().toVariantMap();
+  if (!root.contains(QStringLiteral("maxAbsError"))) {
+    setError(error, QStringLiteral("%1: 缺少 maxAbsError").arg(path));
+    return nullptr;
+  }
+  spec->maxAbsError_ = root.value(QStringLiteral("maxAbsError")).toDouble(-1.0);
+  spec->maxMeanAbsError_ = root.value(QStringLiteral("maxMeanAbsError")).toDouble(0.0);
+  if (!(spec->maxAbsError_ >= 0.0)) {
+    setError(error, QStringLiteral("%1: maxAbsError 应为非负数").arg(path));
+    return nullptr;
+  }
+
+  const QString reference = root.value(QStringLiteral("referenceSet")).toString();
+  if (reference.isEmpty()) {
+    // 没有参考集就无法验证精度，不允许上线快速模型
+    setError(error, QStringLiteral("%1: 缺少 referenceSet").arg(path));
+    return nullptr;
+  }
+  spec->referencePath_ = dir.absoluteFilePath(reference);
+  spec->inputSize_ = inputSize;
+  if (!readReferenceSet(spec->referencePath_, inputSize, &spec->reference_, &spec->referenceRows_, error)) {
+    return nullptr;
+  }
+  return spec;
+}
+
+FastModelSpec::Report FastModelSpec::compare(const float *baseline, const float *candidate) const {
+  Report report;
+  report.rows = referenceRows_;
+  double sumAbs = 0.0;
+  bool finite = true;
+  for (int r = 0; r < referenceRows_; r++) {
+    const double diff = std::fabs(static_cast<double>(candidate[r]) - static_cast<double>(baseline[r]));
+    if (!std::isfinite(diff)) {
+      finite = false;
+      continue;
+    }
+    sumAbs += diff;
+    report.maxAbsError = std::max(report.maxAbsError, diff);
+  }
+  report.meanAbsError = referenceRows_ > 0 ? sumAbs / referenceRows_ : 0.0;
+  report.passed = finite && report.maxAbsError <= maxAbsError_ &&
+                  (maxMeanAbsError_ <= 0.0 || report.meanAbsError <= maxMeanAbsError_);
+  return report;
+}
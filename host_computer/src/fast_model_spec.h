@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QString>
+#include <QVariantMap>
+#include <memory>
+#include <vector>
+
+// 模型的快速版本（int8 量化、fp16 / bf16 半精度、冻结并做推理优化的 TorchScript）及其精度守卫
+// - 配置随模型发布：<模型文件名去掉扩展名>.fast.json（例如 spectrum_model.fast.json），
+//   不存在时只加载原模型
+// - 加载原模型后，在插件新建的实例上加载快速模型（可附带运行时配置），用参考集上两者的预测差异决定是否采用：
+//   误差在容差内时上线快速模型，否则丢弃并继续使用原（float32）模型
+// - 参考集为 CSV，每行一条校正后的光谱（与推理时的输入相同，预处理链在比较时照常执行），
+//   通常由训练脚本从测试集导出
+//
+// 配置示例（相对路径相对于配置文件所在目录）：
+// {
+//   "model": "spectrum_model.int8.onnx",
+//   "options": { "precision": "bfloat16", "optimizeForInference": true },
+//   "referenceSet": "spectrum_model.reference.csv",
+//   "maxAbsError": 0.5,
+//   "maxMeanAbsError": 0.1
+// }
+// - model：快速模型文件，省略时与原模型相同（libtorch 通过 options 在加载时转换）
+// - options：应用到快速模型实例的运行时配置（见 SpectrumPredictorRuntimeOptions）
+// - maxAbsError：参考集上允许的最大绝对误差（必填）；maxMeanAbsError：平均绝对误差上限，省略时不检查
+class FastModelSpec {
+ public:
+  // 参考集上快速模型与原模型的比较结果
+  struct Report {
+    int rows = 0;
+    double maxAbsError = 0.0;
+    double meanAbsError = 0.0;
+    bool passed = false;
+
+    QString describe() const;
+    QVariantMap toVariantMap() const;
+  };
+
+  // 模型对应的快速模型配置路径
+  static QString metadataPathForModel(const QString &modelPath);
+
+  // 读取模型旁边的快速模型配置与参考集（每行 inputSize 个点）：文件不存在时返回空且 error 为空；
+  // 配置或参考集无效时返回空并写入 error
+  static std::shared_ptr<const FastModelSpec> loadForModel(const QString &modelPath, int inputSize,
+                                                           QString *error = nullptr);
+
+  const QString &modelPath() const { return modelPath_; }
+  const QVariantMap &options() const { return options_; }
+  const QString &referencePath() const { return referencePath_; }
+  double maxAbsError() const { return maxAbsError_; }
+  double maxMeanAbsError() const { return maxMeanAbsError_; }
+
+  // 参考集：rows × inputSize 的行优先矩阵
+  int referenceRows() const { return referenceRows_; }
+  int inputSize() const { return inputSize_; }
+  const float *referenceData() const { return reference_.data(); }
+
+  // 比较两组预测值（各 referenceRows() 个），非有限值视为超出容差
+  Report compare(const float *baseline, const float *candidate) const;
+
+ private:
+  FastModelSpec() = default;
+
+  QString modelPath_;
+  QVariantMap options_;
+  QString referencePath_;
+  double maxAbsError_ = 0.0;
+  double maxMeanAbsError_ = 0.0;  // <= 0 表示不检查
+  int referenceRows_ = 0;
+  int inputSize_ = 0;
+  std::vector<float> reference_;
+};
+
+using FastModelSpecPtr = std::shared_ptr<const FastModelSpec>;
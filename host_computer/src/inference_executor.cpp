@@ -0,0 +1,235 @@
+#include "inference_executor.h"
+#include "pipeline_stats.h"
+#include "spectrum_frame.h"
+#include "spectrum_predictor_manager.h"
+#include "thread_placement.h"
+
+#include <QDebug>
+#include <algorithm>
+
+InferenceExecutor::InferenceExecutor(SpectrumPredictorManager *manager, QObject *parent)
+    : QThread(parent), manager_(manager), stopRequested_(false),
+      queueCapacity_(DEFAULT_QUEUE_CAPACITY), queueDepth_(0), completed_(0), dropped_(0),
+      latencyNext_(0), reportedCompleted_(0), reportedDropped_(0), reportedDepth_(0), p50LatencyMs_(0.0), p99LatencyMs_(0.0) {
+  latencySamples_.reserve(kLatencySamples);
+  fanoutPool_.setExpiryTimeout(-1);  // 扇出线程常驻，避免每次请求重新创建线程
+  // 统计定时器运行在主线程（执行器对象所在线程）
+  statsTimer_.setInterval(500);
+  connect(&statsTimer_, &QTimer::timeout, this, &InferenceExecutor::updateStats);
+  statsTimer_.start();
+}
+
+InferenceExecutor::~InferenceExecutor() {
+  stopProcessing();
+}
+
+void InferenceExecutor::submit(InferenceRequest request) {
+  if (request.predictorIndices.isEmpty() ||
+      request.inputs.size() != static_cast<size_t>(request.predictorIndices.size())) {
+    return;
+  }
+  for (const auto &input : request.inputs) {
+    if (!input) {
+      return;
+    }
+  }
+  if (request.submitNs == 0) {
+    request.submitNs = SpectrumFrame::nowNs();
+  }
+
+  QMutexLocker locker(&mutex_);
+  if (stopRequested_) {
+    return;
+  }
+  // 最新优先：同一来源的请求达到上限时丢弃它最旧的请求，模型始终处理各来源最近的光谱
+  const size_t capacity = static_cast<size_t>(queueCapacity_.load(std::memory_order_relaxed));
+  size_t sameStream = 0;
+  for (const InferenceRequest &queued : pending_) {
+    if (queued.streamId == request.streamId) {
+      sameStream++;
+    }
+  }
+  for (auto it = pending_.begin(); sameStream >= capacity && it != pending_.end();) {
+    if (it->streamId == request.streamId) {
+      it = pending_.erase(it);
+      sameStream--;
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      ++it;
+    }
+  }
+  pending_.push_back(std::move(request));
+  queueDepth_.store(static_cast<int>(pending_.size()), std::memory_order_relaxed);
+  pendingChanged_.wakeOne();
+}
+
+void InferenceExecutor::setQueueCapacity(int capacity) {
+  capacity = qMax(1, capacity);
+  if (queueCapacity_.exchange(capacity) != capacity) {
+    emit statsChanged();
+  }
+}
+
+void InferenceExecutor::stopProcessing() {
+  {
+    QMutexLocker locker(&mutex_);
+    stopRequested_ = true;
+    pending_.clear();
+    queueDepth_.store(0, std::memory_order_relaxed);
+    pendingChanged_.wakeAll();
+  }
+  // 正在执行的推理无法中断，等待其完成
+  wait();
+}
+
+void InferenceExecutor::run() {
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Inference);
+  while (true) {
+    InferenceRequest request;
+    {
+      QMutexLocker locker(&mutex_);
+      while (pending_.empty() && !stopRequested_) {
+        pendingChanged_.wait(&mutex_);
+      }
+      if (stopRequested_) {
+        break;
+      }
+      request = std::move(pending_.front());
+      pending_.pop_front();
+      queueDepth_.store(static_cast<int>(pending_.size()), std::memory_order_relaxed);
+    }
+
+    std::vector<float> results;
+    std::vector<char> ok;
+    const quint64 traceId = static_cast<quint64>(request.windowTimestampNs);
+    const qint64 startNs = SpectrumFrame::nowNs();
+    PipelineStats::record(PipelineStats::InferenceQueue, request.submitNs, startNs, traceId);
+    runRequest(request, results, ok);
+    const qint64 completedNs = SpectrumFrame::nowNs();
+    recordLatency(completedNs - startNs);
+    completed_.fetch_add(1, std::memory_order_relaxed);
+
+    QVariantList indices;
+    QVariantList values;
+    double sum = 0.0;
+    int succeeded = 0;
+    for (int i = 0; i < request.predictorIndices.size(); i++) {
+      const int index = request.predictorIndices[i];
+      indices.append(index);
+      if (!ok[static_cast<size_t>(i)]) {
+        values.append(QVariant());
+        continue;
+      }
+      const double value = static_cast<double>(results[static_cast<size_t>(i)]);
+      values.append(value);
+      sum += value;
+      succeeded++;
+      emit predictionReady(index, value, request.windowTimestampNs, completedNs, request.streamId);
+    }
+    if (request.predictorIndices.size() > 1 && succeeded > 0) {
+      emit multiPredictionReady(indices, values, sum / succeeded, request.windowTimestampNs, completedNs,
+                                request.streamId);
+    }
+    if (!request.shadowInputs.empty()) {
+      runShadow(request, results, ok);
+    }
+  }
+  fanoutPool_.waitForDone();
+}
+
+void InferenceExecutor::runRequest(const InferenceRequest &request, std::vector<float> &results,
+                                   std::vector<char> &ok) {
+  const int count = request.predictorIndices.size();
+  results.assign(static_cast<size_t>(count), 0.0f);
+  ok.assign(static_cast<size_t>(count), 0);
+
+  auto predictOne = [this, &request, &results, &ok](int i) {
+    const int index = request.predictorIndices[i];
+    const std::vector<float> &input = *request.inputs[static_cast<size_t>(i)];
+    // 检查预测器是否已加载模型
+    if (!manager_->isModelLoaded(index)) {
+      qDebug() << "预测器" << index << "模型未加载，跳过预测";
+      return;
+    }
+    const qint64 startNs = SpectrumFrame::nowNs();
+    const bool predicted = manager_->predictBatch(index, input.data(), 1, input.size(), &results[static_cast<size_t>(i)]);
+    PipelineStats::record(PipelineStats::Inference, startNs, SpectrumFrame::nowNs(),
+                          static_cast<quint64>(request.windowTimestampNs));
+    if (predicted) {
+      ok[static_cast<size_t>(i)] = 1;
+    } else {
+      qWarning() << "预测器" << index << "预测失败";
+    }
+  };
+
+  // 其余预测器交给扇出线程池，第一个在当前线程执行；全部完成后才返回
+  for (int i = 1; i < count; i++) {
+    fanoutPool_.start([&predictOne, i]() {
+      ThreadPlacement::applyToCurrentThreadOnce(ThreadPlacement::InferenceFanout);
+      predictOne(i);
+    });
+  }
+  predictOne(0);
+  if (count > 1) {
+    fanoutPool_.waitForDone();
+  }
+}
+
+void InferenceExecutor::runShadow(const InferenceRequest &request, const std::vector<float> &results,
+                                  const std::vector<char> &ok) {
+  const size_t count = qMin(request.shadowInputs.size(), static_cast<size_t>(request.predictorIndices.size()));
+  for (size_t i = 0; i < count; i++) {
+    const auto &input = request.shadowInputs[i];
+    const int index = request.predictorIndices[static_cast<int>(i)];
+    // 提交后影子模型可能已被清除，此时不再记录
+    if (!input || !manager_->hasShadowModel(index)) {
+      continue;
+    }
+    float shadowValue = 0.0f;
+    const bool shadowOk = manager_->predictShadow(index, input->data(), input->size(), &shadowValue);
+    emit shadowPredictionReady(index, ok[i] ? QVariant(static_cast<double>(results[i])) : QVariant(),
+                               shadowOk ? QVariant(static_cast<double>(shadowValue)) : QVariant(),
+                               request.windowTimestampNs, request.streamId);
+  }
+}
+
+void InferenceExecutor::recordLatency(qint64 latencyNs) {
+  QMutexLocker locker(&latencyMutex_);
+  if (latencySamples_.size() < static_cast<size_t>(kLatencySamples)) {
+    latencySamples_.push_back(latencyNs);
+  } else {
+    latencySamples_[latencyNext_] = latencyNs;
+  }
+  latencyNext_ = (latencyNext_ + 1) % kLatencySamples;
+}
+
+void InferenceExecutor::updateStats() {
+  const quint64 completed = completed_.load(std::memory_order_relaxed);
+  const int depth = queueDepth();
+  const quint64 dropped = dropped_.load(std::memory_order_relaxed);
+  if (completed == reportedCompleted_ && depth == reportedDepth_ && dropped == reportedDropped_) {
+    return;
+  }
+  reportedDepth_ = depth;
+  reportedDropped_ = dropped;
+  if (completed != reportedCompleted_) {
+    reportedCompleted_ = completed;
+
+    // 复制样本后在锁外求分位数
+    std::vector<qint64> samples;
+    {
+      QMutexLocker locker(&latencyMutex_);
+      samples = latencySamples_;
+    }
+    if (!samples.empty()) {
+      auto percentile = [&samples](double p) {
+        const size_t k = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(k), samples.end());
+        return static_cast<double>(samples[k]) / 1e6;
+      };
+      p50LatencyMs_ = percentile(0.50);
+      p99LatencyMs_ = percentile(0.99);
+    }
+  }
+  emit statsChanged();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QVariant>
+#include <QVector>
+#include <QTimer>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class SpectrumPredictorManager;
+
+// 推理请求：一条平均光谱及其对应的帧窗口时间戳
+struct InferenceRequest {
+  QVector<int> predictorIndices;  // 参与预测的预测器（多个时并行执行）
+  // 与 predictorIndices 一一对应的只读输入（已经过各模型的预处理链），提交后不再修改
+  // 预处理相同的预测器共用同一份缓冲区
+  std::vector<std::shared_ptr<const std::vector<float>>> inputs;
+  // 影子模式：与 predictorIndices 一一对应，非空时在线结果发出后再用影子模型对同一条光谱打分
+  // （可以为空数组，表示没有预测器启用影子模型）
+  std::vector<std::shared_ptr<const std::vector<float>>> shadowInputs;
+  qint64 windowTimestampNs = 0;  // 窗口内最后一帧的接收时间戳（SpectrumFrame::nowNs() 时基）
+  qint64 submitNs = 0;  // 提交时间
+  int streamId = 0;  // 光谱来源（多光谱仪时区分设备，见 DeviceRegistry），随结果信号原样发出
+};
+
+// 异步推理执行器（由 SpectrumPredictorManager 持有）
+// - 处理线程只调用 submit() 入队，模型在独立的工作线程中运行，不再拖慢光谱输出
+// - 请求队列按来源（streamId）有界：某个来源的请求数达到上限时丢弃它最旧的请求（最新优先），
+//   被合并掉的请求计入 droppedRequests；多台光谱仪共用执行器时互不挤占
+// - 一个请求可以包含多个预测器：第一个在工作线程中运行，其余在扇出线程池中并行运行，
+//   读取各自预处理后的只读输入，预处理相同的预测器共用一份，不按预测器复制
+// - 影子模型在在线结果发出之后才运行，不计入推理耗时统计，也不推迟在线结果
+// - 统计最近 kLatencySamples 次推理耗时（整个请求）的 p50 / p99，由主线程定时刷新到属性
+class InferenceExecutor : public QThread {
+  Q_OBJECT
+  Q_PROPERTY(int queueDepth READ queueDepth NOTIFY statsChanged)
+  Q_PROPERTY(int queueCapacity READ queueCapacity WRITE setQueueCapacity NOTIFY statsChanged)
+  Q_PROPERTY(double p50LatencyMs READ p50LatencyMs NOTIFY statsChanged)
+  Q_PROPERTY(double p99LatencyMs READ p99LatencyMs NOTIFY statsChanged)
+  Q_PROPERTY(int completedRequests READ completedRequests NOTIFY statsChanged)
+  Q_PROPERTY(int droppedRequests READ droppedRequests NOTIFY statsChanged)
+
+ public:
+  static const int DEFAULT_QUEUE_CAPACITY = 2;
+  static const int kLatencySamples = 1024;
+
+  explicit InferenceExecutor(SpectrumPredictorManager *manager, QObject *parent = nullptr);
+  ~InferenceExecutor();
+
+  // 任意线程调用：提交推理请求，不阻塞
+  void submit(InferenceRequest request);
+
+  // 停止工作线程（丢弃未执行的请求）
+  void stopProcessing();
+
+  int queueDepth() const { return queueDepth_.load(std::memory_order_relaxed); }
+  int queueCapacity() const { return queueCapacity_.load(std::memory_order_relaxed); }
+  void setQueueCapacity(int capacity);
+  double p50LatencyMs() const { return p50LatencyMs_; }
+  double p99LatencyMs() const { return p99LatencyMs_; }
+  int completedRequests() const { return static_cast<int>(completed_.load(std::memory_order_relaxed)); }
+  int droppedRequests() const { return static_cast<int>(dropped_.load(std::memory_order_relaxed)); }
+
+ signals:
+  // 推理完成（工作线程发出）：预测器索引、预测值、窗口时间戳、推理完成时间（用于统计信号送达延迟）、
+  // 请求的来源（streamId，单光谱仪时为 0）；只关心前几个参数的接收方可以省略后面的参数
+  void predictionReady(int predictorIndex, double predictionValue, qint64 windowTimestampNs, qint64 completedNs,
+                       int streamId);
+  // 多预测器请求完成：各预测器索引与预测值（失败的预测器值为空），以及成功结果的平均值
+  // 每个成功的预测器仍会单独发出 predictionReady
+  void multiPredictionReady(const QVariantList &predictorIndices, const QVariantList &predictionValues,
+                            double ensembleMean, qint64 windowTimestampNs, qint64 completedNs, int streamId);
+  // 影子模式对比（工作线程发出）：在线 / 影子模型对同一窗口的预测值，失败的一方为空
+  void shadowPredictionReady(int predictorIndex, const QVariant &liveValue, const QVariant &shadowValue,
+                             qint64 windowTimestampNs, int streamId);
+  void statsChanged();
+
+ protected:
+  void run() override;
+
+ private slots:
+  void updateStats();
+
+ private:
+  void recordLatency(qint64 latencyNs);
+
+  // 执行一个请求：results[i] / ok[i] 对应 request.predictorIndices[i]
+  void runRequest(const InferenceRequest &request, std::vector<float> &results, std::vector<char> &ok);
+  // 对启用了影子模型的预测器再打分一次，与在线结果一起发出 shadowPredictionReady
+  void runShadow(const InferenceRequest &request, const std::vector<float> &results, const std::vector<char> &ok);
+
+  SpectrumPredictorManager *manager_;
+  QThreadPool fanoutPool_;  // 多预测器并行执行（仅工作线程提交任务）
+  QMutex mutex_;  // 保护 pending_ 与 stopRequested_
+  QWaitCondition pendingChanged_;
+  std::deque<InferenceRequest> pending_;
+  bool stopRequested_;
+  std::atomic<int> queueCapacity_;
+  std::atomic<int> queueDepth_;
+  std::atomic<quint64> completed_;
+  std::atomic<quint64> dropped_;
+
+  QMutex latencyMutex_;  // 保护 latencySamples_
+  std::vector<qint64> latencySamples_;  // 最近的推理耗时（纳秒，环形）
+  size_t latencyNext_;
+  // 上次刷新属性时的计数（仅主线程访问）
+  quint64 reportedCompleted_;
+  quint64 reportedDropped_;
+  int reportedDepth_;
+  double p50LatencyMs_;
+  double p99LatencyMs_;
+  QTimer statsTimer_;
+};
@@ -0,0 +1,130 @@
+#include "inference_runtime.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
+
+InferenceRuntime::InferenceRuntime()
+    : intraOpThreads_(qBound(1, QThread::idealThreadCount() / 2, 4)),
+      interOpThreads_(1),
+      allowSpinning_(false) {}
+
+InferenceRuntime::~InferenceRuntime() {
+  clear();
+}
+
+QString InferenceRuntime::defaultConfigPath() {
+  return QCoreApplication::applicationDirPath() + QStringLiteral("/inference_runtime.json");
+}
+
+bool InferenceRuntime::load(const QString &path, QString *error) {
+  QFile file(path);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (document.isNull() || !document.isObject()) {
+    if (error) {
+      *error = parseError.errorString();
+    }
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  auto readThreads = [&root, error](const QString &key, int fallback, int *value) {
+    if (!root.contains(key)) {
+      *value = fallback;
+      return true;
+    }
+    const int threads = root.value(key).toInt(0);
+    if (threads < 1 || threads > 256) {
+      if (error) {
+        *error = QStringLiteral("\"%1\" 应为 1~256 的整数").arg(key);
+      }
+      return false;
+    }
+    *value = threads;
+    return true;
+  };
+  int intra = 0;
+  int inter = 0;
+  if (!readThreads(QStringLiteral("intraOpThreads"), intraOpThreads_, &intra) ||
+      !readThreads(QStringLiteral("interOpThreads"), interOpThreads_, &inter)) {
+    return false;
+  }
+  intraOpThreads_ = intra;
+  interOpThreads_ = inter;
+  allowSpinning_ = root.value(QStringLiteral("allowSpinning")).toBool(allowSpinning_);
+  return true;
+}
+
+std::shared_ptr<void> InferenceRuntime::sharedObject(const QString &key,
+                                                     const std::function<std::shared_ptr<void>()> &factory) {
+  // 持锁调用 factory：同一 key 只会被创建一次（不同插件可能在后台加载线程与主线程上同时请求）
+  QMutexLocker locker(&mutex_);
+  auto it = objects_.constFind(key);
+  if (it != objects_.constEnd()) {
+    return it.value();
+  }
+  std::shared_ptr<void> object = factory ? factory() : nullptr;
+  if (object) {
+    objects_.insert(key, object);
+  }
+  return object;
+}
+
+bool InferenceRuntime::runOnce(const QString &key, const std::function<void()> &apply) {
+  QMutexLocker locker(&mutex_);
+  if (applied_.contains(key)) {
+    return false;
+  }
+  applied_.insert(key);
+  if (apply) {
+    apply();
+  }
+  return true;
+}
+
+void InferenceRuntime::clear() {
+  QHash<QString, std::shared_ptr<void>> objects;
+  {
+    QMutexLocker locker(&mutex_);
+    objects.swap(objects_);
+  }
+  // 在锁外释放，对象的析构函数可能再次访问运行时
+  objects.clear();
+}
+
+QString InferenceRuntime::describe() const {
+  QMutexLocker locker(&mutex_);
+  QStringList keys = objects_.keys();
+  keys.sort();
+  return QStringLiteral("intra=%1 inter=%2 spin=%3 shared=[%4]")
+      .arg(intraOpThreads_)
+      .arg(interOpThreads_)
+      .arg(allowSpinning_ ? QStringLiteral("on") : QStringLiteral("off"))
+      .arg(keys.join(QStringLiteral(",")));
+}
+
+QVariantMap InferenceRuntime::toVariantMap() const {
+  QMutexLocker locker(&mutex_);
+  QStringList keys = objects_.keys();
+  keys.sort();
+  QVariantMap map;
+  map.insert(QStringLiteral("intraOpThreads"), intraOpThreads_);
+  map.insert(QStringLiteral("interOpThreads"), interOpThreads_);
+  map.insert(QStringLiteral("allowSpinning"), allowSpinning_);
+  map.insert(QStringLiteral("sharedObjects"), keys);
+  return map;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVariantMap>
+
+#include "spectrum_predictor_interface.h"
+
+// 进程内所有预测插件共用的推理运行时（InferenceRuntimeService 的宿主实现）
+// - 固定的 CPU 线程预算：ONNX Runtime 的全局线程池、libtorch 的进程级线程数都按此设置，
+//   多个插件、在线 / 影子模型同时加载时不再各自创建 nproc 个线程互相争抢
+// - 共享对象注册表：宿主不链接任何推理库，只按 key 保存插件创建的对象（例如 Ort::Env）
+// - 配置文件为 JSON（默认 <程序目录>/inference_runtime.json），不存在时使用默认值
+//
+// 配置示例：
+// {
+//   "intraOpThreads": 4,
+//   "interOpThreads": 1,
+//   "allowSpinning": false
+// }
+class InferenceRuntime : public InferenceRuntimeService {
+ public:
+  InferenceRuntime();
+  ~InferenceRuntime() override;
+
+  static QString defaultConfigPath();
+
+  // 读取配置文件；文件不存在返回 true 并保留默认值，格式错误返回 false 并写入 error
+  // 需在插件初始化之前调用，之后修改不影响已创建的共享对象
+  bool load(const QString &path, QString *error = nullptr);
+
+  int intraOpThreads() const override { return intraOpThreads_; }
+  int interOpThreads() const override { return interOpThreads_; }
+  bool allowSpinning() const override { return allowSpinning_; }
+
+  std::shared_ptr<void> sharedObject(const QString &key,
+                                     const std::function<std::shared_ptr<void>()> &factory) override;
+  bool runOnce(const QString &key, const std::function<void()> &apply) override;
+
+  // 释放注册表持有的共享对象（插件卸载前调用；仍被插件引用的对象在最后一个引用释放时销毁）
+  void clear();
+
+  QString describe() const;
+  QVariantMap toVariantMap() const;
+
+ private:
+  int intraOpThreads_;
+  int interOpThreads_;
+  bool allowSpinning_;
+
+  mutable QMutex mutex_;
+  QHash<QString, std::shared_ptr<void>> objects_;
+  QSet<QString> applied_;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+
+// 无锁对数-线性延迟直方图（HDR 风格）
+// - 每个 2 的幂区间再等分为 16 个子桶，相对误差约 6%，覆盖 1 ns ~ 约 1 小时
+// - record() 只做 relaxed 原子加法，可在任意线程的热路径上并发调用
+// - 读取为近似快照（各桶分别读取），用于统计显示
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxMagnitude = 42;  // 2^42 ns ≈ 73 分钟，更大的值计入最后一桶
+  static constexpr int kBucketCount = (kMaxMagnitude - kSubBucketBits + 2) * kSubBuckets;
+
+  LatencyHistogram() { reset(); }
+
+  void record(qint64 valueNs) {
+    const uint64_t v = valueNs > 0 ? static_cast<uint64_t>(valueNs) : 0;
+    counts_[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (v > seen && !max_.compare_exchange_weak(seen, v, std::memory_order_relaxed)) {
+    }
+  }
+
+  void reset() {
+    for (auto &c : counts_) {
+      c.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t maxNs() const { return max_.load(std::memory_order_relaxed); }
+  double meanNs() const {
+    const uint64_t n = count();
+    return n > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+  }
+
+  // 百分位（0 < p < 100），返回所在桶的中点
+  double percentileNs(double p) const {
+    uint64_t total = 0;
+    uint64_t snapshot[kBucketCount];
+    for (int i = 0; i < kBucketCount; ++i) {
+      snapshot[i] = counts_[i].load(std::memory_order_relaxed);
+      total += snapshot[i];
+    }
+    if (total == 0) {
+      return 0.0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+      seen += snapshot[i];
+      if (seen >= rank) {
+        const double lower = static_cast<double>(bucketLowerBound(i));
+        const double width = static_cast<double>(bucketWidth(i));
+        return lower + width / 2.0;
+      }
+    }
+    return static_cast<double>(maxNs());
+  }
+
+  static int bucketIndex(uint64_t v) {
+    if (v < static_cast<uint64_t>(kSubBuckets)) {
+      return static_cast<int>(v);
+    }
+    int magnitude = 63 - __builtin_clzll(v);
+    if (magnitude > kMaxMagnitude) {
+      return kBucketCount - 1;
+    }
+    const int sub = static_cast<int>((v >> (magnitude - kSubBucketBits)) & (kSubBuckets - 1));
+    return (magnitude - kSubBucketBits + 1) * kSubBuckets + sub;
+  }
+
+  static uint64_t bucketLowerBound(int index) {
+    if (index < kSubBuckets) {
+      return static_cast<uint64_t>(index);
+    }
+    const int magnitude = index / kSubBuckets + kSubBucketBits - 1;
+    const int sub = index % kSubBuckets;
+    return static_cast<uint64_t>(kSubBuckets + sub) << (magnitude - kSubBucketBits);
+  }
+
+  static uint64_t bucketWidth(int index) {
+    if (index < kSubBuckets) {
+      return 1;
+    }
+    const int magnitude = index / kSubBuckets + kSubBucketBits - 1;
+    return static_cast<uint64_t>(1) << (magnitude - kSubBucketBits);
+  }
+
+ private:
+  std::atomic<uint64_t> counts_[kBucketCount];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
@@ -0,0 +1,149 @@
+#include "link_stats.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr double kGapFactor = 1.5;  // 间隔超过帧周期的倍数即视为丢帧
+constexpr double kPeriodGain = 1.0 / 64.0;  // 帧周期估计的平滑系数
+constexpr double kJitterGain = 1.0 / 16.0;  // RFC 3550 抖动平滑系数
+
+int bucketFor(qint64 intervalNs) {
+  const qint64 us = intervalNs / 1000;
+  if (us <= 0) {
+    return 0;
+  }
+  int bucket = 1;
+  qint64 upper = 2;
+  while (us >= upper && bucket < LinkStats::kHistogramBuckets - 1) {
+    upper <<= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+LinkStats::LinkStats() {
+  reset();
+}
+
+void LinkStats::reset() {
+  datagrams_ = 0;
+  runts_ = 0;
+  oversized_ = 0;
+  lostFrames_ = 0;
+  inferredLostFrames_ = 0;
+  gapEvents_ = 0;
+  reordered_ = 0;
+  duplicates_ = 0;
+  kernelDrops_ = 0;
+  periodNs_ = 0.0;
+  jitterNs_ = 0.0;
+  for (auto &bucket : histogram_) {
+    bucket = 0;
+  }
+  lastArrivalNs_ = 0;
+  haveCounter_ = false;
+  expectedCounter_ = 0;
+  usingCounters_ = false;
+}
+
+void LinkStats::recordDatagram(qint64 arrivalNs, bool perPacketTime, unsigned int bytes, unsigned int frameBytes) {
+  datagrams_.fetch_add(1, std::memory_order_relaxed);
+  if (bytes < frameBytes) {
+    runts_.fetch_add(1, std::memory_order_relaxed);
+  } else if (bytes > frameBytes && bytes != frameBytes + sizeof(uint16_t)) {
+    oversized_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (perPacketTime) {
+    if (lastArrivalNs_ != 0 && arrivalNs > lastArrivalNs_) {
+      recordInterval(arrivalNs - lastArrivalNs_);
+    }
+    lastArrivalNs_ = arrivalNs;
+  }
+}
+
+void LinkStats::recordInterval(qint64 intervalNs) {
+  histogram_[bucketFor(intervalNs)].fetch_add(1, std::memory_order_relaxed);
+
+  const double interval = static_cast<double>(intervalNs);
+  double period = periodNs_.load(std::memory_order_relaxed);
+  if (period <= 0.0) {
+    periodNs_.store(interval, std::memory_order_relaxed);
+    return;
+  }
+
+  if (interval > kGapFactor * period) {
+    // 明显超过一个帧周期：不计入周期估计；没有帧计数时按间隔推断丢失的帧数
+    if (!usingCounters_) {
+      const quint64 missing = static_cast<quint64>(std::llround(interval / period)) - 1;
+      if (missing > 0) {
+        inferredLostFrames_.fetch_add(missing, std::memory_order_relaxed);
+        gapEvents_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  } else {
+    period += (interval - period) * kPeriodGain;
+    periodNs_.store(period, std::memory_order_relaxed);
+  }
+
+  double jitter = jitterNs_.load(std::memory_order_relaxed);
+  jitter += (std::fabs(interval - period) - jitter) * kJitterGain;
+  jitterNs_.store(jitter, std::memory_order_relaxed);
+}
+
+void LinkStats::recordFrameCounter(uint16_t counter) {
+  usingCounters_ = true;
+  if (!haveCounter_) {
+    haveCounter_ = true;
+    expectedCounter_ = static_cast<uint16_t>(counter + 1);
+    return;
+  }
+  const uint16_t ahead = static_cast<uint16_t>(counter - expectedCounter_);
+  if (ahead == 0) {
+    expectedCounter_ = static_cast<uint16_t>(counter + 1);
+  } else if (ahead < 0x8000) {
+    // 跳过了 ahead 帧
+    lostFrames_.fetch_add(ahead, std::memory_order_relaxed);
+    gapEvents_.fetch_add(1, std::memory_order_relaxed);
+    expectedCounter_ = static_cast<uint16_t>(counter + 1);
+  } else if (counter == static_cast<uint16_t>(expectedCounter_ - 1)) {
+    duplicates_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    // 序号落后：迟到的数据包（此前已计为丢失，这里更正）
+    reordered_.fetch_add(1, std::memory_order_relaxed);
+    quint64 lost = lostFrames_.load(std::memory_order_relaxed);
+    if (lost > 0) {
+      lostFrames_.store(lost - 1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void LinkStats::recordKernelDrops(uint32_t cumulative) {
+  kernelDrops_.store(cumulative, std::memory_order_relaxed);
+}
+
+LinkStats::Snapshot LinkStats::snapshot() const {
+  Snapshot s;
+  s.datagrams = datagrams_.load(std::memory_order_relaxed);
+  s.runts = runts_.load(std::memory_order_relaxed);
+  s.oversized = oversized_.load(std::memory_order_relaxed);
+  s.lostFrames = lostFrames_.load(std::memory_order_relaxed);
+  s.inferredLostFrames = inferredLostFrames_.load(std::memory_order_relaxed);
+  s.gapEvents = gapEvents_.load(std::memory_order_relaxed);
+  s.reordered = reordered_.load(std::memory_order_relaxed);
+  s.duplicates = duplicates_.load(std::memory_order_relaxed);
+  s.kernelDrops = kernelDrops_.load(std::memory_order_relaxed);
+  s.periodUs = periodNs_.load(std::memory_order_relaxed) / 1000.0;
+  s.jitterUs = jitterNs_.load(std::memory_order_relaxed) / 1000.0;
+  for (int i = 0; i < kHistogramBuckets; ++i) {
+    s.histogram[i] = histogram_[i].load(std::memory_order_relaxed);
+  }
+  return s;
+}
+
+double LinkStats::bucketLowerBoundUs(int bucket) {
+  return bucket <= 0 ? 0.0 : std::ldexp(1.0, bucket - 1);
+}
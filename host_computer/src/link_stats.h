@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+
+// UDP 链路质量统计：由接收线程逐个数据包更新，任意线程读取快照
+// - 帧计数：数据包末尾附带 16 位帧计数（大端）时按计数检测丢帧、乱序与重复
+// - 无帧计数时按到达间隔推断丢帧：间隔超过估计帧周期的 1.5 倍视为丢失 round(间隔/周期) - 1 帧
+// - 到达间隔直方图与 RFC 3550 风格的抖动估计（需要逐包时间戳，批量接收时建议启用内核时间戳）
+// - 内核丢包：SO_RXQ_OVFL 报告的套接字接收队列溢出累计数
+class LinkStats {
+ public:
+  // 到达间隔直方图：第 0 桶 < 1 us，第 k 桶 [2^(k-1), 2^k) us，最后一桶为溢出
+  static constexpr int kHistogramBuckets = 24;
+
+  struct Snapshot {
+    quint64 datagrams = 0;  // 收到的数据包
+    quint64 runts = 0;  // 短包（不足一整帧）
+    quint64 oversized = 0;  // 超长包（超出一帧且不是帧计数格式）
+    quint64 lostFrames = 0;  // 按帧计数检测到的丢帧
+    quint64 inferredLostFrames = 0;  // 按到达间隔推断的丢帧（无帧计数时）
+    quint64 gapEvents = 0;  // 丢帧事件次数（一次连续丢失计一次）
+    quint64 reordered = 0;  // 迟到（序号落后）的数据包
+    quint64 duplicates = 0;  // 重复的帧计数
+    quint64 kernelDrops = 0;  // 内核接收队列溢出丢弃的数据包
+    double periodUs = 0.0;  // 估计的帧周期
+    double jitterUs = 0.0;  // 到达间隔相对帧周期的平滑偏差
+    quint64 histogram[kHistogramBuckets] = {};
+  };
+
+  LinkStats();
+
+  // 接收开始前调用
+  void reset();
+
+  // 以下仅接收线程调用
+  // arrivalNs: 数据包时间戳；perPacketTime: 时间戳是否逐包（内核时间戳或逐包接收）
+  void recordDatagram(qint64 arrivalNs, bool perPacketTime, unsigned int bytes, unsigned int frameBytes);
+  void recordFrameCounter(uint16_t counter);
+  void recordKernelDrops(uint32_t cumulative);
+
+  // 任意线程调用
+  Snapshot snapshot() const;
+
+  // 直方图第 bucket 桶的下界（微秒）
+  static double bucketLowerBoundUs(int bucket);
+
+ private:
+  void recordInterval(qint64 intervalNs);
+
+  std::atomic<quint64> datagrams_;
+  std::atomic<quint64> runts_;
+  std::atomic<quint64> oversized_;
+  std::atomic<quint64> lostFrames_;
+  std::atomic<quint64> inferredLostFrames_;
+  std::atomic<quint64> gapEvents_;
+  std::atomic<quint64> reordered_;
+  std::atomic<quint64> duplicates_;
+  std::atomic<quint64> kernelDrops_;
+  std::atomic<double> periodNs_;
+  std::atomic<double> jitterNs_;
+  std::atomic<quint64> histogram_[kHistogramBuckets];
+
+  // 以下仅接收线程访问
+  qint64 lastArrivalNs_;
+  bool haveCounter_;
+  uint16_t expectedCounter_;
+  bool usingCounters_;  // 已收到帧计数，不再按间隔推断丢帧
+};
@@ -2,33 +2,67 @@
 
 #include <QCoreApplication>
 #include <QDir>
-#include <QFile>
-#include <QMutexLocker>
-#include <QTextStream>
+#include <QMetaObject>
+#include <vector>
+
+#include "async_log_writer.h"
 
 LogManager *LogManager::s_instance = nullptr;
 QtMessageHandler LogManager::s_prevHandler = nullptr;
 
 LogManager::LogManager(QObject *parent)
     : QObject(parent),
+      model_(new LogModel(kMaxEntries, this)),
+      writer_(std::make_unique<AsyncLogWriter>()),
+      pendingEntries_(4096),
+      drainScheduled_(false),
+      logTarget_(-1),
+      resultTarget_(-1),
+      shadowTarget_(-1),
       resultSpectrumLen_(1024) {  // 默认光谱点数（1000~1600nm 分成 1024 点）
-  // 简单单例：保存最后一个创建的实例指针
-  s_instance = this;
-
   // 确定日志文件路径：<应用目录>/log/...
   const QString baseDir = QCoreApplication::applicationDirPath();
   QDir dir(baseDir);
   if (!dir.exists(QStringLiteral("log"))) {
     dir.mkpath(QStringLiteral("log"));
   }
-  logFilePath_ = dir.filePath(QStringLiteral("log/app.log"));
-  resultCsvPath_ = dir.filePath(QStringLiteral("log/result.csv"));
+
+  // 预测结果 CSV 表头：基础字段 + 对应波长列（单位 nm），假定 1000~1600 等间隔
+  QByteArray resultHeader("timestamp,predictorIndex,value,status,monitorEnabled,lowerLimit,upperLimit");
+  if (resultSpectrumLen_ > 0) {
+    const double lambdaStart = 1000.0;
+    const double lambdaEnd = 1600.0;
+    const double step = (resultSpectrumLen_ > 1)
+                          ? (lambdaEnd - lambdaStart) / (resultSpectrumLen_ - 1)
+                          : 0.0;
+    for (int i = 0; i < resultSpectrumLen_; ++i) {
+      const double lambda = lambdaStart + step * i;
+      resultHeader.append(',');
+      resultHeader.append(QByteArray::number(lambda, 'f', 2));
+    }
+  }
+  resultHeader.append('\n');
+
+  logTarget_ = writer_->addTarget(dir.filePath(QStringLiteral("log/app.log")),
+                                  kMaxLogFileBytes, kMaxBackupFiles);
+  resultTarget_ = writer_->addTarget(dir.filePath(QStringLiteral("log/result.csv")),
+                                     kMaxResultFileBytes, kMaxBackupFiles, resultHeader);
+  shadowTarget_ = writer_->addTarget(dir.filePath(QStringLiteral("log/shadow.csv")),
+                                     kMaxLogFileBytes, kMaxBackupFiles,
+                                     QByteArray("timestamp,predictorIndex,windowTimestampNs,liveValue,shadowValue,"
+                                                "diff,liveModel,shadowModel\n"));
+  writer_->start(QThread::LowPriority);
+
+  // 简单单例：保存最后一个创建的实例指针（写盘线程就绪后再接收全局日志）
+  s_instance = this;
 }
 
 LogManager::~LogManager() {
   if (s_instance == this) {
     s_instance = nullptr;
   }
+  // 写完队列中剩余的日志再退出
+  writer_->stopWriting();
 }
 
 LogManager *LogManager::instance() {
@@ -36,16 +70,15 @@ LogManager *LogManager::instance() {
 }
 
 QVariantList LogManager::entries() const {
-  QMutexLocker locker(&mutex_);
-  return entries_;
+  return model_->toVariantList();
 }
 
 void LogManager::clear() {
-  {
-    QMutexLocker locker(&mutex_);
-    entries_.clear();
+  // 先取走尚未显示的条目，避免清空后又出现旧日志
+  LogModel::Entry discarded[64];
+  while (pendingEntries_.pop(discarded, 64) > 0) {
   }
-  emit entriesChanged();
+  model_->clear();
 }
 
 void LogManager::logInfo(const QString &source, const QString &message) {
@@ -63,130 +96,132 @@ void LogManager::logPredictionResult(int predictorIndex,
                                      double lowerLimit,
                                      double upperLimit,
                                      const QVariantList &spectrum) {
-  if (resultCsvPath_.isEmpty()) {
+  if (resultTarget_ < 0) {
     return;
   }
 
-  QMutexLocker locker(&mutex_);
-
-  QFile file(resultCsvPath_);
-  const bool exists = file.exists();
-  if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-    qWarning() << "[LogManager] Failed to open prediction result CSV:" << resultCsvPath_
-               << ", error:" << file.errorString();
-    return;
-  }
-
-  QTextStream out(&file);
-
-  // 如果文件是新建的，先写表头
-  if (!exists) {
-    out << "timestamp,predictorIndex,value,status,monitorEnabled,lowerLimit,upperLimit";
-    // 如果有光谱长度信息，追加对应波长列（单位 nm），假定 1000~1600 等间隔
-    if (resultSpectrumLen_ > 0) {
-      const double lambdaStart = 1000.0;
-      const double lambdaEnd = 1600.0;
-      const double step = (resultSpectrumLen_ > 1)
-                            ? (lambdaEnd - lambdaStart) / (resultSpectrumLen_ - 1)
-                            : 0.0;
-      for (int i = 0; i < resultSpectrumLen_; ++i) {
-        const double lambda = lambdaStart + step * i;
-        out << "," << QString::number(lambda, 'f', 2);
-      }
-    }
-    out << "\n";
-  }
-
+  // 在调用线程中格式化一整行，写盘由后台线程完成（表头在新建文件时自动写入）
+  QString line;
+  line.reserve(32 + resultSpectrumLen_ * 14);
   const QString ts = QDateTime::currentDateTime().toString(Qt::ISODate);
 
   // 写基础字段
-  out << ts << ","
-      << predictorIndex << ","
-      << QString::number(value, 'f', 10) << ","
-      << "\"" << status << "\"" << ","
-      << (monitorEnabled ? "1" : "0") << ",";
+  line += ts + QLatin1Char(',')
+        + QString::number(predictorIndex) + QLatin1Char(',')
+        + QString::number(value, 'f', 10) + QLatin1Char(',')
+        + QLatin1Char('"') + status + QLatin1Char('"') + QLatin1Char(',')
+        + (monitorEnabled ? QStringLiteral("1") : QStringLiteral("0")) + QLatin1Char(',');
 
   if (monitorEnabled) {
-    out << QString::number(lowerLimit, 'f', 10) << ","
-        << QString::number(upperLimit, 'f', 10);
+    line += QString::number(lowerLimit, 'f', 10) + QLatin1Char(',')
+          + QString::number(upperLimit, 'f', 10);
   } else {
-    out << ",";  // lowerLimit 空
-    out << "";   // upperLimit 空
+    line += QLatin1Char(',');  // lowerLimit、upperLimit 空
   }
 
   // 追加光谱数据列（如果有配置长度）
   if (resultSpectrumLen_ > 0) {
     for (int i = 0; i < resultSpectrumLen_; ++i) {
-      out << ",";
+      line += QLatin1Char(',');
       if (i < spectrum.size()) {
         bool ok = false;
         const double v = spectrum[i].toDouble(&ok);
         if (ok) {
-          out << QString::number(v, 'f', 10);
+          line += QString::number(v, 'f', 10);
         }
       }
     }
   }
 
-  out << "\n";
+  line += QLatin1Char('\n');
+  writer_->post(resultTarget_, line.toUtf8());
+}
+
+void LogManager::logShadowPrediction(int predictorIndex,
+                                     const QVariant &liveValue,
+                                     const QVariant &shadowValue,
+                                     qint64 windowTimestampNs,
+                                     const QString &liveModel,
+                                     const QString &shadowModel) {
+  if (shadowTarget_ < 0) {
+    return;
+  }
 
-  file.close();
+  QString line;
+  line.reserve(160 + liveModel.size() + shadowModel.size());
+  line += QDateTime::currentDateTime().toString(Qt::ISODate) + QLatin1Char(',')
+        + QString::number(predictorIndex) + QLatin1Char(',')
+        + QString::number(windowTimestampNs) + QLatin1Char(',');
+  if (liveValue.isValid()) {
+    line += QString::number(liveValue.toDouble(), 'f', 10);
+  }
+  line += QLatin1Char(',');
+  if (shadowValue.isValid()) {
+    line += QString::number(shadowValue.toDouble(), 'f', 10);
+  }
+  line += QLatin1Char(',');
+  if (liveValue.isValid() && shadowValue.isValid()) {
+    line += QString::number(shadowValue.toDouble() - liveValue.toDouble(), 'f', 10);
+  }
+  line += QStringLiteral(",\"") + liveModel + QStringLiteral("\",\"") + shadowModel + QStringLiteral("\"\n");
+  writer_->post(shadowTarget_, line.toUtf8());
 }
 
 void LogManager::append(QtMsgType type, const QString &msg) {
-  QVariantMap entry;
+  LogModel::Entry entry;
 
   // 时间戳
-  entry.insert(QStringLiteral("timestamp"),
-               QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz")));
+  entry.timestamp = QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz"));
 
   // 日志级别
-  QString level;
   switch (type) {
     case QtDebugMsg:
-      level = QStringLiteral("DEBUG");
+      entry.level = QStringLiteral("DEBUG");
       break;
     case QtInfoMsg:
-      level = QStringLiteral("INFO");
+      entry.level = QStringLiteral("INFO");
       break;
     case QtWarningMsg:
-      level = QStringLiteral("WARN");
+      entry.level = QStringLiteral("WARN");
       break;
     case QtCriticalMsg:
-      level = QStringLiteral("ERROR");
+      entry.level = QStringLiteral("ERROR");
       break;
     case QtFatalMsg:
-      level = QStringLiteral("FATAL");
+      entry.level = QStringLiteral("FATAL");
       break;
   }
-  entry.insert(QStringLiteral("level"), level);
 
   // 消息文本
-  entry.insert(QStringLiteral("message"), msg);
-
-  {
-    QMutexLocker locker(&mutex_);
-    entries_.append(entry);
-
-    // 控制最大条数，避免内存无限增长
-    while (entries_.size() > kMaxEntries) {
-      entries_.removeFirst();
-    }
+  entry.message = msg;
+
+  // 投递到后台写盘线程（不在调用线程中打开文件）
+  writer_->post(logTarget_, (entry.timestamp + QStringLiteral(" [") + entry.level +
+                             QStringLiteral("] ") + entry.message + QLatin1Char('\n')).toUtf8());
+  if (type == QtFatalMsg) {
+    // 进程即将终止：同步写完已排队的日志
+    writer_->stopWriting();
+    return;
   }
 
-  emit entriesChanged();
+  // 投递到主线程的界面队列；队列已满时丢弃（文件中仍有记录）
+  if (pendingEntries_.push(std::move(entry)) && !drainScheduled_.exchange(true)) {
+    QMetaObject::invokeMethod(this, [this]() { drainPendingEntries(); }, Qt::QueuedConnection);
+  }
+}
 
-  // 同步追加写入到本地 .log 文件
-  if (!logFilePath_.isEmpty()) {
-    QFile file(logFilePath_);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-      QTextStream out(&file);
-      out << entry.value(QStringLiteral("timestamp")).toString()
-          << " [" << entry.value(QStringLiteral("level")).toString() << "] "
-          << entry.value(QStringLiteral("message")).toString() << '\n';
-      file.close();
+void LogManager::drainPendingEntries() {
+  // 先清除标志再取数据：之后到达的条目会重新投递一次
+  drainScheduled_.store(false);
+  std::vector<LogModel::Entry> batch;
+  LogModel::Entry chunk[64];
+  size_t n = 0;
+  while ((n = pendingEntries_.pop(chunk, 64)) > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      batch.push_back(std::move(chunk[i]));
     }
   }
+  model_->appendEntries(batch);
 }
 
 void LogManager::messageHandler(QtMsgType type,
@@ -3,23 +3,33 @@
 #include <QObject>
 #include <QVariant>
 #include <QDateTime>
-#include <QMutex>
 #include <QString>
+#include <atomic>
+#include <memory>
+
+#include "log_model.h"
+#include "mpsc_ring.h"
+
+class AsyncLogWriter;
 
 // 简单日志管理器：
 // - 通过全局 Qt 消息处理函数收集 qDebug/qWarning 等日志
-// - 将日志存到内存中的 QVariantList，供 QML 显示
+// - 日志经无锁队列交给后台线程批量写入 log/app.log（按大小滚动），调用线程不做文件 I/O
+// - 内存中保留最近 kMaxEntries 条，以 LogModel 的形式供 QML 显示（增量插入行）
 // - 每条日志包含：时间戳、级别、消息文本
 class LogManager : public QObject {
   Q_OBJECT
-  Q_PROPERTY(QVariantList entries READ entries NOTIFY entriesChanged)
+  Q_PROPERTY(LogModel *model READ model CONSTANT)
 
  public:
   explicit LogManager(QObject *parent = nullptr);
   ~LogManager() override;
 
-  // 返回所有日志条目（每条是一个 QVariantMap: { timestamp, level, message }）
-  QVariantList entries() const;
+  // 日志列表模型（主线程访问）
+  LogModel *model() const { return model_; }
+
+  // 返回所有日志条目的快照（每条是一个 QVariantMap: { timestamp, level, message }）
+  Q_INVOKABLE QVariantList entries() const;
 
   // 清空日志
   Q_INVOKABLE void clear();
@@ -27,7 +37,7 @@ class LogManager : public QObject {
   // 供 QML / 业务代码显式记录一条“通信状态”等信息日志
   Q_INVOKABLE void logInfo(const QString &source, const QString &message);
 
-  // 将单条预测结果追加写入 log/result.csv
+  // 将单条预测结果追加写入 log/result.csv（异步写入，超过大小上限时滚动并重写表头）
   // predictorIndex: 预测器索引
   // value: 预测值
   // status: "正常"/"异常"/"未启用异常监控"
@@ -42,6 +52,15 @@ class LogManager : public QObject {
                                        double upperLimit,
                                        const QVariantList &spectrum);
 
+  // 影子模式对比结果追加写入 log/shadow.csv（任意线程调用，异步写入）
+  // liveValue / shadowValue 为空表示该模型预测失败
+  Q_INVOKABLE void logShadowPrediction(int predictorIndex,
+                                       const QVariant &liveValue,
+                                       const QVariant &shadowValue,
+                                       qint64 windowTimestampNs,
+                                       const QString &liveModel,
+                                       const QString &shadowModel);
+
   // 安装全局 Qt 消息处理函数，用于捕获 qDebug/qWarning 等日志
   static void installGlobalHandler();
 
@@ -50,18 +69,26 @@ class LogManager : public QObject {
 
   // 最大保留的日志条数（超过后会丢弃最旧的）
   static const int kMaxEntries = 10000;
-
- signals:
-  void entriesChanged();
+  // 日志文件滚动参数
+  static const qint64 kMaxLogFileBytes = 16LL * 1024 * 1024;
+  static const qint64 kMaxResultFileBytes = 256LL * 1024 * 1024;
+  static const int kMaxBackupFiles = 5;
 
  private:
+  // 任意线程调用：格式化一条日志，投递到写盘队列与界面队列
   void append(QtMsgType type, const QString &msg);
 
-  QVariantList entries_;
-  mutable QMutex mutex_;
-  QString logFilePath_;      // 文本日志路径 log/app.log
-  QString resultCsvPath_;    // 预测结果 CSV 路径 log/result.csv
-  int resultSpectrumLen_;    // 预测结果 CSV 中光谱列的长度（首次写入时确定）
+  // 主线程调用：把界面队列中积攒的日志批量追加到模型
+  void drainPendingEntries();
+
+  LogModel *model_;
+  std::unique_ptr<AsyncLogWriter> writer_;
+  MpscRing<LogModel::Entry> pendingEntries_;  // 其它线程 → 主线程的日志条目
+  std::atomic<bool> drainScheduled_;  // 是否已投递一次 drainPendingEntries
+  int logTarget_;            // 文本日志 log/app.log 在 writer_ 中的编号
+  int resultTarget_;         // 预测结果 log/result.csv 在 writer_ 中的编号
+  int shadowTarget_;         // 影子模式对比 log/shadow.csv 在 writer_ 中的编号
+  int resultSpectrumLen_;    // 预测结果 CSV 中光谱列的长度
 
   static LogManager *s_instance;
   static QtMessageHandler s_prevHandler;
@@ -0,0 +1,99 @@
+#include "log_model.h"
+
+#include <QVariantMap>
+
+LogModel::LogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent), ring_(static_cast<size_t>(qMax(1, capacity))), head_(0), count_(0) {
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) {
+    return 0;
+  }
+  return count_;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() < 0 || index.row() >= count_) {
+    return QVariant();
+  }
+  const Entry &entry = at(index.row());
+  switch (role) {
+    case TimestampRole:
+      return entry.timestamp;
+    case LevelRole:
+      return entry.level;
+    case MessageRole:
+    case Qt::DisplayRole:
+      return entry.message;
+    default:
+      return QVariant();
+  }
+}
+
+QHash<int, QByteArray> LogModel::roleNames() const {
+  QHash<int, QByteArray> roles;
+  roles.insert(TimestampRole, "timestamp");
+  roles.insert(LevelRole, "level");
+  roles.insert(MessageRole, "message");
+  return roles;
+}
+
+void LogModel::appendEntries(std::vector<Entry> &entries) {
+  if (entries.empty()) {
+    return;
+  }
+  const int capacity = static_cast<int>(ring_.size());
+  // 一批超过容量时只保留最新的 capacity 条
+  const int skip = qMax(0, static_cast<int>(entries.size()) - capacity);
+  const int incoming = static_cast<int>(entries.size()) - skip;
+
+  const int overflow = count_ + incoming - capacity;
+  if (overflow > 0) {
+    beginRemoveRows(QModelIndex(), 0, overflow - 1);
+    for (int i = 0; i < overflow; ++i) {
+      ring_[(head_ + static_cast<size_t>(i)) % ring_.size()] = Entry();
+    }
+    head_ = (head_ + static_cast<size_t>(overflow)) % ring_.size();
+    count_ -= overflow;
+    endRemoveRows();
+  }
+
+  beginInsertRows(QModelIndex(), count_, count_ + incoming - 1);
+  for (int i = 0; i < incoming; ++i) {
+    ring_[(head_ + static_cast<size_t>(count_ + i)) % ring_.size()] =
+        std::move(entries[static_cast<size_t>(skip + i)]);
+  }
+  count_ += incoming;
+  endInsertRows();
+  entries.clear();
+  emit countChanged();
+}
+
+void LogModel::clear() {
+  if (count_ == 0) {
+    return;
+  }
+  beginResetModel();
+  for (Entry &entry : ring_) {
+    entry = Entry();
+  }
+  head_ = 0;
+  count_ = 0;
+  endResetModel();
+  emit countChanged();
+}
+
+QVariantList LogModel::toVariantList() const {
+  QVariantList list;
+  list.reserve(count_);
+  for (int row = 0; row < count_; ++row) {
+    const Entry &entry = at(row);
+    QVariantMap map;
+    map.insert(QStringLiteral("timestamp"), entry.timestamp);
+    map.insert(QStringLiteral("level"), entry.level);
+    map.insert(QStringLiteral("message"), entry.message);
+    list.append(map);
+  }
+  return list;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVariant>
+#include <vector>
+
+// 日志列表模型：固定容量的环形缓冲，供 QML ListView 显示
+// - 新日志按批追加，只发出增量的行插入/删除通知，ListView 不会整表重建
+// - 超过容量时丢弃最旧的行（环形覆盖，不移动其余元素）
+// - 只能在主线程访问，其它线程的日志由 LogManager 汇总后批量追加
+class LogModel : public QAbstractListModel {
+  Q_OBJECT
+  Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+ public:
+  enum Roles {
+    TimestampRole = Qt::UserRole + 1,
+    LevelRole,
+    MessageRole
+  };
+
+  struct Entry {
+    QString timestamp;
+    QString level;
+    QString message;
+  };
+
+  explicit LogModel(int capacity, QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  QHash<int, QByteArray> roleNames() const override;
+
+  // 追加一批日志（按时间顺序），超出容量时先移除最旧的行
+  void appendEntries(std::vector<Entry> &entries);
+  void clear();
+
+  // 全部条目的快照（每条是 QVariantMap: { timestamp, level, message }）
+  QVariantList toVariantList() const;
+
+  int capacity() const { return static_cast<int>(ring_.size()); }
+
+ signals:
+  void countChanged();
+
+ private:
+  const Entry &at(int row) const { return ring_[(head_ + static_cast<size_t>(row)) % ring_.size()]; }
+
+  std::vector<Entry> ring_;
+  size_t head_;  // 第 0 行在环中的位置
+  int count_;
+};
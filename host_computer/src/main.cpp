@@ -1,4 +1,5 @@
 #include <QCoreApplication>
+#include <QDebug>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
@@ -8,19 +9,37 @@
 #include "udp_communicator.h"
 #include "spectrum_predictor_manager.h"
 #include "spectrum_file_manager.h"
+#include "spectrum_record_store.h"
 #include "log_manager.h"
 #include "system_monitor.h"
+#include "pipeline_stats.h"
+#include "result_publisher.h"
+#include "device_registry.h"
 
 int main(int argc, char *argv[]) {
   QGuiApplication app(argc, argv);
 
+  // 发布器先于预测器管理器创建、后于它销毁：推理线程停止后才不会再调用 publishPrediction
+  ResultPublisher::Config publisherConfig;
+  QString publisherConfigError;
+  if (!publisherConfig.load(ResultPublisher::Config::defaultConfigPath(), &publisherConfigError)) {
+    qWarning() << "网络发布配置无效，已禁用:" << publisherConfigError;
+    publisherConfig = ResultPublisher::Config();
+  }
+  ResultPublisher resultPublisher(publisherConfig);
+
   PluginManager pluginManager;
   SerialCommunicator serialComm;
   UdpCommunicator udpComm;
   SpectrumPredictorManager predictorManager;
   SpectrumFileManager spectrumFileManager;
+  // 单次采集窗口的记录：超过内存上限的光谱溢出到 <缓存目录>/spill
+  SpectrumRecordStore spectrumRecords;
   LogManager logManager;
   SystemMonitor systemMonitor;
+  PipelineStats pipelineStats;
+  // 多台光谱仪（<程序目录>/devices.json）：在预测器管理器之后创建、之前销毁
+  DeviceRegistry deviceRegistry(&predictorManager);
 
   // 安装全局日志处理，捕获 qDebug / console.log 等输出
   LogManager::installGlobalHandler();
@@ -28,11 +47,59 @@ int main(int argc, char *argv[]) {
   // 将预测器管理器设置到 UDP 通信器中
   udpComm.setPredictorManager(&predictorManager);
 
-  // 连接串口状态改变信号，自动控制UDP接收
-  // 默认UDP端口和绑定地址
+  // 影子模式：在线 / 候选模型的对比结果写入 log/shadow.csv
+  QObject::connect(predictorManager.inferenceExecutor(), &InferenceExecutor::shadowPredictionReady, &logManager,
+                   [&logManager, &predictorManager](int index, const QVariant &liveValue, const QVariant &shadowValue,
+                                                    qint64 windowTimestampNs) {
+    logManager.logShadowPrediction(index, liveValue, shadowValue, windowTimestampNs,
+                                   predictorManager.modelPath(index), predictorManager.shadowModelPath(index));
+  });
+
+  // 预测结果网络发布：推理线程直接投递到发布队列，光谱在主线程转发
+  QObject::connect(predictorManager.inferenceExecutor(), &InferenceExecutor::predictionReady, &resultPublisher,
+                   [&resultPublisher](int index, double value, qint64 windowTimestampNs, qint64, int streamId) {
+    resultPublisher.publishPrediction(index, value, windowTimestampNs, streamId);
+  }, Qt::DirectConnection);
+  QObject::connect(&udpComm, &UdpCommunicator::spectrumReady, &resultPublisher, &ResultPublisher::onSpectrumReady);
+  if (publisherConfig.enabled()) {
+    QString publisherError;
+    if (resultPublisher.startPublishing(&publisherError)) {
+      qDebug() << "预测结果网络发布:" << publisherConfig.describe();
+    } else {
+      qWarning() << "预测结果网络发布启动失败:" << publisherError;
+    }
+  }
+
+  // 默认UDP端口、绑定地址和串口（多设备配置不能再使用这些端口与串口）
   const int defaultUdpPort = 1234;
   const QString defaultUdpBindAddress = QStringLiteral("192.168.1.102");
-  
+  const QString defaultSerialPort = QStringLiteral("/dev/ttyUSB0");
+
+  // 配置了多台设备时为每台设备创建独立的流水线，光谱与预测按 streamId 发布
+  {
+    DeviceRegistry::Config devicesConfig;
+    QString devicesError;
+    if (!devicesConfig.load(DeviceRegistry::Config::defaultConfigPath(), &devicesError) ||
+        !devicesConfig.checkPrimaryConflicts(defaultUdpPort, defaultSerialPort, &devicesError)) {
+      qWarning() << "多设备配置无效，已忽略:" << devicesError;
+    } else if (!devicesConfig.devices.isEmpty()) {
+      if (!deviceRegistry.configure(devicesConfig, &devicesError)) {
+        qWarning() << "多设备流水线创建失败:" << devicesError;
+      } else {
+        qDebug() << "多设备:" << devicesConfig.describe();
+        QObject::connect(&deviceRegistry, &DeviceRegistry::spectrumReady, &resultPublisher,
+                         &ResultPublisher::onStreamSpectrumReady);
+        if (devicesConfig.autoStart) {
+          deviceRegistry.startAll();
+        }
+      }
+    }
+  }
+
+  // 恢复上次保存的黑白参考，未过期时无需重新累积即可输出校正光谱与预测
+  udpComm.loadCalibrationCache();
+
+  // 连接串口状态改变信号，自动控制UDP接收
   QObject::connect(&serialComm, &SerialCommunicator::stateChanged, 
                    [&udpComm, defaultUdpPort, defaultUdpBindAddress](bool started) {
     if (started) {
@@ -50,8 +117,12 @@ int main(int argc, char *argv[]) {
   engine.rootContext()->setContextProperty("udpComm", &udpComm);
   engine.rootContext()->setContextProperty("predictorManager", &predictorManager);
   engine.rootContext()->setContextProperty("spectrumFileManager", &spectrumFileManager);
+  engine.rootContext()->setContextProperty("spectrumRecords", &spectrumRecords);
   engine.rootContext()->setContextProperty("logManager", &logManager);
   engine.rootContext()->setContextProperty("systemMonitor", &systemMonitor);
+  engine.rootContext()->setContextProperty("pipelineStats", &pipelineStats);
+  engine.rootContext()->setContextProperty("resultPublisher", &resultPublisher);
+  engine.rootContext()->setContextProperty("deviceRegistry", &deviceRegistry);
 
   const QUrl url(QStringLiteral("qrc:/Main.qml"));
   QObject::connect(
@@ -69,11 +140,11 @@ int main(int argc, char *argv[]) {
   }
 
   // 连接应用程序退出信号，在关闭前自动发送停止命令（如果还在运行）
-  QObject::connect(&app, &QGuiApplication::aboutToQuit, [&serialComm]() {
+  QObject::connect(&app, &QGuiApplication::aboutToQuit, [&serialComm, defaultSerialPort]() {
     if (serialComm.isStarted()) {
       // 如果串口还在运行状态，自动发送停止命令
       // 使用默认串口名称，如果需要可以从QML获取，但这里使用默认值
-      serialComm.sendStopCommand(QStringLiteral("/dev/ttyUSB0"));
+      serialComm.sendStopCommand(defaultSerialPort);
     }
   });
 
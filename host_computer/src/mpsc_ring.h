@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 有界多生产者/单消费者无锁环形队列（每个槽位带序号，参考 Vyukov 有界队列）
+// - 容量向上取整为 2 的幂
+// - push 可在任意线程并发调用，只通过 CAS 争用写下标，不加锁
+// - pop 只能在一个消费者线程调用
+// - 队列满时 push 返回 false，由调用方决定丢弃策略
+template <typename T>
+class MpscRing {
+ public:
+  explicit MpscRing(size_t capacity)
+      : mask_(roundUpPow2(capacity < 2 ? 2 : capacity) - 1), cells_(mask_ + 1) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRing(const MpscRing &) = delete;
+  MpscRing &operator=(const MpscRing &) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // 任意生产者线程调用
+  bool push(T &&value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell *cell = nullptr;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        // 槽位空闲：抢占写下标
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 已满（消费者尚未取走这一圈的元素）
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 消费者调用：最多取出 maxCount 个元素，返回实际数量
+  // 某个生产者已抢到槽位但尚未写完时，在该槽位前停止（下次再取）
+  size_t pop(T *out, size_t maxCount) {
+    size_t n = 0;
+    while (n < maxCount) {
+      Cell &cell = cells_[head_ & mask_];
+      if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+        break;
+      }
+      out[n++] = std::move(cell.value);
+      cell.value = T();  // 释放槽位持有的资源
+      cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+    }
+    if (n > 0) {
+      headPublished_.store(head_, std::memory_order_release);
+    }
+    return n;
+  }
+
+  // 任意线程调用，结果仅供参考
+  size_t sizeApprox() const {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t head = headPublished_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool emptyApprox() const { return sizeApprox() == 0; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence{0};
+    T value{};
+  };
+
+  static size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  const size_t mask_;
+  std::vector<Cell> cells_;
+
+  // 生产者共享的写下标与消费者的读下标放在不同缓存行，避免伪共享
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) size_t head_ = 0;  // 仅消费者访问
+  std::atomic<size_t> headPublished_{0};  // 供 sizeApprox 读取
+};
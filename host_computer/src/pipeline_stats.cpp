@@ -0,0 +1,249 @@
+#include "pipeline_stats.h"
+#include "latency_histogram.h"
+#include "mpsc_ring.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <QVariantMap>
+#include <atomic>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// 进程内全局的统计存储：热路径只访问这里，不经过 QObject
+struct PipelineRegistry {
+  LatencyHistogram histograms[PipelineStats::StageCount];
+  MpscRing<PipelineStats::TraceEvent> traceRing{65536};
+  std::atomic<bool> tracing{false};
+  std::atomic<quint64> droppedTraceEvents{0};
+};
+
+PipelineRegistry &registry() {
+  static PipelineRegistry instance;
+  return instance;
+}
+
+// 线程 ID 只在每个线程第一次记录跟踪事件时查询一次
+int currentThreadId() {
+  thread_local int tid = static_cast<int>(::syscall(SYS_gettid));
+  return tid;
+}
+
+}  // namespace
+
+PipelineStats::PipelineStats(QObject *parent)
+    : QObject(parent), reportedTotal_(0) {
+  registry();  // 在主线程构造全局存储，避免热路径上首次访问时初始化
+  timer_.setInterval(1000);
+  connect(&timer_, &QTimer::timeout, this, &PipelineStats::update);
+  timer_.start();
+  update();
+}
+
+PipelineStats::~PipelineStats() {
+  registry().tracing.store(false, std::memory_order_relaxed);
+}
+
+void PipelineStats::record(Stage stage, qint64 startNs, qint64 endNs, quint64 traceId) {
+  if (stage < 0 || stage >= StageCount || startNs <= 0) {
+    return;
+  }
+  PipelineRegistry &r = registry();
+  const qint64 durationNs = endNs - startNs;
+  r.histograms[stage].record(durationNs);
+  if (!r.tracing.load(std::memory_order_relaxed)) {
+    return;
+  }
+  TraceEvent event;
+  event.stage = stage;
+  event.threadId = currentThreadId();
+  event.startNs = startNs;
+  event.durationNs = durationNs > 0 ? durationNs : 0;
+  event.traceId = traceId;
+  if (!r.traceRing.push(std::move(event))) {
+    r.droppedTraceEvents.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void PipelineStats::recordFrame(Stage stage, qint64 startNs, qint64 endNs, quint64 sequence) {
+  if (shouldTraceFrame(sequence)) {
+    record(stage, startNs, endNs, sequence);
+    return;
+  }
+  if (stage >= 0 && stage < StageCount && startNs > 0) {
+    registry().histograms[stage].record(endNs - startNs);
+  }
+}
+
+const char *PipelineStats::stageName(Stage stage) {
+  switch (stage) {
+    case Receive:
+      return "receive";
+    case Handoff:
+      return "handoff";
+    case Averaging:
+      return "averaging";
+    case Correction:
+      return "correction";
+    case Preprocess:
+      return "preprocess";
+    case InferenceQueue:
+      return "inference_queue";
+    case Inference:
+      return "inference";
+    case Delivery:
+      return "delivery";
+    case EndToEnd:
+      return "end_to_end";
+    default:
+      return "unknown";
+  }
+}
+
+bool PipelineStats::tracing() const {
+  return registry().tracing.load(std::memory_order_relaxed);
+}
+
+void PipelineStats::setTracing(bool enabled) {
+  if (registry().tracing.exchange(enabled) == enabled) {
+    return;
+  }
+  if (enabled) {
+    // 重新开始跟踪时丢弃上一次的事件，导出的文件只包含本次跟踪区间
+    traceEvents_.clear();
+    drainTraceEvents();
+    traceEvents_.clear();
+    registry().droppedTraceEvents.store(0, std::memory_order_relaxed);
+  }
+  qDebug() << (enabled ? "流水线跟踪已开启" : "流水线跟踪已停止");
+  emit tracingChanged();
+}
+
+void PipelineStats::reset() {
+  PipelineRegistry &r = registry();
+  for (auto &histogram : r.histograms) {
+    histogram.reset();
+  }
+  drainTraceEvents();
+  traceEvents_.clear();
+  r.droppedTraceEvents.store(0, std::memory_order_relaxed);
+  reportedTotal_ = ~0ULL;
+  update();
+}
+
+void PipelineStats::drainTraceEvents() {
+  PipelineRegistry &r = registry();
+  TraceEvent batch[1024];
+  size_t n;
+  while ((n = r.traceRing.pop(batch, 1024)) > 0) {
+    const size_t room = static_cast<size_t>(kMaxTraceEvents) - traceEvents_.size();
+    traceEvents_.insert(traceEvents_.end(), batch, batch + qMin(n, room));
+    if (n > room) {
+      r.droppedTraceEvents.fetch_add(n - room, std::memory_order_relaxed);
+    }
+  }
+  if (traceEvents_.size() >= static_cast<size_t>(kMaxTraceEvents) && tracing()) {
+    qWarning() << "流水线跟踪事件已达上限" << kMaxTraceEvents << "，自动停止跟踪";
+    setTracing(false);
+  }
+}
+
+void PipelineStats::update() {
+  drainTraceEvents();
+
+  PipelineRegistry &r = registry();
+  quint64 total = 0;
+  for (const auto &histogram : r.histograms) {
+    total += histogram.count();
+  }
+  if (total == reportedTotal_) {
+    return;
+  }
+  reportedTotal_ = total;
+
+  QVariantList stages;
+  for (int i = 0; i < StageCount; i++) {
+    const LatencyHistogram &histogram = r.histograms[i];
+    QVariantMap entry;
+    entry.insert(QStringLiteral("name"), QString::fromLatin1(stageName(static_cast<Stage>(i))));
+    entry.insert(QStringLiteral("count"), static_cast<double>(histogram.count()));
+    entry.insert(QStringLiteral("meanUs"), histogram.meanNs() / 1e3);
+    entry.insert(QStringLiteral("p50Us"), histogram.percentileNs(50.0) / 1e3);
+    entry.insert(QStringLiteral("p99Us"), histogram.percentileNs(99.0) / 1e3);
+    entry.insert(QStringLiteral("p999Us"), histogram.percentileNs(99.9) / 1e3);
+    entry.insert(QStringLiteral("maxUs"), static_cast<double>(histogram.maxNs()) / 1e3);
+    stages.append(entry);
+  }
+  stages_ = stages;
+  emit statsUpdated();
+}
+
+QString PipelineStats::summary() const {
+  QStringList parts;
+  for (const QVariant &value : stages_) {
+    const QVariantMap entry = value.toMap();
+    if (entry.value(QStringLiteral("count")).toDouble() <= 0) {
+      continue;
+    }
+    parts.append(QStringLiteral("%1 p50=%2us p99=%3us max=%4us")
+                     .arg(entry.value(QStringLiteral("name")).toString())
+                     .arg(entry.value(QStringLiteral("p50Us")).toDouble(), 0, 'f', 1)
+                     .arg(entry.value(QStringLiteral("p99Us")).toDouble(), 0, 'f', 1)
+                     .arg(entry.value(QStringLiteral("maxUs")).toDouble(), 0, 'f', 1));
+  }
+  return parts.join(QStringLiteral("; "));
+}
+
+bool PipelineStats::dumpChromeTrace(const QString &filePath) {
+  drainTraceEvents();
+
+  QFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qWarning() << "无法写入跟踪文件:" << filePath << file.errorString();
+    return false;
+  }
+
+  // Chrome trace 事件格式：ts / dur 以微秒为单位，"X" 为带时长的完整事件
+  const qint64 pid = QCoreApplication::applicationPid();
+  QByteArray out;
+  out.reserve(1 << 20);
+  out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  out.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":");
+  out.append(QByteArray::number(pid));
+  out.append(",\"args\":{\"name\":\"host_computer\"}}");
+
+  bool ok = true;
+  for (const TraceEvent &event : traceEvents_) {
+    out.append(",\n{\"name\":\"");
+    out.append(stageName(static_cast<Stage>(event.stage)));
+    out.append("\",\"cat\":\"pipeline\",\"ph\":\"X\",\"ts\":");
+    out.append(QByteArray::number(static_cast<double>(event.startNs) / 1e3, 'f', 3));
+    out.append(",\"dur\":");
+    out.append(QByteArray::number(static_cast<double>(event.durationNs) / 1e3, 'f', 3));
+    out.append(",\"pid\":");
+    out.append(QByteArray::number(pid));
+    out.append(",\"tid\":");
+    out.append(QByteArray::number(event.threadId));
+    out.append(",\"args\":{\"id\":");
+    out.append(QByteArray::number(event.traceId));
+    out.append("}}");
+    if (out.size() >= (1 << 20)) {
+      ok = ok && file.write(out) == out.size();
+      out.clear();
+    }
+  }
+  out.append("\n]}\n");
+  ok = ok && file.write(out) == out.size();
+  file.close();
+
+  if (!ok) {
+    qWarning() << "写入跟踪文件失败:" << filePath << file.errorString();
+    return false;
+  }
+  qDebug() << "已导出流水线跟踪:" << filePath << "事件数:" << traceEvents_.size()
+           << "丢弃:" << registry().droppedTraceEvents.load(std::memory_order_relaxed);
+  return true;
+}
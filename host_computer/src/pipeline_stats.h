@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+#include <QtGlobal>
+#include <vector>
+
+// 全流水线延迟统计：从数据报到达到预测结果送达主线程
+// - 各阶段在热路径上调用静态函数 record()，写入进程内全局的无锁直方图，不依赖 QObject 是否存在
+// - 时间戳统一使用 SpectrumFrame::nowNs()（CLOCK_MONOTONIC）
+// - 开启跟踪后同时记录逐事件的起止时间，可导出为 Chrome trace / Perfetto 可读的 JSON
+// - PipelineStats 对象只负责周期性汇总分位数并暴露给 QML
+class PipelineStats : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(QVariantList stages READ stages NOTIFY statsUpdated)
+  Q_PROPERTY(bool tracing READ tracing WRITE setTracing NOTIFY tracingChanged)
+  Q_PROPERTY(int traceEventCount READ traceEventCount NOTIFY statsUpdated)
+
+ public:
+  enum Stage {
+    Receive = 0,      // 数据报到达（内核/用户态时间戳）→ 分发给下游
+    Handoff,          // 分发 → 处理线程从队列取出
+    Averaging,        // 窗口平均值计算
+    Correction,       // 黑白校正
+    Preprocess,       // 模型预处理链（平滑/求导、SNV/MSC、波段选择、重采样）
+    InferenceQueue,   // 提交推理请求 → 推理线程开始执行
+    Inference,        // 单个预测器在插件内的推理耗时
+    Delivery,         // 推理完成 → 主线程槽函数收到结果
+    EndToEnd,         // 窗口最后一帧到达 → 主线程收到预测结果
+    StageCount
+  };
+  Q_ENUM(Stage)
+
+  explicit PipelineStats(QObject *parent = nullptr);
+  ~PipelineStats() override;
+
+  // 任意线程调用：记录一个阶段从 startNs 到 endNs 的耗时
+  // traceId 把同一帧/同一窗口的各阶段关联起来（帧用接收序号，窗口用窗口时间戳）
+  static void record(Stage stage, qint64 startNs, qint64 endNs, quint64 traceId = 0);
+  // 逐帧阶段只按 1/kFrameTraceStride 抽样写入跟踪（直方图仍逐帧统计），避免跟踪缓冲被帧事件占满
+  static bool shouldTraceFrame(quint64 sequence) { return sequence % kFrameTraceStride == 0; }
+  static void recordFrame(Stage stage, qint64 startNs, qint64 endNs, quint64 sequence);
+  static const char *stageName(Stage stage);
+
+  QVariantList stages() const { return stages_; }
+  bool tracing() const;
+  void setTracing(bool enabled);
+  int traceEventCount() const { return static_cast<int>(traceEvents_.size()); }
+
+  // 清空直方图与已缓存的跟踪事件
+  Q_INVOKABLE void reset();
+  // 写出 Chrome trace JSON（chrome://tracing 或 ui.perfetto.dev 可直接打开）
+  Q_INVOKABLE bool dumpChromeTrace(const QString &filePath);
+  // 单行文本摘要，便于写日志
+  Q_INVOKABLE QString summary() const;
+
+  static constexpr quint64 kFrameTraceStride = 64;
+  static constexpr int kMaxTraceEvents = 500000;  // 主线程缓存的跟踪事件上限，达到后自动停止跟踪
+
+  struct TraceEvent {
+    int stage = 0;
+    int threadId = 0;
+    qint64 startNs = 0;
+    qint64 durationNs = 0;
+    quint64 traceId = 0;
+  };
+
+ signals:
+  void statsUpdated();
+  void tracingChanged();
+
+ private slots:
+  void update();
+
+ private:
+  void drainTraceEvents();
+
+  QTimer timer_;
+  QVariantList stages_;
+  std::vector<TraceEvent> traceEvents_;
+  quint64 reportedTotal_;
+};
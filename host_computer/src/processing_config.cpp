@@ -0,0 +1,50 @@
+#include "processing_config.h"
+
+#include "udp_communicator.h"
+
+void ProcessingConfig::load(const QJsonObject &processing) {
+  spectrumThreshold = processing.value(QStringLiteral("spectrumThreshold")).toInt(spectrumThreshold);
+  referenceThreshold = processing.value(QStringLiteral("referenceThreshold")).toInt(referenceThreshold);
+  averagingMode = processing.value(QStringLiteral("averagingMode")).toInt(averagingMode);
+  outputInterval = processing.value(QStringLiteral("outputInterval")).toInt(outputInterval);
+  emaTimeConstant = processing.value(QStringLiteral("emaTimeConstant")).toDouble(emaTimeConstant);
+  adaptiveTargetSnr = processing.value(QStringLiteral("adaptiveTargetSnr")).toDouble(adaptiveTargetSnr);
+  adaptiveTargetStdError = processing.value(QStringLiteral("adaptiveTargetStdError")).toDouble(adaptiveTargetStdError);
+  adaptiveMinPackets = processing.value(QStringLiteral("adaptiveMinPackets")).toInt(adaptiveMinPackets);
+  adaptiveMaxPackets = processing.value(QStringLiteral("adaptiveMaxPackets")).toInt(adaptiveMaxPackets);
+  referenceTargetStdError =
+      processing.value(QStringLiteral("referenceTargetStdError")).toDouble(referenceTargetStdError);
+}
+
+void applyProcessingConfig(UdpCommunicator *udp, const ProcessingConfig &config) {
+  if (config.spectrumThreshold > 0) {
+    udp->setSpectrumThreshold(config.spectrumThreshold);
+  }
+  if (config.referenceThreshold > 0) {
+    udp->setReferenceThreshold(config.referenceThreshold);
+  }
+  if (config.averagingMode >= 0) {
+    udp->setAveragingMode(config.averagingMode);
+  }
+  if (config.outputInterval > 0) {
+    udp->setOutputInterval(config.outputInterval);
+  }
+  if (config.emaTimeConstant > 0.0) {
+    udp->setEmaTimeConstant(config.emaTimeConstant);
+  }
+  if (config.adaptiveTargetSnr >= 0.0) {
+    udp->setAdaptiveTargetSnr(config.adaptiveTargetSnr);
+  }
+  if (config.adaptiveTargetStdError >= 0.0) {
+    udp->setAdaptiveTargetStdError(config.adaptiveTargetStdError);
+  }
+  if (config.adaptiveMaxPackets > 0) {
+    udp->setAdaptiveMaxPackets(config.adaptiveMaxPackets);
+  }
+  if (config.adaptiveMinPackets > 0) {
+    udp->setAdaptiveMinPackets(config.adaptiveMinPackets);
+  }
+  if (config.referenceTargetStdError >= 0.0) {
+    udp->setReferenceTargetStdError(config.referenceTargetStdError);
+  }
+}
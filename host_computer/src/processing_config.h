@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QJsonObject>
+
+class UdpCommunicator;
+
+// 光谱处理参数：守护进程配置（DaemonConfig）与多设备配置（DeviceRegistry）中的 "processing" 对象
+// <= 0（averagingMode 与 adaptive / reference 目标项 < 0）的项保持 UdpCommunicator 的默认值
+struct ProcessingConfig {
+  int spectrumThreshold = 0;
+  int referenceThreshold = 0;
+  int averagingMode = -1;
+  int outputInterval = 0;
+  double emaTimeConstant = 0.0;
+  // 自适应平均：目标项 < 0 表示保持默认值（0 表示不使用该项），包数 <= 0 表示保持默认值
+  double adaptiveTargetSnr = -1.0;
+  double adaptiveTargetStdError = -1.0;
+  int adaptiveMinPackets = 0;
+  int adaptiveMaxPackets = 0;
+  double referenceTargetStdError = -1.0;
+
+  // 从 JSON 对象读取，缺少的键保持当前值
+  void load(const QJsonObject &processing);
+};
+
+// 把配置中设置了的项应用到 udp，其余保持默认值（在开始接收之前调用）
+void applyProcessingConfig(UdpCommunicator *udp, const ProcessingConfig &config);
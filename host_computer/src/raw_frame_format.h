@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "spectrum_frame.h"
+
+// 原始帧录制文件（.sfr）格式，由 RawFrameRecorder 写入、ReplaySource 读取
+//
+// 文件布局（小端）：
+//   [0, kHeaderSize)      RawFrameFileHeader，其余字节为 0（按 4096 对齐，便于 O_DIRECT 写入）
+//   [kHeaderSize, ...)    连续的 RawFrameRecord，每帧一条、按到达顺序排列
+// 打开分段时即写入 recordCount 为 0 的文件头，并按分段大小预分配；正常关闭时截断到实际长度并回写 recordCount。
+// 异常退出的文件 recordCount 为 0，读取方应扫描到第一条 timestampNs == 0 的记录为止。
+namespace RawFrameFormat {
+
+constexpr char kMagic[8] = {'S', 'P', 'E', 'C', 'R', 'A', 'W', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kHeaderSize = 4096;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t pixelCount;  // 每帧像素数（SpectrumFrame::kPixelCount）
+  uint32_t recordSize;  // sizeof(FrameRecord)
+  uint32_t segmentIndex;  // 分段序号（按大小滚动时递增）
+  uint64_t recordCount;  // 帧数（正常关闭时写入）
+  uint64_t firstSequence;  // 第一帧的接收序号
+  int64_t firstTimestampNs;  // 第一帧的接收时间戳（CLOCK_MONOTONIC）
+  int64_t startWallMs;  // 分段开始时的墙上时间（毫秒级 UTC），用于把单调时间戳换算为日期
+  uint8_t reserved[72];
+};
+
+struct FrameRecord {
+  uint64_t sequence;  // 接收序号
+  int64_t timestampNs;  // 接收时间戳（CLOCK_MONOTONIC，纳秒）
+  uint32_t count;  // 有效点数（短包时小于 pixelCount）
+  uint32_t reserved;
+  uint16_t data[SpectrumFrame::kPixelCount];
+};
+
+static_assert(sizeof(FileHeader) == 128, "raw frame file header layout changed");
+static_assert(sizeof(FrameRecord) == 24 + 2 * SpectrumFrame::kPixelCount, "raw frame record layout changed");
+
+}  // namespace RawFrameFormat
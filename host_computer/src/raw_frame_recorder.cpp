@@ -0,0 +1,367 @@
+#include "raw_frame_recorder.h"
+#include "thread_placement.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using RawFrameFormat::FileHeader;
+using RawFrameFormat::FrameRecord;
+
+namespace {
+
+constexpr size_t kDirectIoAlignment = 4096;
+
+size_t alignUp(size_t value) {
+  return (value + kDirectIoAlignment - 1) / kDirectIoAlignment * kDirectIoAlignment;
+}
+
+// 完整写入 size 字节（处理部分写入与 EINTR）
+bool pwriteAll(int fd, const char *data, size_t size, qint64 offset) {
+  while (size > 0) {
+    const ssize_t n = pwrite(fd, data, size, offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+    offset += n;
+  }
+  return true;
+}
+
+}  // namespace
+
+static_assert(RawFrameRecorder::kBufferBytes % kDirectIoAlignment == 0, "write buffer must be sector aligned");
+static_assert(RawFrameFormat::kHeaderSize % kDirectIoAlignment == 0, "file header must be sector aligned");
+
+RawFrameRecorder::RawFrameRecorder(QObject *parent)
+    : QThread(parent), inputQueue_(std::make_shared<SpectrumFrameQueue>(kQueueCapacity)),
+      maxFileBytes_(kDefaultMaxFileBytes), directIo_(false), stopRequested_(false),
+      active_(0), segment_(0), segmentRecords_(0), recordsPerSegment_(1),
+      pendingIo_(nullptr), ioStop_(false), ioThread_(nullptr), ioFailed_(false),
+      fd_(-1), openSegmentIndex_(-1), fileOffset_(0),
+      recordedFrames_(0), discardedFrames_(0), bytesWritten_(0), segmentCount_(0) {
+  std::memset(&segmentHeader_, 0, sizeof(segmentHeader_));
+}
+
+RawFrameRecorder::~RawFrameRecorder() {
+  stopRecording();
+}
+
+void RawFrameRecorder::configure(const QString &basePath, qint64 maxFileBytes, bool directIo) {
+  basePath_ = basePath;
+  if (basePath_.endsWith(QStringLiteral(".sfr"))) {
+    basePath_.chop(4);
+  }
+  // 分段至少能容纳一块写缓冲区
+  maxFileBytes_ = qMax(maxFileBytes, static_cast<qint64>(RawFrameFormat::kHeaderSize + kBufferBytes));
+  directIo_ = directIo;
+  recordsPerSegment_ = static_cast<quint64>(maxFileBytes_ - RawFrameFormat::kHeaderSize) / sizeof(FrameRecord);
+}
+
+void RawFrameRecorder::stopRecording() {
+  stopRequested_ = true;
+  inputQueue_->wake();  // 唤醒等待中的打包线程，剩余的帧写完后退出
+  wait();
+}
+
+QString RawFrameRecorder::currentFile() const {
+  QMutexLocker locker(&fileMutex_);
+  return currentFile_;
+}
+
+QString RawFrameRecorder::segmentPath(int segment) const {
+  return basePath_ + QStringLiteral("_%1.sfr").arg(segment, 4, 10, QChar('0'));
+}
+
+void RawFrameRecorder::fail(const QString &error) {
+  qWarning() << "[RawFrameRecorder]" << error;
+  ioFailed_ = true;
+  emit errorOccurred(error);
+}
+
+void RawFrameRecorder::run() {
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Recorder);
+  // O_DIRECT 要求缓冲区按扇区对齐
+  for (WriteBuffer &b : buffers_) {
+    b.data = static_cast<char *>(std::aligned_alloc(kDirectIoAlignment, kBufferBytes));
+    b.used = 0;
+    b.endsSegment = false;
+  }
+  active_ = 0;
+  segment_ = 0;
+  segmentRecords_ = 0;
+  ioStop_ = false;
+  ioThread_ = QThread::create([this]() { ioLoop(); });
+  ioThread_->start();
+
+  const int popChunk = 256;
+  std::vector<SpectrumFramePtr> chunk(popChunk);
+  while (true) {
+    const int n = inputQueue_->popFrames(chunk.data(), popChunk);
+    if (n == 0) {
+      // 停止时把队列中剩余的帧写完再退出
+      if (stopRequested_) {
+        break;
+      }
+      inputQueue_->waitForFrames();
+      continue;
+    }
+    for (int i = 0; i < n; ++i) {
+      SpectrumFramePtr &frame = chunk[static_cast<size_t>(i)];
+      if (ioFailed_.load(std::memory_order_relaxed)) {
+        discardedFrames_.fetch_add(1, std::memory_order_relaxed);
+      } else if (frame) {
+        appendFrame(*frame);
+      }
+      frame.reset();
+    }
+  }
+
+  // 关闭最后一个分段并等待 I/O 线程写完
+  if (segmentRecords_ > 0) {
+    submitActive(true);
+  }
+  {
+    QMutexLocker locker(&ioMutex_);
+    while (pendingIo_) {
+      ioCond_.wait(&ioMutex_);
+    }
+    ioStop_ = true;
+    ioCond_.wakeAll();
+  }
+  ioThread_->wait();
+  delete ioThread_;
+  ioThread_ = nullptr;
+
+  for (WriteBuffer &b : buffers_) {
+    std::free(b.data);
+    b.data = nullptr;
+  }
+}
+
+void RawFrameRecorder::appendFrame(const SpectrumFrame &frame) {
+  // 分段写满时在帧边界处滚动，保证每个文件都只包含完整的帧
+  if (segmentRecords_ == recordsPerSegment_) {
+    submitActive(true);
+    segment_++;
+    segmentRecords_ = 0;
+  }
+  if (segmentRecords_ == 0) {
+    std::memset(&segmentHeader_, 0, sizeof(segmentHeader_));
+    std::memcpy(segmentHeader_.magic, RawFrameFormat::kMagic, sizeof(RawFrameFormat::kMagic));
+    segmentHeader_.version = RawFrameFormat::kVersion;
+    segmentHeader_.pixelCount = SpectrumFrame::kPixelCount;
+    segmentHeader_.recordSize = sizeof(FrameRecord);
+    segmentHeader_.segmentIndex = static_cast<uint32_t>(segment_);
+    segmentHeader_.firstSequence = frame.sequence;
+    segmentHeader_.firstTimestampNs = frame.timestampNs;
+    segmentHeader_.startWallMs = QDateTime::currentMSecsSinceEpoch();
+  }
+
+  FrameRecord record;
+  record.sequence = frame.sequence;
+  record.timestampNs = frame.timestampNs;
+  record.count = static_cast<uint32_t>(frame.count);
+  record.reserved = 0;
+  std::memcpy(record.data, frame.data, sizeof(record.data));
+
+  // 记录在缓冲区之间连续拼接，可能跨越两块缓冲区
+  const char *src = reinterpret_cast<const char *>(&record);
+  size_t remaining = sizeof(record);
+  while (remaining > 0) {
+    WriteBuffer &b = buffers_[active_];
+    if (b.used == 0) {
+      b.segment = segment_;
+    }
+    const size_t n = qMin(remaining, kBufferBytes - b.used);
+    std::memcpy(b.data + b.used, src, n);
+    b.used += n;
+    src += n;
+    remaining -= n;
+    if (b.used == kBufferBytes) {
+      submitActive(false);
+    }
+  }
+
+  segmentRecords_++;
+  recordedFrames_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RawFrameRecorder::submitActive(bool endsSegment) {
+  WriteBuffer &b = buffers_[active_];
+  if (b.used == 0 && !endsSegment) {
+    return;
+  }
+  if (b.used == 0) {
+    b.segment = segment_;
+  }
+  b.endsSegment = endsSegment;
+  // 每块都带上分段的文件头，I/O 线程打开新分段时先写入（recordCount 为 0），正常关闭时再回写帧数
+  b.header = segmentHeader_;
+  b.header.recordCount = endsSegment ? segmentRecords_ : 0;
+
+  {
+    // 等待 I/O 线程写完另一块缓冲区；等待期间接收线程的帧在无锁队列中缓存
+    QMutexLocker locker(&ioMutex_);
+    while (pendingIo_) {
+      ioCond_.wait(&ioMutex_);
+    }
+    pendingIo_ = &b;
+    ioCond_.wakeAll();
+  }
+
+  active_ ^= 1;
+  buffers_[active_].used = 0;
+  buffers_[active_].endsSegment = false;
+}
+
+void RawFrameRecorder::ioLoop() {
+  while (true) {
+    WriteBuffer *buffer = nullptr;
+    {
+      QMutexLocker locker(&ioMutex_);
+      while (!pendingIo_ && !ioStop_) {
+        ioCond_.wait(&ioMutex_);
+      }
+      if (!pendingIo_) {
+        break;
+      }
+      buffer = pendingIo_;
+    }
+
+    if (!ioFailed_.load(std::memory_order_relaxed)) {
+      writeBuffer(*buffer);
+    }
+
+    QMutexLocker locker(&ioMutex_);
+    pendingIo_ = nullptr;
+    ioCond_.wakeAll();
+  }
+
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  openSegmentIndex_ = -1;
+}
+
+bool RawFrameRecorder::openSegment(int segment, const FileHeader &header) {
+  const QString path = segmentPath(segment);
+  const QByteArray nativePath = QFile::encodeName(path);
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  fd_ = -1;
+  if (directIo_) {
+    fd_ = ::open(nativePath.constData(), flags | O_DIRECT, 0644);
+    if (fd_ < 0 && errno == EINVAL) {
+      qWarning() << "[RawFrameRecorder] 文件系统不支持 O_DIRECT，改用普通写入:" << path;
+    }
+  }
+  if (fd_ < 0) {
+    fd_ = ::open(nativePath.constData(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    fail(QStringLiteral("无法创建录制文件 %1: %2").arg(path, QString::fromLocal8Bit(strerror(errno))));
+    return false;
+  }
+
+  // 按分段大小预分配，避免写入过程中频繁扩展文件；不支持时只影响性能
+  const int err = posix_fallocate(fd_, 0, maxFileBytes_);
+  if (err != 0) {
+    qWarning() << "[RawFrameRecorder] 预分配失败:" << path << strerror(err);
+  }
+
+  // 先写入 recordCount 为 0 的文件头：异常退出后文件仍可识别，读取方扫描到第一条空记录为止
+  FileHeader openHeader = header;
+  openHeader.recordCount = 0;
+  if (!writeHeaderBlock(openHeader)) {
+    fail(QStringLiteral("写入录制文件头失败 %1: %2").arg(path, QString::fromLocal8Bit(strerror(errno))));
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  openSegmentIndex_ = segment;
+  fileOffset_ = RawFrameFormat::kHeaderSize;
+  segmentCount_.fetch_add(1, std::memory_order_relaxed);
+  {
+    QMutexLocker locker(&fileMutex_);
+    currentFile_ = path;
+  }
+  emit segmentOpened(path);
+  return true;
+}
+
+bool RawFrameRecorder::writeBuffer(const WriteBuffer &buffer) {
+  if (openSegmentIndex_ != buffer.segment) {
+    if (!openSegment(buffer.segment, buffer.header)) {
+      return false;
+    }
+  }
+
+  if (buffer.used > 0) {
+    // O_DIRECT 要求写入长度按扇区对齐：只有分段的最后一块可能不满，补 0 后写入，关闭时再截断
+    size_t size = buffer.used;
+    if (directIo_) {
+      const size_t padded = alignUp(buffer.used);
+      std::memset(buffer.data + buffer.used, 0, padded - buffer.used);
+      size = padded;
+    }
+    if (!pwriteAll(fd_, buffer.data, size, fileOffset_)) {
+      fail(QStringLiteral("写入录制文件失败 %1: %2")
+               .arg(segmentPath(buffer.segment), QString::fromLocal8Bit(strerror(errno))));
+      return false;
+    }
+    fileOffset_ += static_cast<qint64>(buffer.used);
+    bytesWritten_.fetch_add(buffer.used, std::memory_order_relaxed);
+  }
+
+  if (buffer.endsSegment) {
+    return closeSegment(buffer.header);
+  }
+  return true;
+}
+
+bool RawFrameRecorder::writeHeaderBlock(const FileHeader &header) {
+  char *block = static_cast<char *>(std::aligned_alloc(kDirectIoAlignment, RawFrameFormat::kHeaderSize));
+  if (!block) {
+    errno = ENOMEM;
+    return false;
+  }
+  std::memset(block, 0, RawFrameFormat::kHeaderSize);
+  std::memcpy(block, &header, sizeof(header));
+  const bool ok = pwriteAll(fd_, block, RawFrameFormat::kHeaderSize, 0);
+  std::free(block);
+  return ok;
+}
+
+bool RawFrameRecorder::closeSegment(const FileHeader &header) {
+  const qint64 dataEnd = RawFrameFormat::kHeaderSize +
+                         static_cast<qint64>(header.recordCount) * static_cast<qint64>(sizeof(FrameRecord));
+  bool ok = ftruncate(fd_, dataEnd) == 0;
+
+  // 回写带最终帧数的文件头
+  ok = ok && writeHeaderBlock(header);
+  ok = ok && fdatasync(fd_) == 0;
+
+  if (!ok) {
+    fail(QStringLiteral("关闭录制文件失败 %1: %2")
+             .arg(segmentPath(openSegmentIndex_), QString::fromLocal8Bit(strerror(errno))));
+  }
+  ::close(fd_);
+  fd_ = -1;
+  openSegmentIndex_ = -1;
+  return ok;
+}
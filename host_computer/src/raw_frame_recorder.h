@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+
+#include "raw_frame_format.h"
+#include "spectrum_frame_queue.h"
+
+// 原始帧录制线程：把接收线程收到的每一帧（含接收序号与时间戳）追加写入 .sfr 文件
+// - 作为接收线程的帧接收端，入队只写无锁队列，永不阻塞接收线程；队列满时丢帧并计数
+// - 打包线程把帧拷入两块大缓冲区之一，写满后交给 I/O 线程写盘，同时继续填充另一块（双缓冲）
+// - 每个分段文件按 maxFileBytes 预分配，写满后滚动到下一个分段 <base>_0001.sfr ...
+// - 可选 O_DIRECT：缓冲区与写入长度按 4096 对齐，绕过页缓存
+class RawFrameRecorder : public QThread {
+  Q_OBJECT
+
+ public:
+  static constexpr qint64 kDefaultMaxFileBytes = 1024LL * 1024 * 1024;  // 每个分段 1 GiB
+  static constexpr size_t kBufferBytes = 4 * 1024 * 1024;  // 每块写缓冲 4 MiB
+  static constexpr size_t kQueueCapacity = 65536;  // 约 3 秒的帧（20k 帧/秒）
+
+  explicit RawFrameRecorder(QObject *parent = nullptr);
+  ~RawFrameRecorder();
+
+  // basePath：输出文件前缀（可以带 .sfr 后缀），分段文件为 <base>_NNNN.sfr
+  // 必须在 start() 之前调用
+  void configure(const QString &basePath, qint64 maxFileBytes = kDefaultMaxFileBytes,
+                 bool directIo = false);
+
+  // 输入队列：由接收线程直接写入
+  std::shared_ptr<SpectrumFrameQueue> inputQueue() const { return inputQueue_; }
+
+  // 写完已入队的帧后停止
+  void stopRecording();
+
+  // 统计（任意线程读取）
+  quint64 recordedFrames() const { return recordedFrames_.load(std::memory_order_relaxed); }
+  quint64 droppedFrames() const {
+    return inputQueue_->overflowCount() + discardedFrames_.load(std::memory_order_relaxed);
+  }
+  quint64 bytesWritten() const { return bytesWritten_.load(std::memory_order_relaxed); }
+  int segmentCount() const { return segmentCount_.load(std::memory_order_relaxed); }
+  QString currentFile() const;
+
+ signals:
+  void segmentOpened(const QString &filePath);
+  void errorOccurred(const QString &error);
+
+ protected:
+  void run() override;
+
+ private:
+  // 一块写缓冲区及其所属分段
+  struct WriteBuffer {
+    char *data = nullptr;
+    size_t used = 0;
+    int segment = 0;
+    bool endsSegment = false;  // 写完后关闭该分段
+    RawFrameFormat::FileHeader header;  // 所属分段的文件头（recordCount 只在 endsSegment 时有效）
+  };
+
+  void appendFrame(const SpectrumFrame &frame);
+  void submitActive(bool endsSegment);
+  void ioLoop();
+  bool openSegment(int segment, const RawFrameFormat::FileHeader &header);
+  bool writeBuffer(const WriteBuffer &buffer);
+  bool closeSegment(const RawFrameFormat::FileHeader &header);
+  // 在文件开头写入整块 4096 字节的文件头（满足 O_DIRECT 的对齐要求）
+  bool writeHeaderBlock(const RawFrameFormat::FileHeader &header);
+  QString segmentPath(int segment) const;
+  void fail(const QString &error);
+
+  std::shared_ptr<SpectrumFrameQueue> inputQueue_;
+  QString basePath_;
+  qint64 maxFileBytes_;
+  bool directIo_;
+  std::atomic<bool> stopRequested_;
+
+  // 以下仅打包线程访问
+  WriteBuffer buffers_[2];
+  int active_;  // 正在填充的缓冲区
+  int segment_;
+  quint64 segmentRecords_;
+  RawFrameFormat::FileHeader segmentHeader_;
+  quint64 recordsPerSegment_;
+
+  // 打包线程与 I/O 线程之间的交接，受 ioMutex_ 保护
+  QMutex ioMutex_;
+  QWaitCondition ioCond_;
+  WriteBuffer *pendingIo_;  // I/O 线程正在写或待写的缓冲区（写完后置空）
+  bool ioStop_;
+  QThread *ioThread_;
+  std::atomic<bool> ioFailed_;  // 写盘失败后不再接收新帧
+
+  // 以下仅 I/O 线程访问
+  int fd_;
+  int openSegmentIndex_;
+  qint64 fileOffset_;
+
+  std::atomic<quint64> recordedFrames_;
+  std::atomic<quint64> discardedFrames_;  // 写盘失败后丢弃的帧
+  std::atomic<quint64> bytesWritten_;
+  std::atomic<int> segmentCount_;
+  mutable QMutex fileMutex_;
+  QString currentFile_;  // 受 fileMutex_ 保护
+};
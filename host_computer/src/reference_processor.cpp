@@ -1,126 +1,127 @@
 #include "reference_processor.h"
+#include "spectral_math.h"
 
 #include <QDebug>
 
 ReferenceProcessor::ReferenceProcessor(ReferenceType type, QObject *parent)
-    : QThread(parent), stopRequested_(false), accumulating_(false), referenceType_(type) {
+    : QObject(parent), accumulator_(true), accumulatedPackets_(0), activeThreshold_(DEFAULT_REFERENCE_THRESHOLD),
+      activeMinPackets_(DEFAULT_ADAPTIVE_MIN_PACKETS), activeTargetStdError_(0.0),
+      accumulating_(false), resetRequested_(false),
+      accumulatedCount_(0), referenceThreshold_(DEFAULT_REFERENCE_THRESHOLD),
+      adaptiveMinPackets_(DEFAULT_ADAPTIVE_MIN_PACKETS), adaptiveTargetStdError_(0.0), referenceType_(type) {
 }
 
-ReferenceProcessor::~ReferenceProcessor() {
-  stopProcessing();
+void ReferenceProcessor::setReferenceThreshold(int packets) {
+  referenceThreshold_ = qMax(1, packets);
+}
+
+void ReferenceProcessor::setAdaptiveTarget(double targetStdError, int minPackets) {
+  adaptiveTargetStdError_ = qMax(0.0, targetStdError);
+  adaptiveMinPackets_ = qMax(2, minPackets);
 }
 
 void ReferenceProcessor::startAccumulating() {
-  QMutexLocker locker(&mutex_);
+  resetRequested_ = true;
+  accumulatedCount_ = 0;
   accumulating_ = true;
-  accumulatedData_.clear();
-  condition_.wakeOne();
 }
 
 void ReferenceProcessor::stopAccumulating() {
-  QMutexLocker locker(&mutex_);
   accumulating_ = false;
-  accumulatedData_.clear();
+  resetRequested_ = true;
+  accumulatedCount_ = 0;
 }
 
 int ReferenceProcessor::getAccumulatedCount() const {
-  QMutexLocker locker(const_cast<QMutex*>(&mutex_));
-  return accumulatedData_.size();
+  return accumulatedCount_;
 }
 
-void ReferenceProcessor::addSpectrumData(const QVariantList &data) {
-  QMutexLocker locker(&mutex_);
-  if (accumulating_ && accumulatedData_.size() < REFERENCE_THRESHOLD) {
-    accumulatedData_.append(data);
-    // 发送进度更新信号
-    emit progressChanged(accumulatedData_.size(), REFERENCE_THRESHOLD);
-    condition_.wakeOne();  // 唤醒处理线程
+void ReferenceProcessor::pushFrames(const SpectrumFramePtr *frames, int count) {
+  if (resetRequested_.exchange(false)) {
+    accumulator_.reset();
+    accumulatedPackets_ = 0;
+    activeThreshold_ = referenceThreshold_;
+    activeTargetStdError_ = adaptiveTargetStdError_;
+    activeMinPackets_ = qMin(adaptiveMinPackets_.load(), activeThreshold_);
+  }
+  if (!accumulating_) {
+    return;
   }
-}
 
-void ReferenceProcessor::stopProcessing() {
-  {
-    QMutexLocker locker(&mutex_);
-    stopRequested_ = true;
-    accumulating_ = false;
-    condition_.wakeAll();  // 唤醒所有等待的线程
+  const int before = accumulatedPackets_;
+  bool targetReached = false;
+  for (int i = 0; i < count && accumulatedPackets_ < activeThreshold_; ++i) {
+    // 只取到阈值为止
+    const SpectrumFramePtr &frame = frames[i];
+    if (frame && frame->isComplete()) {
+      accumulator_.add(frame->data);
+    }
+    accumulatedPackets_++;
+    // 自适应：达到最少包数后定期检查标准误，达到目标即提前结束
+    if (activeTargetStdError_ > 0.0 && accumulatedPackets_ >= activeMinPackets_ &&
+        accumulatedPackets_ % kAdaptiveCheckInterval == 0 && adaptiveTargetReached()) {
+      targetReached = true;
+      break;
+    }
   }
-  wait(1000);  // 等待最多1秒
-  if (isRunning()) {
-    terminate();
-    wait();
+  if (accumulatedPackets_ == before) {
+    return;  // 已达到阈值
+  }
+
+  // 进度按 256 帧（或到达阈值时）通知一次，避免每个小批次都排队一个信号
+  accumulatedCount_ = accumulatedPackets_;
+  if (accumulatedPackets_ / 256 != before / 256 || accumulatedPackets_ >= activeThreshold_ || targetReached) {
+    emit progressChanged(accumulatedPackets_, targetReached ? accumulatedPackets_ : activeThreshold_);
+  }
+
+  // 如果累积的数据达到阈值（或自适应目标），进行处理
+  if (accumulatedPackets_ >= activeThreshold_ || targetReached) {
+    accumulating_ = false;  // 停止累积
+    processReference();
+    accumulator_.reset();
+    accumulatedPackets_ = 0;
   }
 }
 
-void ReferenceProcessor::run() {
-  const int dataPoints = 1024;  // 每个数据包的点数
+bool ReferenceProcessor::adaptiveTargetReached() const {
+  return accumulator_.quality().stdError <= activeTargetStdError_;
+}
 
-  while (!stopRequested_) {
-    QMutexLocker locker(&mutex_);
-    
-    // 等待有数据或停止请求
-    while ((!accumulating_ || accumulatedData_.size() < REFERENCE_THRESHOLD) && !stopRequested_) {
-      condition_.wait(&mutex_);
-    }
+void ReferenceProcessor::processReference() {
+  const int dataPoints = SpectrumFrame::kPixelCount;  // 每个数据包的点数
+
+  // 在处理线程中计算，不阻塞主线程
+  // 平均值 = 逐像素和 / 有效（完整）数据包数量
+  QVector<double> means(dataPoints, 0.0);
+  QVector<double> stdDevs(dataPoints, 0.0);
+  accumulator_.mean(means.data());
+  accumulator_.stdDev(stdDevs.data());
+
+  // 找到最大值和最小值
+  double minVal = 0.0;
+  double maxVal = 0.0;
+  SpectralMath::minMax(means.constData(), dataPoints, &minVal, &maxVal);
+
+  QVariantList averagedData;
+  averagedData.reserve(dataPoints);
+  for (int i = 0; i < dataPoints; i++) {
+    averagedData.append(means[i]);
+  }
 
-    if (stopRequested_) {
-      break;
-    }
+  // 逐像素噪声（标准差）
+  QVariantList noiseData;
+  noiseData.reserve(dataPoints);
+  double noiseSum = 0.0;
+  for (int i = 0; i < dataPoints; i++) {
+    noiseData.append(stdDevs[i]);
+    noiseSum += stdDevs[i];
+  }
+  emit noiseReady(noiseData, noiseSum / dataPoints, accumulator_.quality().stdError);
 
-    // 如果累积的数据达到阈值，进行处理
-    if (accumulating_ && accumulatedData_.size() >= REFERENCE_THRESHOLD) {
-      // 复制数据到本地，释放锁
-      QList<QVariantList> dataToProcess = accumulatedData_;
-      accumulatedData_.clear();
-      accumulating_ = false;  // 停止累积
-      locker.unlock();
-
-      // 在后台线程中处理数据，不阻塞主线程
-      QVariantList averagedData;
-      averagedData.reserve(dataPoints);
-
-      // 初始化平均值数组
-      for (int i = 0; i < dataPoints; i++) {
-        averagedData.append(0.0);
-      }
-
-      // 计算平均值
-      int packetCount = dataToProcess.size();
-      for (const QVariantList &packet : dataToProcess) {
-        if (packet.size() == dataPoints) {
-          for (int i = 0; i < dataPoints; i++) {
-            double currentValue = averagedData[i].toDouble();
-            double packetValue = packet[i].toDouble();
-            averagedData[i] = QVariant::fromValue(currentValue + packetValue);
-          }
-        }
-      }
-
-      // 除以数据包数量得到平均值
-      for (int i = 0; i < dataPoints; i++) {
-        double avg = averagedData[i].toDouble() / packetCount;
-        averagedData[i] = QVariant::fromValue(avg);
-      }
-
-      // 找到最大值和最小值
-      double minVal = averagedData[0].toDouble();
-      double maxVal = averagedData[0].toDouble();
-      for (int i = 1; i < dataPoints; i++) {
-        double val = averagedData[i].toDouble();
-        if (val < minVal) minVal = val;
-        if (val > maxVal) maxVal = val;
-      }
-
-      // 根据参考类型发送相应的信号
-      if (referenceType_ == BlackReference) {
-        emit blackReferenceReady(averagedData, minVal, maxVal);
-      } else {
-        emit whiteReferenceReady(averagedData, minVal, maxVal);
-      }
-
-      // 重新获取锁，继续下一轮
-      locker.relock();
-    }
+  // 根据参考类型发送相应的信号
+  if (referenceType_ == BlackReference) {
+    emit blackReferenceReady(averagedData, minVal, maxVal, accumulatedPackets_);
+  } else {
+    emit whiteReferenceReady(averagedData, minVal, maxVal, accumulatedPackets_);
   }
 }
-
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <QObject>
-#include <QThread>
 #include <QVariant>
-#include <QMutex>
-#include <QWaitCondition>
+#include <QVector>
+#include <atomic>
+#include <memory>
 
-// 通用参考数据处理线程，可以处理黑参考或白参考，累积39500个数据包并计算平均值
-class ReferenceProcessor : public QThread {
+#include "spectrum_accumulator.h"
+#include "spectrum_frame.h"
+#include "spectrum_frame_queue.h"
+
+// 通用参考数据累积器，可以处理黑参考或白参考，累积一定数量（默认39500个）数据包并计算平均值
+// 设置了目标标准误时改为自适应：达到最少包数后，逐像素标准误的中位数达到目标即结束，阈值作为上限
+// 不再单独占用线程：作为消费者挂在 SpectrumProcessor 上，在处理线程中与主光谱共用同一批帧
+// 信号从处理线程发出，连接时需使用 QueuedConnection
+class ReferenceProcessor : public QObject, public SpectrumFrameSink {
   Q_OBJECT
 
  public:
@@ -16,20 +23,29 @@ class ReferenceProcessor : public QThread {
     WhiteReference
   };
 
+  static const int DEFAULT_REFERENCE_THRESHOLD = 39500;  // 默认需要累积39500条数据
+  static const int DEFAULT_ADAPTIVE_MIN_PACKETS = 3950;  // 自适应时至少累积的数据包数
+  static const int kAdaptiveCheckInterval = 256;  // 自适应时每隔多少个数据包检查一次标准误
+
   explicit ReferenceProcessor(ReferenceType type, QObject *parent = nullptr);
-  ~ReferenceProcessor();
 
+  // 设置需要累积的数据包数（在下一次 startAccumulating() 时生效）
+  void setReferenceThreshold(int packets);
+  int referenceThreshold() const { return referenceThreshold_; }
+
+  // 自适应结束条件（在下一次 startAccumulating() 时生效）：逐像素标准误（计数）的中位数不超过 targetStdError
+  // 时结束，<= 0 表示始终累积 referenceThreshold 个数据包
+  void setAdaptiveTarget(double targetStdError, int minPackets = DEFAULT_ADAPTIVE_MIN_PACKETS);
+  double adaptiveTargetStdError() const { return adaptiveTargetStdError_; }
+  
   // 开始累积参考数据
   void startAccumulating();
   
   // 停止累积
   void stopAccumulating();
   
-  // 添加一条光谱数据
-  void addSpectrumData(const QVariantList &data);
-  
-  // 停止处理
-  void stopProcessing();
+  // 处理线程调用：累加一批帧（未在累积或已达到阈值时直接返回）
+  void pushFrames(const SpectrumFramePtr *frames, int count) override;
   
   // 获取当前累积进度
   int getAccumulatedCount() const;
@@ -41,22 +57,33 @@ class ReferenceProcessor : public QThread {
   // 累积进度更新
   void progressChanged(int count, int total);
   
-  // 黑参考数据处理完成
-  void blackReferenceReady(const QVariantList &averagedSpectrum, double minVal, double maxVal);
+  // 黑参考数据处理完成（packetCount 为实际累积的数据包数）
+  void blackReferenceReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
   
   // 白参考数据处理完成
-  void whiteReferenceReady(const QVariantList &averagedSpectrum, double minVal, double maxVal);
-
- protected:
-  void run() override;
+  void whiteReferenceReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
+  
+  // 参考数据的逐像素噪声（标准差）及其平均值、平均值的中位数标准误，在 ready 信号之前发送
+  void noiseReady(const QVariantList &pixelStdDev, double meanStdDev, double stdError);
 
  private:
-  QMutex mutex_;
-  QWaitCondition condition_;
-  QList<QVariantList> accumulatedData_;  // 累积的光谱数据
-  bool stopRequested_;
-  bool accumulating_;  // 是否正在累积
+  // 对累积满的数据求平均并发送结果
+  void processReference();
+
+  // 自适应时检查是否已达到目标标准误（仅处理线程调用）
+  bool adaptiveTargetReached() const;
+
+  SpectrumAccumulator accumulator_;  // 逐帧累加的像素和与平方和（仅处理线程访问）
+  int accumulatedPackets_;  // 已接收的数据包数（含不完整的包，仅处理线程访问）
+  int activeThreshold_;  // 本次累积使用的阈值（仅处理线程访问）
+  int activeMinPackets_;  // 本次累积的自适应最少包数与目标（仅处理线程访问）
+  double activeTargetStdError_;
+  std::atomic<bool> accumulating_;  // 是否正在累积
+  std::atomic<bool> resetRequested_;  // 请求处理线程清空已累积的数据
+  std::atomic<int> accumulatedCount_;  // 当前累积进度（供其它线程读取）
+  std::atomic<int> referenceThreshold_;  // 需要累积的数据包数
+  std::atomic<int> adaptiveMinPackets_;
+  std::atomic<double> adaptiveTargetStdError_;  // 自适应目标标准误（<= 0 表示不使用）
   ReferenceType referenceType_;  // 参考类型（黑参考或白参考）
-  static const int REFERENCE_THRESHOLD = 39500;  // 需要累积39500条数据
 };
 
@@ -0,0 +1,322 @@
+#include "replay_source.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QVariant>
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+#include "spectrum_file_manager.h"
+#include "thread_placement.h"
+
+using RawFrameFormat::FileHeader;
+using RawFrameFormat::FrameRecord;
+
+namespace {
+
+constexpr int kReplayBatch = 32;  // 每次分发的最大帧数（与接收线程默认批大小一致）
+constexpr qint64 kCsvDefaultIntervalNs = 1000000;  // CSV 无有效时间列时的帧间隔（1 ms）
+constexpr qint64 kMaxSleepSliceNs = 20000000;  // 单次休眠上限，保证 stopReplay 及时生效
+constexpr qint64 kBackpressureSleepNs = 100000;  // 下游队列已满时的等待间隔
+
+void sleepNs(qint64 ns) {
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+  ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+  nanosleep(&ts, nullptr);
+}
+
+}  // namespace
+
+ReplaySource::ReplaySource(QObject *parent)
+    : SpectrumFrameSource(parent), totalFrames_(0), speed_(1.0), loop_(false),
+      running_(false), ringPos_(0) {
+}
+
+ReplaySource::~ReplaySource() {
+  stopReplay();
+  close();
+}
+
+bool ReplaySource::open(const QString &path) {
+  close();
+  QString error;
+  bool ok = false;
+  if (path.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)) {
+    ok = openCsv(path, &error);
+  } else {
+    ok = openRawSegment(path, &error);
+    // 同一次录制按大小滚动出的后续分段：<base>_0000.sfr → <base>_0001.sfr → ...
+    const QString suffix = QStringLiteral(".sfr");
+    const int digitsPos = path.size() - suffix.size() - 4;
+    bool numbered = false;
+    const int first = digitsPos > 0 && path.endsWith(suffix) && path.at(digitsPos - 1) == QChar('_')
+                          ? path.mid(digitsPos, 4).toInt(&numbered)
+                          : -1;
+    if (ok && numbered) {
+      const QString base = path.left(digitsPos - 1);
+      for (int segment = first + 1;; ++segment) {
+        const QString next = base + QStringLiteral("_%1.sfr").arg(segment, 4, 10, QChar('0'));
+        if (!QFileInfo::exists(next)) {
+          break;
+        }
+        QString segmentError;
+        if (!openRawSegment(next, &segmentError)) {
+          // 后续分段损坏时只回放已读取的部分
+          qWarning() << "[ReplaySource] Skip remaining segments:" << segmentError;
+          break;
+        }
+      }
+    }
+  }
+
+  if (!ok) {
+    close();
+    emit errorOccurred(error);
+    return false;
+  }
+  if (totalFrames_ == 0) {
+    close();
+    emit errorOccurred(QStringLiteral("回放文件中没有光谱帧: ") + path);
+    return false;
+  }
+  return true;
+}
+
+bool ReplaySource::openRawSegment(const QString &path, QString *error) {
+  auto file = std::make_unique<QFile>(path);
+  if (!file->open(QIODevice::ReadOnly)) {
+    *error = QStringLiteral("无法打开回放文件 %1: %2").arg(path, file->errorString());
+    return false;
+  }
+  const qint64 size = file->size();
+  if (size < static_cast<qint64>(RawFrameFormat::kHeaderSize)) {
+    *error = QStringLiteral("回放文件过短: ") + path;
+    return false;
+  }
+  uchar *base = file->map(0, size);
+  if (!base) {
+    *error = QStringLiteral("无法映射回放文件 %1: %2").arg(path, file->errorString());
+    return false;
+  }
+
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, RawFrameFormat::kMagic, sizeof(header.magic)) != 0 ||
+      header.version != RawFrameFormat::kVersion ||
+      header.pixelCount != static_cast<uint32_t>(SpectrumFrame::kPixelCount) ||
+      header.recordSize != sizeof(FrameRecord)) {
+    *error = QStringLiteral("不是有效的原始帧录制文件: ") + path;
+    return false;
+  }
+
+  const auto *records = reinterpret_cast<const FrameRecord *>(base + RawFrameFormat::kHeaderSize);
+  const quint64 capacity = static_cast<quint64>(size - RawFrameFormat::kHeaderSize) / sizeof(FrameRecord);
+  quint64 count = header.recordCount;
+  if (count == 0) {
+    // 录制异常中断：文件按分段大小预分配，扫描到第一条未写入（时间戳为 0）的记录
+    while (count < capacity && records[count].timestampNs != 0) {
+      ++count;
+    }
+  }
+  count = qMin(count, capacity);
+
+  Segment segment;
+  segment.file = std::move(file);
+  segment.records = records;
+  segment.count = count;
+  segments_.push_back(std::move(segment));
+  totalFrames_ += count;
+  return true;
+}
+
+bool ReplaySource::openCsv(const QString &path, QString *error) {
+  // 逐行解析，直接转换成帧记录，不在内存中保留整份表格
+  csvRecords_.clear();
+  qint64 firstMs = 0;
+  bool haveTime = false;
+  qint64 previousNs = 0;
+  const qint64 rows = SpectrumFileManager::readSpectraTable(
+      path, [this, &firstMs, &haveTime, &previousNs](const SpectrumRecordInfo &info, const double *spectrum,
+                                                     int count) {
+        csvRecords_.emplace_back();
+        FrameRecord &record = csvRecords_.back();
+        std::memset(&record, 0, sizeof(record));
+
+        // CSV 保存的是已平均（可能已校正）的光谱，按原值取整截断到 uint16 作为一帧原始计数
+        const int points = qMin(count, SpectrumFrame::kPixelCount);
+        for (int p = 0; p < points; ++p) {
+          const double v = std::round(spectrum[p]);
+          record.data[p] = static_cast<uint16_t>(qBound(0.0, v, 65535.0));
+        }
+        record.count = static_cast<uint32_t>(points);
+        record.sequence = static_cast<uint64_t>(csvRecords_.size() - 1);
+
+        // 按 time 列的相对间隔回放；时间缺失或倒退时退化为固定间隔
+        qint64 ns = previousNs + kCsvDefaultIntervalNs;
+        const QDateTime time = info.time.toDateTime();
+        if (time.isValid()) {
+          const qint64 ms = time.toMSecsSinceEpoch();
+          if (!haveTime) {
+            firstMs = ms;
+            haveTime = true;
+          }
+          const qint64 relative = (ms - firstMs) * 1000000LL + kCsvDefaultIntervalNs;
+          if (relative > previousNs) {
+            ns = relative;
+          }
+        }
+        record.timestampNs = ns;
+        previousNs = ns;
+      });
+  if (rows <= 0) {
+    csvRecords_.clear();
+    *error = QStringLiteral("无法读取回放 CSV: ") + path;
+    return false;
+  }
+  csvRecords_.shrink_to_fit();
+
+  Segment segment;
+  segment.records = csvRecords_.data();
+  segment.count = csvRecords_.size();
+  segments_.push_back(std::move(segment));
+  totalFrames_ += segment.count;
+  return true;
+}
+
+void ReplaySource::close() {
+  segments_.clear();  // QFile 析构时解除映射
+  csvRecords_.clear();
+  csvRecords_.shrink_to_fit();
+  totalFrames_ = 0;
+}
+
+bool ReplaySource::startReplay(double speed, bool loop) {
+  if (running_) {
+    emit statusChanged(QStringLiteral("回放已在运行"));
+    return false;
+  }
+  if (totalFrames_ == 0) {
+    emit errorOccurred(QStringLiteral("未打开回放文件"));
+    return false;
+  }
+  speed_ = speed > 0.0 ? speed : 0.0;
+  loop_ = loop;
+  resetCounters();
+  running_ = true;
+  start(QThread::HighPriority);
+  return true;
+}
+
+void ReplaySource::stopReplay() {
+  if (isRunning()) {
+    running_ = false;
+    wait();
+  }
+  running_ = false;
+}
+
+std::shared_ptr<SpectrumFrame> &ReplaySource::acquireSlot(size_t index) {
+  std::shared_ptr<SpectrumFrame> &slot = frameRing_[index % frameRing_.size()];
+  if (slot && slot.use_count() == 1) {
+    // 下游已全部释放该帧，与其最后一次读取建立先后关系后即可原地复用
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } else {
+    slot = std::make_shared<SpectrumFrame>();
+  }
+  return slot;
+}
+
+bool ReplaySource::sleepUntil(qint64 deadlineNs) {
+  for (;;) {
+    if (!running_) {
+      return false;
+    }
+    const qint64 remaining = deadlineNs - SpectrumFrame::nowNs();
+    if (remaining <= 0) {
+      return true;
+    }
+    sleepNs(qMin(remaining, kMaxSleepSliceNs));
+  }
+}
+
+void ReplaySource::run() {
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Replay);
+  frameRing_.clear();
+  frameRing_.resize(kReplayBatch * 4);
+  for (auto &slot : frameRing_) {
+    slot = std::make_shared<SpectrumFrame>();
+  }
+  ringPos_ = 0;
+
+  const bool unthrottled = speed_ <= 0.0;
+  emit statusChanged(unthrottled
+                         ? QStringLiteral("✓ 回放已启动（不限速），共 %1 帧").arg(totalFrames_)
+                         : QStringLiteral("✓ 回放已启动（%1 倍速），共 %2 帧").arg(speed_).arg(totalFrames_));
+
+  std::vector<SpectrumFramePtr> batch;
+  batch.reserve(kReplayBatch);
+  quint64 sequence = 0;
+  const qint64 startNs = SpectrumFrame::nowNs();
+  qint64 passStartNs = startNs;  // 本轮回放开始的时刻（循环时重新对齐）
+
+  do {
+    const qint64 recordBaseNs = segments_.front().records[0].timestampNs;
+    for (const Segment &segment : segments_) {
+      for (quint64 i = 0; i < segment.count && running_;) {
+        const quint64 n = qMin<quint64>(kReplayBatch, segment.count - i);
+        if (unthrottled) {
+          // 不限速：只在所有下游队列都有空位时才分发，避免溢出丢帧
+          while (running_ && sinks_.minFreeSlots() < n) {
+            sleepNs(kBackpressureSleepNs);
+          }
+        } else {
+          // 按录制时的帧间隔回放：等到这一批第一帧的回放时刻
+          const qint64 offsetNs = segment.records[i].timestampNs - recordBaseNs;
+          if (!sleepUntil(passStartNs + static_cast<qint64>(static_cast<double>(offsetNs) / speed_))) {
+            break;
+          }
+        }
+
+        const qint64 nowNs = SpectrumFrame::nowNs();
+        for (quint64 k = 0; k < n; ++k) {
+          const FrameRecord &record = segment.records[i + k];
+          // 限速回放只分发回放时刻已到的帧，其余留给下一批
+          if (!unthrottled && k > 0 &&
+              passStartNs + static_cast<qint64>(static_cast<double>(record.timestampNs - recordBaseNs) / speed_) > nowNs) {
+            break;
+          }
+          std::shared_ptr<SpectrumFrame> &slot = acquireSlot(ringPos_++);
+          SpectrumFrame *frame = slot.get();
+          const int count = qMin(static_cast<int>(record.count), SpectrumFrame::kPixelCount);
+          std::memcpy(frame->data, record.data, sizeof(frame->data));
+          frame->count = count;
+          frame->sequence = sequence++;
+          frame->timestampNs = nowNs;
+          batch.push_back(slot);
+        }
+        dispatchFrames(batch.data(), static_cast<int>(batch.size()));
+        i += batch.size();
+        batch.clear();
+      }
+    }
+    passStartNs = SpectrumFrame::nowNs();
+  } while (loop_ && running_);
+
+  // 等待下游把已分发的帧处理完，耗时按端到端（含处理）计算
+  while (running_ && sinks_.maxBacklog() > 0) {
+    sleepNs(kBackpressureSleepNs);
+  }
+  const qint64 elapsedNs = SpectrumFrame::nowNs() - startNs;
+
+  frameRing_.clear();
+  sinks_.releaseSnapshot();
+  if (running_) {
+    running_ = false;
+    emit replayFinished(receivedPackets(), elapsedNs);
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "raw_frame_format.h"
+#include "spectrum_frame_source.h"
+
+// 录制回放线程：把 RawFrameRecorder 录制的 .sfr 文件（或 saveAllSpectraTableToCsv 导出的表格 CSV）
+// 按原始时间间隔重新送入处理流水线，可替代 UdpReceiverThread 用于离线调参与吞吐测试
+//
+// speed: 1 为实时回放，N 为 N 倍速，0 为不限速（按下游队列的剩余容量反压，不丢帧）
+// 回放帧重新分配接收序号，时间戳改为回放时刻，下游的延迟统计与实时接收一致
+class ReplaySource : public SpectrumFrameSource {
+  Q_OBJECT
+
+ public:
+  explicit ReplaySource(QObject *parent = nullptr);
+  ~ReplaySource();
+
+  // 打开回放文件（在启动前调用）
+  // path 为 .sfr 时自动接上同一次录制的后续分段（<base>_NNNN.sfr 序号连续的文件）
+  // path 为 .csv 时每行光谱作为一帧，按 time 列的间隔回放（无时间列时按 1 ms 间隔）
+  bool open(const QString &path);
+  quint64 frameCount() const { return totalFrames_; }
+  int segmentCount() const { return static_cast<int>(segments_.size()); }
+
+  // 启动回放线程，loop 为 true 时播完后从头循环
+  bool startReplay(double speed, bool loop);
+  void stopReplay();
+  void stopSource() override { stopReplay(); }
+
+ signals:
+  // 回放完成（循环模式下不发送）：回放帧数、从开始到下游队列排空的耗时（纳秒）
+  void replayFinished(quint64 frames, qint64 elapsedNs);
+
+ protected:
+  void run() override;
+
+ private:
+  // 一段连续的帧记录（映射的 .sfr 分段或 CSV 转换结果）
+  struct Segment {
+    std::unique_ptr<QFile> file;  // .sfr 分段文件（CSV 为空）
+    const RawFrameFormat::FrameRecord *records = nullptr;
+    quint64 count = 0;
+  };
+
+  bool openRawSegment(const QString &path, QString *error);
+  bool openCsv(const QString &path, QString *error);
+  void close();
+
+  std::shared_ptr<SpectrumFrame> &acquireSlot(size_t index);
+
+  // 等待到指定的单调时钟时刻，期间可被 stopReplay 打断；返回 false 表示已请求停止
+  bool sleepUntil(qint64 deadlineNs);
+
+  std::vector<Segment> segments_;
+  std::vector<RawFrameFormat::FrameRecord> csvRecords_;  // CSV 转换得到的帧记录
+  quint64 totalFrames_;
+  double speed_;
+  bool loop_;
+  std::atomic<bool> running_;
+  std::vector<std::shared_ptr<SpectrumFrame>> frameRing_;  // 可复用的帧对象环
+  size_t ringPos_;
+};
@@ -0,0 +1,495 @@
+#include "rescore_job.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+#include "spectrum_archive.h"
+#include "spectrum_file_manager.h"
+#include "spectrum_frame.h"
+
+// 输入记录的顺序读取器：.spa 归档按记录下标读取（mmap，只访问用到的页），CSV 逐行解析
+class RescoreJob::Reader {
+ public:
+  virtual ~Reader() = default;
+
+  // 文件中的光谱点数（归档的 pointCount，CSV 表头的光谱列数）
+  virtual int columns() const = 0;
+  // 读取下一条记录：光谱写入 row 的前 cols 个点（短光谱补 0，长光谱截断），读完返回 false
+  virtual bool next(Key *key, float *row, int cols) = 0;
+  virtual qint64 skipped() const { return 0; }
+
+  static std::unique_ptr<Reader> open(const QString &path, QString *error);
+};
+
+namespace {
+
+QString timeText(const QVariant &time) {
+  if (time.canConvert<QDateTime>()) {
+    const QDateTime dt = time.toDateTime();
+    if (dt.isValid()) {
+      return dt.toString(Qt::ISODate);
+    }
+  }
+  return time.toString();
+}
+
+QString quoted(QString text) {
+  text.replace(QStringLiteral("\""), QStringLiteral("\"\""));
+  return QStringLiteral("\"") + text + QStringLiteral("\"");
+}
+
+QJsonObject latencyJson(const LatencyHistogram &histogram) {
+  QJsonObject o;
+  o.insert(QStringLiteral("count"), static_cast<double>(histogram.count()));
+  o.insert(QStringLiteral("meanMs"), histogram.meanNs() / 1e6);
+  o.insert(QStringLiteral("p50Ms"), histogram.percentileNs(50.0) / 1e6);
+  o.insert(QStringLiteral("p99Ms"), histogram.percentileNs(99.0) / 1e6);
+  o.insert(QStringLiteral("maxMs"), static_cast<double>(histogram.maxNs()) / 1e6);
+  return o;
+}
+
+class ArchiveReader : public RescoreJob::Reader {
+ public:
+  bool open(const QString &path, QString *error) {
+    if (!archive_.open(path, error)) {
+      return false;
+    }
+    buffer_.resize(static_cast<size_t>(qMax(1, archive_.pointCount())));
+    return true;
+  }
+
+  int columns() const override { return archive_.pointCount(); }
+
+  bool next(RescoreJob::Key *key, float *row, int cols) override;
+
+ private:
+  SpectrumArchive archive_;
+  qint64 next_ = 0;
+  std::vector<double> buffer_;
+};
+
+class CsvReader : public RescoreJob::Reader {
+ public:
+  bool open(const QString &path, QString *error) {
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      if (error) {
+        *error = file_.errorString();
+      }
+      return false;
+    }
+    in_.setDevice(&file_);
+    // 表头：index,label,time,length,minVal,maxVal,moisture,λ0,...,λN
+    const QStringList header = SpectrumFileManager::splitCsvLine(in_.readLine());
+    if (header.size() < 7) {
+      if (error) {
+        *error = QStringLiteral("CSV 表头少于 7 列，格式应与 saveAllSpectraTableToCsv 一致");
+      }
+      return false;
+    }
+    columns_ = static_cast<int>(header.size()) - 7;
+    return true;
+  }
+
+  int columns() const override { return columns_; }
+  qint64 skipped() const override { return skipped_; }
+
+  bool next(RescoreJob::Key *key, float *row, int cols) override;
+
+ private:
+  QFile file_;
+  QTextStream in_;
+  int columns_ = 0;
+  qint64 skipped_ = 0;
+};
+
+}  // namespace
+
+bool ArchiveReader::next(RescoreJob::Key *key, float *row, int cols) {
+  if (next_ >= archive_.recordCount()) {
+    return false;
+  }
+  const qint64 i = next_++;
+  const QVariantMap meta = archive_.metadata(i);
+  key->index = meta.value(QStringLiteral("index")).toInt();
+  key->label = meta.value(QStringLiteral("label")).toString();
+  key->time = timeText(meta.value(QStringLiteral("time")));
+  key->moisture = meta.value(QStringLiteral("moisture")).toDouble();
+
+  const int n = qMin(archive_.readSpectrum(i, buffer_.data(), static_cast<int>(buffer_.size())), cols);
+  for (int c = 0; c < n; c++) {
+    row[c] = static_cast<float>(buffer_[static_cast<size_t>(c)]);
+  }
+  std::fill(row + n, row + cols, 0.0f);
+  return true;
+}
+
+bool CsvReader::next(RescoreJob::Key *key, float *row, int cols) {
+  while (!in_.atEnd()) {
+    const QString line = in_.readLine();
+    if (line.trimmed().isEmpty()) {
+      continue;
+    }
+    const QStringList fields = SpectrumFileManager::splitCsvLine(line);
+    bool ok = false;
+    const int index = fields.size() >= 7 ? fields[0].trimmed().toInt(&ok) : 0;
+    if (!ok) {
+      skipped_++;
+      continue;
+    }
+    key->index = index;
+    key->label = fields[1];
+    key->time = fields[2];
+    key->moisture = fields[6].trimmed().toDouble();
+
+    int n = 0;
+    for (int i = 7; i < fields.size() && n < cols; i++) {
+      const QString part = fields[i].trimmed();
+      if (part.isEmpty()) {
+        continue;
+      }
+      row[n++] = part.toFloat();
+    }
+    std::fill(row + n, row + cols, 0.0f);
+    return true;
+  }
+  return false;
+}
+
+std::unique_ptr<RescoreJob::Reader> RescoreJob::Reader::open(const QString &path, QString *error) {
+  if (QFileInfo(path).suffix().compare(QStringLiteral("spa"), Qt::CaseInsensitive) == 0) {
+    auto reader = std::make_unique<ArchiveReader>();
+    return reader->open(path, error) ? std::move(reader) : nullptr;
+  }
+  auto reader = std::make_unique<CsvReader>();
+  return reader->open(path, error) ? std::move(reader) : nullptr;
+}
+
+// 工作线程：取一批、预测、交回；没有更多批次且读取结束时退出
+class RescoreJob::Worker : public QThread {
+ public:
+  Worker(RescoreJob *job, const SpectrumPredictorManager::ModelSlot *slot) : job_(job), slot_(slot) {}
+  ~Worker() override { wait(); }
+
+ protected:
+  void run() override {
+    std::vector<float> scratch;
+    while (BatchPtr batch = job_->takePending()) {
+      const qint64 startNs = SpectrumFrame::nowNs();
+      job_->predict(slot_, batch.get(), &scratch);
+      job_->stats_.inferenceLatency.record(SpectrumFrame::nowNs() - startNs);
+      job_->finishBatch(std::move(batch));
+    }
+  }
+
+ private:
+  RescoreJob *job_;
+  const SpectrumPredictorManager::ModelSlot *slot_;  // 为空时使用在线实例
+};
+
+QString RescoreJob::Stats::describe() const {
+  return QStringLiteral("%1 条（失败 %2，跳过 %3），%4 批，%5 线程%6，%7 条/秒；"
+                        "推理每批 p50 %8 ms / p99 %9 ms / max %10 ms")
+      .arg(records)
+      .arg(failed)
+      .arg(skipped)
+      .arg(batches)
+      .arg(threads)
+      .arg(sharedInstance ? QStringLiteral("（共用在线实例）") : QString())
+      .arg(recordsPerSecond(), 0, 'f', 1)
+      .arg(inferenceLatency.percentileNs(50.0) / 1e6, 0, 'f', 3)
+      .arg(inferenceLatency.percentileNs(99.0) / 1e6, 0, 'f', 3)
+      .arg(static_cast<double>(inferenceLatency.maxNs()) / 1e6, 0, 'f', 3);
+}
+
+QJsonObject RescoreJob::Stats::toJson() const {
+  QJsonObject o;
+  o.insert(QStringLiteral("records"), static_cast<double>(records));
+  o.insert(QStringLiteral("failed"), static_cast<double>(failed));
+  o.insert(QStringLiteral("skipped"), static_cast<double>(skipped));
+  o.insert(QStringLiteral("batches"), static_cast<double>(batches));
+  o.insert(QStringLiteral("threads"), threads);
+  o.insert(QStringLiteral("sharedInstance"), sharedInstance);
+  o.insert(QStringLiteral("loadSeconds"), loadSeconds);
+  o.insert(QStringLiteral("elapsedSeconds"), elapsedSeconds);
+  o.insert(QStringLiteral("recordsPerSecond"), recordsPerSecond());
+  o.insert(QStringLiteral("inferenceLatency"), latencyJson(inferenceLatency));
+  o.insert(QStringLiteral("batchLatency"), latencyJson(batchLatency));
+  return o;
+}
+
+RescoreJob::RescoreJob(SpectrumPredictorManager *manager, const Options &options)
+    : manager_(manager), options_(options), columns_(0), nextToWrite_(0), inFlight_(0), readerDone_(false) {}
+
+RescoreJob::~RescoreJob() = default;
+
+bool RescoreJob::loadInstances(int threads, QString *error) {
+  const int index = options_.predictorIndex;
+  const QString modelPath = options_.modelPath.isEmpty() ? manager_->getDefaultModelPath(index) : options_.modelPath;
+  QElapsedTimer timer;
+  timer.start();
+
+  QString instanceError;
+  SpectrumPredictorManager::ModelSlotPtr first = manager_->createModelInstance(index, modelPath, &instanceError);
+  if (!first) {
+    // 插件未实现实例工厂扩展：只能在在线实例上推理，插件内部未必可重入，因此只用一个线程
+    qWarning() << "无法创建独立模型实例，退回单线程:" << instanceError;
+    if (!manager_->loadModel(index, modelPath)) {
+      if (error) {
+        *error = QStringLiteral("模型加载失败: %1").arg(modelPath);
+      }
+      return false;
+    }
+    stats_.sharedInstance = true;
+    stats_.threads = 1;
+    preprocessor_ = manager_->preprocessor(index);
+    columns_ = preprocessor_ ? preprocessor_->inputSize() : 0;
+    stats_.loadSeconds = timer.nsecsElapsed() / 1e9;
+    return true;
+  }
+
+  instances_.push_back(first);
+  for (int i = 1; i < threads; i++) {
+    SpectrumPredictorManager::ModelSlotPtr slot = manager_->createModelInstance(index, modelPath, &instanceError);
+    if (!slot) {
+      qWarning() << "只创建了" << i << "个模型实例:" << instanceError;
+      break;
+    }
+    instances_.push_back(std::move(slot));
+  }
+  stats_.threads = static_cast<int>(instances_.size());
+  preprocessor_ = first->preprocessor;
+  if (preprocessor_) {
+    columns_ = preprocessor_->inputSize();
+  } else if (first->batch) {
+    columns_ = static_cast<int>(first->batch->inputSize());
+  }
+  stats_.loadSeconds = timer.nsecsElapsed() / 1e9;
+  return true;
+}
+
+bool RescoreJob::predictRows(const SpectrumPredictorManager::ModelSlot *slot, const float *data, size_t rows,
+                             size_t cols, float *out) {
+  if (slot) {
+    return SpectrumPredictorManager::predictWithSlot(*slot, data, rows, cols, out);
+  }
+  return manager_->predictBatch(options_.predictorIndex, data, rows, cols, out);
+}
+
+void RescoreJob::predict(const SpectrumPredictorManager::ModelSlot *slot, Batch *batch,
+                         std::vector<float> *scratch) {
+  const size_t rows = static_cast<size_t>(batch->rows);
+  batch->output.assign(rows, 0.0f);
+  batch->ok.assign(rows, 0);
+
+  const float *input = batch->input.data();
+  size_t cols = static_cast<size_t>(columns_);
+  if (preprocessor_) {
+    cols = static_cast<size_t>(preprocessor_->outputSize());
+    scratch->resize(rows * cols);
+    for (size_t r = 0; r < rows; r++) {
+      preprocessor_->apply(input + r * static_cast<size_t>(columns_), scratch->data() + r * cols);
+    }
+    input = scratch->data();
+  }
+
+  if (predictRows(slot, input, rows, cols, batch->output.data())) {
+    for (size_t r = 0; r < rows; r++) {
+      batch->ok[r] = std::isfinite(batch->output[r]) ? 1 : 0;
+    }
+    return;
+  }
+  // 整批失败：逐条重试，只把真正失败的记录标记为失败
+  for (size_t r = 0; r < rows; r++) {
+    float value = 0.0f;
+    if (predictRows(slot, input + r * cols, 1, cols, &value) && std::isfinite(value)) {
+      batch->output[r] = value;
+      batch->ok[r] = 1;
+    }
+  }
+}
+
+RescoreJob::BatchPtr RescoreJob::takePending() {
+  QMutexLocker locker(&mutex_);
+  while (pending_.empty() && !readerDone_) {
+    pendingChanged_.wait(&mutex_);
+  }
+  if (pending_.empty()) {
+    return nullptr;
+  }
+  BatchPtr batch = std::move(pending_.front());
+  pending_.pop_front();
+  return batch;
+}
+
+void RescoreJob::finishBatch(BatchPtr batch) {
+  QMutexLocker locker(&mutex_);
+  const quint64 sequence = batch->sequence;
+  completed_[sequence] = std::move(batch);
+  completedChanged_.wakeAll();
+}
+
+int RescoreJob::writeCompleted(QTextStream *out) {
+  std::vector<BatchPtr> ready;
+  {
+    QMutexLocker locker(&mutex_);
+    for (auto it = completed_.find(nextToWrite_); it != completed_.end(); it = completed_.find(nextToWrite_)) {
+      ready.push_back(std::move(it->second));
+      completed_.erase(it);
+      nextToWrite_++;
+    }
+  }
+  if (ready.empty()) {
+    return 0;
+  }
+
+  const qint64 nowNs = SpectrumFrame::nowNs();
+  for (const BatchPtr &batch : ready) {
+    for (int r = 0; r < batch->rows; r++) {
+      const Key &key = batch->keys[static_cast<size_t>(r)];
+      *out << key.index << ',' << quoted(key.label) << ',' << quoted(key.time) << ',' << key.moisture << ',';
+      if (batch->ok[static_cast<size_t>(r)]) {
+        *out << batch->output[static_cast<size_t>(r)];
+      } else {
+        stats_.failed++;
+      }
+      *out << '\n';
+    }
+    stats_.records += batch->rows;
+    stats_.batches++;
+    stats_.batchLatency.record(nowNs - batch->readNs);
+  }
+
+  // 写完才释放在途名额，输出跟不上时同样对读取形成反压
+  QMutexLocker locker(&mutex_);
+  inFlight_ -= static_cast<int>(ready.size());
+  return static_cast<int>(ready.size());
+}
+
+bool RescoreJob::run(QString *error) {
+  auto fail = [error](const QString &message) {
+    if (error) {
+      *error = message;
+    }
+    return false;
+  };
+
+  QString openError;
+  std::unique_ptr<Reader> reader = Reader::open(options_.inputPath, &openError);
+  if (!reader) {
+    return fail(QStringLiteral("无法打开输入 %1: %2").arg(options_.inputPath, openError));
+  }
+  QFile outputFile(options_.outputPath);
+  if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+    return fail(QStringLiteral("无法写入 %1: %2").arg(options_.outputPath, outputFile.errorString()));
+  }
+
+  const int threads = options_.threads > 0 ? options_.threads : qMax(1, QThread::idealThreadCount());
+  if (!loadInstances(threads, error)) {
+    return false;
+  }
+  if (columns_ <= 0) {
+    columns_ = reader->columns();
+  }
+  if (columns_ <= 0) {
+    return fail(QStringLiteral("输入中没有光谱数据"));
+  }
+  if (reader->columns() != columns_) {
+    qWarning() << "输入光谱点数" << reader->columns() << "与模型输入长度" << columns_ << "不一致，按模型长度补 0 / 截断";
+  }
+
+  QTextStream out(&outputFile);
+  out.setRealNumberNotation(QTextStream::FixedNotation);
+  out.setRealNumberPrecision(6);
+  out << "index,label,time,moisture,prediction\n";
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (int i = 0; i < stats_.threads; i++) {
+    const SpectrumPredictorManager::ModelSlot *slot = instances_.empty() ? nullptr : instances_[i].get();
+    workers.push_back(std::make_unique<Worker>(this, slot));
+    workers.back()->start();
+  }
+
+  const int maxInFlight = stats_.threads * kBatchesPerThread;
+  const int batchSize = qBound(1, options_.batchSize, 65536);
+  QElapsedTimer timer;
+  timer.start();
+
+  quint64 sequence = 0;
+  qint64 read = 0;
+  bool more = true;
+  while (more) {
+    auto batch = std::make_unique<Batch>();
+    batch->input.resize(static_cast<size_t>(batchSize) * static_cast<size_t>(columns_));
+    batch->keys.resize(static_cast<size_t>(batchSize));
+    while (batch->rows < batchSize) {
+      if (options_.limit > 0 && read >= options_.limit) {
+        more = false;
+        break;
+      }
+      float *row = batch->input.data() + static_cast<size_t>(batch->rows) * static_cast<size_t>(columns_);
+      if (!reader->next(&batch->keys[static_cast<size_t>(batch->rows)], row, columns_)) {
+        more = false;
+        break;
+      }
+      batch->rows++;
+      read++;
+    }
+    if (batch->rows == 0) {
+      break;
+    }
+    batch->input.resize(static_cast<size_t>(batch->rows) * static_cast<size_t>(columns_));
+    batch->keys.resize(static_cast<size_t>(batch->rows));
+    batch->sequence = sequence++;
+    batch->readNs = SpectrumFrame::nowNs();
+
+    // 在途批次已满时先写出已完成的批次，等待下一批按顺序完成
+    for (;;) {
+      writeCompleted(&out);
+      QMutexLocker locker(&mutex_);
+      if (inFlight_ < maxInFlight) {
+        pending_.push_back(std::move(batch));
+        inFlight_++;
+        pendingChanged_.wakeOne();
+        break;
+      }
+      if (completed_.find(nextToWrite_) == completed_.end()) {
+        completedChanged_.wait(&mutex_);
+      }
+    }
+  }
+
+  {
+    QMutexLocker locker(&mutex_);
+    readerDone_ = true;
+    pendingChanged_.wakeAll();
+  }
+  for (;;) {
+    writeCompleted(&out);
+    QMutexLocker locker(&mutex_);
+    if (inFlight_ == 0) {
+      break;
+    }
+    if (completed_.find(nextToWrite_) == completed_.end()) {
+      completedChanged_.wait(&mutex_);
+    }
+  }
+  workers.clear();
+
+  out.flush();
+  stats_.elapsedSeconds = timer.nsecsElapsed() / 1e9;
+  stats_.skipped = reader->skipped();
+  if (out.status() != QTextStream::Ok) {
+    return fail(QStringLiteral("写入 %1 失败").arg(options_.outputPath));
+  }
+  return true;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "spectrum_predictor_manager.h"
+
+class QTextStream;
+
+// 离线批量重算：用预测插件把归档（.spa）或表格 CSV 中保存的光谱重新预测一遍（calc_rescore）
+// - 调用 run() 的线程按记录顺序流式读取输入，每 batchSize 条组成一批，不把整个文件读入内存
+// - threads 个工作线程各自持有一个独立的模型实例（SpectrumPredictorManager::createModelInstance），
+//   并行执行模型的预处理链与 predictBatch；插件不支持独立实例时退回到在线实例、单线程推理
+// - 结果按输入顺序写入 CSV：index,label,time,moisture,prediction（预测失败时 prediction 为空）
+// - 在途批次数有上限（每个工作线程 kBatchesPerThread 批），推理跟不上时读取线程阻塞
+class RescoreJob {
+ public:
+  static const int kBatchesPerThread = 4;
+
+  struct Options {
+    QString inputPath;   // .spa 归档，或 SpectrumFileManager::saveAllSpectraTableToCsv 格式的 CSV
+    QString outputPath;
+    int predictorIndex = -1;
+    QString modelPath;   // 为空时使用插件的默认模型路径
+    int batchSize = 64;
+    int threads = 0;     // 0 为在线 CPU 数
+    qint64 limit = 0;    // 只处理前 N 条记录，0 为全部
+  };
+
+  struct Stats {
+    qint64 records = 0;
+    qint64 failed = 0;   // 预测失败或结果不是有限值
+    qint64 skipped = 0;  // 无法解析而跳过的 CSV 行
+    qint64 batches = 0;
+    int threads = 0;
+    bool sharedInstance = false;  // 退回到在线实例（单线程）
+    double loadSeconds = 0.0;     // 模型实例加载与预热
+    double elapsedSeconds = 0.0;  // 读取开始到最后一批写完
+    LatencyHistogram inferenceLatency;  // 每批 predictBatch（含预处理）耗时
+    LatencyHistogram batchLatency;      // 每批读完到写出的耗时（含排队）
+
+    double recordsPerSecond() const { return elapsedSeconds > 0.0 ? records / elapsedSeconds : 0.0; }
+    QString describe() const;
+    QJsonObject toJson() const;
+  };
+
+  // 一条输入记录的标识，原样写回输出
+  struct Key {
+    int index = 0;
+    QString label;
+    QString time;
+    double moisture = 0.0;
+  };
+
+  // 输入的顺序读取器（.spa 归档或 CSV，实现见 rescore_job.cpp）
+  class Reader;
+
+  RescoreJob(SpectrumPredictorManager *manager, const Options &options);
+  ~RescoreJob();
+  RescoreJob(const RescoreJob &) = delete;
+  RescoreJob &operator=(const RescoreJob &) = delete;
+
+  // 阻塞直到全部记录写出；输入、输出或模型无法打开时返回 false 并写入 error
+  bool run(QString *error = nullptr);
+  const Stats &stats() const { return stats_; }
+
+ private:
+  class Worker;
+  friend class Worker;
+
+  struct Batch {
+    quint64 sequence = 0;
+    int rows = 0;
+    std::vector<float> input;  // rows × columns_
+    std::vector<Key> keys;
+    std::vector<float> output;
+    std::vector<char> ok;
+    qint64 readNs = 0;
+  };
+  using BatchPtr = std::unique_ptr<Batch>;
+
+  bool loadInstances(int threads, QString *error);
+  // 工作线程：预处理并预测一批，整批失败时逐条重试以找出失败的记录
+  void predict(const SpectrumPredictorManager::ModelSlot *slot, Batch *batch, std::vector<float> *scratch);
+  bool predictRows(const SpectrumPredictorManager::ModelSlot *slot, const float *data, size_t rows, size_t cols,
+                   float *out);
+  // 读取线程：按顺序写出已完成的批次，返回写出的批数
+  int writeCompleted(QTextStream *out);
+  BatchPtr takePending();
+  void finishBatch(BatchPtr batch);
+
+  SpectrumPredictorManager *manager_;
+  Options options_;
+  Stats stats_;
+  int columns_;  // 每条输入光谱的点数（模型或预处理链的输入长度），长短不一的记录补 0 / 截断
+  SpectralPreprocessorPtr preprocessor_;
+  std::vector<SpectrumPredictorManager::ModelSlotPtr> instances_;  // 空表示使用在线实例
+
+  QMutex mutex_;
+  QWaitCondition pendingChanged_;
+  QWaitCondition completedChanged_;
+  std::deque<BatchPtr> pending_;
+  std::map<quint64, BatchPtr> completed_;
+  quint64 nextToWrite_;
+  int inFlight_;
+  bool readerDone_;
+};
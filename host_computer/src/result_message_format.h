@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+// 预测结果发布格式（ResultPublisher 发送，下游 MES / PLC 网关读取）
+//
+// 每个 UDP 数据报（TCP 时为一帧，前面加 uint32 小端长度）的布局（小端）：
+//   DatagramHeader
+//   messageCount 条消息：MessageHeader + spectrumPoints 个 float32（光谱，可为 0 个）
+// sequence 按数据报递增，接收方据此发现丢包；同一数据报内消息按产生顺序排列。
+namespace ResultMessageFormat {
+
+constexpr char kMagic[4] = {'S', 'P', 'R', 'S'};
+constexpr uint16_t kVersion = 1;
+
+enum MessageType : uint8_t {
+  Prediction = 1,  // 一个预测器对一条光谱的预测值（可附带这条光谱）
+  Spectrum = 2,    // 一条处理完成的平均光谱（predictorIndex 为 -1）
+};
+
+enum Status : uint8_t {
+  Normal = 0,       // 在监控上下限内
+  Abnormal = 1,     // 超出监控上下限
+  Unmonitored = 2,  // 未启用异常监控
+  Failed = 3,       // 预测失败（value 为 NaN）
+};
+
+struct DatagramHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t messageCount;
+  uint32_t sequence;     // 数据报序号（每个发布端从 0 开始）
+  uint32_t droppedMessages;  // 发布端截至目前因队列满丢弃的消息数
+  int64_t sentNs;        // 发送时间（CLOCK_REALTIME，纳秒）
+};
+
+struct MessageHeader {
+  uint8_t type;            // MessageType
+  uint8_t status;          // Status
+  int16_t predictorIndex;
+  uint16_t spectrumPoints;  // 紧随其后的 float32 个数
+  uint16_t streamId;        // 光谱仪（多光谱仪时为 DeviceRegistry 中的序号，单光谱仪为 0）
+  int64_t timestampNs;     // 光谱窗口时间（CLOCK_REALTIME，纳秒）
+  float value;             // 预测值（Spectrum 消息为 0）
+  uint32_t reserved2;
+};
+
+static_assert(sizeof(DatagramHeader) == 24, "result datagram header layout changed");
+static_assert(sizeof(MessageHeader) == 24, "result message header layout changed");
+
+}  // namespace ResultMessageFormat
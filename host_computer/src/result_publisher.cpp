@@ -0,0 +1,578 @@
+#include "result_publisher.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+#include "result_message_format.h"
+
+namespace {
+
+constexpr int kPopChunk = 256;  // 每次从队列取出的最大消息数
+constexpr int kIdleTimeoutMs = 500;  // 无唤醒时的最长等待，兼作停止检查周期
+constexpr int kMaxClients = 32;
+constexpr int kMaxSpectrumPoints = 65535;  // MessageHeader::spectrumPoints 为 uint16
+
+qint64 clockNs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+bool setNonBlocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool parseIpv4(const QString &text, struct in_addr *addr) {
+  return inet_pton(AF_INET, text.toLatin1().constData(), addr) == 1;
+}
+
+QString errnoString() {
+  return QString::fromLocal8Bit(strerror(errno));
+}
+
+}  // namespace
+
+QString ResultPublisher::Config::defaultConfigPath() {
+  return QCoreApplication::applicationDirPath() + QStringLiteral("/publisher.json");
+}
+
+bool ResultPublisher::Config::load(const QString &path, QString *error) {
+  QFile file(path);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (document.isNull() || !document.isObject()) {
+    if (error) {
+      *error = parseError.errorString();
+    }
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  Config parsed = *this;
+  parsed.multicastGroup = root.value(QStringLiteral("multicastGroup")).toString(parsed.multicastGroup);
+  parsed.multicastPort = root.value(QStringLiteral("multicastPort")).toInt(parsed.multicastPort);
+  parsed.multicastInterface = root.value(QStringLiteral("multicastInterface")).toString(parsed.multicastInterface);
+  parsed.multicastTtl = qBound(0, root.value(QStringLiteral("multicastTtl")).toInt(parsed.multicastTtl), 255);
+  parsed.multicastLoopback = root.value(QStringLiteral("multicastLoopback")).toBool(parsed.multicastLoopback);
+  parsed.tcpPort = root.value(QStringLiteral("tcpPort")).toInt(parsed.tcpPort);
+  parsed.tcpBindAddress = root.value(QStringLiteral("tcpBindAddress")).toString(parsed.tcpBindAddress);
+  parsed.attachSpectrum = root.value(QStringLiteral("attachSpectrum")).toBool(parsed.attachSpectrum);
+  parsed.publishSpectra = root.value(QStringLiteral("publishSpectra")).toBool(parsed.publishSpectra);
+  parsed.maxDatagramBytes = qBound(512, root.value(QStringLiteral("maxDatagramBytes")).toInt(parsed.maxDatagramBytes),
+                                   65000);
+  parsed.batchDelayUs = qBound(0, root.value(QStringLiteral("batchDelayUs")).toInt(parsed.batchDelayUs), 100000);
+  parsed.tcpClientBufferBytes =
+      qMax(64 * 1024, root.value(QStringLiteral("tcpClientBufferBytes")).toInt(parsed.tcpClientBufferBytes));
+  parsed.queueCapacity = qBound(16, root.value(QStringLiteral("queueCapacity")).toInt(parsed.queueCapacity), 1 << 20);
+  parsed.spectrumQueueCapacity =
+      qBound(2, root.value(QStringLiteral("spectrumQueueCapacity")).toInt(parsed.spectrumQueueCapacity), 4096);
+
+  if (parsed.multicastPort < 0 || parsed.multicastPort > 65535 || parsed.tcpPort < 0 || parsed.tcpPort > 65535) {
+    if (error) {
+      *error = QStringLiteral("\"multicastPort\" / \"tcpPort\" 应为 0~65535");
+    }
+    return false;
+  }
+  struct in_addr addr;
+  if (parsed.multicastPort > 0 && (!parseIpv4(parsed.multicastGroup, &addr) || !IN_MULTICAST(ntohl(addr.s_addr)))) {
+    if (error) {
+      *error = QStringLiteral("\"multicastGroup\" 不是 IPv4 组播地址: %1").arg(parsed.multicastGroup);
+    }
+    return false;
+  }
+  if (!parsed.multicastInterface.isEmpty() && !parseIpv4(parsed.multicastInterface, &addr)) {
+    if (error) {
+      *error = QStringLiteral("\"multicastInterface\" 应为网卡的 IPv4 地址: %1").arg(parsed.multicastInterface);
+    }
+    return false;
+  }
+  *this = parsed;
+  return true;
+}
+
+QString ResultPublisher::Config::describe() const {
+  QStringList parts;
+  if (multicastPort > 0) {
+    parts << QStringLiteral("组播 %1:%2 (ttl %3)").arg(multicastGroup).arg(multicastPort).arg(multicastTtl);
+  }
+  if (tcpPort > 0) {
+    parts << QStringLiteral("TCP %1:%2").arg(tcpBindAddress).arg(tcpPort);
+  }
+  if (parts.isEmpty()) {
+    return QStringLiteral("未启用");
+  }
+  parts << QStringLiteral("数据报上限 %1 字节").arg(maxDatagramBytes);
+  if (attachSpectrum) {
+    parts << QStringLiteral("预测附带光谱");
+  }
+  if (publishSpectra) {
+    parts << QStringLiteral("发布平均光谱");
+  }
+  return parts.join(QStringLiteral(", "));
+}
+
+ResultPublisher::ResultPublisher(const Config &config, QObject *parent)
+    : QThread(parent), config_(config), predictions_(static_cast<size_t>(config.queueCapacity)),
+      spectra_(static_cast<size_t>(config.spectrumQueueCapacity)),
+      eventFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), udpFd_(-1), listenFd_(-1), datagramMessages_(0),
+      sequence_(0), consumerWaiting_(false), stopRequested_(false), monitorEnabled_(false), lowerLimit_(0.0),
+      upperLimit_(0.0), datagrams_(0), messages_(0), droppedPredictions_(0), droppedSpectra_(0), networkDrops_(0),
+      clientCount_(0) {
+}
+
+ResultPublisher::~ResultPublisher() {
+  stopPublishing();
+  closeSockets();
+  if (eventFd_ >= 0) {
+    close(eventFd_);
+    eventFd_ = -1;
+  }
+}
+
+bool ResultPublisher::startPublishing(QString *error) {
+  if (isRunning() || !config_.enabled()) {
+    return isRunning();
+  }
+  if (!openSockets(error)) {
+    closeSockets();
+    return false;
+  }
+  stopRequested_ = false;
+  start();
+  return true;
+}
+
+void ResultPublisher::stopPublishing() {
+  if (!isRunning()) {
+    return;
+  }
+  stopRequested_ = true;
+  wake();
+  wait();
+  closeSockets();
+}
+
+void ResultPublisher::setMonitorLimits(bool enabled, double lowerLimit, double upperLimit) {
+  lowerLimit_.store(lowerLimit, std::memory_order_relaxed);
+  upperLimit_.store(upperLimit, std::memory_order_relaxed);
+  monitorEnabled_.store(enabled, std::memory_order_release);
+}
+
+qint64 ResultPublisher::toRealtimeNs(qint64 monotonicNs) {
+  // 两个时钟各读一次，按差值换算；误差为两次读时钟之间的间隔（亚微秒级）
+  const qint64 realtimeNow = clockNs(CLOCK_REALTIME);
+  const qint64 monotonicNow = clockNs(CLOCK_MONOTONIC);
+  return realtimeNow - (monotonicNow - monotonicNs);
+}
+
+void ResultPublisher::publishPrediction(int predictorIndex, double value, qint64 windowTimestampNs, int streamId) {
+  if (!isRunning()) {
+    return;
+  }
+  Message message;
+  message.type = ResultMessageFormat::Prediction;
+  message.predictorIndex = static_cast<qint16>(predictorIndex);
+  message.streamId = static_cast<quint16>(streamId);
+  message.timestampNs = toRealtimeNs(windowTimestampNs);
+  message.value = static_cast<float>(value);
+  if (!std::isfinite(value)) {
+    message.status = ResultMessageFormat::Failed;
+  } else if (!monitorEnabled_.load(std::memory_order_acquire)) {
+    message.status = ResultMessageFormat::Unmonitored;
+  } else {
+    const bool inRange = value >= lowerLimit_.load(std::memory_order_relaxed) &&
+                         value <= upperLimit_.load(std::memory_order_relaxed);
+    message.status = inRange ? ResultMessageFormat::Normal : ResultMessageFormat::Abnormal;
+  }
+  if (config_.attachSpectrum && streamId >= 0 && streamId < kMaxAttachedStreams) {
+    message.spectrum = std::atomic_load(&latestSpectrum_[streamId]);
+  }
+  if (!predictions_.push(std::move(message))) {
+    droppedPredictions_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // 与发布线程的“置等待标志 → 再检查队列”配对，保证不会丢失唤醒
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumerWaiting_.load(std::memory_order_relaxed)) {
+    wake();
+  }
+}
+
+void ResultPublisher::publishSpectrum(const float *data, int count, qint64 timestampNs, int streamId) {
+  if (!isRunning() || count <= 0 || (!config_.attachSpectrum && !config_.publishSpectra)) {
+    return;
+  }
+  auto spectrum = std::make_shared<std::vector<float>>(data, data + qMin(count, kMaxSpectrumPoints));
+  SpectrumPtr shared = std::move(spectrum);
+  if (config_.attachSpectrum && streamId >= 0 && streamId < kMaxAttachedStreams) {
+    std::atomic_store(&latestSpectrum_[streamId], shared);
+  }
+  if (!config_.publishSpectra) {
+    return;
+  }
+  Message message;
+  message.type = ResultMessageFormat::Spectrum;
+  message.status = ResultMessageFormat::Unmonitored;
+  message.streamId = static_cast<quint16>(streamId);
+  message.timestampNs = toRealtimeNs(timestampNs);
+  message.spectrum = std::move(shared);
+  if (!spectra_.push(std::move(message))) {
+    droppedSpectra_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumerWaiting_.load(std::memory_order_relaxed)) {
+    wake();
+  }
+}
+
+void ResultPublisher::onSpectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal,
+                                      int packetCount) {
+  Q_UNUSED(minVal);
+  Q_UNUSED(maxVal);
+  Q_UNUSED(packetCount);
+  onStreamSpectrumReady(QString(), 0, averagedSpectrum);
+}
+
+void ResultPublisher::onStreamSpectrumReady(const QString &deviceId, int streamId,
+                                            const QVariantList &averagedSpectrum) {
+  Q_UNUSED(deviceId);
+  if (!isRunning() || (!config_.attachSpectrum && !config_.publishSpectra)) {
+    return;
+  }
+  std::vector<float> values;
+  values.reserve(static_cast<size_t>(averagedSpectrum.size()));
+  for (const QVariant &value : averagedSpectrum) {
+    values.push_back(value.toFloat());
+  }
+  publishSpectrum(values.data(), static_cast<int>(values.size()), clockNs(CLOCK_MONOTONIC), streamId);
+}
+
+QVariantMap ResultPublisher::stats() const {
+  QVariantMap map;
+  map.insert(QStringLiteral("running"), isRunning());
+  map.insert(QStringLiteral("config"), config_.describe());
+  map.insert(QStringLiteral("datagrams"), static_cast<qulonglong>(datagrams_.load(std::memory_order_relaxed)));
+  map.insert(QStringLiteral("messages"), static_cast<qulonglong>(messages_.load(std::memory_order_relaxed)));
+  map.insert(QStringLiteral("droppedPredictions"),
+             static_cast<qulonglong>(droppedPredictions_.load(std::memory_order_relaxed)));
+  map.insert(QStringLiteral("droppedSpectra"),
+             static_cast<qulonglong>(droppedSpectra_.load(std::memory_order_relaxed)));
+  map.insert(QStringLiteral("networkDrops"), static_cast<qulonglong>(networkDrops_.load(std::memory_order_relaxed)));
+  map.insert(QStringLiteral("clients"), clientCount_.load(std::memory_order_relaxed));
+  return map;
+}
+
+bool ResultPublisher::openSockets(QString *error) {
+  auto fail = [error](const QString &message) {
+    if (error) {
+      *error = message;
+    }
+    return false;
+  };
+
+  if (config_.multicastPort > 0) {
+    udpFd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (udpFd_ < 0) {
+      return fail(QStringLiteral("创建组播套接字失败: %1").arg(errnoString()));
+    }
+    const int ttl = config_.multicastTtl;
+    const int loop = config_.multicastLoopback ? 1 : 0;
+    setsockopt(udpFd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(udpFd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    if (!config_.multicastInterface.isEmpty()) {
+      struct in_addr iface;
+      parseIpv4(config_.multicastInterface, &iface);
+      if (setsockopt(udpFd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) != 0) {
+        return fail(QStringLiteral("设置组播网卡 %1 失败: %2").arg(config_.multicastInterface, errnoString()));
+      }
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config_.multicastPort));
+    parseIpv4(config_.multicastGroup, &addr.sin_addr);
+    multicastAddr_.assign(reinterpret_cast<const char *>(&addr), reinterpret_cast<const char *>(&addr) + sizeof(addr));
+  }
+
+  if (config_.tcpPort > 0) {
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listenFd_ < 0) {
+      return fail(QStringLiteral("创建 TCP 套接字失败: %1").arg(errnoString()));
+    }
+    const int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config_.tcpPort));
+    if (!parseIpv4(config_.tcpBindAddress, &addr.sin_addr)) {
+      return fail(QStringLiteral("无效的 TCP 绑定地址: %1").arg(config_.tcpBindAddress));
+    }
+    if (bind(listenFd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listenFd_, 8) != 0) {
+      return fail(QStringLiteral("监听 TCP %1:%2 失败: %3")
+                      .arg(config_.tcpBindAddress)
+                      .arg(config_.tcpPort)
+                      .arg(errnoString()));
+    }
+  }
+  return true;
+}
+
+void ResultPublisher::closeSockets() {
+  for (Client &client : clients_) {
+    close(client.fd);
+  }
+  clients_.clear();
+  clientCount_ = 0;
+  if (udpFd_ >= 0) {
+    close(udpFd_);
+    udpFd_ = -1;
+  }
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+    listenFd_ = -1;
+  }
+}
+
+void ResultPublisher::wake() {
+  if (eventFd_ >= 0) {
+    uint64_t one = 1;
+    ssize_t ret = write(eventFd_, &one, sizeof(one));
+    (void)ret;
+  }
+}
+
+void ResultPublisher::waitForWork() {
+  // 同时等待：新消息（eventfd）、新订阅端（listenFd_）、订阅端断开或可写（有积压时）
+  std::vector<struct pollfd> fds;
+  fds.reserve(clients_.size() + 2);
+  auto add = [&fds](int fd, short events) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    fds.push_back(pfd);
+  };
+  add(eventFd_, POLLIN);
+  if (listenFd_ >= 0) {
+    add(listenFd_, POLLIN);
+  }
+  const size_t firstClient = fds.size();
+  for (const Client &client : clients_) {
+    add(client.fd, static_cast<short>(POLLIN | (client.pending.isEmpty() ? 0 : POLLOUT)));
+  }
+
+  consumerWaiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const bool idle = predictions_.emptyApprox() && spectra_.emptyApprox() && !stopRequested_;
+  const int ready = poll(fds.data(), static_cast<nfds_t>(fds.size()), idle ? kIdleTimeoutMs : 0);
+  consumerWaiting_.store(false, std::memory_order_relaxed);
+  if (ready <= 0) {
+    return;
+  }
+
+  if (fds[0].revents & POLLIN) {
+    uint64_t counter = 0;
+    ssize_t ret = read(eventFd_, &counter, sizeof(counter));
+    (void)ret;
+    // 合并窗口：第一条消息到达后稍等片刻，让同一轮推理的其它预测器结果进同一个数据报
+    if (config_.batchDelayUs > 0) {
+      usleep(static_cast<useconds_t>(config_.batchDelayUs));
+    }
+  }
+  if (listenFd_ >= 0 && (fds[1].revents & POLLIN)) {
+    acceptClients();
+  }
+  // 倒序处理，closeClient 删除元素不影响尚未处理的下标
+  for (size_t i = clients_.size(); i-- > 0;) {
+    const short revents = fds[firstClient + i].revents;
+    if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+      closeClient(i);
+      continue;
+    }
+    if (revents & POLLIN) {
+      // 订阅端不应发送数据：读出丢弃，读到 0 表示对端关闭
+      char buffer[256];
+      const ssize_t n = recv(clients_[i].fd, buffer, sizeof(buffer), 0);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        closeClient(i);
+        continue;
+      }
+    }
+    if (revents & POLLOUT) {
+      writeClient(clients_[i]);
+    }
+  }
+}
+
+void ResultPublisher::run() {
+  datagram_.reserve(config_.maxDatagramBytes);
+  while (!stopRequested_) {
+    waitForWork();
+    drain();
+  }
+  // 退出前发完剩余的消息，并尽量把 TCP 积压写出
+  drain();
+  for (Client &client : clients_) {
+    writeClient(client);
+  }
+}
+
+void ResultPublisher::drain() {
+  Message messages[kPopChunk];
+  size_t n = 0;
+  // 预测消息优先：光谱消息只在预测队列取空后发送
+  while ((n = predictions_.pop(messages, kPopChunk)) > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      append(messages[i]);
+      messages[i].spectrum.reset();
+    }
+  }
+  while ((n = spectra_.pop(messages, kPopChunk)) > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      append(messages[i]);
+      messages[i].spectrum.reset();
+    }
+  }
+  flushDatagram();
+}
+
+void ResultPublisher::append(const Message &message) {
+  const int points = message.spectrum ? static_cast<int>(message.spectrum->size()) : 0;
+  const int bytes = static_cast<int>(sizeof(ResultMessageFormat::MessageHeader)) + points * static_cast<int>(sizeof(float));
+  if (datagramMessages_ > 0 &&
+      (datagram_.size() + bytes > config_.maxDatagramBytes || datagramMessages_ == 0xFFFF)) {
+    flushDatagram();
+  }
+  if (datagramMessages_ == 0) {
+    datagram_.resize(sizeof(ResultMessageFormat::DatagramHeader));
+  }
+
+  ResultMessageFormat::MessageHeader header;
+  memset(&header, 0, sizeof(header));
+  header.type = message.type;
+  header.status = message.status;
+  header.predictorIndex = message.predictorIndex;
+  header.spectrumPoints = static_cast<uint16_t>(points);
+  header.streamId = message.streamId;
+  header.timestampNs = message.timestampNs;
+  header.value = message.value;
+  datagram_.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (points > 0) {
+    datagram_.append(reinterpret_cast<const char *>(message.spectrum->data()),
+                     static_cast<qsizetype>(points * sizeof(float)));
+  }
+  ++datagramMessages_;
+  messages_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResultPublisher::flushDatagram() {
+  if (datagramMessages_ == 0) {
+    return;
+  }
+  ResultMessageFormat::DatagramHeader header;
+  memcpy(header.magic, ResultMessageFormat::kMagic, sizeof(header.magic));
+  header.version = ResultMessageFormat::kVersion;
+  header.messageCount = static_cast<uint16_t>(datagramMessages_);
+  header.sequence = sequence_++;
+  header.droppedMessages = static_cast<uint32_t>(droppedPredictions_.load(std::memory_order_relaxed) +
+                                                 droppedSpectra_.load(std::memory_order_relaxed));
+  header.sentNs = clockNs(CLOCK_REALTIME);
+  memcpy(datagram_.data(), &header, sizeof(header));
+  datagramMessages_ = 0;
+  datagrams_.fetch_add(1, std::memory_order_relaxed);
+
+  if (udpFd_ >= 0) {
+    // 非阻塞发送：内核发送缓冲满（EAGAIN）时丢弃该数据报，发布线程不被网络拖住
+    const ssize_t sent = sendto(udpFd_, datagram_.constData(), static_cast<size_t>(datagram_.size()), 0,
+                                reinterpret_cast<const struct sockaddr *>(multicastAddr_.data()),
+                                static_cast<socklen_t>(multicastAddr_.size()));
+    if (sent < 0) {
+      networkDrops_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  if (!clients_.empty()) {
+    const uint32_t length = static_cast<uint32_t>(datagram_.size());
+    for (Client &client : clients_) {
+      // 积压超过上限时整帧丢弃（保持帧边界），只影响这一个订阅端
+      if (client.pending.size() + static_cast<qsizetype>(sizeof(length)) + datagram_.size() >
+          config_.tcpClientBufferBytes) {
+        networkDrops_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      client.pending.append(reinterpret_cast<const char *>(&length), sizeof(length));
+      client.pending.append(datagram_);
+      writeClient(client);
+    }
+  }
+  datagram_.clear();
+}
+
+void ResultPublisher::acceptClients() {
+  while (true) {
+    const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        qWarning() << "[ResultPublisher] accept failed:" << errnoString();
+      }
+      return;
+    }
+    if (static_cast<int>(clients_.size()) >= kMaxClients) {
+      close(fd);
+      continue;
+    }
+    Client client;
+    client.fd = fd;
+    clients_.push_back(std::move(client));
+    clientCount_ = static_cast<int>(clients_.size());
+  }
+}
+
+void ResultPublisher::writeClient(Client &client) {
+  while (!client.pending.isEmpty()) {
+    const ssize_t n = send(client.fd, client.pending.constData(), static_cast<size_t>(client.pending.size()),
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0) {
+      client.pending.remove(0, static_cast<qsizetype>(n));
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // EAGAIN：等 POLLOUT 再写；其它错误由下一轮 poll 的 POLLERR / POLLHUP 关闭
+    return;
+  }
+}
+
+void ResultPublisher::closeClient(size_t index) {
+  close(clients_[index].fd);
+  clients_.erase(clients_.begin() + static_cast<std::ptrdiff_t>(index));
+  clientCount_ = static_cast<int>(clients_.size());
+}
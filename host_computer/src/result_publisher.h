@@ -0,0 +1,140 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+#include <QVariantList>
+#include <QVariantMap>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mpsc_ring.h"
+
+// 预测结果与光谱的网络发布线程（格式见 result_message_format.h）
+// - 任意线程调用 publishPrediction() / publishSpectrum()：编码所需的字段投递到无锁队列，不做网络 I/O；
+//   推理线程可以直接调用（InferenceExecutor::predictionReady 以 Qt::DirectConnection 连接），结果不经过主线程
+// - 后台线程每次唤醒把队列中的消息按 maxDatagramBytes 合并成数据报，发往 UDP 组播和 / 或 TCP 订阅端
+// - 反压：队列满时丢弃新消息并计数；光谱消息队列很小，网络或下游跟不上时先丢光谱、保证预测值送达；
+//   每个 TCP 订阅端有独立的发送缓冲上限，慢的订阅端只丢它自己的数据报，不影响其它订阅端
+// - 配置文件为 JSON（默认 <程序目录>/publisher.json），不存在或端口都为 0 时不启动
+//
+// 配置示例：
+// {
+//   "multicastGroup": "239.192.0.10", "multicastPort": 5600, "multicastInterface": "192.168.1.102",
+//   "multicastTtl": 1, "tcpPort": 5601,
+//   "attachSpectrum": false, "publishSpectra": false,
+//   "maxDatagramBytes": 8192, "batchDelayUs": 500, "tcpClientBufferBytes": 1048576
+// }
+class ResultPublisher : public QThread {
+  Q_OBJECT
+
+ public:
+  struct Config {
+    QString multicastGroup = QStringLiteral("239.192.0.10");
+    int multicastPort = 0;  // 0 表示不发组播
+    QString multicastInterface;  // 组播出口网卡的 IPv4 地址，空表示由路由决定
+    int multicastTtl = 1;
+    bool multicastLoopback = false;
+    int tcpPort = 0;  // 0 表示不监听 TCP
+    QString tcpBindAddress = QStringLiteral("0.0.0.0");
+    bool attachSpectrum = false;   // 预测消息附带最新一条光谱
+    bool publishSpectra = false;   // 每条平均光谱单独发一条消息
+    int maxDatagramBytes = 8192;   // 合并后的数据报上限（单条消息超过时单独发送）
+    int batchDelayUs = 500;        // 收到第一条消息后最多再等多久合并后续消息（0 表示立即发送）
+    int tcpClientBufferBytes = 1 << 20;
+    int queueCapacity = 4096;      // 预测消息队列
+    int spectrumQueueCapacity = 64;  // 光谱消息队列
+
+    bool enabled() const { return multicastPort > 0 || tcpPort > 0; }
+    static QString defaultConfigPath();
+    // 读取配置文件；文件不存在返回 true 并保留默认值，格式错误返回 false 并写入 error
+    bool load(const QString &path, QString *error = nullptr);
+    QString describe() const;
+  };
+
+  explicit ResultPublisher(const Config &config, QObject *parent = nullptr);
+  ~ResultPublisher() override;
+
+  // 打开套接字并启动发布线程；未启用或失败时返回 false（失败写入 error）
+  bool startPublishing(QString *error = nullptr);
+  // 停止线程：先发完队列中剩余的消息
+  void stopPublishing();
+
+  // 异常监控上下限（与界面 / 守护进程的监控一致），决定预测消息的 status
+  Q_INVOKABLE void setMonitorLimits(bool enabled, double lowerLimit, double upperLimit);
+
+  // 任意线程调用：windowTimestampNs 为光谱窗口时间（CLOCK_MONOTONIC），发送时换算为 CLOCK_REALTIME
+  // streamId 为光谱来源（InferenceExecutor 信号中的 streamId）
+  void publishPrediction(int predictorIndex, double value, qint64 windowTimestampNs, int streamId = 0);
+  void publishSpectrum(const float *data, int count, qint64 timestampNs, int streamId = 0);
+
+  // 发布统计：datagrams、messages、droppedPredictions、droppedSpectra（队列满丢弃）、
+  // networkDrops（组播发送失败或 TCP 订阅端积压超限而丢弃的数据报）、clients
+  Q_INVOKABLE QVariantMap stats() const;
+
+ public slots:
+  // 连接 UdpCommunicator::spectrumReady：更新附带的最新光谱，按配置单独发布
+  void onSpectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
+  // 连接 DeviceRegistry::spectrumReady：多设备时按设备的 streamId 发布
+  void onStreamSpectrumReady(const QString &deviceId, int streamId, const QVariantList &averagedSpectrum);
+
+ protected:
+  void run() override;
+
+ private:
+  using SpectrumPtr = std::shared_ptr<const std::vector<float>>;
+
+  struct Message {
+    quint8 type = 0;
+    quint8 status = 0;
+    qint16 predictorIndex = -1;
+    quint16 streamId = 0;
+    qint64 timestampNs = 0;  // CLOCK_REALTIME
+    float value = 0.0f;
+    SpectrumPtr spectrum;
+  };
+
+  struct Client {
+    int fd = -1;
+    QByteArray pending;  // 尚未写入内核的帧
+  };
+
+  bool openSockets(QString *error);
+  void closeSockets();
+  void wake();
+  void waitForWork();
+  void drain();
+  void append(const Message &message);
+  void flushDatagram();
+  void acceptClients();
+  void writeClient(Client &client);
+  void closeClient(size_t index);
+  static qint64 toRealtimeNs(qint64 monotonicNs);
+
+  Config config_;
+  MpscRing<Message> predictions_;
+  MpscRing<Message> spectra_;
+  // 每个 streamId 最新一条光谱（std::atomic_load / atomic_store），超出范围的 streamId 不附带光谱
+  static const int kMaxAttachedStreams = 64;
+  SpectrumPtr latestSpectrum_[kMaxAttachedStreams];
+  int eventFd_;
+  int udpFd_;
+  int listenFd_;
+  std::vector<char> multicastAddr_;  // sockaddr_in
+  std::vector<Client> clients_;  // 仅发布线程访问
+  QByteArray datagram_;  // 正在合并的数据报
+  int datagramMessages_;
+  quint32 sequence_;
+  std::atomic<bool> consumerWaiting_;
+  std::atomic<bool> stopRequested_;
+  std::atomic<bool> monitorEnabled_;
+  std::atomic<double> lowerLimit_;
+  std::atomic<double> upperLimit_;
+  std::atomic<quint64> datagrams_;
+  std::atomic<quint64> messages_;
+  std::atomic<quint64> droppedPredictions_;
+  std::atomic<quint64> droppedSpectra_;
+  std::atomic<quint64> networkDrops_;
+  std::atomic<int> clientCount_;
+};
@@ -0,0 +1,73 @@
+#include "spectral_calibration.h"
+#include "spectral_math.h"
+
+#include <cmath>
+
+std::shared_ptr<const SpectralCalibration> SpectralCalibration::build(const double *black, const double *white,
+                                                                      const Options &options) {
+  std::shared_ptr<SpectralCalibration> calibration(new SpectralCalibration());
+
+  // 暗电流缩放：黑参考 = 偏置 + 暗电流部分，暗电流部分与积分时间成正比
+  if (options.darkIntegrationUs > 0.0 && options.integrationUs > 0.0) {
+    calibration->darkScale_ = options.integrationUs / options.darkIntegrationUs;
+  }
+  const double darkScale = calibration->darkScale_;
+
+  for (int i = 0; i < kPixelCount; i++) {
+    const double dark = darkScale == 1.0 ? black[i] : options.darkBias + (black[i] - options.darkBias) * darkScale;
+    const double span = white[i] - dark;
+    const bool saturated = options.saturationLevel > 0.0 && white[i] >= options.saturationLevel;
+    if (std::fabs(span) < options.minSpan || saturated) {
+      calibration->badPixel_[i] = 1;
+      calibration->gain_[i] = 1.0f;
+      calibration->offset_[i] = 0.0f;
+      continue;
+    }
+    const double gain = 1.0 / span;
+    calibration->badPixel_[i] = 0;
+    calibration->gain_[i] = static_cast<float>(gain);
+    calibration->offset_[i] = static_cast<float>(-dark * gain);
+  }
+
+  // 预先确定每个坏像素的插值邻居，校正时只做查表
+  for (int i = 0; i < kPixelCount; i++) {
+    if (!calibration->badPixel_[i]) {
+      continue;
+    }
+    Repair repair{i, -1, -1, 1.0};
+    if (options.interpolateBadPixels) {
+      for (int j = i - 1; j >= 0; j--) {
+        if (!calibration->badPixel_[j]) {
+          repair.left = j;
+          break;
+        }
+      }
+      for (int j = i + 1; j < kPixelCount; j++) {
+        if (!calibration->badPixel_[j]) {
+          repair.right = j;
+          break;
+        }
+      }
+      // 只有一侧有正常像素时直接取该像素
+      if (repair.left < 0) {
+        repair.left = repair.right;
+      } else if (repair.right < 0) {
+        repair.right = repair.left;
+      } else {
+        repair.leftWeight = static_cast<double>(repair.right - i) / (repair.right - repair.left);
+      }
+    }
+    calibration->repairs_.push_back(repair);
+  }
+  return calibration;
+}
+
+void SpectralCalibration::apply(const double *raw, double *out) const {
+  SpectralMath::applyGainOffset(raw, gain_, offset_, out, kPixelCount);
+  // 邻居都是正常像素，插值只读取已校正的值，与处理顺序无关
+  for (const Repair &repair : repairs_) {
+    if (repair.left >= 0) {
+      out[repair.pixel] = out[repair.left] * repair.leftWeight + out[repair.right] * (1.0 - repair.leftWeight);
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "spectrum_frame.h"
+
+// 黑白校正的预计算标定：参考数据变化时在主线程构建一次，之后只读
+// - 逐像素 gain = 1 / (白 - 黑)、offset = -黑 * gain（float32，64 字节对齐），
+//   校正只需一次乘加：out = raw * gain + offset
+// - 坏像素（白黑差过小、白参考饱和）记入掩码：gain = 1、offset = 0 保留原始值，
+//   启用插值时再用左右最近的正常像素线性插值替换
+// - 可选暗电流模型：黑参考 = 偏置 + 暗电流 * 积分时间，积分时间变化时按比例缩放黑参考的暗电流部分
+//   （白参考须在当前积分时间下采集）
+// 处理线程通过原子共享指针取得当前标定（见 SpectrumProcessor::setCalibration），替换时不阻塞处理
+class SpectralCalibration {
+ public:
+  static constexpr int kPixelCount = SpectrumFrame::kPixelCount;
+
+  struct Options {
+    double minSpan = 1e-6;             // |白 - 黑| 小于该值的像素视为坏像素（与原有除零保护一致）
+    double saturationLevel = 65535.0;  // 白参考均值达到该值视为饱和；<= 0 表示不检查
+    bool interpolateBadPixels = true;  // 坏像素用相邻正常像素插值（否则保留原始值）
+    double darkBias = 0.0;             // 与积分时间无关的电子偏置（计数）
+    double darkIntegrationUs = 0.0;    // 黑参考采集时的积分时间（微秒），<= 0 表示不缩放
+    double integrationUs = 0.0;        // 当前积分时间（微秒），<= 0 表示不缩放
+  };
+
+  // black / white 为 kPixelCount 个逐像素平均值
+  static std::shared_ptr<const SpectralCalibration> build(const double *black, const double *white,
+                                                          const Options &options);
+
+  // 对一条平均光谱做黑白校正（out 可以与 raw 相同）
+  void apply(const double *raw, double *out) const;
+
+  int badPixelCount() const { return static_cast<int>(repairs_.size()); }
+  bool isBadPixel(int pixel) const { return badPixel_[pixel] != 0; }
+  const uint8_t *badPixelMask() const { return badPixel_; }
+  const float *gain() const { return gain_; }
+  const float *offset() const { return offset_; }
+  // 暗电流缩放系数（当前积分时间 / 黑参考积分时间），未缩放时为 1
+  double darkScale() const { return darkScale_; }
+
+ private:
+  SpectralCalibration() = default;
+
+  // 坏像素插值：out[pixel] = out[left] * leftWeight + out[right] * (1 - leftWeight)
+  struct Repair {
+    int pixel;
+    int left;
+    int right;
+    double leftWeight;
+  };
+
+  alignas(64) float gain_[kPixelCount];
+  alignas(64) float offset_[kPixelCount];
+  uint8_t badPixel_[kPixelCount];
+  std::vector<Repair> repairs_;  // 每个坏像素一项；不插值或没有正常像素时 left = right = -1
+  double darkScale_ = 1.0;
+};
+
+using SpectralCalibrationPtr = std::shared_ptr<const SpectralCalibration>;
@@ -0,0 +1,430 @@
+#include "spectral_math.h"
+
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SPECTRAL_MATH_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define SPECTRAL_MATH_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace SpectralMath {
+
+namespace {
+
+struct Kernels {
+  Isa isa;
+  void (*accumulateU16)(uint32_t *, const uint16_t *, int);
+  void (*accumulateSquaresU16)(uint64_t *, const uint16_t *, int);
+  void (*subtractU16)(uint32_t *, const uint16_t *, int);
+  void (*subtractSquaresU16)(uint64_t *, const uint16_t *, int);
+  void (*emaUpdateU16)(double *, const uint16_t *, double, int);
+  void (*applyGainOffset)(const double *, const float *, const float *, double *, int);
+  void (*minMax)(const double *, int, double *, double *);
+};
+
+// ---------------- 标量实现 ----------------
+
+void accumulateU16Scalar(uint32_t *sums, const uint16_t *pixels, int count) {
+  for (int i = 0; i < count; i++) {
+    sums[i] += pixels[i];
+  }
+}
+
+void accumulateSquaresU16Scalar(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  for (int i = 0; i < count; i++) {
+    const uint32_t v = pixels[i];
+    sumSquares[i] += v * v;
+  }
+}
+
+void subtractU16Scalar(uint32_t *sums, const uint16_t *pixels, int count) {
+  for (int i = 0; i < count; i++) {
+    sums[i] -= pixels[i];
+  }
+}
+
+void subtractSquaresU16Scalar(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  for (int i = 0; i < count; i++) {
+    const uint32_t v = pixels[i];
+    sumSquares[i] -= v * v;
+  }
+}
+
+void emaUpdateU16Scalar(double *ema, const uint16_t *pixels, double alpha, int count) {
+  for (int i = 0; i < count; i++) {
+    ema[i] += alpha * (static_cast<double>(pixels[i]) - ema[i]);
+  }
+}
+
+void applyGainOffsetScalar(const double *raw, const float *gain, const float *offset,
+                           double *out, int count) {
+  for (int i = 0; i < count; i++) {
+    out[i] = raw[i] * static_cast<double>(gain[i]) + static_cast<double>(offset[i]);
+  }
+}
+
+void minMaxScalar(const double *data, int count, double *minOut, double *maxOut) {
+  double minVal = data[0];
+  double maxVal = data[0];
+  for (int i = 1; i < count; i++) {
+    const double v = data[i];
+    if (v < minVal) minVal = v;
+    if (v > maxVal) maxVal = v;
+  }
+  *minOut = minVal;
+  *maxOut = maxVal;
+}
+
+const Kernels kScalarKernels = {
+  Isa::Scalar, accumulateU16Scalar, accumulateSquaresU16Scalar, subtractU16Scalar,
+  subtractSquaresU16Scalar, emaUpdateU16Scalar, applyGainOffsetScalar, minMaxScalar
+};
+
+// ---------------- AVX2 实现 ----------------
+
+#ifdef SPECTRAL_MATH_HAVE_AVX2
+
+__attribute__((target("avx2")))
+void accumulateU16Avx2(uint32_t *sums, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + i));
+    const __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+    const __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+    __m256i *s0 = reinterpret_cast<__m256i *>(sums + i);
+    __m256i *s1 = reinterpret_cast<__m256i *>(sums + i + 8);
+    _mm256_storeu_si256(s0, _mm256_add_epi32(_mm256_loadu_si256(s0), lo));
+    _mm256_storeu_si256(s1, _mm256_add_epi32(_mm256_loadu_si256(s1), hi));
+  }
+  accumulateU16Scalar(sums + i, pixels + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void accumulateSquaresU16Avx2(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i));
+    const __m256i v32 = _mm256_cvtepu16_epi32(v);
+    // 65535² < 2³²，32 位无符号乘积不会溢出
+    const __m256i sq = _mm256_mullo_epi32(v32, v32);
+    const __m256i lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sq));
+    const __m256i hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sq, 1));
+    __m256i *s0 = reinterpret_cast<__m256i *>(sumSquares + i);
+    __m256i *s1 = reinterpret_cast<__m256i *>(sumSquares + i + 4);
+    _mm256_storeu_si256(s0, _mm256_add_epi64(_mm256_loadu_si256(s0), lo));
+    _mm256_storeu_si256(s1, _mm256_add_epi64(_mm256_loadu_si256(s1), hi));
+  }
+  accumulateSquaresU16Scalar(sumSquares + i, pixels + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void subtractU16Avx2(uint32_t *sums, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + i));
+    const __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+    const __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+    __m256i *s0 = reinterpret_cast<__m256i *>(sums + i);
+    __m256i *s1 = reinterpret_cast<__m256i *>(sums + i + 8);
+    _mm256_storeu_si256(s0, _mm256_sub_epi32(_mm256_loadu_si256(s0), lo));
+    _mm256_storeu_si256(s1, _mm256_sub_epi32(_mm256_loadu_si256(s1), hi));
+  }
+  subtractU16Scalar(sums + i, pixels + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void subtractSquaresU16Avx2(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i));
+    const __m256i v32 = _mm256_cvtepu16_epi32(v);
+    const __m256i sq = _mm256_mullo_epi32(v32, v32);
+    const __m256i lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sq));
+    const __m256i hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sq, 1));
+    __m256i *s0 = reinterpret_cast<__m256i *>(sumSquares + i);
+    __m256i *s1 = reinterpret_cast<__m256i *>(sumSquares + i + 4);
+    _mm256_storeu_si256(s0, _mm256_sub_epi64(_mm256_loadu_si256(s0), lo));
+    _mm256_storeu_si256(s1, _mm256_sub_epi64(_mm256_loadu_si256(s1), hi));
+  }
+  subtractSquaresU16Scalar(sumSquares + i, pixels + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void emaUpdateU16Avx2(double *ema, const uint16_t *pixels, double alpha, int count) {
+  const __m256d va = _mm256_set1_pd(alpha);
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i v16 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pixels + i));
+    const __m256d x = _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(v16));
+    const __m256d e = _mm256_loadu_pd(ema + i);
+    // 不依赖 FMA 指令集，用乘加代替
+    _mm256_storeu_pd(ema + i, _mm256_add_pd(e, _mm256_mul_pd(va, _mm256_sub_pd(x, e))));
+  }
+  emaUpdateU16Scalar(ema + i, pixels + i, alpha, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+void applyGainOffsetAvx2(const double *raw, const float *gain, const float *offset,
+                         double *out, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d g = _mm256_cvtps_pd(_mm_loadu_ps(gain + i));
+    const __m256d o = _mm256_cvtps_pd(_mm_loadu_ps(offset + i));
+    _mm256_storeu_pd(out + i, _mm256_fmadd_pd(_mm256_loadu_pd(raw + i), g, o));
+  }
+  applyGainOffsetScalar(raw + i, gain + i, offset + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void minMaxAvx2(const double *data, int count, double *minOut, double *maxOut) {
+  if (count < 4) {
+    minMaxScalar(data, count, minOut, maxOut);
+    return;
+  }
+  __m256d vmin = _mm256_loadu_pd(data);
+  __m256d vmax = vmin;
+  int i = 4;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d v = _mm256_loadu_pd(data + i);
+    vmin = _mm256_min_pd(vmin, v);
+    vmax = _mm256_max_pd(vmax, v);
+  }
+  alignas(32) double mins[4];
+  alignas(32) double maxs[4];
+  _mm256_store_pd(mins, vmin);
+  _mm256_store_pd(maxs, vmax);
+  double minVal = mins[0];
+  double maxVal = maxs[0];
+  for (int k = 1; k < 4; k++) {
+    if (mins[k] < minVal) minVal = mins[k];
+    if (maxs[k] > maxVal) maxVal = maxs[k];
+  }
+  for (; i < count; i++) {
+    if (data[i] < minVal) minVal = data[i];
+    if (data[i] > maxVal) maxVal = data[i];
+  }
+  *minOut = minVal;
+  *maxOut = maxVal;
+}
+
+const Kernels kAvx2Kernels = {
+  Isa::Avx2, accumulateU16Avx2, accumulateSquaresU16Avx2, subtractU16Avx2,
+  subtractSquaresU16Avx2, emaUpdateU16Avx2, applyGainOffsetAvx2, minMaxAvx2
+};
+
+#endif  // SPECTRAL_MATH_HAVE_AVX2
+
+// ---------------- NEON 实现 ----------------
+
+#ifdef SPECTRAL_MATH_HAVE_NEON
+
+void accumulateU16Neon(uint32_t *sums, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const uint16x8_t v = vld1q_u16(pixels + i);
+    vst1q_u32(sums + i, vaddw_u16(vld1q_u32(sums + i), vget_low_u16(v)));
+    vst1q_u32(sums + i + 4, vaddw_high_u16(vld1q_u32(sums + i + 4), v));
+  }
+  accumulateU16Scalar(sums + i, pixels + i, count - i);
+}
+
+void accumulateSquaresU16Neon(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const uint16x4_t v = vld1_u16(pixels + i);
+    const uint32x4_t sq = vmull_u16(v, v);
+    vst1q_u64(sumSquares + i, vaddw_u32(vld1q_u64(sumSquares + i), vget_low_u32(sq)));
+    vst1q_u64(sumSquares + i + 2, vaddw_high_u32(vld1q_u64(sumSquares + i + 2), sq));
+  }
+  accumulateSquaresU16Scalar(sumSquares + i, pixels + i, count - i);
+}
+
+void subtractU16Neon(uint32_t *sums, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const uint16x8_t v = vld1q_u16(pixels + i);
+    vst1q_u32(sums + i, vsubw_u16(vld1q_u32(sums + i), vget_low_u16(v)));
+    vst1q_u32(sums + i + 4, vsubw_high_u16(vld1q_u32(sums + i + 4), v));
+  }
+  subtractU16Scalar(sums + i, pixels + i, count - i);
+}
+
+void subtractSquaresU16Neon(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const uint16x4_t v = vld1_u16(pixels + i);
+    const uint32x4_t sq = vmull_u16(v, v);
+    vst1q_u64(sumSquares + i, vsubw_u32(vld1q_u64(sumSquares + i), vget_low_u32(sq)));
+    vst1q_u64(sumSquares + i + 2, vsubw_high_u32(vld1q_u64(sumSquares + i + 2), sq));
+  }
+  subtractSquaresU16Scalar(sumSquares + i, pixels + i, count - i);
+}
+
+void emaUpdateU16Neon(double *ema, const uint16_t *pixels, double alpha, int count) {
+  const float64x2_t va = vdupq_n_f64(alpha);
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const uint32x4_t v32 = vmovl_u16(vld1_u16(pixels + i));
+    const float64x2_t x0 = vcvtq_f64_u64(vmovl_u32(vget_low_u32(v32)));
+    const float64x2_t x1 = vcvtq_f64_u64(vmovl_high_u32(v32));
+    const float64x2_t e0 = vld1q_f64(ema + i);
+    const float64x2_t e1 = vld1q_f64(ema + i + 2);
+    vst1q_f64(ema + i, vfmaq_f64(e0, va, vsubq_f64(x0, e0)));
+    vst1q_f64(ema + i + 2, vfmaq_f64(e1, va, vsubq_f64(x1, e1)));
+  }
+  emaUpdateU16Scalar(ema + i, pixels + i, alpha, count - i);
+}
+
+void applyGainOffsetNeon(const double *raw, const float *gain, const float *offset,
+                         double *out, int count) {
+  int i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const float64x2_t g = vcvt_f64_f32(vld1_f32(gain + i));
+    const float64x2_t o = vcvt_f64_f32(vld1_f32(offset + i));
+    vst1q_f64(out + i, vfmaq_f64(o, vld1q_f64(raw + i), g));
+  }
+  applyGainOffsetScalar(raw + i, gain + i, offset + i, out + i, count - i);
+}
+
+void minMaxNeon(const double *data, int count, double *minOut, double *maxOut) {
+  if (count < 2) {
+    minMaxScalar(data, count, minOut, maxOut);
+    return;
+  }
+  float64x2_t vmin = vld1q_f64(data);
+  float64x2_t vmax = vmin;
+  int i = 2;
+  for (; i + 2 <= count; i += 2) {
+    const float64x2_t v = vld1q_f64(data + i);
+    vmin = vminq_f64(vmin, v);
+    vmax = vmaxq_f64(vmax, v);
+  }
+  double minVal = vminvq_f64(vmin);
+  double maxVal = vmaxvq_f64(vmax);
+  for (; i < count; i++) {
+    if (data[i] < minVal) minVal = data[i];
+    if (data[i] > maxVal) maxVal = data[i];
+  }
+  *minOut = minVal;
+  *maxOut = maxVal;
+}
+
+const Kernels kNeonKernels = {
+  Isa::Neon, accumulateU16Neon, accumulateSquaresU16Neon, subtractU16Neon,
+  subtractSquaresU16Neon, emaUpdateU16Neon, applyGainOffsetNeon, minMaxNeon
+};
+
+#endif  // SPECTRAL_MATH_HAVE_NEON
+
+// ---------------- 运行时分派 ----------------
+
+const Kernels *kernelsFor(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar:
+      return &kScalarKernels;
+    case Isa::Avx2:
+#ifdef SPECTRAL_MATH_HAVE_AVX2
+      // AVX2 内核中的校正使用 FMA（Haswell 之后的 AVX2 处理器都支持）
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &kAvx2Kernels;
+      }
+#endif
+      return nullptr;
+    case Isa::Neon:
+#ifdef SPECTRAL_MATH_HAVE_NEON
+      return &kNeonKernels;
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+const Kernels *selectBestKernels() {
+  if (const Kernels *k = kernelsFor(Isa::Avx2)) {
+    return k;
+  }
+  if (const Kernels *k = kernelsFor(Isa::Neon)) {
+    return k;
+  }
+  return &kScalarKernels;
+}
+
+std::atomic<const Kernels *> g_activeKernels{nullptr};
+
+inline const Kernels &kernels() {
+  const Kernels *k = g_activeKernels.load(std::memory_order_acquire);
+  if (!k) {
+    // 并发首次调用时可能重复选择，结果相同，无需加锁
+    k = selectBestKernels();
+    g_activeKernels.store(k, std::memory_order_release);
+  }
+  return *k;
+}
+
+}  // namespace
+
+Isa activeIsa() {
+  return kernels().isa;
+}
+
+const char *isaName(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar:
+      return "scalar";
+    case Isa::Avx2:
+      return "avx2";
+    case Isa::Neon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool isIsaSupported(Isa isa) {
+  return kernelsFor(isa) != nullptr;
+}
+
+bool setActiveIsa(Isa isa) {
+  const Kernels *k = kernelsFor(isa);
+  if (!k) {
+    return false;
+  }
+  g_activeKernels.store(k, std::memory_order_release);
+  return true;
+}
+
+void accumulateU16(uint32_t *sums, const uint16_t *pixels, int count) {
+  kernels().accumulateU16(sums, pixels, count);
+}
+
+void accumulateSquaresU16(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  kernels().accumulateSquaresU16(sumSquares, pixels, count);
+}
+
+void subtractU16(uint32_t *sums, const uint16_t *pixels, int count) {
+  kernels().subtractU16(sums, pixels, count);
+}
+
+void subtractSquaresU16(uint64_t *sumSquares, const uint16_t *pixels, int count) {
+  kernels().subtractSquaresU16(sumSquares, pixels, count);
+}
+
+void emaUpdateU16(double *ema, const uint16_t *pixels, double alpha, int count) {
+  kernels().emaUpdateU16(ema, pixels, alpha, count);
+}
+
+void applyGainOffset(const double *raw, const float *gain, const float *offset,
+                     double *out, int count) {
+  kernels().applyGainOffset(raw, gain, offset, out, count);
+}
+
+void minMax(const double *data, int count, double *minOut, double *maxOut) {
+  kernels().minMax(data, count, minOut, maxOut);
+}
+
+}  // namespace SpectralMath
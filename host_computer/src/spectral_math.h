@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// 光谱逐像素运算的向量化内核（不依赖 Qt，可单独用于基准测试）
+// - x86-64：运行时检测 AVX2，不支持时回退到标量实现
+// - AArch64：使用 NEON（AArch64 上 NEON 为必备指令集）
+// - 其它平台：标量实现
+// 首次调用时自动选择当前 CPU 支持的最快实现，也可通过 setActiveIsa() 强制指定
+namespace SpectralMath {
+
+enum class Isa {
+  Scalar,
+  Avx2,
+  Neon
+};
+
+// 当前使用的指令集
+Isa activeIsa();
+
+// 指令集名称（用于日志和基准测试输出）
+const char *isaName(Isa isa);
+
+// 当前 CPU 与编译目标是否支持该指令集
+bool isIsaSupported(Isa isa);
+
+// 强制使用指定指令集，不支持时返回 false 且保持不变
+bool setActiveIsa(Isa isa);
+
+// 逐像素加宽累加：sums[i] += pixels[i]
+void accumulateU16(uint32_t *sums, const uint16_t *pixels, int count);
+
+// 逐像素平方和累加：sumSquares[i] += pixels[i] * pixels[i]
+void accumulateSquaresU16(uint64_t *sumSquares, const uint16_t *pixels, int count);
+
+// 逐像素减去一帧（滑动窗口移出最旧帧）：sums[i] -= pixels[i]
+void subtractU16(uint32_t *sums, const uint16_t *pixels, int count);
+
+// 逐像素减去平方：sumSquares[i] -= pixels[i] * pixels[i]
+void subtractSquaresU16(uint64_t *sumSquares, const uint16_t *pixels, int count);
+
+// 指数移动平均更新：ema[i] += alpha * (pixels[i] - ema[i])
+void emaUpdateU16(double *ema, const uint16_t *pixels, double alpha, int count);
+
+// 预计算增益/偏移的线性校正：out[i] = raw[i] * gain[i] + offset[i]（out 可以与 raw 相同）
+// gain / offset 为 float32（见 SpectralCalibration），按 double 精度做一次乘加
+// AVX2 / NEON 实现使用融合乘加，与标量结果可能有最后一位的舍入差异
+void applyGainOffset(const double *raw, const float *gain, const float *offset,
+                     double *out, int count);
+
+// 水平最小值/最大值，count 必须大于 0
+void minMax(const double *data, int count, double *minOut, double *maxOut);
+
+}  // namespace SpectralMath
@@ -0,0 +1,556 @@
+#include "spectral_preprocessor.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+class SpectralPreprocessor::Step {
+ public:
+  virtual ~Step() = default;
+  virtual int outputSize() const = 0;
+  // in 为构建时的输入长度，out 与 in 不重叠
+  virtual void apply(const float *in, float *out) const = 0;
+  virtual QString describe() const = 0;
+};
+
+namespace {
+
+using Step = SpectralPreprocessor::Step;
+
+bool setError(QString *error, const QString &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+bool readFloatArray(const QJsonValue &value, std::vector<double> *out) {
+  if (!value.isArray()) {
+    return false;
+  }
+  const QJsonArray array = value.toArray();
+  out->clear();
+  out->reserve(static_cast<size_t>(array.size()));
+  for (const QJsonValue &item : array) {
+    if (!item.isDouble()) {
+      return false;
+    }
+    out->push_back(item.toDouble());
+  }
+  return true;
+}
+
+// 选择若干 [start, end) 区间并拼接
+class BandsStep : public Step {
+ public:
+  std::vector<std::pair<int, int>> ranges;
+  int size = 0;
+
+  int outputSize() const override { return size; }
+  void apply(const float *in, float *out) const override {
+    for (const auto &range : ranges) {
+      const int count = range.second - range.first;
+      std::memcpy(out, in + range.first, sizeof(float) * static_cast<size_t>(count));
+      out += count;
+    }
+  }
+  QString describe() const override { return QStringLiteral("bands(%1)").arg(size); }
+};
+
+// Savitzky–Golay 平滑/求导：内部点共用一组卷积系数，两端各 half 个点用单独的系数行
+class SavGolStep : public Step {
+ public:
+  int size = 0;
+  int window = 0;
+  int polyorder = 0;
+  int deriv = 0;
+  std::vector<float> interior;             // window 个系数
+  std::vector<std::vector<float>> left;    // 第 i 个点（i < half）作用在 in[0, window)
+  std::vector<std::vector<float>> right;   // 第 i 个点（倒数 half - i 个）作用在 in[size - window, size)
+
+  int outputSize() const override { return size; }
+  void apply(const float *in, float *out) const override {
+    const int half = window / 2;
+    const int first = half;
+    const int last = size - half;  // 内部点 [first, last)
+    // 按系数展开为 axpy：每一轮都是连续数组上的乘加，可向量化
+    std::fill(out + first, out + last, 0.0f);
+    for (int k = 0; k < window; k++) {
+      const float w = interior[static_cast<size_t>(k)];
+      const float *src = in + k - half;
+      for (int i = first; i < last; i++) {
+        out[i] += w * src[i];
+      }
+    }
+    const float *tail = in + size - window;
+    for (int i = 0; i < half; i++) {
+      float head = 0.0f;
+      float end = 0.0f;
+      const float *wl = left[static_cast<size_t>(i)].data();
+      const float *wr = right[static_cast<size_t>(i)].data();
+      for (int k = 0; k < window; k++) {
+        head += wl[k] * in[k];
+        end += wr[k] * tail[k];
+      }
+      out[i] = head;
+      out[last + i] = end;
+    }
+  }
+  QString describe() const override {
+    return QStringLiteral("savgol(w=%1,p=%2,d=%3)").arg(window).arg(polyorder).arg(deriv);
+  }
+};
+
+// 标准正态变换
+class SnvStep : public Step {
+ public:
+  int size = 0;
+
+  int outputSize() const override { return size; }
+  void apply(const float *in, float *out) const override {
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (int i = 0; i < size; i++) {
+      sum += in[i];
+      sumSq += static_cast<double>(in[i]) * in[i];
+    }
+    const double mean = sum / size;
+    const double variance = std::max(0.0, sumSq / size - mean * mean);
+    const double stdDev = std::sqrt(variance);
+    const float m = static_cast<float>(mean);
+    const float scale = stdDev > 1e-12 ? static_cast<float>(1.0 / stdDev) : 1.0f;
+    for (int i = 0; i < size; i++) {
+      out[i] = (in[i] - m) * scale;
+    }
+  }
+  QString describe() const override { return QStringLiteral("snv"); }
+};
+
+// 多元散射校正：参考光谱的去均值结果与平方和在构建时算好
+class MscStep : public Step {
+ public:
+  int size = 0;
+  std::vector<float> centeredReference;
+  double referenceMean = 0.0;
+  double referenceSumSq = 0.0;
+
+  int outputSize() const override { return size; }
+  void apply(const float *in, float *out) const override {
+    double sum = 0.0;
+    double cross = 0.0;
+    const float *ref = centeredReference.data();
+    for (int i = 0; i < size; i++) {
+      sum += in[i];
+      cross += static_cast<double>(ref[i]) * in[i];
+    }
+    const double mean = sum / size;
+    const double slope = cross / referenceSumSq;
+    // 斜率接近 0（与参考几乎无关）时只去均值，避免放大噪声
+    if (std::fabs(slope) < 1e-12) {
+      const float m = static_cast<float>(mean);
+      for (int i = 0; i < size; i++) {
+        out[i] = in[i] - m;
+      }
+      return;
+    }
+    const float intercept = static_cast<float>(mean - slope * referenceMean);
+    const float scale = static_cast<float>(1.0 / slope);
+    for (int i = 0; i < size; i++) {
+      out[i] = (in[i] - intercept) * scale;
+    }
+  }
+  QString describe() const override { return QStringLiteral("msc"); }
+};
+
+// 波长轴线性插值重采样：每个目标点的左邻下标与权重在构建时算好
+class ResampleStep : public Step {
+ public:
+  std::vector<int> lower;
+  std::vector<float> weight;  // out = in[lower] * (1 - weight) + in[lower + 1] * weight
+
+  int outputSize() const override { return static_cast<int>(lower.size()); }
+  void apply(const float *in, float *out) const override {
+    const int count = static_cast<int>(lower.size());
+    const int *lo = lower.data();
+    const float *w = weight.data();
+    for (int i = 0; i < count; i++) {
+      const float a = in[lo[i]];
+      const float b = in[lo[i] + 1];
+      out[i] = a + (b - a) * w[i];
+    }
+  }
+  QString describe() const override { return QStringLiteral("resample(%1)").arg(static_cast<int>(lower.size())); }
+};
+
+// 求解 (AᵀA) X = Aᵀ，返回 (polyorder + 1) x window 的最小二乘伪逆
+bool savGolPseudoInverse(int window, int polyorder, std::vector<std::vector<double>> *pinv) {
+  const int half = window / 2;
+  const int cols = polyorder + 1;
+  std::vector<std::vector<double>> a(static_cast<size_t>(cols), std::vector<double>(static_cast<size_t>(cols), 0.0));
+  std::vector<std::vector<double>> b(static_cast<size_t>(cols), std::vector<double>(static_cast<size_t>(window), 0.0));
+  for (int k = 0; k < window; k++) {
+    const double t = k - half;
+    std::vector<double> powers(static_cast<size_t>(cols));
+    double p = 1.0;
+    for (int j = 0; j < cols; j++) {
+      powers[static_cast<size_t>(j)] = p;
+      p *= t;
+    }
+    for (int r = 0; r < cols; r++) {
+      b[static_cast<size_t>(r)][static_cast<size_t>(k)] = powers[static_cast<size_t>(r)];
+      for (int c = 0; c < cols; c++) {
+        a[static_cast<size_t>(r)][static_cast<size_t>(c)] += powers[static_cast<size_t>(r)] * powers[static_cast<size_t>(c)];
+      }
+    }
+  }
+  // 列主元高斯消元（AᵀA 对称正定，window > polyorder 时可逆）
+  for (int col = 0; col < cols; col++) {
+    int pivot = col;
+    for (int r = col + 1; r < cols; r++) {
+      if (std::fabs(a[static_cast<size_t>(r)][static_cast<size_t>(col)]) >
+          std::fabs(a[static_cast<size_t>(pivot)][static_cast<size_t>(col)])) {
+        pivot = r;
+      }
+    }
+    if (std::fabs(a[static_cast<size_t>(pivot)][static_cast<size_t>(col)]) < 1e-12) {
+      return false;
+    }
+    std::swap(a[static_cast<size_t>(col)], a[static_cast<size_t>(pivot)]);
+    std::swap(b[static_cast<size_t>(col)], b[static_cast<size_t>(pivot)]);
+    const double diag = a[static_cast<size_t>(col)][static_cast<size_t>(col)];
+    for (int r = 0; r < cols; r++) {
+      if (r == col) {
+        continue;
+      }
+      const double factor = a[static_cast<size_t>(r)][static_cast<size_t>(col)] / diag;
+      if (factor == 0.0) {
+        continue;
+      }
+      for (int c = 0; c < cols; c++) {
+        a[static_cast<size_t>(r)][static_cast<size_t>(c)] -= factor * a[static_cast<size_t>(col)][static_cast<size_t>(c)];
+      }
+      for (int k = 0; k < window; k++) {
+        b[static_cast<size_t>(r)][static_cast<size_t>(k)] -= factor * b[static_cast<size_t>(col)][static_cast<size_t>(k)];
+      }
+    }
+  }
+  for (int r = 0; r < cols; r++) {
+    const double diag = a[static_cast<size_t>(r)][static_cast<size_t>(r)];
+    for (int k = 0; k < window; k++) {
+      b[static_cast<size_t>(r)][static_cast<size_t>(k)] /= diag;
+    }
+  }
+  *pinv = std::move(b);
+  return true;
+}
+
+// 窗口内拟合多项式在 t0（相对窗口中心）处的 deriv 阶导数对应的系数行
+std::vector<float> savGolRow(const std::vector<std::vector<double>> &pinv, int window, int polyorder, int deriv,
+                             double t0, double delta) {
+  std::vector<double> row(static_cast<size_t>(window), 0.0);
+  for (int j = deriv; j <= polyorder; j++) {
+    // d^deriv / dt^deriv (t^j) = j! / (j - deriv)! * t^(j - deriv)
+    double factor = 1.0;
+    for (int m = j - deriv + 1; m <= j; m++) {
+      factor *= m;
+    }
+    factor *= std::pow(t0, j - deriv);
+    for (int k = 0; k < window; k++) {
+      row[static_cast<size_t>(k)] += factor * pinv[static_cast<size_t>(j)][static_cast<size_t>(k)];
+    }
+  }
+  const double scale = 1.0 / std::pow(delta, deriv);
+  std::vector<float> out(static_cast<size_t>(window));
+  for (int k = 0; k < window; k++) {
+    out[static_cast<size_t>(k)] = static_cast<float>(row[static_cast<size_t>(k)] * scale);
+  }
+  return out;
+}
+
+std::unique_ptr<Step> buildBands(const QJsonObject &object, int inputSize, QString *error) {
+  const QJsonValue rangesValue = object.value(QStringLiteral("ranges"));
+  if (!rangesValue.isArray() || rangesValue.toArray().isEmpty()) {
+    setError(error, QStringLiteral("bands 需要非空的 ranges 数组"));
+    return nullptr;
+  }
+  auto step = std::make_unique<BandsStep>();
+  for (const QJsonValue &item : rangesValue.toArray()) {
+    const QJsonArray pair = item.toArray();
+    if (pair.size() != 2 || !pair.at(0).isDouble() || !pair.at(1).isDouble()) {
+      setError(error, QStringLiteral("bands 的每个区间应为 [start, end]"));
+      return nullptr;
+    }
+    const int start = pair.at(0).toInt();
+    const int end = pair.at(1).toInt();
+    if (start < 0 || end > inputSize || start >= end) {
+      setError(error, QStringLiteral("bands 区间 [%1, %2) 超出输入范围 0..%3").arg(start).arg(end).arg(inputSize));
+      return nullptr;
+    }
+    step->ranges.emplace_back(start, end);
+    step->size += end - start;
+  }
+  return step;
+}
+
+std::unique_ptr<Step> buildSavGol(const QJsonObject &object, int inputSize, QString *error) {
+  auto step = std::make_unique<SavGolStep>();
+  step->size = inputSize;
+  step->window = object.value(QStringLiteral("window")).toInt(0);
+  step->polyorder = object.value(QStringLiteral("polyorder")).toInt(-1);
+  step->deriv = object.value(QStringLiteral("deriv")).toInt(0);
+  const double delta = object.value(QStringLiteral("delta")).toDouble(1.0);
+  if (step->window < 3 || step->window % 2 == 0 || step->window > inputSize) {
+    setError(error, QStringLiteral("savgol 的 window 须为不超过 %1 的奇数（>= 3）").arg(inputSize));
+    return nullptr;
+  }
+  if (step->polyorder < 0 || step->polyorder >= step->window) {
+    setError(error, QStringLiteral("savgol 的 polyorder 须满足 0 <= polyorder < window"));
+    return nullptr;
+  }
+  if (step->deriv < 0 || step->deriv > step->polyorder) {
+    setError(error, QStringLiteral("savgol 的 deriv 须满足 0 <= deriv <= polyorder"));
+    return nullptr;
+  }
+  if (!(delta > 0.0)) {
+    setError(error, QStringLiteral("savgol 的 delta 须大于 0"));
+    return nullptr;
+  }
+
+  std::vector<std::vector<double>> pinv;
+  if (!savGolPseudoInverse(step->window, step->polyorder, &pinv)) {
+    setError(error, QStringLiteral("savgol 系数求解失败"));
+    return nullptr;
+  }
+  const int half = step->window / 2;
+  step->interior = savGolRow(pinv, step->window, step->polyorder, step->deriv, 0.0, delta);
+  for (int i = 0; i < half; i++) {
+    step->left.push_back(savGolRow(pinv, step->window, step->polyorder, step->deriv, i - half, delta));
+    step->right.push_back(savGolRow(pinv, step->window, step->polyorder, step->deriv, i + 1, delta));
+  }
+  return step;
+}
+
+std::unique_ptr<Step> buildMsc(const QJsonObject &object, int inputSize, QString *error) {
+  std::vector<double> reference;
+  if (!readFloatArray(object.value(QStringLiteral("reference")), &reference) ||
+      static_cast<int>(reference.size()) != inputSize) {
+    setError(error, QStringLiteral("msc 需要 %1 个点的 reference 数组").arg(inputSize));
+    return nullptr;
+  }
+  auto step = std::make_unique<MscStep>();
+  step->size = inputSize;
+  double sum = 0.0;
+  for (double v : reference) {
+    sum += v;
+  }
+  step->referenceMean = sum / inputSize;
+  step->centeredReference.resize(reference.size());
+  for (size_t i = 0; i < reference.size(); i++) {
+    const double centered = reference[i] - step->referenceMean;
+    step->centeredReference[i] = static_cast<float>(centered);
+    step->referenceSumSq += centered * centered;
+  }
+  if (step->referenceSumSq < 1e-12) {
+    setError(error, QStringLiteral("msc 的 reference 不能是常数"));
+    return nullptr;
+  }
+  return step;
+}
+
+std::unique_ptr<Step> buildResample(const QJsonObject &object, int inputSize, QString *error) {
+  if (inputSize < 2) {
+    setError(error, QStringLiteral("resample 至少需要 2 个输入点"));
+    return nullptr;
+  }
+  std::vector<double> source;
+  if (object.contains(QStringLiteral("sourceWavelengths"))) {
+    if (!readFloatArray(object.value(QStringLiteral("sourceWavelengths")), &source) ||
+        static_cast<int>(source.size()) != inputSize) {
+      setError(error, QStringLiteral("resample 的 sourceWavelengths 须为 %1 个点").arg(inputSize));
+      return nullptr;
+    }
+  } else {
+    std::vector<double> coefficients;
+    if (!readFloatArray(object.value(QStringLiteral("sourceCoefficients")), &coefficients) || coefficients.empty()) {
+      setError(error, QStringLiteral("resample 需要 sourceWavelengths 或 sourceCoefficients"));
+      return nullptr;
+    }
+    source.resize(static_cast<size_t>(inputSize));
+    for (int i = 0; i < inputSize; i++) {
+      double value = 0.0;
+      for (auto it = coefficients.rbegin(); it != coefficients.rend(); ++it) {
+        value = value * i + *it;
+      }
+      source[static_cast<size_t>(i)] = value;
+    }
+  }
+  for (size_t i = 1; i < source.size(); i++) {
+    if (!(source[i] > source[i - 1])) {
+      setError(error, QStringLiteral("resample 的源波长须严格递增"));
+      return nullptr;
+    }
+  }
+
+  std::vector<double> target;
+  if (object.contains(QStringLiteral("targetWavelengths"))) {
+    if (!readFloatArray(object.value(QStringLiteral("targetWavelengths")), &target) || target.empty()) {
+      setError(error, QStringLiteral("resample 的 targetWavelengths 须为非空数组"));
+      return nullptr;
+    }
+  } else {
+    const double start = object.value(QStringLiteral("targetStart")).toDouble();
+    const double stepSize = object.value(QStringLiteral("targetStep")).toDouble();
+    const int count = object.value(QStringLiteral("targetCount")).toInt(0);
+    if (count <= 0 || !(stepSize > 0.0)) {
+      setError(error, QStringLiteral("resample 需要 targetWavelengths 或 targetStart / targetStep / targetCount"));
+      return nullptr;
+    }
+    target.resize(static_cast<size_t>(count));
+    for (int i = 0; i < count; i++) {
+      target[static_cast<size_t>(i)] = start + stepSize * i;
+    }
+  }
+
+  auto step = std::make_unique<ResampleStep>();
+  step->lower.resize(target.size());
+  step->weight.resize(target.size());
+  for (size_t i = 0; i < target.size(); i++) {
+    const double t = target[i];
+    int lo = 0;
+    double w = 0.0;
+    if (t >= source.back()) {
+      lo = inputSize - 2;
+      w = 1.0;
+    } else if (t > source.front()) {
+      lo = static_cast<int>(std::upper_bound(source.begin(), source.end(), t) - source.begin()) - 1;
+      w = (t - source[static_cast<size_t>(lo)]) / (source[static_cast<size_t>(lo) + 1] - source[static_cast<size_t>(lo)]);
+    }
+    step->lower[i] = lo;
+    step->weight[i] = static_cast<float>(w);
+  }
+  return step;
+}
+
+}  // namespace
+
+SpectralPreprocessor::~SpectralPreprocessor() = default;
+
+std::shared_ptr<const SpectralPreprocessor> SpectralPreprocessor::fromJson(const QJsonObject &root, int inputSize,
+                                                                           QString *error) {
+  const QJsonValue stepsValue = root.value(QStringLiteral("steps"));
+  if (!stepsValue.isArray()) {
+    setError(error, QStringLiteral("缺少 steps 数组"));
+    return nullptr;
+  }
+  std::shared_ptr<SpectralPreprocessor> preprocessor(new SpectralPreprocessor());
+  preprocessor->inputSize_ = inputSize;
+  preprocessor->maxSize_ = inputSize;
+  int size = inputSize;
+  const QJsonArray steps = stepsValue.toArray();
+  for (int i = 0; i < steps.size(); i++) {
+    const QJsonObject object = steps.at(i).toObject();
+    const QString type = object.value(QStringLiteral("type")).toString();
+    QString stepError;
+    std::unique_ptr<Step> step;
+    if (type == QStringLiteral("bands")) {
+      step = buildBands(object, size, &stepError);
+    } else if (type == QStringLiteral("savgol")) {
+      step = buildSavGol(object, size, &stepError);
+    } else if (type == QStringLiteral("snv")) {
+      auto snv = std::make_unique<SnvStep>();
+      snv->size = size;
+      step = std::move(snv);
+    } else if (type == QStringLiteral("msc")) {
+      step = buildMsc(object, size, &stepError);
+    } else if (type == QStringLiteral("resample")) {
+      step = buildResample(object, size, &stepError);
+    } else {
+      stepError = QStringLiteral("未知的步骤类型 \"%1\"").arg(type);
+    }
+    if (!step) {
+      setError(error, QStringLiteral("第 %1 步：%2").arg(i + 1).arg(stepError));
+      return nullptr;
+    }
+    size = step->outputSize();
+    if (size <= 0) {
+      setError(error, QStringLiteral("第 %1 步：输出为空").arg(i + 1));
+      return nullptr;
+    }
+    preprocessor->maxSize_ = std::max(preprocessor->maxSize_, size);
+    preprocessor->steps_.push_back(std::move(step));
+  }
+  preprocessor->outputSize_ = size;
+  return preprocessor;
+}
+
+QString SpectralPreprocessor::metadataPathForModel(const QString &modelPath) {
+  const QFileInfo info(modelPath);
+  return info.absolutePath() + QChar('/') + info.completeBaseName() + QStringLiteral(".preprocess.json");
+}
+
+std::shared_ptr<const SpectralPreprocessor> SpectralPreprocessor::loadForModel(const QString &modelPath, int inputSize,
+                                                                               QString *error) {
+  if (error) {
+    error->clear();
+  }
+  const QString path = metadataPathForModel(modelPath);
+  QFile file(path);
+  if (!file.exists()) {
+    return nullptr;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    setError(error, QStringLiteral("%1: %2").arg(path, file.errorString()));
+    return nullptr;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+    setError(error, QStringLiteral("%1: %2").arg(path, parseError.errorString()));
+    return nullptr;
+  }
+  QString buildError;
+  auto preprocessor = fromJson(document.object(), inputSize, &buildError);
+  if (!preprocessor) {
+    setError(error, QStringLiteral("%1: %2").arg(path, buildError));
+  }
+  return preprocessor;
+}
+
+QString SpectralPreprocessor::describe() const {
+  QStringList names;
+  for (const auto &step : steps_) {
+    names << step->describe();
+  }
+  if (names.isEmpty()) {
+    names << QStringLiteral("identity");
+  }
+  return QStringLiteral("%1 (%2→%3)").arg(names.join(QStringLiteral(" → "))).arg(inputSize_).arg(outputSize_);
+}
+
+void SpectralPreprocessor::apply(const float *in, float *out) const {
+  if (steps_.empty()) {
+    std::memcpy(out, in, sizeof(float) * static_cast<size_t>(inputSize_));
+    return;
+  }
+  // 中间结果在两块线程局部缓冲之间交替，最后一步直接写入 out
+  thread_local std::vector<float> ping;
+  thread_local std::vector<float> pong;
+  if (ping.size() < static_cast<size_t>(maxSize_)) {
+    ping.resize(static_cast<size_t>(maxSize_));
+    pong.resize(static_cast<size_t>(maxSize_));
+  }
+  const float *src = in;
+  float *buffers[2] = {ping.data(), pong.data()};
+  for (size_t i = 0; i < steps_.size(); i++) {
+    float *dst = i + 1 == steps_.size() ? out : buffers[i % 2];
+    steps_[i]->apply(src, dst);
+    src = dst;
+  }
+}
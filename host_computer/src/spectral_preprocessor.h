@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QString>
+#include <memory>
+#include <vector>
+
+class QJsonObject;
+
+// 预测前的光谱预处理链：黑白校正之后、提交推理之前执行，每个模型可以有自己的一条链
+// - 配置随模型发布：<模型文件名去掉扩展名>.preprocess.json（例如 spectrum_model.preprocess.json），
+//   不存在时模型直接使用校正后的 1024 点光谱
+// - 加载时把每一步“编译”为固定的内核与系数表（Savitzky–Golay 卷积系数、MSC 参考、重采样下标与权重），
+//   运行时只做连续 float 数组上的乘加，内层循环可由编译器向量化
+// - 波段选择与重采样会缩短输出，交给模型的张量随之变小
+//
+// 配置示例（steps 按顺序执行，每一步的输入长度为上一步的输出长度）：
+// {
+//   "steps": [
+//     { "type": "savgol", "window": 11, "polyorder": 2, "deriv": 1, "delta": 1.0 },
+//     { "type": "snv" },
+//     { "type": "msc", "reference": [ ... ] },
+//     { "type": "bands", "ranges": [[100, 400], [600, 900]] },
+//     { "type": "resample", "sourceWavelengths": [ ... ],
+//       "targetStart": 900.0, "targetStep": 2.0, "targetCount": 300 }
+//   ]
+// }
+// - savgol：与 scipy.signal.savgol_filter(mode="interp") 一致，两端用窗口内拟合的多项式求值
+// - snv：减均值后除以标准差（总体标准差，与 numpy.std 默认一致）
+// - msc：对参考光谱做线性回归 x ≈ a + b * ref，输出 (x - a) / b
+// - bands：按 [start, end) 下标区间拼接
+// - resample：sourceWavelengths（或 sourceCoefficients 多项式，自变量为像素下标）给出当前每个点的波长，
+//   线性插值到 targetWavelengths（或 targetStart / targetStep / targetCount），超出范围取端点值
+class SpectralPreprocessor {
+ public:
+  class Step;
+
+  ~SpectralPreprocessor();
+
+  // 从 JSON 编译预处理链，失败返回空并写入 error
+  static std::shared_ptr<const SpectralPreprocessor> fromJson(const QJsonObject &root, int inputSize,
+                                                              QString *error = nullptr);
+
+  // 模型对应的预处理配置路径
+  static QString metadataPathForModel(const QString &modelPath);
+
+  // 读取模型旁边的预处理配置：文件不存在时返回空且 error 为空；格式错误时返回空并写入 error
+  static std::shared_ptr<const SpectralPreprocessor> loadForModel(const QString &modelPath, int inputSize,
+                                                                  QString *error = nullptr);
+
+  int inputSize() const { return inputSize_; }
+  int outputSize() const { return outputSize_; }
+  QString describe() const;
+
+  // in 为 inputSize() 个点，out 至少 outputSize() 个点（不能与 in 重叠）；可在多个线程同时调用
+  void apply(const float *in, float *out) const;
+
+ private:
+  SpectralPreprocessor() = default;
+
+  int inputSize_ = 0;
+  int outputSize_ = 0;
+  int maxSize_ = 0;  // 各步骤中间结果的最大长度
+  std::vector<std::unique_ptr<Step>> steps_;
+};
+
+using SpectralPreprocessorPtr = std::shared_ptr<const SpectralPreprocessor>;
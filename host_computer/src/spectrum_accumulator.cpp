@@ -0,0 +1,119 @@
+#include "spectrum_accumulator.h"
+#include "spectral_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+SpectrumAccumulator::SpectrumAccumulator(bool trackSquares)
+    : partialCount_(0), count_(0), trackSquares_(trackSquares) {
+  reset();
+}
+
+void SpectrumAccumulator::reset() {
+  std::memset(partial_, 0, sizeof(partial_));
+  std::memset(sums_, 0, sizeof(sums_));
+  std::memset(sumSquares_, 0, sizeof(sumSquares_));
+  partialCount_ = 0;
+  count_ = 0;
+}
+
+void SpectrumAccumulator::add(const uint16_t *pixels) {
+  if (partialCount_ == kMaxPartialCount) {
+    foldPartial();
+  }
+
+  SpectralMath::accumulateU16(partial_, pixels, kPixelCount);
+  if (trackSquares_) {
+    SpectralMath::accumulateSquaresU16(sumSquares_, pixels, kPixelCount);
+  }
+
+  partialCount_++;
+  count_++;
+}
+
+void SpectrumAccumulator::remove(const uint16_t *pixels) {
+  if (count_ == 0) {
+    return;
+  }
+  // 窗口内的和不超过 UINT32_MAX，uint32 分块和上的模运算加减始终得到精确结果
+  SpectralMath::subtractU16(partial_, pixels, kPixelCount);
+  if (trackSquares_) {
+    SpectralMath::subtractSquaresU16(sumSquares_, pixels, kPixelCount);
+  }
+  if (partialCount_ > 0) {
+    partialCount_--;
+  }
+  count_--;
+}
+
+void SpectrumAccumulator::foldPartial() {
+  for (int i = 0; i < kPixelCount; i++) {
+    sums_[i] += partial_[i];
+  }
+  std::memset(partial_, 0, sizeof(partial_));
+  partialCount_ = 0;
+}
+
+void SpectrumAccumulator::mean(double *out) const {
+  const double scale = count_ > 0 ? 1.0 / count_ : 0.0;
+  for (int i = 0; i < kPixelCount; i++) {
+    out[i] = static_cast<double>(sums_[i] + partial_[i]) * scale;
+  }
+}
+
+void SpectrumAccumulator::stdDev(double *out) const {
+  if (!trackSquares_ || count_ < 2) {
+    std::memset(out, 0, sizeof(double) * kPixelCount);
+    return;
+  }
+
+  const double n = count_;
+  for (int i = 0; i < kPixelCount; i++) {
+    const double sum = static_cast<double>(sums_[i] + partial_[i]);
+    const double sumSq = static_cast<double>(sumSquares_[i]);
+    // 样本方差：(Σx² - (Σx)²/n) / (n - 1)，浮点误差可能导致微小负值
+    const double variance = (sumSq - sum * sum / n) / (n - 1.0);
+    out[i] = variance > 0.0 ? std::sqrt(variance) : 0.0;
+  }
+}
+
+SpectrumAccumulator::Quality SpectrumAccumulator::quality(const float *gain, const float *offset,
+                                                           const uint8_t *skip) const {
+  Quality result;
+  if (!trackSquares_ || count_ < 2) {
+    return result;
+  }
+
+  // 只在自适应平均的检查点调用（每几十帧一次），两次 nth_element 的开销远小于累加本身
+  double snr[kPixelCount];
+  double stdError[kPixelCount];
+  int pixels = 0;
+  const double n = count_;
+  const double errorScale = 1.0 / std::sqrt(n);
+  for (int i = 0; i < kPixelCount; i++) {
+    if (skip && skip[i]) {
+      continue;
+    }
+    const double sum = static_cast<double>(sums_[i] + partial_[i]);
+    const double variance = (static_cast<double>(sumSquares_[i]) - sum * sum / n) / (n - 1.0);
+    double signal = sum / n;
+    double error = variance > 0.0 ? std::sqrt(variance) * errorScale : 0.0;
+    if (gain) {
+      signal = signal * gain[i] + (offset ? offset[i] : 0.0);
+      error *= std::fabs(gain[i]);
+    }
+    stdError[pixels] = error;
+    snr[pixels] = error > 0.0 ? std::min(std::fabs(signal) / error, kMaxSnr) : (signal != 0.0 ? kMaxSnr : 0.0);
+    pixels++;
+  }
+  if (pixels == 0) {
+    return result;
+  }
+  const int middle = pixels / 2;
+  std::nth_element(snr, snr + middle, snr + pixels);
+  std::nth_element(stdError, stdError + middle, stdError + pixels);
+  result.snr = snr[middle];
+  result.stdError = stdError[middle];
+  return result;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+#include "spectrum_frame.h"
+
+// 增量式逐像素累加器：每帧到达时立即累加，内存占用恒定，不再缓存整窗数据
+// - 逐像素和先累加到 uint32 分块和中，接近溢出前折叠进 uint64 总和
+// - 可选累加平方和，用于估计逐像素噪声（标准差）
+class SpectrumAccumulator {
+ public:
+  static constexpr int kPixelCount = SpectrumFrame::kPixelCount;
+  // 使用 remove() 的滑动窗口允许的最大帧数（保证分块和不会折叠）
+  static constexpr int kMaxWindowCount = 65536;
+
+  explicit SpectrumAccumulator(bool trackSquares = false);
+
+  // 是否累加平方和（修改后需要 reset() 才能保证结果一致）
+  void setTrackSquares(bool enabled) { trackSquares_ = enabled; }
+  bool tracksSquares() const { return trackSquares_; }
+
+  // 清空全部累加结果
+  void reset();
+
+  // 累加一帧（kPixelCount 个像素）
+  void add(const uint16_t *pixels);
+
+  // 移出一帧之前累加过的数据（滑动窗口用）
+  // 只要 count() 始终不超过 kMaxWindowCount（先 remove 再 add），结果就是精确的
+  void remove(const uint16_t *pixels);
+
+  // 已累加的帧数
+  int count() const { return count_; }
+
+  // 逐像素平均值，count() 为 0 时输出全 0
+  void mean(double *out) const;
+
+  // 逐像素标准差（样本方差开方），需要启用平方和，count() 小于 2 时输出全 0
+  void stdDev(double *out) const;
+
+  // 平均光谱的质量估计（需要启用平方和，count() 小于 2 时均为 0）
+  struct Quality {
+    double snr = 0.0;       // 逐像素 |均值| / 标准误 的中位数
+    double stdError = 0.0;  // 逐像素标准误 σ/√n 的中位数（与 snr 同一单位）
+  };
+  static constexpr double kMaxSnr = 1e9;  // 噪声为 0 的像素按该值计
+
+  // gain / offset 不为空时按黑白校正后的值估计（信号 = 均值 * gain + offset，标准误 × |gain|），
+  // skip 中非 0 的像素（坏像素）不参与统计
+  Quality quality(const float *gain = nullptr, const float *offset = nullptr, const uint8_t *skip = nullptr) const;
+
+ private:
+  // uint32 分块和最多容纳的帧数：65535 * 65537 == UINT32_MAX
+  static constexpr int kMaxPartialCount = 65537;
+
+  // 把 uint32 分块和折叠进 uint64 总和
+  void foldPartial();
+
+  alignas(64) uint32_t partial_[kPixelCount];  // 当前分块的逐像素和
+  alignas(64) uint64_t sums_[kPixelCount];  // 已折叠的逐像素和
+  alignas(64) uint64_t sumSquares_[kPixelCount];  // 逐像素平方和（可选）
+  int partialCount_;  // 当前分块已累加的帧数
+  int count_;  // 总帧数
+  bool trackSquares_;
+};
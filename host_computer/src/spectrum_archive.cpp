@@ -0,0 +1,364 @@
+#include "spectrum_archive.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'P', 'E', 'C', 'A', 'R', 'C', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr qint64 kAlignment = 64;
+constexpr int64_t kNoTime = std::numeric_limits<int64_t>::min();
+
+// 与 CSV 表头相同：光谱按 1000~1600 nm 等间隔采样
+constexpr double kLambdaStart = 1000.0;
+constexpr double kLambdaEnd = 1600.0;
+
+qint64 alignUp(qint64 value) {
+  return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+struct SpectrumArchive::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t sampleType;
+  uint64_t recordCount;
+  uint32_t pointCount;  // 每条光谱的固定步长（点数）
+  uint32_t recordMetaSize;  // sizeof(RecordMeta)，便于以后扩展
+  uint64_t wavelengthOffset;
+  uint64_t metadataOffset;
+  uint64_t spectraOffset;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+  uint8_t reserved[56];
+};
+
+struct SpectrumArchive::RecordMeta {
+  int64_t index;
+  int64_t timeMs;  // 毫秒级 UTC 时间戳，kNoTime 表示时间以文本形式存放
+  double minVal;
+  double maxVal;
+  double moisture;
+  uint32_t length;  // 有效点数（≤ pointCount）
+  uint32_t labelOffset;
+  uint32_t labelSize;
+  uint32_t timeTextOffset;
+  uint32_t timeTextSize;
+  uint32_t reserved;
+};
+
+SpectrumArchive::~SpectrumArchive() {
+  close();
+}
+
+bool SpectrumArchive::write(const QString &filePath, const QVariantList &records, SampleType sampleType,
+                            const SpectrumResolver &spectrumFor, QString *errorString) {
+  return write(filePath, VariantRecordList(records, spectrumFor), sampleType, errorString);
+}
+
+bool SpectrumArchive::write(const QString &filePath, const SpectrumRecordSource &source, SampleType sampleType,
+                            QString *errorString) {
+  static_assert(sizeof(Header) == 128, "SpectrumArchive header must stay 128 bytes");
+  static_assert(sizeof(RecordMeta) == 64, "SpectrumArchive record meta must stay 64 bytes");
+
+  auto fail = [errorString](const QString &message) {
+    if (errorString) {
+      *errorString = message;
+    }
+    qWarning() << "[SpectrumArchive]" << message;
+    return false;
+  };
+
+  if (filePath.isEmpty()) {
+    return fail(QStringLiteral("empty filePath"));
+  }
+
+  // 第一遍：元数据、字符串表与最大光谱长度（光谱本身在第二遍逐条写出，不整体驻留内存）
+  const qint64 recordCount = source.recordCount();
+  std::vector<RecordMeta> metas(static_cast<size_t>(recordCount));
+  QByteArray strings;
+  int maxLen = 0;
+  auto appendString = [&strings](const QString &text, uint32_t &offset, uint32_t &size) {
+    const QByteArray utf8 = text.toUtf8();
+    offset = static_cast<uint32_t>(strings.size());
+    size = static_cast<uint32_t>(utf8.size());
+    strings.append(utf8);
+  };
+
+  for (qint64 r = 0; r < recordCount; ++r) {
+    const SpectrumRecordInfo info = source.recordInfo(r);
+    RecordMeta &m = metas[static_cast<size_t>(r)];
+    std::memset(&m, 0, sizeof(m));
+    m.index = info.index;
+    m.minVal = info.minVal;
+    m.maxVal = info.maxVal;
+    m.moisture = info.moisture;
+    appendString(info.label, m.labelOffset, m.labelSize);
+
+    const QDateTime dt = info.time.toDateTime();
+    if (info.time.canConvert<QDateTime>() && dt.isValid()) {
+      m.timeMs = dt.toMSecsSinceEpoch();
+    } else {
+      m.timeMs = kNoTime;
+      appendString(info.time.toString(), m.timeTextOffset, m.timeTextSize);
+    }
+
+    m.length = static_cast<uint32_t>(qMax(0, info.length));
+    maxLen = qMax(maxLen, info.length);
+  }
+
+  const qint64 sampleBytes = sampleType == UInt16Samples ? 2 : 4;
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.sampleType = sampleType;
+  header.recordCount = static_cast<uint64_t>(recordCount);
+  header.pointCount = static_cast<uint32_t>(maxLen);
+  header.recordMetaSize = sizeof(RecordMeta);
+  header.wavelengthOffset = static_cast<uint64_t>(alignUp(sizeof(Header)));
+  header.metadataOffset = static_cast<uint64_t>(
+      alignUp(static_cast<qint64>(header.wavelengthOffset) + maxLen * static_cast<qint64>(sizeof(double))));
+  header.spectraOffset = static_cast<uint64_t>(
+      alignUp(static_cast<qint64>(header.metadataOffset) + recordCount * static_cast<qint64>(sizeof(RecordMeta))));
+  header.stringsOffset = static_cast<uint64_t>(
+      alignUp(static_cast<qint64>(header.spectraOffset) + recordCount * maxLen * sampleBytes));
+  header.stringsSize = static_cast<uint64_t>(strings.size());
+
+  QFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    return fail(QStringLiteral("Failed to open file for writing: %1, error: %2").arg(filePath, file.errorString()));
+  }
+
+  auto writeAt = [&file](qint64 offset, const void *data, qint64 size) {
+    // 区段之间的对齐空隙补 0
+    if (file.pos() < offset) {
+      const QByteArray padding(offset - file.pos(), '\0');
+      if (file.write(padding) != padding.size()) {
+        return false;
+      }
+    }
+    return size == 0 || file.write(static_cast<const char *>(data), size) == size;
+  };
+
+  std::vector<double> lambdas(static_cast<size_t>(maxLen));
+  const double step = (maxLen > 1) ? (kLambdaEnd - kLambdaStart) / (maxLen - 1) : 0.0;
+  for (int i = 0; i < maxLen; ++i) {
+    lambdas[static_cast<size_t>(i)] = kLambdaStart + step * i;
+  }
+
+  bool ok = writeAt(0, &header, sizeof(header)) &&
+            writeAt(static_cast<qint64>(header.wavelengthOffset), lambdas.data(),
+                    maxLen * static_cast<qint64>(sizeof(double))) &&
+            writeAt(static_cast<qint64>(header.metadataOffset), metas.data(),
+                    recordCount * static_cast<qint64>(sizeof(RecordMeta)));
+
+  // 第二遍：逐条写出固定步长的光谱
+  QByteArray row(static_cast<int>(maxLen * sampleBytes), '\0');
+  std::vector<double> spectrum(static_cast<size_t>(maxLen));
+  for (qint64 r = 0; ok && r < recordCount; ++r) {
+    std::memset(row.data(), 0, static_cast<size_t>(row.size()));
+    const int n = qBound(0, source.readSpectrum(r, spectrum.data(), maxLen), maxLen);
+    if (sampleType == UInt16Samples) {
+      auto *out = reinterpret_cast<uint16_t *>(row.data());
+      for (int i = 0; i < n; ++i) {
+        const double v = std::round(spectrum[static_cast<size_t>(i)]);
+        out[i] = static_cast<uint16_t>(qBound(0.0, v, 65535.0));
+      }
+    } else {
+      auto *out = reinterpret_cast<float *>(row.data());
+      for (int i = 0; i < n; ++i) {
+        out[i] = static_cast<float>(spectrum[static_cast<size_t>(i)]);
+      }
+    }
+    const qint64 offset = static_cast<qint64>(header.spectraOffset) + r * maxLen * sampleBytes;
+    ok = writeAt(offset, row.constData(), row.size());
+  }
+
+  ok = ok && writeAt(static_cast<qint64>(header.stringsOffset), strings.constData(), strings.size());
+  file.close();
+  if (!ok) {
+    return fail(QStringLiteral("Failed to write archive: %1, error: %2").arg(filePath, file.errorString()));
+  }
+
+  qDebug() << "[SpectrumArchive] Saved archive:" << filePath << ", records:" << recordCount
+           << ", points:" << maxLen << ", sampleType:" << (sampleType == UInt16Samples ? "uint16" : "float32");
+  return true;
+}
+
+bool SpectrumArchive::open(const QString &filePath, QString *errorString) {
+  close();
+  auto fail = [this, errorString](const QString &message) {
+    if (errorString) {
+      *errorString = message;
+    }
+    qWarning() << "[SpectrumArchive]" << message;
+    close();
+    return false;
+  };
+
+  file_.setFileName(filePath);
+  if (!file_.open(QIODevice::ReadOnly)) {
+    return fail(QStringLiteral("Failed to open archive: %1, error: %2").arg(filePath, file_.errorString()));
+  }
+  size_ = file_.size();
+  if (size_ < static_cast<qint64>(sizeof(Header))) {
+    return fail(QStringLiteral("Archive too small: %1").arg(filePath));
+  }
+
+  // 只建立映射，光谱页在首次访问时才由内核读入
+  data_ = file_.map(0, size_);
+  if (!data_) {
+    return fail(QStringLiteral("Failed to mmap archive: %1, error: %2").arg(filePath, file_.errorString()));
+  }
+  header_ = reinterpret_cast<const Header *>(data_);
+
+  if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) {
+    return fail(QStringLiteral("Not a spectrum archive: %1").arg(filePath));
+  }
+  if (header_->version != kVersion || header_->recordMetaSize != sizeof(RecordMeta) ||
+      header_->sampleType > UInt16Samples) {
+    return fail(QStringLiteral("Unsupported archive version: %1").arg(header_->version));
+  }
+
+  // 各区段必须完整落在文件内（用无符号除法避免乘法溢出）
+  const uint64_t fileSize = static_cast<uint64_t>(size_);
+  const uint64_t sampleBytes = header_->sampleType == UInt16Samples ? 2 : 4;
+  auto fits = [fileSize](uint64_t offset, uint64_t count, uint64_t elemSize) {
+    if (offset > fileSize) {
+      return false;
+    }
+    return elemSize == 0 || count <= (fileSize - offset) / elemSize;
+  };
+  const uint64_t stride = static_cast<uint64_t>(header_->pointCount) * sampleBytes;
+  if (!fits(header_->wavelengthOffset, header_->pointCount, sizeof(double)) ||
+      !fits(header_->metadataOffset, header_->recordCount, sizeof(RecordMeta)) ||
+      !fits(header_->spectraOffset, header_->recordCount, stride) ||
+      !fits(header_->stringsOffset, header_->stringsSize, 1)) {
+    return fail(QStringLiteral("Archive truncated or corrupt: %1").arg(filePath));
+  }
+
+  qDebug() << "[SpectrumArchive] Opened archive:" << filePath << ", records:" << header_->recordCount
+           << ", points:" << header_->pointCount;
+  return true;
+}
+
+void SpectrumArchive::close() {
+  if (data_) {
+    file_.unmap(data_);
+  }
+  data_ = nullptr;
+  header_ = nullptr;
+  size_ = 0;
+  if (file_.isOpen()) {
+    file_.close();
+  }
+}
+
+qint64 SpectrumArchive::recordCount() const {
+  return header_ ? static_cast<qint64>(header_->recordCount) : 0;
+}
+
+int SpectrumArchive::pointCount() const {
+  return header_ ? static_cast<int>(header_->pointCount) : 0;
+}
+
+SpectrumArchive::SampleType SpectrumArchive::sampleType() const {
+  return header_ ? static_cast<SampleType>(header_->sampleType) : Float32Samples;
+}
+
+QVariantList SpectrumArchive::wavelengths() const {
+  QVariantList result;
+  if (!header_) {
+    return result;
+  }
+  const auto *lambdas = reinterpret_cast<const double *>(data_ + header_->wavelengthOffset);
+  result.reserve(static_cast<int>(header_->pointCount));
+  for (uint32_t i = 0; i < header_->pointCount; ++i) {
+    result.append(lambdas[i]);
+  }
+  return result;
+}
+
+const SpectrumArchive::RecordMeta *SpectrumArchive::meta(qint64 i) const {
+  if (!header_ || i < 0 || i >= recordCount()) {
+    return nullptr;
+  }
+  return reinterpret_cast<const RecordMeta *>(data_ + header_->metadataOffset) + i;
+}
+
+QString SpectrumArchive::stringAt(uint32_t offset, uint32_t size) const {
+  if (static_cast<uint64_t>(offset) + size > header_->stringsSize) {
+    return QString();
+  }
+  return QString::fromUtf8(reinterpret_cast<const char *>(data_ + header_->stringsOffset + offset),
+                           static_cast<qsizetype>(size));
+}
+
+QVariantMap SpectrumArchive::metadata(qint64 i) const {
+  return meta(i) ? recordInfo(i).toVariantMap() : QVariantMap();
+}
+
+SpectrumRecordInfo SpectrumArchive::recordInfo(qint64 i) const {
+  SpectrumRecordInfo info;
+  const RecordMeta *m = meta(i);
+  if (!m) {
+    return info;
+  }
+  if (m->timeMs != kNoTime) {
+    info.time = QDateTime::fromMSecsSinceEpoch(m->timeMs);
+  } else {
+    info.time = stringAt(m->timeTextOffset, m->timeTextSize);
+  }
+  info.index = m->index;
+  info.label = stringAt(m->labelOffset, m->labelSize);
+  info.length = static_cast<int>(qMin(m->length, header_->pointCount));
+  info.minVal = m->minVal;
+  info.maxVal = m->maxVal;
+  info.moisture = m->moisture;
+  return info;
+}
+
+int SpectrumArchive::readSpectrum(qint64 i, double *out, int maxPoints) const {
+  const RecordMeta *m = meta(i);
+  if (!m) {
+    return 0;
+  }
+  const int n = qMin(static_cast<int>(qMin(m->length, header_->pointCount)), maxPoints);
+  const uchar *row = data_ + header_->spectraOffset;
+  if (header_->sampleType == UInt16Samples) {
+    const auto *values = reinterpret_cast<const uint16_t *>(row) + i * header_->pointCount;
+    for (int k = 0; k < n; ++k) {
+      out[k] = values[k];
+    }
+  } else {
+    const auto *values = reinterpret_cast<const float *>(row) + i * header_->pointCount;
+    for (int k = 0; k < n; ++k) {
+      out[k] = values[k];
+    }
+  }
+  return n;
+}
+
+QVariantList SpectrumArchive::spectrum(qint64 i) const {
+  QVariantList result;
+  const RecordMeta *m = meta(i);
+  if (!m) {
+    return result;
+  }
+  std::vector<double> values(qMin(m->length, header_->pointCount));
+  const int n = readSpectrum(i, values.data(), static_cast<int>(values.size()));
+  result.reserve(n);
+  for (int k = 0; k < n; ++k) {
+    result.append(values[static_cast<size_t>(k)]);
+  }
+  return result;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+#include <cstdint>
+#include <functional>
+
+#include "spectrum_record.h"
+
+// 二进制列式光谱归档（.spa），可通过 mmap 打开，按需读取单条光谱
+//
+// 文件布局（小端，各区段按 64 字节对齐）：
+//   [文件头 Header]
+//   [波长轴]      pointCount × float64（nm）
+//   [元数据表]    recordCount × RecordMeta（index / time / length / minVal / maxVal / moisture / 字符串引用）
+//   [光谱块]      recordCount × pointCount × 采样类型（float32 或 uint16），固定步长，短光谱补 0
+//   [字符串表]    UTF-8 的标签与无法解析为时间的时间文本
+// 打开后本身也是 SpectrumRecordSource，可直接再导出为 CSV 或另一份归档
+class SpectrumArchive : public SpectrumRecordSource {
+ public:
+  enum SampleType : uint32_t {
+    Float32Samples = 0,
+    UInt16Samples = 1  // 原始计数值，写入时四舍五入并截断到 [0, 65535]
+  };
+
+  SpectrumArchive() = default;
+  ~SpectrumArchive() override;
+  SpectrumArchive(const SpectrumArchive &) = delete;
+  SpectrumArchive &operator=(const SpectrumArchive &) = delete;
+
+  // 流式写入归档：元数据先读一遍确定步长，光谱第二遍逐条取出写入，内存中只保留一条光谱
+  static bool write(const QString &filePath, const SpectrumRecordSource &source, SampleType sampleType,
+                    QString *errorString = nullptr);
+
+  // 写入归档，records 的格式与 SpectrumFileManager::saveAllSpectraTableToCsv 相同
+  // 记录中没有 spectrum 时调用 spectrumFor(record) 获取（用于延迟加载的归档记录）
+  using SpectrumResolver = VariantRecordList::SpectrumResolver;
+  static bool write(const QString &filePath, const QVariantList &records, SampleType sampleType,
+                    const SpectrumResolver &spectrumFor = SpectrumResolver(),
+                    QString *errorString = nullptr);
+
+  // 以只读 mmap 方式打开，只校验文件头与各区段范围，不读取光谱数据
+  bool open(const QString &filePath, QString *errorString = nullptr);
+  void close();
+  bool isOpen() const { return data_ != nullptr; }
+  QString filePath() const { return file_.fileName(); }
+
+  qint64 recordCount() const override;
+  int pointCount() const;
+  SampleType sampleType() const;
+  QVariantList wavelengths() const;
+
+  // 单条记录的元数据（不含光谱），键与 CSV 导入的记录相同
+  QVariantMap metadata(qint64 i) const;
+  SpectrumRecordInfo recordInfo(qint64 i) const override;
+  // 单条光谱，只访问该记录所在的页
+  QVariantList spectrum(qint64 i) const;
+  // 把单条光谱（length 个点）写入 out，返回点数
+  int readSpectrum(qint64 i, double *out, int maxPoints) const override;
+
+ private:
+  struct Header;
+  struct RecordMeta;
+
+  const RecordMeta *meta(qint64 i) const;
+  QString stringAt(uint32_t offset, uint32_t size) const;
+
+  QFile file_;
+  uchar *data_ = nullptr;
+  qint64 size_ = 0;
+  const Header *header_ = nullptr;
+};
@@ -1,4 +1,5 @@
 #include "spectrum_file_manager.h"
+#include "spectrum_archive.h"
 
 #include <QDateTime>
 #include <QDebug>
@@ -9,6 +10,8 @@
 SpectrumFileManager::SpectrumFileManager(QObject *parent)
     : QObject(parent) {}
 
+SpectrumFileManager::~SpectrumFileManager() = default;
+
 bool SpectrumFileManager::saveSpectrumToCsv(const QVariantList &spectrum,
                                             const QString &filePath) {
   if (filePath.isEmpty()) {
@@ -91,6 +94,10 @@ QVariantList SpectrumFileManager::loadSpectrumFromCsv(const QString &filePath) {
 
 bool SpectrumFileManager::saveAllSpectraTableToCsv(const QVariantList &records,
                                                    const QString &filePath) {
+  return saveSpectraTableToCsv(VariantRecordList(records), filePath);
+}
+
+bool SpectrumFileManager::saveSpectraTableToCsv(const SpectrumRecordSource &source, const QString &filePath) {
   if (filePath.isEmpty()) {
     qWarning() << "[SpectrumFileManager] saveAllSpectraTableToCsv: empty filePath";
     return false;
@@ -104,13 +111,10 @@ bool SpectrumFileManager::saveAllSpectraTableToCsv(const QVariantList &records,
   }
 
   // 计算所有记录中光谱的最大长度，用于决定光谱列数
+  const qint64 recordCount = source.recordCount();
   int maxLen = 0;
-  for (const QVariant &recVar : records) {
-    const QVariantMap recMap = recVar.toMap();
-    const QVariantList spectrum = recMap.value(QStringLiteral("spectrum")).toList();
-    if (spectrum.size() > maxLen) {
-      maxLen = spectrum.size();
-    }
+  for (qint64 r = 0; r < recordCount; ++r) {
+    maxLen = qMax(maxLen, source.recordInfo(r).length);
   }
 
   QTextStream out(&file);
@@ -132,50 +136,41 @@ bool SpectrumFileManager::saveAllSpectraTableToCsv(const QVariantList &records,
   }
   out << "\n";
 
-  // 每条记录一行
-  for (const QVariant &recVar : records) {
-    const QVariantMap recMap = recVar.toMap();
-    const int index = recMap.value(QStringLiteral("index")).toInt();
-    QString label = recMap.value(QStringLiteral("label")).toString();
+  // 每条记录一行，光谱逐条读入同一块缓冲
+  std::vector<double> spectrum(static_cast<size_t>(maxLen));
+  for (qint64 r = 0; r < recordCount; ++r) {
+    const SpectrumRecordInfo info = source.recordInfo(r);
+    QString label = info.label;
 
     QString timeStr;
-    const QVariant timeVar = recMap.value(QStringLiteral("time"));
-    if (timeVar.canConvert<QDateTime>()) {
-      const QDateTime dt = timeVar.toDateTime();
+    if (info.time.canConvert<QDateTime>()) {
+      const QDateTime dt = info.time.toDateTime();
       timeStr = dt.toString(Qt::ISODate);
     } else {
       // 退化为直接 toString
-      timeStr = timeVar.toString();
+      timeStr = info.time.toString();
     }
 
-    const int length = recMap.value(QStringLiteral("length")).toInt();
-    const double minVal = recMap.value(QStringLiteral("minVal")).toDouble();
-    const double maxVal = recMap.value(QStringLiteral("maxVal")).toDouble();
-    const double moisture = recMap.value(QStringLiteral("moisture")).toDouble();
-    const QVariantList spectrum = recMap.value(QStringLiteral("spectrum")).toList();
+    const int points = qBound(0, source.readSpectrum(r, spectrum.data(), maxLen), maxLen);
 
     // 为了不修改原始字符串，这里用局部变量做转义
     label.replace("\"", "\"\"");
     timeStr.replace("\"", "\"\"");
 
     // 先写前几列元数据（用引号包裹 label 和 time，避免逗号影响）
-    out << index << ",";
+    out << info.index << ",";
     out << "\"" << label << "\",";
     out << "\"" << timeStr << "\",";
-    out << length << ",";
-    out << minVal << ",";
-    out << maxVal << ",";
-    out << moisture;
+    out << info.length << ",";
+    out << info.minVal << ",";
+    out << info.maxVal << ",";
+    out << info.moisture;
 
     // 再写光谱数据列
     for (int i = 0; i < maxLen; ++i) {
       out << ",";
-      if (i < spectrum.size()) {
-        bool ok = false;
-        const double value = spectrum[i].toDouble(&ok);
-        if (ok) {
-          out << value;
-        }
+      if (i < points) {
+        out << spectrum[static_cast<size_t>(i)];
       }
     }
     out << "\n";
@@ -183,12 +178,12 @@ bool SpectrumFileManager::saveAllSpectraTableToCsv(const QVariantList &records,
 
   file.close();
   qDebug() << "[SpectrumFileManager] Saved all spectra table to CSV:" << filePath
-           << ", records:" << records.size() << ", maxLen:" << maxLen;
+           << ", records:" << recordCount << ", maxLen:" << maxLen;
   return true;
 }
 
 // 简单 CSV 行解析器，支持双引号包裹、双引号转义 "" -> "
-static QStringList splitCsvLine(const QString &line) {
+QStringList SpectrumFileManager::splitCsvLine(const QString &line) {
   QStringList result;
   QString current;
   bool inQuotes = false;
@@ -217,33 +212,50 @@ static QStringList splitCsvLine(const QString &line) {
 
 QVariantList SpectrumFileManager::loadAllSpectraTableFromCsv(const QString &filePath) {
   QVariantList records;
+  readSpectraTable(filePath, [&records](const SpectrumRecordInfo &info, const double *values, int points) {
+    QVariantList spectrum;
+    spectrum.reserve(points);
+    for (int i = 0; i < points; ++i) {
+      spectrum.append(values[i]);
+    }
+    QVariantMap recMap = info.toVariantMap();
+    recMap.insert(QStringLiteral("spectrum"), spectrum);
+    records.append(recMap);
+  });
+  qDebug() << "[SpectrumFileManager] Loaded all spectra table from CSV:" << filePath
+           << ", records:" << records.size();
+  return records;
+}
 
+qint64 SpectrumFileManager::readSpectraTable(const QString &filePath, const TableRowHandler &onRecord) {
   if (filePath.isEmpty()) {
     qWarning() << "[SpectrumFileManager] loadAllSpectraTableFromCsv: empty filePath";
-    return records;
+    return -1;
   }
 
   QFile file(filePath);
   if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
     qWarning() << "[SpectrumFileManager] Failed to open file for reading (all spectra table):"
                << filePath << ", error:" << file.errorString();
-    return records;
+    return -1;
   }
 
   QTextStream in(&file);
   const QString headerLine = in.readLine();
   if (headerLine.isEmpty()) {
     qWarning() << "[SpectrumFileManager] CSV table file is empty:" << filePath;
-    return records;
+    return -1;
   }
 
   const QStringList headerCols = splitCsvLine(headerLine);
   if (headerCols.size() < 7) {
     qWarning() << "[SpectrumFileManager] CSV table header too short, expected at least 7 columns:";
-    return records;
+    return -1;
   }
 
-  // 逐行解析数据
+  // 逐行解析数据，光谱缓冲在各行之间复用
+  qint64 recordCount = 0;
+  std::vector<double> spectrum;
   while (!in.atEnd()) {
     const QString line = in.readLine();
     if (line.trimmed().isEmpty())
@@ -255,79 +267,73 @@ QVariantList SpectrumFileManager::loadAllSpectraTableFromCsv(const QString &file
       continue;
     }
 
+    SpectrumRecordInfo info;
     bool ok = false;
-    const int index = cols[0].trimmed().toInt(&ok);
+    info.index = cols[0].trimmed().toInt(&ok);
     if (!ok) {
       qWarning() << "[SpectrumFileManager] Invalid index value in CSV row, skip:" << cols[0];
       continue;
     }
 
-    const QString label = cols[1];  // 引号已在解析时去掉
+    info.label = cols[1];  // 引号已在解析时去掉
     const QString timeStr = cols[2];
 
-    const int length = cols[3].trimmed().toInt(&ok);
+    info.length = cols[3].trimmed().toInt(&ok);
     if (!ok) {
       qWarning() << "[SpectrumFileManager] Invalid length value in CSV row, skip:" << cols[3];
       continue;
     }
 
-    const double minVal = cols[4].trimmed().toDouble(&ok);
+    info.minVal = cols[4].trimmed().toDouble(&ok);
     if (!ok) {
       qWarning() << "[SpectrumFileManager] Invalid minVal value in CSV row, skip:" << cols[4];
       continue;
     }
 
-    const double maxVal = cols[5].trimmed().toDouble(&ok);
+    info.maxVal = cols[5].trimmed().toDouble(&ok);
     if (!ok) {
       qWarning() << "[SpectrumFileManager] Invalid maxVal value in CSV row, skip:" << cols[5];
       continue;
     }
 
-    const double moisture = cols[6].trimmed().toDouble(&ok);
+    info.moisture = cols[6].trimmed().toDouble(&ok);
     if (!ok) {
       qWarning() << "[SpectrumFileManager] Invalid moisture value in CSV row, set to 0:" << cols[6];
     }
 
     // 光谱数据从第 7 列开始
-    QVariantList spectrum;
+    spectrum.clear();
     for (int i = 7; i < cols.size(); ++i) {
       const QString part = cols[i].trimmed();
       if (part.isEmpty())
         continue;
       const double v = part.toDouble(&ok);
       if (ok) {
-        spectrum.append(v);
+        spectrum.push_back(v);
       } else {
         qWarning() << "[SpectrumFileManager] Invalid spectrum value in CSV row, column" << i << ":" << part;
       }
     }
 
     // 尝试将时间字符串解析为 QDateTime
-    QDateTime dt = QDateTime::fromString(timeStr, Qt::ISODate);
-    QVariant timeVar;
+    const QDateTime dt = QDateTime::fromString(timeStr, Qt::ISODate);
     if (dt.isValid()) {
-      timeVar = dt;
+      info.time = dt;
     } else {
-      timeVar = timeStr;
+      info.time = timeStr;
     }
 
-    QVariantMap recMap;
-    recMap.insert(QStringLiteral("index"), index);
-    recMap.insert(QStringLiteral("label"), label);
-    recMap.insert(QStringLiteral("time"), timeVar);
-    recMap.insert(QStringLiteral("length"), length);
-    recMap.insert(QStringLiteral("minVal"), minVal);
-    recMap.insert(QStringLiteral("maxVal"), maxVal);
-    recMap.insert(QStringLiteral("moisture"), moisture);
-    recMap.insert(QStringLiteral("spectrum"), spectrum);
-
-    records.append(recMap);
+    onRecord(info, spectrum.data(), static_cast<int>(spectrum.size()));
+    ++recordCount;
   }
 
   file.close();
-  qDebug() << "[SpectrumFileManager] Loaded all spectra table from CSV:" << filePath
-           << ", records:" << records.size();
-  return records;
+  return recordCount;
 }
 
-
+bool SpectrumFileManager::saveAllSpectraToArchive(const QVariantList &records, const QString &filePath,
+                                                  bool rawCounts) {
+  const SpectrumArchive::SampleType sampleType =
+      rawCounts ? SpectrumArchive::UInt16Samples : SpectrumArchive::Float32Samples;
+  return SpectrumArchive::write(filePath, records, sampleType);
+}
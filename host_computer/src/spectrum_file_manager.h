@@ -1,13 +1,18 @@
 #pragma once
 
 #include <QObject>
+#include <QStringList>
 #include <QVariantList>
+#include <functional>
+
+#include "spectrum_record.h"
 
 class SpectrumFileManager : public QObject {
   Q_OBJECT
 
 public:
   explicit SpectrumFileManager(QObject *parent = nullptr);
+  ~SpectrumFileManager();
 
   // 将一条光谱保存为 CSV（简单格式：单行，逗号分隔的数值）
   Q_INVOKABLE bool saveSpectrumToCsv(const QVariantList &spectrum,
@@ -22,10 +27,26 @@ public:
   Q_INVOKABLE bool saveAllSpectraTableToCsv(const QVariantList &records,
                                             const QString &filePath);
 
+  // 同上，但从数据源逐条读取记录写出（不需要先构造完整的 QVariantList）
+  static bool saveSpectraTableToCsv(const SpectrumRecordSource &source, const QString &filePath);
+
   // 从表格形式 CSV 中读取全部记录，格式需与 saveAllSpectraTableToCsv 输出一致
   // 返回 QVariantList，每个元素是 QVariantMap，键包括：
   // index, label, time(QDateTime), length, minVal, maxVal, moisture, spectrum(QVariantList)
   Q_INVOKABLE QVariantList loadAllSpectraTableFromCsv(const QString &filePath);
+
+  // 逐行读取表格 CSV，每解析出一条有效记录调用一次 onRecord（spectrum 只在回调期间有效）
+  // 返回读取的记录数，文件无法打开或表头无效时返回 -1
+  using TableRowHandler = std::function<void(const SpectrumRecordInfo &info, const double *spectrum, int points)>;
+  static qint64 readSpectraTable(const QString &filePath, const TableRowHandler &onRecord);
+
+  // 拆分表格 CSV 的一行（支持双引号包裹与 "" 转义），逐行处理大文件时使用
+  static QStringList splitCsvLine(const QString &line);
+
+  // 将全部记录保存为二进制光谱归档（.spa，格式见 spectrum_archive.h）
+  // rawCounts 为 true 时光谱以 uint16 原始计数保存（体积减半，适合未校正数据），否则为 float32
+  Q_INVOKABLE bool saveAllSpectraToArchive(const QVariantList &records, const QString &filePath,
+                                           bool rawCounts = false);
 };
 
 
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QMetaType>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+// 单帧原始光谱数据：一个UDP数据包在接收线程中只解码一次，
+// 之后以只读共享指针的形式在接收线程、处理线程与参考线程之间传递，不再拷贝
+struct alignas(64) SpectrumFrame {
+  static constexpr int kPixelCount = 1024;  // SCL1024 每帧像素数
+
+  uint16_t data[kPixelCount];  // 已转换为主机字节序的原始计数值
+  int count = 0;               // 实际有效点数（短包时小于 kPixelCount）
+  quint64 sequence = 0;        // 接收序号（按到达顺序递增）
+  qint64 timestampNs = 0;      // 接收时间戳（CLOCK_MONOTONIC，纳秒）
+  qint64 dispatchNs = 0;       // 分发给下游的时间（同一时基），用于流水线延迟统计
+
+  bool isComplete() const { return count == kPixelCount; }
+
+  // 当前单调时钟时间（纳秒），与 timestampNs 使用同一时基
+  static qint64 nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+  }
+};
+
+using SpectrumFramePtr = std::shared_ptr<const SpectrumFrame>;
+
+Q_DECLARE_METATYPE(SpectrumFramePtr)
@@ -0,0 +1,160 @@
+#include "spectrum_frame_queue.h"
+
+#include <QMutexLocker>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <algorithm>
+
+SpectrumFrameQueue::SpectrumFrameQueue(size_t capacity)
+    : ring_(capacity), eventFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), consumerWaiting_(false),
+      pushed_(0), overflow_(0) {
+}
+
+SpectrumFrameQueue::~SpectrumFrameQueue() {
+  if (eventFd_ >= 0) {
+    close(eventFd_);
+    eventFd_ = -1;
+  }
+}
+
+void SpectrumFrameQueue::pushFrames(const SpectrumFramePtr *frames, int count) {
+  int accepted = 0;
+  for (int i = 0; i < count; ++i) {
+    if (ring_.push(frames[i])) {
+      accepted++;
+    } else {
+      // 消费者跟不上：丢弃新帧，生产者不阻塞
+      overflow_.fetch_add(static_cast<quint64>(count - i), std::memory_order_relaxed);
+      break;
+    }
+  }
+  if (accepted == 0) {
+    return;
+  }
+  pushed_.fetch_add(static_cast<quint64>(accepted), std::memory_order_relaxed);
+
+  // 与消费者的“置等待标志 → 再检查队列”配对，保证不会丢失唤醒
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumerWaiting_.load(std::memory_order_relaxed)) {
+    wake();
+  }
+}
+
+int SpectrumFrameQueue::popFrames(SpectrumFramePtr *out, int maxCount) {
+  return static_cast<int>(ring_.pop(out, static_cast<size_t>(maxCount)));
+}
+
+void SpectrumFrameQueue::waitForFrames() {
+  consumerWaiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring_.emptyApprox() && eventFd_ >= 0) {
+    // 阻塞直到生产者或 wake() 写入 eventfd
+    struct pollfd pfd = {eventFd_, POLLIN, 0};
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+    }
+    drainEventFd();
+  }
+  consumerWaiting_.store(false, std::memory_order_relaxed);
+}
+
+bool SpectrumFrameQueue::beginWait() {
+  consumerWaiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return ring_.emptyApprox();
+}
+
+void SpectrumFrameQueue::endWait(bool readable) {
+  consumerWaiting_.store(false, std::memory_order_relaxed);
+  if (readable && eventFd_ >= 0) {
+    drainEventFd();
+  }
+}
+
+void SpectrumFrameQueue::drainEventFd() {
+  uint64_t counter = 0;
+  // 非阻塞读取：EAGAIN 表示计数已为 0（已经清零），直接返回
+  while (read(eventFd_, &counter, sizeof(counter)) < 0 && errno == EINTR) {
+  }
+}
+
+size_t SpectrumFrameQueue::freeSlotsApprox() const {
+  const size_t used = ring_.sizeApprox();
+  return used < ring_.capacity() ? ring_.capacity() - used : 0;
+}
+
+void SpectrumFrameQueue::wake() {
+  if (eventFd_ >= 0) {
+    uint64_t one = 1;
+    ssize_t ret = write(eventFd_, &one, sizeof(one));
+    (void)ret;
+  }
+}
+
+void SpectrumFrameSinkList::add(const std::shared_ptr<SpectrumFrameSink> &sink) {
+  if (!sink) {
+    return;
+  }
+  QMutexLocker locker(&mutex_);
+  if (std::find(sinks_.begin(), sinks_.end(), sink) == sinks_.end()) {
+    sinks_.push_back(sink);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void SpectrumFrameSinkList::remove(const std::shared_ptr<SpectrumFrameSink> &sink) {
+  QMutexLocker locker(&mutex_);
+  auto it = std::find(sinks_.begin(), sinks_.end(), sink);
+  if (it != sinks_.end()) {
+    sinks_.erase(it);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void SpectrumFrameSinkList::clear() {
+  QMutexLocker locker(&mutex_);
+  sinks_.clear();
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumFrameSinkList::refreshSnapshot() {
+  const quint64 version = version_.load(std::memory_order_acquire);
+  if (version != snapshotVersion_) {
+    // 配置发生变化时才加锁刷新本地快照
+    QMutexLocker locker(&mutex_);
+    snapshot_ = sinks_;
+    snapshotVersion_ = version_.load(std::memory_order_relaxed);
+  }
+}
+
+void SpectrumFrameSinkList::dispatch(const SpectrumFramePtr *frames, int count) {
+  refreshSnapshot();
+  for (const auto &sink : snapshot_) {
+    sink->pushFrames(frames, count);
+  }
+}
+
+size_t SpectrumFrameSinkList::minFreeSlots() {
+  refreshSnapshot();
+  size_t result = SIZE_MAX;
+  for (const auto &sink : snapshot_) {
+    result = std::min(result, sink->freeSlotsApprox());
+  }
+  return result;
+}
+
+size_t SpectrumFrameSinkList::maxBacklog() {
+  refreshSnapshot();
+  size_t result = 0;
+  for (const auto &sink : snapshot_) {
+    result = std::max(result, sink->backlogApprox());
+  }
+  return result;
+}
+
+void SpectrumFrameSinkList::releaseSnapshot() {
+  snapshot_.clear();
+  snapshotVersion_ = ~0ULL;  // 下次 dispatch 时强制刷新
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QMutex>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "spectrum_frame.h"
+#include "spsc_ring.h"
+
+// 光谱帧接收端接口：由接收线程（生产者）直接调用，实现不得阻塞
+class SpectrumFrameSink {
+ public:
+  virtual ~SpectrumFrameSink() = default;
+  virtual void pushFrames(const SpectrumFramePtr *frames, int count) = 0;
+
+  // 剩余容量与积压帧数的近似值，供可以等待的生产者（如回放）实施反压；默认不限制
+  virtual size_t freeSlotsApprox() const { return SIZE_MAX; }
+  virtual size_t backlogApprox() const { return 0; }
+};
+
+// 接收线程 → 处理线程之间的有界无锁帧队列
+// - 生产者写入 SPSC 环后，仅当消费者处于空闲等待状态时才通过 eventfd 唤醒
+// - 队列满时丢弃新帧并累加溢出计数，生产者永远不会被阻塞
+class SpectrumFrameQueue : public SpectrumFrameSink {
+ public:
+  static constexpr size_t kDefaultCapacity = 8192;
+
+  explicit SpectrumFrameQueue(size_t capacity = kDefaultCapacity);
+  ~SpectrumFrameQueue() override;
+
+  // 生产者线程调用
+  void pushFrames(const SpectrumFramePtr *frames, int count) override;
+
+  // 消费者线程调用：取出最多 maxCount 帧，返回实际数量
+  int popFrames(SpectrumFramePtr *out, int maxCount);
+
+  // 消费者线程调用：队列为空时阻塞等待，直到有新帧或 wake() 被调用
+  void waitForFrames();
+
+  // 任意线程调用：唤醒消费者（用于停止线程）
+  void wake();
+
+  // 一个消费者线程同时等待多个队列时（见 SpectrumWorkerPool）：
+  // beginWait() 置等待标志并返回队列是否仍为空，随后在 eventFd() 上与其它队列一起 poll，
+  // 返回后调用 endWait(readable) 清除标志（readable 为 poll 报告该 eventfd 可读）
+  int eventFd() const { return eventFd_; }
+  bool beginWait();
+  void endWait(bool readable);
+
+  quint64 pushedCount() const { return pushed_.load(std::memory_order_relaxed); }
+  quint64 overflowCount() const { return overflow_.load(std::memory_order_relaxed); }
+  size_t sizeApprox() const { return ring_.sizeApprox(); }
+  size_t freeSlotsApprox() const override;
+  size_t backlogApprox() const override { return ring_.sizeApprox(); }
+
+ private:
+  // 清零 eventfd 计数（eventfd 为非阻塞，计数已为 0 时直接返回）
+  void drainEventFd();
+
+  SpscRing<SpectrumFramePtr> ring_;
+  int eventFd_;
+  std::atomic<bool> consumerWaiting_;
+  std::atomic<quint64> pushed_;
+  std::atomic<quint64> overflow_;
+};
+
+// 接收线程持有的接收端列表
+// - 增删接收端可以在任意线程进行（加锁，只在配置变化时发生）
+// - dispatch() 只在生产者线程调用，稳态下只读取一次版本号，不加锁
+class SpectrumFrameSinkList {
+ public:
+  void add(const std::shared_ptr<SpectrumFrameSink> &sink);
+  void remove(const std::shared_ptr<SpectrumFrameSink> &sink);
+  void clear();
+
+  // 生产者线程调用：把一批帧交给当前全部接收端
+  void dispatch(const SpectrumFramePtr *frames, int count);
+
+  // 生产者线程调用：各接收端中最小的剩余容量 / 最大的积压帧数
+  size_t minFreeSlots();
+  size_t maxBacklog();
+
+  // 生产者线程调用：释放本地快照（线程退出时）
+  void releaseSnapshot();
+
+ private:
+  void refreshSnapshot();
+
+  QMutex mutex_;
+  std::vector<std::shared_ptr<SpectrumFrameSink>> sinks_;  // 受 mutex_ 保护
+  std::atomic<quint64> version_{0};
+
+  // 以下仅由生产者线程访问
+  quint64 snapshotVersion_ = 0;
+  std::vector<std::shared_ptr<SpectrumFrameSink>> snapshot_;
+};
@@ -0,0 +1,35 @@
+#include "spectrum_frame_source.h"
+#include "pipeline_stats.h"
+
+SpectrumFrameSource::SpectrumFrameSource(QObject *parent)
+    : QThread(parent), receivedPackets_(0), lastPacketLength_(0) {
+}
+
+void SpectrumFrameSource::addFrameSink(const std::shared_ptr<SpectrumFrameSink> &sink) {
+  sinks_.add(sink);
+}
+
+void SpectrumFrameSource::removeFrameSink(const std::shared_ptr<SpectrumFrameSink> &sink) {
+  sinks_.remove(sink);
+}
+
+void SpectrumFrameSource::dispatchFrames(const SpectrumFramePtr *frames, int count) {
+  if (count <= 0) {
+    return;
+  }
+  // 分发前帧仍只被数据源持有（槽位复用时已确认下游释放），此处补写分发时间戳
+  const qint64 dispatchNs = SpectrumFrame::nowNs();
+  for (int i = 0; i < count; i++) {
+    SpectrumFrame *frame = const_cast<SpectrumFrame *>(frames[i].get());
+    frame->dispatchNs = dispatchNs;
+    PipelineStats::recordFrame(PipelineStats::Receive, frame->timestampNs, dispatchNs, frame->sequence);
+  }
+  receivedPackets_.fetch_add(static_cast<quint64>(count), std::memory_order_relaxed);
+  lastPacketLength_.store(frames[count - 1]->count, std::memory_order_relaxed);
+  sinks_.dispatch(frames, count);
+}
+
+void SpectrumFrameSource::resetCounters() {
+  receivedPackets_ = 0;
+  lastPacketLength_ = 0;
+}
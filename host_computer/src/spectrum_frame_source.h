@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <memory>
+
+#include "spectrum_frame.h"
+#include "spectrum_frame_queue.h"
+
+class LinkStats;
+
+// 光谱帧来源线程的公共基类：UDP 接收线程与录制回放都从这里把帧分发给各接收端
+// UdpCommunicator 只通过这个接口连接处理线程，不关心帧来自网络还是文件
+class SpectrumFrameSource : public QThread {
+  Q_OBJECT
+
+ public:
+  explicit SpectrumFrameSource(QObject *parent = nullptr);
+
+  // 注册/移除帧接收端：来源线程把每批帧直接交给接收端，不经过主线程
+  void addFrameSink(const std::shared_ptr<SpectrumFrameSink> &sink);
+  void removeFrameSink(const std::shared_ptr<SpectrumFrameSink> &sink);
+
+  // 停止来源线程并等待其退出
+  virtual void stopSource() = 0;
+
+  // 统计信息（任意线程读取）
+  quint64 receivedPackets() const { return receivedPackets_.load(std::memory_order_relaxed); }
+  int lastPacketLength() const { return lastPacketLength_.load(std::memory_order_relaxed); }
+
+  // 链路质量统计（只有网络来源提供，回放等来源返回空）
+  virtual const LinkStats *linkStats() const { return nullptr; }
+
+ signals:
+  void statusChanged(const QString &message);
+  void errorOccurred(const QString &error);
+
+ protected:
+  // 来源线程调用：更新统计并把一批帧交给全部接收端
+  void dispatchFrames(const SpectrumFramePtr *frames, int count);
+  void resetCounters();
+
+  SpectrumFrameSinkList sinks_;  // 帧接收端（处理线程的输入队列等）
+
+ private:
+  std::atomic<quint64> receivedPackets_;
+  std::atomic<int> lastPacketLength_;
+};
@@ -2,9 +2,38 @@
 #pragma once
 
 #include <QtCore/QtPlugin>
+#include <QObject>
 #include <QString>
 #include <QVariant>
+#include <cstddef>
+#include <functional>
+#include <memory>
 
+// 宿主提供给预测插件的推理运行时服务（由 SpectrumPredictorManager 持有，见 inference_runtime.h）
+// - 所有插件共用一份固定的 CPU 线程预算，而不是各自按默认值创建线程池
+// - 进程内共享对象：例如第一个 ONNX 插件创建的 Ort::Env（全局线程池），其余插件直接复用
+// 插件与宿主使用同一份推理库（同一个 libonnxruntime.so），共享对象的实际类型由 key 约定
+class InferenceRuntimeService {
+ public:
+  virtual ~InferenceRuntimeService() = default;
+
+  // 推理线程预算：算子内 / 算子间线程数（>= 1）
+  virtual int intraOpThreads() const = 0;
+  virtual int interOpThreads() const = 0;
+  // 线程池空闲时是否自旋等待（自旋降低延迟，但会占满分配的核心）
+  virtual bool allowSpinning() const = 0;
+
+  // 取得 key 对应的共享对象；不存在时调用 factory 创建并保存，此后所有调用返回同一对象
+  // 调用方持有返回的 shared_ptr 即可保证对象存活；factory 返回空时不保存
+  virtual std::shared_ptr<void> sharedObject(const QString &key,
+                                             const std::function<std::shared_ptr<void>()> &factory) = 0;
+
+  // 进程级只能设置一次的全局配置（例如 libtorch 的线程数）：同一 key 的 apply 只执行一次，
+  // 首次执行返回 true
+  virtual bool runOnce(const QString &key, const std::function<void()> &apply) = 0;
+};
+
+// 第 1 版接口：逐条预测
 class SpectrumPredictorPlugin {
  public:
   virtual ~SpectrumPredictorPlugin() = default;
@@ -16,7 +45,63 @@ class SpectrumPredictorPlugin {
   virtual bool isModelLoaded() const = 0;  // 检查模型是否已加载
 };
 
+// 第 2 版接口：在第 1 版基础上增加批量预测
+// - 由 SpectrumPredictorManager 在加载时协商：实现了第 2 版的插件走批量路径，旧插件仍按第 1 版加载
+class SpectrumPredictorPluginV2 : public SpectrumPredictorPlugin {
+ public:
+  // 模型期望的每条光谱点数
+  virtual size_t inputSize() const = 0;
+
+  // 批量预测：data 为 rows × cols 的行优先 float 矩阵，out 至少可容纳 rows 个结果
+  // 一次推理调用完成整批预测，失败时返回 false
+  virtual bool predictBatch(const float *data, size_t rows, size_t cols, float *out) = 0;
+};
+
 #define SpectrumPredictorPlugin_iid "org.demo.SpectrumPredictorPlugin/1.0"
 Q_DECLARE_INTERFACE(SpectrumPredictorPlugin, SpectrumPredictorPlugin_iid)
 
+#define SpectrumPredictorPluginV2_iid "org.demo.SpectrumPredictorPlugin/2.0"
+Q_DECLARE_INTERFACE(SpectrumPredictorPluginV2, SpectrumPredictorPluginV2_iid)
+
+// 扩展接口：与第 1 / 2 版接口相互独立、各自带版本号，插件对象通过 Q_INTERFACES 声明实现了哪些扩展
+// 宿主只在 qobject_cast 到对应扩展成功后才调用其中的函数，未实现的扩展按旧行为处理
+// 新增钩子时另加扩展接口（或提升扩展的版本号），不再修改已发布接口的虚函数表
+
+// 实例工厂扩展：创建一个独立的预测器实例（自己的模型与会话）
+// 热加载与影子模式在后台线程中把新模型加载到新实例上，完成后整体替换在线实例，不触碰正在推理的对象
+class SpectrumPredictorFactory {
+ public:
+  virtual ~SpectrumPredictorFactory() = default;
+
+  // 返回与插件根对象同类的新对象（宿主通过 qobject_cast 取得其接口，调用方负责释放），失败时返回空
+  virtual QObject *createInstance() const = 0;
+};
+
+#define SpectrumPredictorFactory_iid "org.demo.SpectrumPredictorFactory/1.0"
+Q_DECLARE_INTERFACE(SpectrumPredictorFactory, SpectrumPredictorFactory_iid)
+
+// 推理运行时配置扩展（线程数、图优化级别、执行提供者等，键名由插件定义）
+class SpectrumPredictorRuntimeOptions {
+ public:
+  virtual ~SpectrumPredictorRuntimeOptions() = default;
+
+  // 模型已加载时插件用新配置重建会话；配置无效时返回 false 并保持原配置
+  virtual bool setRuntimeOptions(const QVariantMap &options) = 0;
+  virtual QVariantMap runtimeOptions() const = 0;
+};
+
+#define SpectrumPredictorRuntimeOptions_iid "org.demo.SpectrumPredictorRuntimeOptions/1.0"
+Q_DECLARE_INTERFACE(SpectrumPredictorRuntimeOptions, SpectrumPredictorRuntimeOptions_iid)
+
+// 共享运行时扩展：接入宿主的推理运行时与线程预算（见 InferenceRuntimeService）
+class SpectrumPredictorRuntimeInit {
+ public:
+  virtual ~SpectrumPredictorRuntimeInit() = default;
+
+  // 宿主在加载插件（以及 createInstance 创建实例）后、加载模型前调用一次
+  // 未实现该扩展的插件自行创建运行时（旧行为）
+  virtual void initialize(InferenceRuntimeService *runtime) = 0;
+};
 
+#define SpectrumPredictorRuntimeInit_iid "org.demo.SpectrumPredictorRuntimeInit/1.0"
+Q_DECLARE_INTERFACE(SpectrumPredictorRuntimeInit, SpectrumPredictorRuntimeInit_iid)
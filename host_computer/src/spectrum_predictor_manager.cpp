@@ -1,16 +1,66 @@
 #include "spectrum_predictor_manager.h"
+#include "spectrum_frame.h"
 
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
 #include <QDebug>
+#include <cmath>
 
-SpectrumPredictorManager::SpectrumPredictorManager(QObject *parent) : QObject(parent) {
+namespace {
+
+// 接管插件工厂新建的对象：取得其预测器接口填入 slot，对象随 slot 一起释放
+// 对象不是预测器时直接删除并返回 false
+bool adoptInstance(QObject *object, SpectrumPredictorManager::ModelSlot *slot) {
+  auto *batch = qobject_cast<SpectrumPredictorPluginV2 *>(object);
+  SpectrumPredictorPlugin *predictor = batch;
+  if (!predictor) {
+    predictor = qobject_cast<SpectrumPredictorPlugin *>(object);
+  }
+  if (!predictor) {
+    delete object;
+    return false;
+  }
+  slot->predictor = std::shared_ptr<SpectrumPredictorPlugin>(predictor, [object](SpectrumPredictorPlugin *) {
+    delete object;
+  });
+  slot->batch = batch;
+  slot->options = qobject_cast<SpectrumPredictorRuntimeOptions *>(object);
+  return true;
+}
+
+// 插件对象实现了共享运行时扩展时接入宿主的推理运行时（加载模型之前调用）
+void initializeInstance(QObject *object, InferenceRuntimeService *runtime) {
+  if (auto *init = qobject_cast<SpectrumPredictorRuntimeInit *>(object)) {
+    init->initialize(runtime);
+  }
+}
+
+}  // namespace
+
+SpectrumPredictorManager::SpectrumPredictorManager(QObject *parent)
+    : QObject(parent), runtime_(std::make_unique<InferenceRuntime>()) {
+  loaderPool_.setMaxThreadCount(1);
+  // 线程预算需在插件初始化之前确定
+  QString runtimeError;
+  if (!runtime_->load(InferenceRuntime::defaultConfigPath(), &runtimeError)) {
+    qWarning() << "推理运行时配置无效，使用默认值:" << runtimeError;
+  }
+  qDebug() << "推理运行时:" << runtime_->describe();
   loadPredictors();
+  executor_ = std::make_unique<InferenceExecutor>(this);
+  connect(executor_.get(), &InferenceExecutor::shadowPredictionReady, this,
+          &SpectrumPredictorManager::recordShadowPrediction);
+  executor_->start();
 }
 
 SpectrumPredictorManager::~SpectrumPredictorManager() {
+  // 等待后台加载结束，再停止推理线程，最后释放模型实例并卸载插件
+  loaderPool_.waitForDone();
+  executor_->stopProcessing();
+  executor_.reset();
   predictors_.clear();
+  runtime_->clear();
 }
 
 QStringList SpectrumPredictorManager::predictorNames() const {
@@ -22,34 +72,229 @@ QStringList SpectrumPredictorManager::predictorNames() const {
   return names;
 }
 
-bool SpectrumPredictorManager::hasPredictors() const { 
-  return !predictors_.empty(); 
+bool SpectrumPredictorManager::hasPredictors() const {
+  return !predictors_.empty();
 }
 
-bool SpectrumPredictorManager::loadModel(int index, const QString &modelPath) {
+SpectrumPredictorManager::ModelSlotPtr SpectrumPredictorManager::liveSlot(int index) const {
   if (index < 0 || index >= static_cast<int>(predictors_.size())) {
-    qWarning() << "预测器索引无效:" << index;
-    emit modelLoaded(index, false);
-    return false;
+    return nullptr;
   }
+  return std::atomic_load(&predictors_[static_cast<std::size_t>(index)].live);
+}
 
-  auto *predictor = predictors_[static_cast<std::size_t>(index)].instance;
-  if (!predictor) {
-    qWarning() << "预测器实例无效";
-    emit modelLoaded(index, false);
-    return false;
+SpectrumPredictorManager::ModelSlotPtr SpectrumPredictorManager::shadowSlot(int index) const {
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return nullptr;
+  }
+  return std::atomic_load(&predictors_[static_cast<std::size_t>(index)].shadow);
+}
+
+SpectrumPredictorManager::ModelSlotPtr SpectrumPredictorManager::buildSlot(int index, const QString &modelPath,
+                                                                          bool freshInstance, QString *error) const {
+  auto fail = [error](const QString &message) {
+    if (error) {
+      *error = message;
+    }
+    return ModelSlotPtr();
+  };
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return fail(QStringLiteral("预测器索引无效: %1").arg(index));
+  }
+  const LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  if (!lp.instance) {
+    return fail(QStringLiteral("预测器实例无效"));
+  }
+  if (modelPath.isEmpty()) {
+    return fail(QStringLiteral("模型路径为空"));
+  }
+
+  // 预处理配置与模型文件无关，先读取，格式错误时不必加载模型
+  QString preprocessError;
+  SpectralPreprocessorPtr chain = SpectralPreprocessor::loadForModel(modelPath, SpectrumFrame::kPixelCount,
+                                                                     &preprocessError);
+  if (!chain && !preprocessError.isEmpty()) {
+    return fail(QStringLiteral("预处理配置无效: %1").arg(preprocessError));
   }
 
-  bool success = predictor->loadModel(modelPath);
-  emit modelLoaded(index, success);
-  
-  if (success) {
-    qDebug() << "模型加载成功:" << modelPath << "预测器:" << predictor->name();
+  auto slot = std::make_shared<ModelSlot>();
+  slot->preprocessor = chain;
+  slot->modelPath = modelPath;
+  QObject *created = lp.factory ? lp.factory->createInstance() : nullptr;
+  if (created) {
+    if (!adoptInstance(created, slot.get())) {
+      return fail(QStringLiteral("插件创建的实例不是预测器: %1").arg(lp.displayName));
+    }
+    initializeInstance(created, runtime_.get());
+    // 新实例沿用在线实例的运行时配置（线程数、执行提供者等）
+    const ModelSlotPtr current = liveSlot(index);
+    if (slot->options && current && current->options) {
+      slot->options->setRuntimeOptions(current->baseOptions.isEmpty() ? current->options->runtimeOptions()
+                                                                       : current->baseOptions);
+    }
+  } else if (freshInstance) {
+    return fail(QStringLiteral("插件不支持创建独立实例: %1").arg(lp.displayName));
   } else {
-    qWarning() << "模型加载失败:" << modelPath;
+    // 不支持实例工厂的插件：在根实例上重新加载（插件负责在内部替换会话），此时无法在上线前校验与预热
+    slot->predictor = std::shared_ptr<SpectrumPredictorPlugin>(lp.instance, [](SpectrumPredictorPlugin *) {});
+    slot->batch = lp.batchInstance;
+    slot->options = lp.options;
   }
-  
-  return success;
+
+  if (!slot->predictor->loadModel(modelPath)) {
+    return fail(QStringLiteral("模型加载失败: %1").arg(modelPath));
+  }
+
+  // 第 2 版插件可以报告模型的输入长度，与预处理输出不一致时拒绝加载，避免每次推理都失败
+  const size_t expected = chain ? static_cast<size_t>(chain->outputSize())
+                                : static_cast<size_t>(SpectrumFrame::kPixelCount);
+  if (slot->batch && slot->batch->inputSize() != expected) {
+    return fail(QStringLiteral("模型输入长度 %1 与预处理输出长度 %2 不一致")
+                    .arg(static_cast<qulonglong>(slot->batch->inputSize()))
+                    .arg(static_cast<qulonglong>(expected)));
+  }
+
+  if (!warmUp(*slot)) {
+    return fail(QStringLiteral("预热推理失败: %1").arg(modelPath));
+  }
+  if (chain) {
+    qDebug() << "预处理链:" << chain->describe();
+  }
+
+  // 快速模型：配置无效或精度不达标时只告警，原模型照常上线
+  QString fastError;
+  const FastModelSpecPtr fastSpec = FastModelSpec::loadForModel(modelPath, SpectrumFrame::kPixelCount, &fastError);
+  if (fastSpec) {
+    FastModelSpec::Report report;
+    std::shared_ptr<ModelSlot> fast = buildFastSlot(index, *slot, *fastSpec, &report, &fastError);
+    QVariantMap status = report.toVariantMap();
+    status.insert(QStringLiteral("model"), fastSpec->modelPath());
+    status.insert(QStringLiteral("adopted"), fast != nullptr);
+    if (fast) {
+      qDebug() << "采用快速模型:" << fastSpec->modelPath() << report.describe();
+      slot = std::move(fast);
+    } else {
+      qWarning() << "快速模型未采用，使用原模型:" << fastError;
+      status.insert(QStringLiteral("error"), fastError);
+    }
+    slot->fastModel = status;
+  } else if (!fastError.isEmpty()) {
+    qWarning() << "快速模型配置无效，使用原模型:" << fastError;
+    QVariantMap status;
+    status.insert(QStringLiteral("adopted"), false);
+    status.insert(QStringLiteral("error"), fastError);
+    slot->fastModel = status;
+  }
+  return slot;
+}
+
+std::shared_ptr<SpectrumPredictorManager::ModelSlot> SpectrumPredictorManager::buildFastSlot(
+    int index, const ModelSlot &baseline, const FastModelSpec &spec, FastModelSpec::Report *report,
+    QString *error) const {
+  auto fail = [error](const QString &message) {
+    if (error) {
+      *error = message;
+    }
+    return std::shared_ptr<ModelSlot>();
+  };
+  const LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  if (!lp.batchInstance || !baseline.batch) {
+    return fail(QStringLiteral("第 1 版插件不支持快速模型"));
+  }
+  // 原模型与快速模型需要同时在线比较，必须是独立实例
+  QObject *object = lp.factory ? lp.factory->createInstance() : nullptr;
+  if (!object) {
+    return fail(QStringLiteral("插件不支持创建独立实例: %1").arg(lp.displayName));
+  }
+  auto fast = std::make_shared<ModelSlot>();
+  if (!adoptInstance(object, fast.get()) || !fast->batch) {
+    return fail(QStringLiteral("插件创建的实例不支持批量预测: %1").arg(lp.displayName));
+  }
+  SpectrumPredictorPluginV2 *created = fast->batch;
+  initializeInstance(object, runtime_.get());
+  fast->preprocessor = baseline.preprocessor;
+  fast->modelPath = baseline.modelPath;
+
+  // 沿用原模型实例的运行时配置，再叠加快速模型自己的配置（精度、推理优化等）
+  fast->baseOptions = baseline.options ? baseline.options->runtimeOptions() : QVariantMap();
+  QVariantMap options = fast->baseOptions;
+  for (auto it = spec.options().constBegin(); it != spec.options().constEnd(); ++it) {
+    options.insert(it.key(), it.value());
+  }
+  // 未实现运行时配置扩展的插件只能使用空配置
+  if (fast->options ? !fast->options->setRuntimeOptions(options) : !options.isEmpty()) {
+    return fail(QStringLiteral("快速模型运行时配置无效"));
+  }
+  if (!created->loadModel(spec.modelPath())) {
+    return fail(QStringLiteral("快速模型加载失败: %1").arg(spec.modelPath()));
+  }
+  const size_t cols = baseline.batch->inputSize();
+  if (created->inputSize() != cols) {
+    return fail(QStringLiteral("快速模型输入长度 %1 与原模型 %2 不一致")
+                    .arg(static_cast<qulonglong>(created->inputSize()))
+                    .arg(static_cast<qulonglong>(cols)));
+  }
+
+  // 参考集与推理时的输入相同（校正后的光谱），先经过模型的预处理链
+  const size_t rows = static_cast<size_t>(spec.referenceRows());
+  std::vector<float> transformed;
+  const float *inputs = spec.referenceData();
+  if (baseline.preprocessor) {
+    transformed.resize(rows * cols);
+    for (size_t r = 0; r < rows; r++) {
+      baseline.preprocessor->apply(inputs + r * static_cast<size_t>(spec.inputSize()), transformed.data() + r * cols);
+    }
+    inputs = transformed.data();
+  } else if (static_cast<size_t>(spec.inputSize()) != cols) {
+    return fail(QStringLiteral("参考集光谱长度与模型输入长度不一致"));
+  }
+  std::vector<float> expected(rows, 0.0f);
+  std::vector<float> actual(rows, 0.0f);
+  if (!predictWithSlot(baseline, inputs, rows, cols, expected.data()) ||
+      !predictWithSlot(*fast, inputs, rows, cols, actual.data())) {
+    return fail(QStringLiteral("参考集推理失败"));
+  }
+  *report = spec.compare(expected.data(), actual.data());
+  if (!report->passed) {
+    return fail(QStringLiteral("精度超出容差（最大绝对误差 ≤ %1%2）: %3")
+                    .arg(spec.maxAbsError())
+                    .arg(spec.maxMeanAbsError() > 0.0
+                             ? QStringLiteral("，平均绝对误差 ≤ %1").arg(spec.maxMeanAbsError())
+                             : QString())
+                    .arg(report->describe()));
+  }
+  if (!warmUp(*fast)) {
+    return fail(QStringLiteral("快速模型预热推理失败"));
+  }
+  return fast;
+}
+
+bool SpectrumPredictorManager::warmUp(const ModelSlot &slot) {
+  // 预热：首次推理会触发内存分配、算子选择与缓存填充，上线前先跑几次，避免第一条真实预测变慢
+  if (!slot.batch) {
+    return true;
+  }
+  const std::vector<float> zeros(slot.batch->inputSize(), 0.0f);
+  float value = 0.0f;
+  for (int i = 0; i < kWarmupRuns; i++) {
+    if (!slot.batch->predictBatch(zeros.data(), 1, zeros.size(), &value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SpectrumPredictorManager::loadModel(int index, const QString &modelPath) {
+  QString error;
+  ModelSlotPtr slot = buildSlot(index, modelPath, false, &error);
+  if (slot) {
+    std::atomic_store(&predictors_[static_cast<std::size_t>(index)].live, slot);
+    qDebug() << "模型加载成功:" << modelPath << "预测器:" << slot->predictor->name();
+  } else {
+    qWarning() << "模型加载失败:" << error;
+  }
+  emit modelLoaded(index, slot != nullptr);
+  return slot != nullptr;
 }
 
 bool SpectrumPredictorManager::loadModelAuto(int index) {
@@ -59,58 +304,331 @@ bool SpectrumPredictorManager::loadModelAuto(int index) {
     emit modelLoaded(index, false);
     return false;
   }
-  
+
   return loadModel(index, modelPath);
 }
 
+bool SpectrumPredictorManager::loadModelAsync(int index, const QString &modelPath) {
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    qWarning() << "预测器索引无效:" << index;
+    return false;
+  }
+  LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  if (lp.loading) {
+    qWarning() << "预测器" << index << "已有模型正在加载";
+    return false;
+  }
+  lp.loading = true;
+  emit modelLoadingChanged(index, true);
+
+  loaderPool_.start([this, index, modelPath]() {
+    QString error;
+    ModelSlotPtr slot = buildSlot(index, modelPath, false, &error);
+    // 回到主线程替换在线模型，推理线程下一次取槽时即使用新模型
+    QMetaObject::invokeMethod(this, [this, index, modelPath, slot, error]() {
+      LoadedPredictor &target = predictors_[static_cast<std::size_t>(index)];
+      target.loading = false;
+      if (slot) {
+        std::atomic_store(&target.live, slot);
+        qDebug() << "模型加载成功（后台）:" << modelPath << "预测器:" << slot->predictor->name();
+      } else {
+        qWarning() << "模型加载失败（后台），原模型保持在线:" << error;
+      }
+      emit modelLoadingChanged(index, false);
+      emit modelLoaded(index, slot != nullptr);
+    }, Qt::QueuedConnection);
+  });
+  return true;
+}
+
+bool SpectrumPredictorManager::loadModelAutoAsync(int index) {
+  const QString modelPath = getDefaultModelPath(index);
+  if (modelPath.isEmpty()) {
+    qWarning() << "无法获取默认模型路径，预测器索引:" << index;
+    return false;
+  }
+  return loadModelAsync(index, modelPath);
+}
+
+bool SpectrumPredictorManager::isModelLoading(int index) const {
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return false;
+  }
+  const LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  return lp.loading || lp.shadowLoading;
+}
+
+bool SpectrumPredictorManager::loadShadowModel(int index, const QString &modelPath) {
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    qWarning() << "预测器索引无效:" << index;
+    return false;
+  }
+  LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  if (lp.shadowLoading) {
+    qWarning() << "预测器" << index << "已有影子模型正在加载";
+    return false;
+  }
+  lp.shadowLoading = true;
+  emit modelLoadingChanged(index, true);
+
+  loaderPool_.start([this, index, modelPath]() {
+    QString error;
+    ModelSlotPtr slot = buildSlot(index, modelPath, true, &error);
+    QMetaObject::invokeMethod(this, [this, index, modelPath, slot, error]() {
+      LoadedPredictor &target = predictors_[static_cast<std::size_t>(index)];
+      target.shadowLoading = false;
+      if (slot) {
+        std::atomic_store(&target.shadow, slot);
+        target.shadowStats = ShadowStats();
+        qInfo() << "影子模型已启用:" << modelPath << "预测器:" << target.displayName;
+        emit shadowModelChanged(index);
+      } else {
+        qWarning() << "影子模型加载失败:" << error;
+      }
+      emit modelLoadingChanged(index, false);
+      emit shadowModelLoaded(index, slot != nullptr);
+    }, Qt::QueuedConnection);
+  });
+  return true;
+}
+
+void SpectrumPredictorManager::clearShadowModel(int index) {
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return;
+  }
+  LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  if (std::atomic_exchange(&lp.shadow, ModelSlotPtr())) {
+    lp.shadowStats = ShadowStats();
+    emit shadowModelChanged(index);
+  }
+}
+
+bool SpectrumPredictorManager::promoteShadowModel(int index) {
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return false;
+  }
+  LoadedPredictor &lp = predictors_[static_cast<std::size_t>(index)];
+  ModelSlotPtr candidate = std::atomic_exchange(&lp.shadow, ModelSlotPtr());
+  if (!candidate) {
+    return false;
+  }
+  // 影子模型已加载并预热，直接替换在线槽；旧模型在最后一个正在进行的推理结束后释放
+  std::atomic_store(&lp.live, candidate);
+  qInfo() << "影子模型已切换为在线模型:" << candidate->modelPath << "预测器:" << lp.displayName;
+  lp.shadowStats = ShadowStats();
+  emit shadowModelChanged(index);
+  emit modelLoaded(index, true);
+  return true;
+}
+
+bool SpectrumPredictorManager::hasShadowModel(int index) const {
+  return shadowSlot(index) != nullptr;
+}
+
+QVariantMap SpectrumPredictorManager::shadowStats(int index) const {
+  QVariantMap map;
+  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return map;
+  }
+  const ShadowStats &stats = predictors_[static_cast<std::size_t>(index)].shadowStats;
+  const double compared = static_cast<double>(stats.count);
+  map.insert(QStringLiteral("count"), static_cast<qulonglong>(stats.count));
+  map.insert(QStringLiteral("failures"), static_cast<qulonglong>(stats.failures));
+  map.insert(QStringLiteral("meanDiff"), stats.count > 0 ? stats.sumDiff / compared : 0.0);
+  map.insert(QStringLiteral("meanAbsDiff"), stats.count > 0 ? stats.sumAbsDiff / compared : 0.0);
+  map.insert(QStringLiteral("maxAbsDiff"), stats.maxAbsDiff);
+  map.insert(QStringLiteral("lastLive"), stats.lastLive);
+  map.insert(QStringLiteral("lastShadow"), stats.lastShadow);
+  return map;
+}
+
+void SpectrumPredictorManager::recordShadowPrediction(int predictorIndex, const QVariant &liveValue,
+                                                      const QVariant &shadowValue, qint64 windowTimestampNs) {
+  Q_UNUSED(windowTimestampNs);
+  if (predictorIndex < 0 || predictorIndex >= static_cast<int>(predictors_.size())) {
+    return;
+  }
+  ShadowStats &stats = predictors_[static_cast<std::size_t>(predictorIndex)].shadowStats;
+  if (!liveValue.isValid() || !shadowValue.isValid()) {
+    stats.failures++;
+    return;
+  }
+  const double live = liveValue.toDouble();
+  const double shadow = shadowValue.toDouble();
+  const double diff = shadow - live;
+  stats.count++;
+  stats.sumDiff += diff;
+  stats.sumAbsDiff += std::fabs(diff);
+  stats.maxAbsDiff = qMax(stats.maxAbsDiff, std::fabs(diff));
+  stats.lastLive = live;
+  stats.lastShadow = shadow;
+}
+
+QString SpectrumPredictorManager::modelPath(int index) const {
+  const ModelSlotPtr slot = liveSlot(index);
+  return slot ? slot->modelPath : QString();
+}
+
+QString SpectrumPredictorManager::shadowModelPath(int index) const {
+  const ModelSlotPtr slot = shadowSlot(index);
+  return slot ? slot->modelPath : QString();
+}
+
+QVariantMap SpectrumPredictorManager::fastModelStatus(int index) const {
+  const ModelSlotPtr slot = liveSlot(index);
+  return slot ? slot->fastModel : QVariantMap();
+}
+
 QString SpectrumPredictorManager::getDefaultModelPath(int index) const {
   if (index < 0 || index >= static_cast<int>(predictors_.size())) {
     return QString();
   }
-  
+
   auto *predictor = predictors_[static_cast<std::size_t>(index)].instance;
   if (!predictor) {
     qWarning() << "预测器实例无效";
     return QString();
   }
-  
+
   // 直接从插件获取默认模型路径，路径构建逻辑在插件中实现
   return predictor->getDefaultModelPath();
 }
 
+SpectralPreprocessorPtr SpectrumPredictorManager::preprocessor(int index) const {
+  const ModelSlotPtr slot = liveSlot(index);
+  return slot ? slot->preprocessor : nullptr;
+}
+
+SpectralPreprocessorPtr SpectrumPredictorManager::shadowPreprocessor(int index) const {
+  const ModelSlotPtr slot = shadowSlot(index);
+  return slot ? slot->preprocessor : nullptr;
+}
+
+QString SpectrumPredictorManager::preprocessingDescription(int index) const {
+  const SpectralPreprocessorPtr chain = preprocessor(index);
+  return chain ? chain->describe() : QString();
+}
+
 double SpectrumPredictorManager::predict(int index, const QVariantList &spectrumData) {
-  if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+  const ModelSlotPtr slot = liveSlot(index);
+  if (!slot) {
     qWarning() << "预测器索引无效:" << index;
     return 0.0;
   }
 
-  auto *predictor = predictors_[static_cast<std::size_t>(index)].instance;
-  if (!predictor) {
-    qWarning() << "预测器实例无效";
-    return 0.0;
-  }
-
-  if (!predictor->isModelLoaded()) {
+  if (!slot->predictor->isModelLoaded()) {
     qWarning() << "模型未加载，无法进行预测";
     return 0.0;
   }
 
-  double result = predictor->predict(spectrumData);
+  // 与推理执行器的路径一致：先经过模型的预处理链
+  double result = 0.0;
+  const SpectralPreprocessorPtr &chain = slot->preprocessor;
+  if (chain && spectrumData.size() == chain->inputSize()) {
+    std::vector<float> input(static_cast<size_t>(chain->inputSize()));
+    for (int i = 0; i < spectrumData.size(); i++) {
+      input[static_cast<size_t>(i)] = spectrumData[i].toFloat();
+    }
+    std::vector<float> processed(static_cast<size_t>(chain->outputSize()));
+    chain->apply(input.data(), processed.data());
+    float value = 0.0f;
+    if (predictWithSlot(*slot, processed.data(), 1, processed.size(), &value)) {
+      result = static_cast<double>(value);
+    }
+  } else {
+    result = slot->predictor->predict(spectrumData);
+  }
   emit predictionCompleted(index, result);
   return result;
 }
 
-bool SpectrumPredictorManager::isModelLoaded(int index) const {
+SpectrumPredictorManager::ModelSlotPtr SpectrumPredictorManager::createModelInstance(int index,
+                                                                                   const QString &modelPath,
+                                                                                   QString *error) const {
+  return buildSlot(index, modelPath, true, error);
+}
+
+bool SpectrumPredictorManager::predictWithSlot(const ModelSlot &slot, const float *data, size_t rows, size_t cols,
+                                               float *out) {
+  if (!slot.predictor->isModelLoaded()) {
+    qWarning() << "模型未加载，无法进行预测";
+    return false;
+  }
+
+  if (slot.batch) {
+    return slot.batch->predictBatch(data, rows, cols, out);
+  }
+
+  // 第 1 版插件：逐条转换为 QVariantList 调用
+  QVariantList row;
+  row.reserve(static_cast<int>(cols));
+  for (size_t r = 0; r < rows; r++) {
+    row.clear();
+    const float *values = data + r * cols;
+    for (size_t c = 0; c < cols; c++) {
+      row.append(static_cast<double>(values[c]));
+    }
+    out[r] = static_cast<float>(slot.predictor->predict(row));
+  }
+  return true;
+}
+
+bool SpectrumPredictorManager::predictBatch(int index, const float *data, size_t rows, size_t cols,
+                                            float *out) {
+  // 持有槽的引用直到推理结束，期间替换模型不影响本次推理
+  const ModelSlotPtr slot = liveSlot(index);
+  if (!slot) {
+    qWarning() << "预测器索引无效:" << index;
+    return false;
+  }
+  return predictWithSlot(*slot, data, rows, cols, out);
+}
+
+bool SpectrumPredictorManager::predictShadow(int index, const float *data, size_t cols, float *out) {
+  const ModelSlotPtr slot = shadowSlot(index);
+  if (!slot) {
+    return false;
+  }
+  return predictWithSlot(*slot, data, 1, cols, out);
+}
+
+int SpectrumPredictorManager::interfaceVersion(int index) const {
   if (index < 0 || index >= static_cast<int>(predictors_.size())) {
+    return 0;
+  }
+  return predictors_[static_cast<std::size_t>(index)].batchInstance ? 2 : 1;
+}
+
+bool SpectrumPredictorManager::setPredictorOptions(int index, const QVariantMap &options) {
+  const ModelSlotPtr slot = liveSlot(index);
+  if (!slot) {
+    qWarning() << "预测器索引无效:" << index;
     return false;
   }
 
-  auto *predictor = predictors_[static_cast<std::size_t>(index)].instance;
+  auto *predictor = slot->options;
   if (!predictor) {
+    qWarning() << "预测器不支持运行时配置:" << predictors_[static_cast<std::size_t>(index)].displayName;
     return false;
   }
 
-  return predictor->isModelLoaded();
+  bool success = predictor->setRuntimeOptions(options);
+  qDebug() << "预测器运行时配置:" << predictor->runtimeOptions() << (success ? "已生效" : "未生效");
+  return success;
+}
+
+QVariantMap SpectrumPredictorManager::predictorOptions(int index) const {
+  const ModelSlotPtr slot = liveSlot(index);
+  return slot && slot->options ? slot->options->runtimeOptions() : QVariantMap();
+}
+
+QVariantMap SpectrumPredictorManager::inferenceRuntime() const {
+  return runtime_->toVariantMap();
+}
+
+bool SpectrumPredictorManager::isModelLoaded(int index) const {
+  const ModelSlotPtr slot = liveSlot(index);
+  return slot && slot->predictor->isModelLoaded();
 }
 
 QString SpectrumPredictorManager::getAlgorithm(int index) const {
@@ -136,7 +654,7 @@ void SpectrumPredictorManager::loadPredictors() {
     if (!info.fileName().contains("predictor_plugin")) {
       continue;
     }
-    
+
     auto loader = std::make_unique<QPluginLoader>(info.absoluteFilePath());
     QObject *obj = loader->instance();
     if (!obj) {
@@ -144,22 +662,39 @@ void SpectrumPredictorManager::loadPredictors() {
       continue;
     }
 
-    auto *predictor = qobject_cast<SpectrumPredictorPlugin *>(obj);
+    // 接口版本协商：优先使用第 2 版（批量预测），否则按第 1 版加载
+    auto *batchPredictor = qobject_cast<SpectrumPredictorPluginV2 *>(obj);
+    SpectrumPredictorPlugin *predictor = batchPredictor;
+    if (!predictor) {
+      predictor = qobject_cast<SpectrumPredictorPlugin *>(obj);
+    }
     if (!predictor) {
       qWarning() << "插件不是预测器插件:" << info.fileName();
       continue;
     }
 
+    // 接入共享的推理运行时（线程预算、ONNX Runtime 环境）
+    initializeInstance(obj, runtime_.get());
+
     LoadedPredictor lp;
     lp.loader = std::move(loader);
     lp.instance = predictor;
+    lp.batchInstance = batchPredictor;
+    lp.factory = qobject_cast<SpectrumPredictorFactory *>(obj);
+    lp.options = qobject_cast<SpectrumPredictorRuntimeOptions *>(obj);
     lp.displayName = predictor->name();
     lp.algorithm = predictor->algorithm();
+    // 初始在线槽指向插件根实例（由 QPluginLoader 持有，不删除）
+    auto slot = std::make_shared<ModelSlot>();
+    slot->predictor = std::shared_ptr<SpectrumPredictorPlugin>(predictor, [](SpectrumPredictorPlugin *) {});
+    slot->batch = batchPredictor;
+    slot->options = lp.options;
+    lp.live = std::move(slot);
+
+    qDebug() << "加载预测器插件:" << lp.displayName << "算法:" << lp.algorithm
+             << "接口版本:" << (batchPredictor ? 2 : 1);
     predictors_.push_back(std::move(lp));
-    
-    qDebug() << "加载预测器插件:" << lp.displayName << "算法:" << lp.algorithm;
   }
 
   emit predictorsChanged();
 }
-
@@ -3,17 +3,30 @@
 #include <QObject>
 #include <QPluginLoader>
 #include <QStringList>
+#include <QThreadPool>
 #include <QVariant>
 #include <memory>
 #include <vector>
 
+#include "fast_model_spec.h"
+#include "inference_executor.h"
+#include "inference_runtime.h"
+#include "spectral_preprocessor.h"
 #include "spectrum_predictor_interface.h"
 
 // 负责加载光谱预测插件
+// - 每个预测器的在线模型是一个只读的 ModelSlot（预测器实例 + 预处理链），整体原子替换：
+//   推理线程取得当前槽的引用后即可放心使用，替换不会打断或阻塞正在进行的推理
+// - 异步加载在后台线程中把新模型加载到插件新建的实例上并预热，完成后才替换在线槽，采集不暂停
+// - 影子模式：候选模型与在线模型对同一条光谱各自打分，结果只记录（log/shadow.csv）不输出，
+//   确认无误后 promoteShadowModel() 直接切换为在线模型
+// - 模型旁边有 .fast.json 时（见 FastModelSpec），加载后在参考集上比较快速模型（int8 / 半精度 / 推理优化）
+//   与原模型，误差在容差内才用快速模型上线
 class SpectrumPredictorManager : public QObject {
   Q_OBJECT
   Q_PROPERTY(QStringList predictorNames READ predictorNames NOTIFY predictorsChanged)
   Q_PROPERTY(bool hasPredictors READ hasPredictors NOTIFY predictorsChanged)
+  Q_PROPERTY(InferenceExecutor *inferenceExecutor READ inferenceExecutor CONSTANT)
 
  public:
   explicit SpectrumPredictorManager(QObject *parent = nullptr);
@@ -22,15 +35,59 @@ class SpectrumPredictorManager : public QObject {
   QStringList predictorNames() const;
   bool hasPredictors() const;
 
-  // 加载模型到指定的预测器
+  // 异步推理执行器：处理线程通过它提交预测请求，结果由其 predictionReady 信号发出
+  InferenceExecutor *inferenceExecutor() const { return executor_.get(); }
+
+  static const int kWarmupRuns = 3;  // 新模型上线前的预热推理次数
+
+  // 加载模型到指定的预测器（在调用线程中同步完成）
   Q_INVOKABLE bool loadModel(int index, const QString &modelPath);
   
   // 根据算法类型自动加载对应文件夹的模型（自动路径）
   Q_INVOKABLE bool loadModelAuto(int index);
+
+  // 异步加载：立即返回，后台线程完成加载与预热后替换在线模型并发出 modelLoaded
+  // 该预测器已有加载在进行时返回 false；加载失败时原模型保持在线
+  Q_INVOKABLE bool loadModelAsync(int index, const QString &modelPath);
+  Q_INVOKABLE bool loadModelAutoAsync(int index);
+  Q_INVOKABLE bool isModelLoading(int index) const;
+
+  // 影子模式：异步加载候选模型（需要插件实现 SpectrumPredictorFactory），完成后发出 shadowModelLoaded
+  Q_INVOKABLE bool loadShadowModel(int index, const QString &modelPath);
+  Q_INVOKABLE void clearShadowModel(int index);
+  // 把影子模型切换为在线模型（不需要重新加载）
+  Q_INVOKABLE bool promoteShadowModel(int index);
+  Q_INVOKABLE bool hasShadowModel(int index) const;
+  // 影子对比统计：count、failures、meanDiff（影子 - 在线）、meanAbsDiff、maxAbsDiff、lastLive、lastShadow
+  Q_INVOKABLE QVariantMap shadowStats(int index) const;
+
+  // 当前在线 / 影子模型的文件路径（未加载时为空）
+  Q_INVOKABLE QString modelPath(int index) const;
+  Q_INVOKABLE QString shadowModelPath(int index) const;
+
+  // 在线模型的快速模型检查结果：model、adopted、rows、maxAbsError、meanAbsError、error（未配置时为空表）
+  Q_INVOKABLE QVariantMap fastModelStatus(int index) const;
   
   // 使用指定的预测器进行预测
   Q_INVOKABLE double predict(int index, const QVariantList &spectrumData);
   
+  // 批量预测：data 为 rows × cols 的行优先 float 矩阵，结果写入 out[0..rows)
+  // 第 2 版插件一次推理完成整批，第 1 版插件逐条回退调用 predict()
+  bool predictBatch(int index, const float *data, size_t rows, size_t cols, float *out);
+  // 用影子模型预测一条光谱（未启用影子模式时返回 false）
+  bool predictShadow(int index, const float *data, size_t cols, float *out);
+  
+  // 插件实现的接口版本（1 或 2），索引无效时返回 0
+  Q_INVOKABLE int interfaceVersion(int index) const;
+  
+  // 设置 / 读取预测器的推理运行时配置（见 SpectrumPredictorRuntimeOptions）
+  // 第 1 版插件不支持配置，返回 false / 空表
+  Q_INVOKABLE bool setPredictorOptions(int index, const QVariantMap &options);
+  Q_INVOKABLE QVariantMap predictorOptions(int index) const;
+
+  // 所有插件共用的推理运行时配置：线程预算与已创建的共享对象（见 InferenceRuntime）
+  Q_INVOKABLE QVariantMap inferenceRuntime() const;
+  
   // 检查模型是否已加载
   Q_INVOKABLE bool isModelLoaded(int index) const;
   
@@ -40,21 +97,89 @@ class SpectrumPredictorManager : public QObject {
   // 获取默认模型路径（根据算法类型）
   Q_INVOKABLE QString getDefaultModelPath(int index) const;
 
+  // 一个已加载的模型：发布后只读，通过 std::atomic_load / atomic_store 整体替换
+  struct ModelSlot {
+    std::shared_ptr<SpectrumPredictorPlugin> predictor;  // 插件根实例使用空删除器（由 QPluginLoader 持有）
+    SpectrumPredictorPluginV2 *batch = nullptr;          // 同一对象的第 2 版接口（旧插件为空）
+    SpectrumPredictorRuntimeOptions *options = nullptr;  // 同一对象的运行时配置扩展（未实现时为空）
+    SpectralPreprocessorPtr preprocessor;                // 模型的预处理链，未配置时为空
+    QString modelPath;                                   // 请求加载的（原）模型路径
+    QVariantMap fastModel;                               // 快速模型检查结果，未配置时为空
+    QVariantMap baseOptions;  // 快速模型：叠加 .fast.json 配置之前的运行时配置（后续新实例沿用它）
+  };
+  using ModelSlotPtr = std::shared_ptr<const ModelSlot>;
+
+  // 离线批量工具（calc_rescore）：在调用线程上把模型加载到插件新建的独立实例上并预热，不影响在线模型
+  // 每个工作线程持有自己的实例即可并行推理；插件未实现 SpectrumPredictorFactory 或加载失败时返回空并写入 error
+  ModelSlotPtr createModelInstance(int index, const QString &modelPath, QString *error = nullptr) const;
+  // 用指定的模型实例预测 rows 条已预处理的光谱（不经过预处理链），任意线程调用
+  static bool predictWithSlot(const ModelSlot &slot, const float *data, size_t rows, size_t cols, float *out);
+
+  // 模型的预处理链（随模型加载，见 SpectralPreprocessor），未配置时为空（直接使用校正后的光谱）
+  // 任意线程调用，返回的对象只读，模型重新加载后旧对象仍可安全使用
+  SpectralPreprocessorPtr preprocessor(int index) const;
+  SpectralPreprocessorPtr shadowPreprocessor(int index) const;
+  Q_INVOKABLE QString preprocessingDescription(int index) const;
+
  signals:
   void predictorsChanged();
   void modelLoaded(int index, bool success);
   void predictionCompleted(int index, double result);
+  void modelLoadingChanged(int index, bool loading);
+  void shadowModelLoaded(int index, bool success);
+  void shadowModelChanged(int index);
+
+ private slots:
+  void recordShadowPrediction(int predictorIndex, const QVariant &liveValue, const QVariant &shadowValue,
+                              qint64 windowTimestampNs);
 
  private:
   void loadPredictors();
 
+  // 影子模式的对比统计（仅主线程访问）
+  struct ShadowStats {
+    quint64 count = 0;
+    quint64 failures = 0;  // 任一方预测失败的次数
+    double sumDiff = 0.0;
+    double sumAbsDiff = 0.0;
+    double maxAbsDiff = 0.0;
+    double lastLive = 0.0;
+    double lastShadow = 0.0;
+  };
+
   struct LoadedPredictor {
     std::unique_ptr<QPluginLoader> loader;
     SpectrumPredictorPlugin *instance = nullptr;  // owned by loader
+    SpectrumPredictorPluginV2 *batchInstance = nullptr;  // 同一对象的第 2 版接口（旧插件为空）
+    SpectrumPredictorFactory *factory = nullptr;  // 同一对象的实例工厂扩展（未实现时为空）
+    SpectrumPredictorRuntimeOptions *options = nullptr;  // 同一对象的运行时配置扩展（未实现时为空）
     QString displayName;
     QString algorithm;
+    ModelSlotPtr live;    // 在线模型（初始为插件根实例，尚未加载模型）
+    ModelSlotPtr shadow;  // 影子候选模型，为空表示未启用
+    // 以下仅主线程访问
+    bool loading = false;
+    bool shadowLoading = false;
+    ShadowStats shadowStats;
   };
 
+  ModelSlotPtr liveSlot(int index) const;
+  ModelSlotPtr shadowSlot(int index) const;
+
+  // 在调用线程上加载并预热模型，可在后台线程运行（只读访问 predictors_）
+  // 优先加载到插件新建的实例上，freshInstance 为 true 时（影子模式）不允许退回到插件根实例
+  // 失败返回空并写入 error
+  ModelSlotPtr buildSlot(int index, const QString &modelPath, bool freshInstance, QString *error) const;
+
+  // 在插件新建的实例上加载快速模型，并在参考集上与 baseline 比较；超出容差或失败时返回空并写入 error
+  std::shared_ptr<ModelSlot> buildFastSlot(int index, const ModelSlot &baseline, const FastModelSpec &spec,
+                                           FastModelSpec::Report *report, QString *error) const;
+
+  static bool warmUp(const ModelSlot &slot);
+
+  std::unique_ptr<InferenceRuntime> runtime_;  // 插件实例共享的运行时，在所有实例释放后销毁
   std::vector<LoadedPredictor> predictors_;
+  std::unique_ptr<InferenceExecutor> executor_;  // 在插件卸载前停止
+  QThreadPool loaderPool_;  // 异步模型加载（单线程，按提交顺序执行）
 };
 
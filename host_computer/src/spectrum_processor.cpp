@@ -1,31 +1,84 @@
 #include "spectrum_processor.h"
+#include "display_feed.h"
+#include "pipeline_stats.h"
 #include "spectrum_predictor_manager.h"
+#include "spectral_math.h"
+#include "spectrum_worker_pool.h"
+#include "thread_placement.h"
 
 #include <QDebug>
 #include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 SpectrumProcessor::SpectrumProcessor(QObject *parent)
-    : QThread(parent), stopRequested_(false), predictorManager_(nullptr), predictorIndex_(-1) {
+    : QThread(parent), inputQueue_(std::make_shared<SpectrumFrameQueue>()), appliedConfig_(~0ULL),
+      windowPackets_(0), activeMode_(BlockMode), activeThreshold_(DEFAULT_SPECTRUM_THRESHOLD),
+      activeInterval_(DEFAULT_OUTPUT_INTERVAL), activeMinPackets_(DEFAULT_ADAPTIVE_MIN_PACKETS),
+      activeMaxPackets_(DEFAULT_ADAPTIVE_MAX_PACKETS), activeTargetSnr_(DEFAULT_ADAPTIVE_TARGET_SNR),
+      activeTargetStdError_(0.0), windowHead_(0), windowFill_(0),
+      emaAlpha_(0.0), emaInitialized_(false), lastFrameTimestampNs_(0),
+      predictorManager_(nullptr), displayFeed_(nullptr), workerPool_(nullptr), streamId_(0),
+      stopRequested_(false), processedFrames_(0),
+      spectrumThreshold_(DEFAULT_SPECTRUM_THRESHOLD), averagingMode_(BlockMode),
+      outputInterval_(DEFAULT_OUTPUT_INTERVAL), emaTimeConstant_(DEFAULT_EMA_TIME_CONSTANT),
+      adaptiveTargetSnr_(DEFAULT_ADAPTIVE_TARGET_SNR), adaptiveTargetStdError_(0.0),
+      adaptiveMinPackets_(DEFAULT_ADAPTIVE_MIN_PACKETS), adaptiveMaxPackets_(DEFAULT_ADAPTIVE_MAX_PACKETS),
+      configVersion_(0) {
 }
 
 SpectrumProcessor::~SpectrumProcessor() {
   stopProcessing();
 }
 
-void SpectrumProcessor::addSpectrumData(const QVariantList &data) {
-  QMutexLocker locker(&mutex_);
-  accumulatedData_.append(data);
-  condition_.wakeOne();  // 唤醒处理线程
+// 将 double 数组打包为 QVariantList（仅在输出到 QML / 预测器时调用一次）
+static QVariantList toVariantList(const QVector<double> &data) {
+  QVariantList values;
+  values.reserve(data.size());
+  for (double v : data) {
+    values.append(v);
+  }
+  return values;
 }
 
-void SpectrumProcessor::setBlackReferenceData(const QVariantList &data) {
-  QMutexLocker locker(&mutex_);
-  blackReferenceData_ = data;
+void SpectrumProcessor::setCalibration(SpectralCalibrationPtr calibration) {
+  std::atomic_store_explicit(&calibration_, std::move(calibration), std::memory_order_release);
 }
 
-void SpectrumProcessor::setWhiteReferenceData(const QVariantList &data) {
-  QMutexLocker locker(&mutex_);
-  whiteReferenceData_ = data;
+void SpectrumProcessor::setSpectrumThreshold(int packets) {
+  spectrumThreshold_ = qMax(1, packets);
+  configVersion_.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumProcessor::setAveragingMode(int mode) {
+  if (mode != BlockMode && mode != SlidingWindowMode && mode != EmaMode && mode != AdaptiveMode) {
+    mode = BlockMode;
+  }
+  averagingMode_ = mode;
+  configVersion_.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumProcessor::setOutputInterval(int packets) {
+  outputInterval_ = qMax(1, packets);
+  configVersion_.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumProcessor::setEmaTimeConstant(double packets) {
+  emaTimeConstant_ = qMax(1.0, packets);
+  configVersion_.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumProcessor::setAdaptiveTarget(double targetSnr, double targetStdError) {
+  adaptiveTargetSnr_ = qMax(0.0, targetSnr);
+  adaptiveTargetStdError_ = qMax(0.0, targetStdError);
+  configVersion_.fetch_add(1, std::memory_order_release);
+}
+
+void SpectrumProcessor::setAdaptiveLimits(int minPackets, int maxPackets) {
+  adaptiveMinPackets_ = qMax(2, minPackets);
+  adaptiveMaxPackets_ = qMax(adaptiveMinPackets_.load(), maxPackets);
+  configVersion_.fetch_add(1, std::memory_order_release);
 }
 
 void SpectrumProcessor::setPredictorManager(SpectrumPredictorManager *manager) {
@@ -34,16 +87,49 @@ void SpectrumProcessor::setPredictorManager(SpectrumPredictorManager *manager) {
 }
 
 void SpectrumProcessor::setPredictorIndex(int index) {
+  setPredictorIndices(index >= 0 ? QVector<int>{index} : QVector<int>());
+}
+
+void SpectrumProcessor::setPredictorIndices(const QVector<int> &indices) {
   QMutexLocker locker(&mutex_);
-  predictorIndex_ = index;
+  predictorIndices_ = indices;
+}
+
+void SpectrumProcessor::addConsumer(const std::shared_ptr<SpectrumFrameSink> &consumer) {
+  if (!consumer) {
+    return;
+  }
+  QMutexLocker locker(&consumersMutex_);
+  if (std::find(consumers_.begin(), consumers_.end(), consumer) == consumers_.end()) {
+    consumers_.push_back(consumer);
+  }
+}
+
+void SpectrumProcessor::removeConsumer(const std::shared_ptr<SpectrumFrameSink> &consumer) {
+  // 处理线程只在持有 consumersMutex_ 时调用消费者，拿到锁即说明它已不在使用中
+  QMutexLocker locker(&consumersMutex_);
+  consumers_.erase(std::remove(consumers_.begin(), consumers_.end(), consumer), consumers_.end());
+}
+
+void SpectrumProcessor::startProcessing() {
+  stopRequested_ = false;
+  if (workerPool_) {
+    workerPool_->addProcessor(this);
+  } else {
+    start();
+  }
 }
 
 void SpectrumProcessor::stopProcessing() {
-  {
-    QMutexLocker locker(&mutex_);
-    stopRequested_ = true;
-    condition_.wakeAll();  // 唤醒所有等待的线程
+  stopRequested_ = true;
+  if (workerPool_) {
+    // removeProcessor 返回后工作线程不会再调用 processPending
+    if (workerPool_->removeProcessor(this)) {
+      releaseAveraging();
+    }
+    return;
   }
+  inputQueue_->wake();  // 唤醒等待中的处理线程
   wait(1000);  // 等待最多1秒
   if (isRunning()) {
     terminate();
@@ -52,142 +138,318 @@ void SpectrumProcessor::stopProcessing() {
 }
 
 void SpectrumProcessor::run() {
-  const int dataPoints = 1024;  // 每个数据包的点数
-
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Processor);
   while (!stopRequested_) {
-    QMutexLocker locker(&mutex_);
-    
-    // 等待有数据或停止请求
-    while (accumulatedData_.size() < SPECTRUM_THRESHOLD && !stopRequested_) {
-      condition_.wait(&mutex_);
-    }
-
-    if (stopRequested_) {
-      break;
+    if (processPending(kPopChunk) == 0) {
+      // 队列为空时才进入等待，生产者只在此时通过 eventfd 唤醒
+      inputQueue_->waitForFrames();
     }
+  }
+  releaseAveraging();
+}
 
-    // 如果累积的数据达到阈值，进行处理
-    if (accumulatedData_.size() >= SPECTRUM_THRESHOLD) {
-      // 复制数据到本地，释放锁
-      QList<QVariantList> dataToProcess = accumulatedData_;
-      accumulatedData_.clear();
-      locker.unlock();
+int SpectrumProcessor::processPending(int maxFrames) {
+  // 平均参数变化时重新开始累积
+  const quint64 config = configVersion_.load(std::memory_order_acquire);
+  if (config != appliedConfig_) {
+    appliedConfig_ = config;
+    resetAveraging();
+  }
 
-      // 在后台线程中处理数据，不阻塞主线程
-      QVariantList averagedData;
-      averagedData.reserve(dataPoints);
+  if (chunk_.empty()) {
+    chunk_.resize(kPopChunk);
+  }
+  const int n = inputQueue_->popFrames(chunk_.data(), qBound(1, maxFrames, kPopChunk));
+  if (n == 0) {
+    return 0;
+  }
+  const qint64 popNs = SpectrumFrame::nowNs();
 
-      // 初始化平均值数组
-      for (int i = 0; i < dataPoints; i++) {
-        averagedData.append(0.0);
+  {
+    QMutexLocker locker(&consumersMutex_);
+    for (int base = 0; base < n; base += kConsumerBatch) {
+      const int count = qMin(kConsumerBatch, n - base);
+      SpectrumFramePtr *frames = chunk_.data() + base;
+      accumulateFrames(frames, count, popNs);
+      for (const auto &consumer : consumers_) {
+        consumer->pushFrames(frames, count);
       }
+      for (int i = 0; i < count; ++i) {
+        frames[i].reset();
+      }
+    }
+  }
+  processedFrames_.fetch_add(static_cast<quint64>(n), std::memory_order_relaxed);
+  return n;
+}
+
+void SpectrumProcessor::releaseAveraging() {
+  accumulator_.reset();
+  windowPackets_ = 0;
+  windowRing_.clear();
+  windowRing_.shrink_to_fit();
+  chunk_.clear();
+  chunk_.shrink_to_fit();
+  appliedConfig_ = ~0ULL;
+}
 
-      // 计算平均值
-      int packetCount = dataToProcess.size();
-      for (const QVariantList &packet : dataToProcess) {
-        if (packet.size() == dataPoints) {
-          for (int i = 0; i < dataPoints; i++) {
-            double currentValue = averagedData[i].toDouble();
-            double packetValue = packet[i].toDouble();
-            averagedData[i] = QVariant::fromValue(currentValue + packetValue);
+void SpectrumProcessor::accumulateFrames(const SpectrumFramePtr *frames, int count, qint64 popNs) {
+  for (int i = 0; i < count; ++i) {
+    const SpectrumFramePtr &frame = frames[i];
+    // 每帧到达时立即累加，不再缓存整窗的帧
+    const bool complete = frame && frame->isComplete();
+    if (frame) {
+      lastFrameTimestampNs_ = frame->timestampNs;
+      PipelineStats::recordFrame(PipelineStats::Handoff, frame->dispatchNs, popNs, frame->sequence);
+    }
+    switch (activeMode_) {
+      case SlidingWindowMode:
+        if (complete) {
+          slideWindow(frame->data);
+        }
+        // 窗口填满后，每隔 activeInterval_ 条输出一次最近一个窗口的平均值
+        if (++windowPackets_ >= activeInterval_) {
+          windowPackets_ = 0;
+          if (windowFill_ == activeThreshold_) {
+            publishAccumulatorMean(accumulator_.count());
           }
         }
+        break;
+      case EmaMode:
+        if (complete) {
+          updateEma(frame->data);
+        }
+        if (++windowPackets_ >= activeInterval_) {
+          windowPackets_ = 0;
+          if (emaInitialized_) {
+            publishSpectrum(ema_, activeInterval_);
+          }
+        }
+        break;
+      case AdaptiveMode: {
+        if (complete) {
+          accumulator_.add(frame->data);
+        }
+        windowPackets_++;
+        // 达到最少包数后每 kAdaptiveCheckInterval 个包估计一次质量，达到目标或包数上限时输出
+        SpectrumAccumulator::Quality quality;
+        const bool check = windowPackets_ >= activeMinPackets_ &&
+                           (windowPackets_ % kAdaptiveCheckInterval == 0 || windowPackets_ >= activeMaxPackets_);
+        if (check && (adaptiveTargetReached(&quality) || windowPackets_ >= activeMaxPackets_)) {
+          publishAccumulatorMean(windowPackets_, quality.snr);
+          accumulator_.reset();
+          windowPackets_ = 0;
+        }
+        break;
       }
+      default:
+        if (complete) {
+          accumulator_.add(frame->data);
+        }
+        windowPackets_++;
+        // 累积的数据达到阈值，进行处理（精确按阈值切分窗口）
+        if (windowPackets_ >= activeThreshold_) {
+          publishAccumulatorMean(windowPackets_);
+          accumulator_.reset();
+          windowPackets_ = 0;
+        }
+        break;
+    }
+  }
+}
 
-      // 除以数据包数量得到平均值
-      for (int i = 0; i < dataPoints; i++) {
-        double avg = averagedData[i].toDouble() / packetCount;
-        averagedData[i] = QVariant::fromValue(avg);
-      }
-
-      // 如果黑白参考数据都存在，进行黑白校正（在后台线程中进行，不阻塞主线程）
-      // finalData 的确定逻辑：
-      // - 如果黑白参考数据存在 → finalData = 校正后的数据
-      // - 如果黑白参考数据不存在 → finalData = 未校正的原始数据
-      QVariantList finalData = averagedData;
-      bool hasCorrection = false;
-      if (!blackReferenceData_.empty() && !whiteReferenceData_.empty() &&
-          blackReferenceData_.size() == dataPoints && whiteReferenceData_.size() == dataPoints) {
-        finalData = applyBlackWhiteCorrection(averagedData);
-        hasCorrection = true;
-      }
+void SpectrumProcessor::resetAveraging() {
+  activeMode_ = averagingMode_;
+  activeThreshold_ = spectrumThreshold_;
+  activeInterval_ = outputInterval_;
+  activeMinPackets_ = adaptiveMinPackets_;
+  activeMaxPackets_ = adaptiveMaxPackets_;
+  activeTargetSnr_ = adaptiveTargetSnr_;
+  activeTargetStdError_ = adaptiveTargetStdError_;
+  // 只有自适应模式需要逐像素方差，其它模式不累加平方和
+  accumulator_.setTrackSquares(activeMode_ == AdaptiveMode);
+  accumulator_.reset();
+  windowPackets_ = 0;
 
-      // 找到最大值和最小值（在 finalData 上，可能是校正后的也可能是未校正的）
-      double minVal = finalData[0].toDouble();
-      double maxVal = finalData[0].toDouble();
-      for (int i = 1; i < dataPoints; i++) {
-        double val = finalData[i].toDouble();
-        if (val < minVal) minVal = val;
-        if (val > maxVal) maxVal = val;
-      }
+  // 滑动窗口只在该模式下分配环形缓冲（窗口长度受累加器精确加减的上限约束）
+  windowHead_ = 0;
+  windowFill_ = 0;
+  if (activeMode_ == SlidingWindowMode) {
+    activeThreshold_ = qMin(activeThreshold_, SpectrumAccumulator::kMaxWindowCount);
+    windowRing_.assign(static_cast<size_t>(activeThreshold_) * SpectrumFrame::kPixelCount, 0);
+  } else {
+    windowRing_.clear();
+    windowRing_.shrink_to_fit();
+  }
 
-      // 如果启用了预测器，对 finalData 进行预测（在后台线程中执行）
-      // 预测数据说明：
-      // - 如果黑白参考数据存在 → 预测基于校正后的数据
-      // - 如果黑白参考数据不存在 → 预测基于未校正的原始数据
-      if (predictorManager_ && predictorIndex_ >= 0) {
-        performPrediction(finalData);
-      }
+  // EMA：alpha = 1 - exp(-1 / tau)，tau 以数据包数计
+  emaInitialized_ = false;
+  if (activeMode_ == EmaMode) {
+    ema_.fill(0.0, SpectrumFrame::kPixelCount);
+    emaAlpha_ = 1.0 - std::exp(-1.0 / emaTimeConstant_.load());
+  } else {
+    ema_.clear();
+  }
+}
 
-      // 发送处理好的数据到主线程（通过信号，自动使用QueuedConnection）
-      emit spectrumReady(finalData, minVal, maxVal, packetCount);
+void SpectrumProcessor::slideWindow(const uint16_t *pixels) {
+  const size_t frameBytes = sizeof(uint16_t) * SpectrumFrame::kPixelCount;
+  int slot;
+  if (windowFill_ == activeThreshold_) {
+    // 窗口已满：先移出最旧的一帧，再把新帧写入它的位置（O(1) 加减，不重新计算整窗）
+    slot = windowHead_;
+    accumulator_.remove(windowRing_.data() + static_cast<size_t>(slot) * SpectrumFrame::kPixelCount);
+    windowHead_ = (windowHead_ + 1) % activeThreshold_;
+  } else {
+    slot = (windowHead_ + windowFill_) % activeThreshold_;
+    windowFill_++;
+  }
+  std::memcpy(windowRing_.data() + static_cast<size_t>(slot) * SpectrumFrame::kPixelCount, pixels, frameBytes);
+  accumulator_.add(pixels);
+}
 
-      // 重新获取锁，继续下一轮
-      locker.relock();
+void SpectrumProcessor::updateEma(const uint16_t *pixels) {
+  if (!emaInitialized_) {
+    // 第一帧直接作为初始值
+    for (int i = 0; i < SpectrumFrame::kPixelCount; i++) {
+      ema_[i] = pixels[i];
     }
+    emaInitialized_ = true;
+    return;
   }
+  SpectralMath::emaUpdateU16(ema_.data(), pixels, emaAlpha_, SpectrumFrame::kPixelCount);
 }
 
-QVariantList SpectrumProcessor::applyBlackWhiteCorrection(const QVariantList &rawData) {
-  // 黑白校正公式：校正后的数据 = (原始数据 - 黑参考) / (白参考 - 黑参考)
-  QVariantList correctedData;
-  correctedData.reserve(rawData.size());
-  
-  for (int i = 0; i < rawData.size(); i++) {
-    double rawValue = rawData[i].toDouble();
-    double blackValue = blackReferenceData_[i].toDouble();
-    double whiteValue = whiteReferenceData_[i].toDouble();
-    
-    // 计算分母：白参考 - 黑参考
-    double denominator = whiteValue - blackValue;
-    
-    // 避免除零，如果分母太小，使用原始值
-    if (qAbs(denominator) < 1e-6) {
-      correctedData.append(rawValue);
-    } else {
-      // 计算校正后的值：(原始数据 - 黑参考) / (白参考 - 黑参考)
-      double correctedValue = (rawValue - blackValue) / denominator;
-      correctedData.append(correctedValue);
-    }
+bool SpectrumProcessor::adaptiveTargetReached(SpectrumAccumulator::Quality *quality) const {
+  // 与输出光谱使用同一份标定：有标定时按校正后的反射率估计，坏像素不参与
+  const SpectralCalibrationPtr calibration = std::atomic_load_explicit(&calibration_, std::memory_order_acquire);
+  *quality = calibration ? accumulator_.quality(calibration->gain(), calibration->offset(), calibration->badPixelMask())
+                         : accumulator_.quality();
+  if (activeTargetSnr_ <= 0.0 && activeTargetStdError_ <= 0.0) {
+    return false;  // 没有目标：累积到上限
   }
-  
-  return correctedData;
+  return (activeTargetSnr_ <= 0.0 || quality->snr >= activeTargetSnr_) &&
+         (activeTargetStdError_ <= 0.0 || quality->stdError <= activeTargetStdError_);
 }
 
-void SpectrumProcessor::performPrediction(const QVariantList &correctedSpectrum) {
-  // 在后台线程中执行预测，不阻塞主线程
-  if (!predictorManager_) {
-    return;
+void SpectrumProcessor::publishAccumulatorMean(int packetCount, double snr) {
+  // 平均值 = 逐像素和 / 有效（完整）数据包数量
+  QVector<double> averagedData(SpectrumFrame::kPixelCount, 0.0);
+  const qint64 startNs = SpectrumFrame::nowNs();
+  accumulator_.mean(averagedData.data());
+  PipelineStats::record(PipelineStats::Averaging, startNs, SpectrumFrame::nowNs(),
+                        static_cast<quint64>(lastFrameTimestampNs_));
+  publishSpectrum(averagedData, packetCount, snr);
+}
+
+void SpectrumProcessor::publishSpectrum(const QVector<double> &averagedData, int packetCount, double snr) {
+  const int dataPoints = SpectrumFrame::kPixelCount;  // 每个数据包的点数
+
+  // 取得当前标定的引用（只增加引用计数），本条光谱处理期间替换标定不影响它
+  const SpectralCalibrationPtr calibration = std::atomic_load_explicit(&calibration_, std::memory_order_acquire);
+
+  // 如果黑白参考数据都存在，进行黑白校正（在后台线程中进行，不阻塞主线程）
+  // finalData 的确定逻辑：
+  // - 如果黑白参考数据存在 → finalData = 校正后的数据
+  // - 如果黑白参考数据不存在 → finalData = 未校正的原始数据
+  QVector<double> finalData = averagedData;
+  if (calibration && averagedData.size() == dataPoints) {
+    const qint64 startNs = SpectrumFrame::nowNs();
+    finalData = applyBlackWhiteCorrection(averagedData, *calibration);
+    PipelineStats::record(PipelineStats::Correction, startNs, SpectrumFrame::nowNs(),
+                          static_cast<quint64>(lastFrameTimestampNs_));
   }
-  
+
+  // 找到最大值和最小值（在 finalData 上，可能是校正后的也可能是未校正的）
+  double minVal = 0.0;
+  double maxVal = 0.0;
+  SpectralMath::minMax(finalData.constData(), dataPoints, &minVal, &maxVal);
+
+  // 输出到 QML 的 QVariantList 只构建一次
+  const QVariantList finalList = toVariantList(finalData);
+
+  // 如果启用了预测器，对 finalData 进行预测（在后台线程中执行）
+  // 预测数据说明：
+  // - 如果黑白参考数据存在 → 预测基于校正后的数据
+  // - 如果黑白参考数据不存在 → 预测基于未校正的原始数据
+  performPrediction(finalData);
+
+  // 曲线显示按显示帧率合并，只保留最新一条（共享 finalData，不拷贝）
+  if (displayFeed_) {
+    displayFeed_->submitSpectrum(finalData, minVal, maxVal, packetCount);
+  }
+
+  // 发送处理好的数据到主线程（通过信号，自动使用QueuedConnection）
+  emit spectrumReady(finalList, minVal, maxVal, packetCount, snr);
+}
+
+QVector<double> SpectrumProcessor::applyBlackWhiteCorrection(const QVector<double> &rawData,
+                                                             const SpectralCalibration &calibration) const {
+  // 黑白校正公式：校正后的数据 = (原始数据 - 黑参考) / (白参考 - 黑参考) = 原始数据 * gain + offset
+  // 坏像素（分母太小或白参考饱和）按标定的掩码插值或保留原始值
+  QVector<double> correctedData(rawData.size());
+  calibration.apply(rawData.constData(), correctedData.data());
+  return correctedData;
+}
+
+void SpectrumProcessor::performPrediction(const QVector<double> &correctedSpectrum) {
   QMutexLocker locker(&mutex_);
-  int currentIndex = predictorIndex_;
+  SpectrumPredictorManager *manager = predictorManager_;
+  QVector<int> indices = predictorIndices_;
   locker.unlock();
   
-  if (currentIndex < 0) {
+  if (!manager || indices.isEmpty()) {
     return;
   }
   
-  // 检查预测器是否已加载模型
-  if (!predictorManager_->isModelLoaded(currentIndex)) {
-    qDebug() << "预测器" << currentIndex << "模型未加载，跳过预测";
-    return;
+  // 转换为连续的 float 缓冲区后交给推理执行器，处理线程不等待模型运行
+  auto input = std::make_shared<std::vector<float>>(static_cast<size_t>(correctedSpectrum.size()));
+  for (int i = 0; i < correctedSpectrum.size(); i++) {
+    (*input)[static_cast<size_t>(i)] = static_cast<float>(correctedSpectrum[i]);
+  }
+
+  // 按模型的预处理链变换输入；使用同一条链（或都没有配置）的预测器共用一份缓冲区
+  const qint64 preprocessStartNs = SpectrumFrame::nowNs();
+  std::vector<std::pair<SpectralPreprocessorPtr, std::shared_ptr<const std::vector<float>>>> transformed;
+  bool preprocessed = false;
+  auto inputFor = [&](const SpectralPreprocessorPtr &chain) -> std::shared_ptr<const std::vector<float>> {
+    if (!chain || chain->inputSize() != correctedSpectrum.size()) {
+      return input;
+    }
+    for (const auto &entry : transformed) {
+      if (entry.first == chain) {
+        return entry.second;
+      }
+    }
+    auto output = std::make_shared<std::vector<float>>(static_cast<size_t>(chain->outputSize()));
+    chain->apply(input->data(), output->data());
+    transformed.emplace_back(chain, output);
+    preprocessed = true;
+    return output;
+  };
+
+  std::vector<std::shared_ptr<const std::vector<float>>> inputs;
+  std::vector<std::shared_ptr<const std::vector<float>>> shadowInputs;
+  inputs.reserve(static_cast<size_t>(indices.size()));
+  for (int i = 0; i < indices.size(); i++) {
+    const int index = indices[i];
+    inputs.push_back(inputFor(manager->preprocessor(index)));
+    // 影子模型使用自己的预处理链
+    if (manager->hasShadowModel(index)) {
+      shadowInputs.resize(static_cast<size_t>(indices.size()));
+      shadowInputs[static_cast<size_t>(i)] = inputFor(manager->shadowPreprocessor(index));
+    }
+  }
+  if (preprocessed) {
+    PipelineStats::record(PipelineStats::Preprocess, preprocessStartNs, SpectrumFrame::nowNs(),
+                          static_cast<quint64>(lastFrameTimestampNs_));
   }
-  
-  // 执行预测（在后台线程中）
-  double prediction = predictorManager_->predict(currentIndex, correctedSpectrum);
-  
-  // 发送预测结果信号
-  emit predictionReady(currentIndex, prediction);
-}
 
+  InferenceRequest request;
+  request.predictorIndices = std::move(indices);
+  request.inputs = std::move(inputs);
+  request.shadowInputs = std::move(shadowInputs);
+  request.windowTimestampNs = lastFrameTimestampNs_;
+  request.streamId = streamId_;
+  manager->inferenceExecutor()->submit(std::move(request));
+}
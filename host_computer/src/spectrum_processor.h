@@ -4,59 +4,208 @@
 #include <QThread>
 #include <QVariant>
 #include <QMutex>
-#include <QWaitCondition>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "spectral_calibration.h"
+#include "spectrum_accumulator.h"
+#include "spectrum_frame.h"
+#include "spectrum_frame_queue.h"
 
 class SpectrumPredictorManager;
+class DisplayFeed;
+class SpectrumWorkerPool;
 
 // 光谱数据处理线程，在后台处理数据累积和计算，不阻塞主界面
+// 同时是唯一的采集阶段：帧来源只写入它的输入队列，黑白参考累积、录制与显示作为消费者挂在这里，
+// 每一小批帧先做主光谱累积，再依次交给各消费者，帧数据只从内存读入一次
 class SpectrumProcessor : public QThread {
   Q_OBJECT
 
  public:
+  // 平均方式
+  enum AveragingMode {
+    BlockMode = 0,          // 分块平均：每累积满一个窗口输出一次（默认）
+    SlidingWindowMode = 1,  // 滑动窗口：始终对最近一个窗口的数据求平均，按输出间隔输出
+    EmaMode = 2,            // 指数移动平均：按输出间隔输出
+    AdaptiveMode = 3        // 自适应分块：按逐像素方差估计质量，达到目标信噪比 / 标准误即输出
+  };
+
+  static const int DEFAULT_SPECTRUM_THRESHOLD = 3950;  // 默认达到3950条后处理
+  static const int DEFAULT_OUTPUT_INTERVAL = 100;  // 滚动模式默认每100条输出一次
+  static constexpr double DEFAULT_EMA_TIME_CONSTANT = 1000.0;  // EMA 默认时间常数（数据包数）
+  static constexpr double DEFAULT_ADAPTIVE_TARGET_SNR = 1000.0;  // 自适应模式默认目标信噪比（中位数）
+  static const int DEFAULT_ADAPTIVE_MIN_PACKETS = 400;  // 自适应模式每条光谱至少累积的数据包数
+  static const int DEFAULT_ADAPTIVE_MAX_PACKETS = 4 * DEFAULT_SPECTRUM_THRESHOLD;  // 未达到目标时的上限
+  static const int kAdaptiveCheckInterval = 64;  // 自适应模式每隔多少个数据包检查一次质量
+
   explicit SpectrumProcessor(QObject *parent = nullptr);
   ~SpectrumProcessor();
 
-  // 添加一条光谱数据
-  void addSpectrumData(const QVariantList &data);
+  // 输入队列：由接收线程直接写入（无锁，只保存共享指针，不拷贝帧内容）
+  std::shared_ptr<SpectrumFrameQueue> inputQueue() const { return inputQueue_; }
+
+  // 消费者：在处理线程中与主光谱共用同一批帧（实现不得阻塞）
+  // removeConsumer 返回后处理线程不会再调用该消费者，调用方可以立即销毁它
+  void addConsumer(const std::shared_ptr<SpectrumFrameSink> &consumer);
+  void removeConsumer(const std::shared_ptr<SpectrumFrameSink> &consumer);
+  
+  // 设置黑白校正标定（空表示不校正）；任意线程调用，处理线程从下一条光谱开始使用，不等待
+  void setCalibration(SpectralCalibrationPtr calibration);
+  
+  // 设置每条光谱累积的数据包数（分块模式的窗口、滑动窗口模式的窗口长度）
+  // 以下平均参数均可在运行时修改，修改后重新开始累积
+  void setSpectrumThreshold(int packets);
+  int spectrumThreshold() const { return spectrumThreshold_; }
+  
+  // 设置平均方式（AveragingMode）
+  void setAveragingMode(int mode);
+  int averagingMode() const { return averagingMode_; }
   
-  // 设置黑白参考数据（用于校正）
-  void setBlackReferenceData(const QVariantList &data);
-  void setWhiteReferenceData(const QVariantList &data);
+  // 设置滚动模式（滑动窗口 / EMA）的输出间隔（数据包数）
+  void setOutputInterval(int packets);
+  int outputInterval() const { return outputInterval_; }
   
+  // 设置 EMA 时间常数（以数据包数计），平滑系数 alpha = 1 - exp(-1 / tau)
+  void setEmaTimeConstant(double packets);
+  double emaTimeConstant() const { return emaTimeConstant_; }
+
+  // 自适应模式的目标：中位数信噪比达到 targetSnr 且中位数标准误不超过 targetStdError 时输出
+  // （<= 0 表示不使用该项；两项都不使用时每条光谱累积 maxPackets 个数据包）
+  // 有黑白校正标定时按校正后的值估计，标准误与输出光谱同一单位
+  void setAdaptiveTarget(double targetSnr, double targetStdError);
+  double adaptiveTargetSnr() const { return adaptiveTargetSnr_; }
+  double adaptiveTargetStdError() const { return adaptiveTargetStdError_; }
+
+  // 自适应模式每条光谱累积的数据包数范围
+  void setAdaptiveLimits(int minPackets, int maxPackets);
+  int adaptiveMinPackets() const { return adaptiveMinPackets_; }
+  int adaptiveMaxPackets() const { return adaptiveMaxPackets_; }
+  
+  // 设置实时曲线的显示数据源（在 start() 之前调用），每条输出光谱同时提交给它合并绘制
+  void setDisplayFeed(DisplayFeed *feed) { displayFeed_ = feed; }
+
+  // 光谱来源编号（在 start() 之前调用），随推理请求提交，结果信号中原样带回
+  void setStreamId(int streamId) { streamId_ = streamId; }
+  int streamId() const { return streamId_; }
+
+  // 由共享的工作线程池驱动（在 startProcessing() 之前调用，空表示使用自己的线程）
+  // 多台光谱仪时各设备的处理器共用有限个线程，而不是每台设备一个处理线程
+  void setWorkerPool(SpectrumWorkerPool *pool) { workerPool_ = pool; }
+
+  // 开始处理：有工作线程池时加入线程池，否则启动自己的处理线程
+  void startProcessing();
+
+  // 工作线程调用：处理输入队列中最多 maxFrames 帧，返回处理的帧数（0 表示队列为空）
+  // 同一时刻只能有一个线程调用（自己的处理线程，或线程池中负责它的工作线程）
+  int processPending(int maxFrames);
+
   // 设置预测器管理器（用于预测）
   void setPredictorManager(SpectrumPredictorManager *manager);
   
   // 设置使用的预测器索引（-1 表示不使用预测）
   void setPredictorIndex(int index);
   
+  // 多预测器模式：每条光谱同时提交给多个预测器并行预测（空表示不使用预测）
+  void setPredictorIndices(const QVector<int> &indices);
+  
   // 停止处理
   void stopProcessing();
 
+  // 已从输入队列取出并处理的帧数（任意线程读取，用于吞吐统计）
+  quint64 processedFrames() const { return processedFrames_.load(std::memory_order_relaxed); }
+
  signals:
-  // 处理完成3950条数据后，发送处理好的光谱曲线数据
-  void spectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
-  
-  // 预测完成信号（预测器索引，预测值）
-  void predictionReady(int predictorIndex, double predictionValue);
+  // 分块模式：累积满一个窗口（默认3950条数据）后发送处理好的光谱曲线数据
+  // 滚动模式：每隔 outputInterval 条数据发送一次
+  // 自适应模式：达到目标质量（或 adaptiveMaxPackets）时发送，snr 为实际达到的中位数信噪比（其它模式为 0）
+  void spectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount,
+                     double snr);
 
  protected:
   void run() override;
 
  private:
   // 黑白校正函数：校正后的数据 = (原始数据 - 黑参考) / (白参考 - 黑参考)
-  QVariantList applyBlackWhiteCorrection(const QVariantList &rawData);
+  // 系数已在 SpectralCalibration 中预先计算，这里只做一次乘加
+  QVector<double> applyBlackWhiteCorrection(const QVector<double> &rawData,
+                                            const SpectralCalibration &calibration) const;
   
-  // 使用预测器进行预测（在后台线程中执行）
-  void performPrediction(const QVariantList &correctedSpectrum);
+  // 按当前配置重新初始化平均状态（仅处理线程调用）
+  void resetAveraging();
+
+  // 滑动窗口：移出最旧的一帧并加入新帧
+  void slideWindow(const uint16_t *pixels);
+
+  // EMA：把一帧并入指数移动平均
+  void updateEma(const uint16_t *pixels);
+
+  // 对平均后的光谱进行校正、预测并发送结果
+  void publishSpectrum(const QVector<double> &averagedData, int packetCount, double snr = 0.0);
+
+  // 对累加器中的数据求平均后发送
+  void publishAccumulatorMean(int packetCount, double snr = 0.0);
+
+  // 自适应模式：估计当前累积结果的质量，返回是否已达到目标
+  bool adaptiveTargetReached(SpectrumAccumulator::Quality *quality) const;
+
+  // 把光谱提交给预测器管理器的异步推理执行器（只入队，不等待推理结果）
+  void performPrediction(const QVector<double> &correctedSpectrum);
+
+  // 每次交给消费者的帧数：16 帧约 32 KB，主光谱累积后仍在缓存中
+  static constexpr int kConsumerBatch = 16;
+
+  // 对一批帧做主光谱累积（仅处理线程调用）
+  void accumulateFrames(const SpectrumFramePtr *frames, int count, qint64 popNs);
+
+  // 停止后释放平均状态（处理线程退出或从线程池移除后调用）
+  void releaseAveraging();
+
+  // 每次从队列中取出的最大帧数
+  static constexpr int kPopChunk = 256;
 
-  QMutex mutex_;
-  QWaitCondition condition_;
-  QList<QVariantList> accumulatedData_;  // 累积的光谱数据
-  QVariantList blackReferenceData_;  // 黑参考数据
-  QVariantList whiteReferenceData_;  // 白参考数据
+  QMutex mutex_;  // 保护预测器设置（不在逐帧数据路径上）
+  QMutex consumersMutex_;  // 保护 consumers_；处理线程每取出一批帧加锁一次
+  std::vector<std::shared_ptr<SpectrumFrameSink>> consumers_;
+  std::shared_ptr<SpectrumFrameQueue> inputQueue_;  // 接收线程 → 处理线程的无锁队列
+  std::vector<SpectrumFramePtr> chunk_;  // 本次取出的帧（仅处理线程访问）
+  quint64 appliedConfig_;  // 已生效的平均参数版本（仅处理线程访问）
+  SpectrumAccumulator accumulator_;  // 逐帧累加的像素和（仅处理线程访问）
+  int windowPackets_;  // 分块模式：当前窗口已接收的数据包数（含不完整的包）；滚动模式：距上次输出的数据包数
+  // 以下为滚动模式状态（仅处理线程访问）
+  int activeMode_;  // 当前生效的平均方式
+  int activeThreshold_;  // 当前生效的窗口长度
+  int activeInterval_;  // 当前生效的输出间隔
+  int activeMinPackets_;  // 自适应模式当前生效的最少 / 最多数据包数
+  int activeMaxPackets_;
+  double activeTargetSnr_;  // 自适应模式当前生效的目标
+  double activeTargetStdError_;
+  std::vector<uint16_t> windowRing_;  // 滑动窗口内各帧的像素（环形缓冲）
+  int windowHead_;  // 最旧一帧在环中的位置
+  int windowFill_;  // 环中的帧数
+  QVector<double> ema_;  // 逐像素指数移动平均
+  double emaAlpha_;  // EMA 平滑系数
+  bool emaInitialized_;
+  // 当前标定：只通过 std::atomic_load / atomic_store 访问（RCU 式替换，旧标定在最后一个使用者释放后销毁）
+  SpectralCalibrationPtr calibration_;
+  qint64 lastFrameTimestampNs_;  // 最近一帧的接收时间戳，作为输出光谱的窗口时间戳（仅处理线程访问）
   SpectrumPredictorManager *predictorManager_;  // 预测器管理器
-  int predictorIndex_;  // 当前使用的预测器索引（-1 表示不使用）
-  bool stopRequested_;
-  static const int SPECTRUM_THRESHOLD = 3950;  // 达到3950条后处理
+  DisplayFeed *displayFeed_;  // 显示数据源（可为空）
+  SpectrumWorkerPool *workerPool_;  // 共享工作线程池（为空时使用自己的线程）
+  int streamId_;  // 光谱来源编号
+  QVector<int> predictorIndices_;  // 当前使用的预测器索引（空表示不使用）
+  std::atomic<bool> stopRequested_;
+  std::atomic<quint64> processedFrames_;
+  std::atomic<int> spectrumThreshold_;  // 每个窗口的数据包数
+  std::atomic<int> averagingMode_;  // 平均方式
+  std::atomic<int> outputInterval_;  // 滚动模式的输出间隔
+  std::atomic<double> emaTimeConstant_;  // EMA 时间常数（数据包数）
+  std::atomic<double> adaptiveTargetSnr_;  // 自适应模式目标信噪比
+  std::atomic<double> adaptiveTargetStdError_;  // 自适应模式目标标准误
+  std::atomic<int> adaptiveMinPackets_;
+  std::atomic<int> adaptiveMaxPackets_;
+  std::atomic<quint64> configVersion_;  // 平均参数版本号，变化时处理线程重新开始累积
 };
 
@@ -0,0 +1,52 @@
+#include "spectrum_record.h"
+
+#include <utility>
+
+QVariantMap SpectrumRecordInfo::toVariantMap() const {
+  QVariantMap recMap;
+  recMap.insert(QStringLiteral("index"), static_cast<int>(index));
+  recMap.insert(QStringLiteral("label"), label);
+  recMap.insert(QStringLiteral("time"), time);
+  recMap.insert(QStringLiteral("length"), length);
+  recMap.insert(QStringLiteral("minVal"), minVal);
+  recMap.insert(QStringLiteral("maxVal"), maxVal);
+  recMap.insert(QStringLiteral("moisture"), moisture);
+  return recMap;
+}
+
+VariantRecordList::VariantRecordList(const QVariantList &records, SpectrumResolver spectrumFor)
+    : records_(records), spectrumFor_(std::move(spectrumFor)) {
+}
+
+QVariantList VariantRecordList::spectrumOf(const QVariantMap &record) const {
+  const QVariant spectrumVar = record.value(QStringLiteral("spectrum"));
+  if (spectrumVar.isValid() || !spectrumFor_) {
+    return spectrumVar.toList();
+  }
+  return spectrumFor_(record);
+}
+
+SpectrumRecordInfo VariantRecordList::recordInfo(qint64 r) const {
+  const QVariantMap recMap = records_[static_cast<int>(r)].toMap();
+  SpectrumRecordInfo info;
+  info.index = recMap.value(QStringLiteral("index")).toLongLong();
+  info.label = recMap.value(QStringLiteral("label")).toString();
+  info.time = recMap.value(QStringLiteral("time"));
+  info.minVal = recMap.value(QStringLiteral("minVal")).toDouble();
+  info.maxVal = recMap.value(QStringLiteral("maxVal")).toDouble();
+  info.moisture = recMap.value(QStringLiteral("moisture")).toDouble();
+  // 自带光谱时以实际点数为准，延迟加载的归档记录只有 length
+  info.length = recMap.contains(QStringLiteral("spectrum"))
+                    ? static_cast<int>(recMap.value(QStringLiteral("spectrum")).toList().size())
+                    : recMap.value(QStringLiteral("length")).toInt();
+  return info;
+}
+
+int VariantRecordList::readSpectrum(qint64 r, double *out, int maxPoints) const {
+  const QVariantList spectrum = spectrumOf(records_[static_cast<int>(r)].toMap());
+  const int n = qMin(static_cast<int>(spectrum.size()), maxPoints);
+  for (int i = 0; i < n; ++i) {
+    out[i] = spectrum[i].toDouble();
+  }
+  return n;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+#include <QVariantMap>
+#include <functional>
+
+// 一条光谱记录的元数据（不含光谱），字段与表格 CSV / .spa 归档中的列相同
+struct SpectrumRecordInfo {
+  qint64 index = 0;
+  QString label;
+  QVariant time;  // QDateTime，无法解析为时间时为原始文本
+  int length = 0;  // 光谱点数
+  double minVal = 0.0;
+  double maxVal = 0.0;
+  double moisture = 0.0;
+
+  QVariantMap toVariantMap() const;
+};
+
+// 按记录号顺序提供记录的数据源：导出归档 / 表格 CSV 时逐条读取元数据与光谱，不必先拼成 QVariantList
+class SpectrumRecordSource {
+ public:
+  virtual ~SpectrumRecordSource() = default;
+
+  virtual qint64 recordCount() const = 0;
+  virtual SpectrumRecordInfo recordInfo(qint64 r) const = 0;
+  // 把第 r 条光谱（最多 maxPoints 个点）写入 out，返回点数
+  virtual int readSpectrum(qint64 r, double *out, int maxPoints) const = 0;
+};
+
+// 把 QML 传来的记录列表（每条是 QVariantMap，键同 SpectrumRecordInfo，另有 spectrum）包装为数据源
+// 记录中没有 spectrum 时调用 spectrumFor(record) 获取（用于延迟加载的归档记录）
+class VariantRecordList : public SpectrumRecordSource {
+ public:
+  using SpectrumResolver = std::function<QVariantList(const QVariantMap &record)>;
+
+  explicit VariantRecordList(const QVariantList &records, SpectrumResolver spectrumFor = SpectrumResolver());
+
+  qint64 recordCount() const override { return records_.size(); }
+  SpectrumRecordInfo recordInfo(qint64 r) const override;
+  int readSpectrum(qint64 r, double *out, int maxPoints) const override;
+
+ private:
+  QVariantList spectrumOf(const QVariantMap &record) const;
+
+  const QVariantList &records_;
+  SpectrumResolver spectrumFor_;
+};
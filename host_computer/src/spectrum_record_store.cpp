@@ -0,0 +1,560 @@
+#include "spectrum_record_store.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+
+#include "spectrum_archive.h"
+#include "spectrum_file_manager.h"
+#include "spectrum_frame.h"
+
+namespace {
+
+constexpr int kInitialSlots = 64;  // 池首次分配的槽位数，之后按倍数增长到上限
+
+// 溢出时只写出选中的几行
+class RowSubset : public SpectrumRecordSource {
+ public:
+  RowSubset(const SpectrumRecordSource &source, const std::vector<int> &rows) : source_(source), rows_(rows) {}
+
+  qint64 recordCount() const override { return static_cast<qint64>(rows_.size()); }
+  SpectrumRecordInfo recordInfo(qint64 r) const override { return source_.recordInfo(rows_[static_cast<size_t>(r)]); }
+  int readSpectrum(qint64 r, double *out, int maxPoints) const override {
+    return source_.readSpectrum(rows_[static_cast<size_t>(r)], out, maxPoints);
+  }
+
+ private:
+  const SpectrumRecordSource &source_;
+  const std::vector<int> &rows_;
+};
+
+std::vector<double> toValues(const QVariantList &spectrum) {
+  std::vector<double> values(static_cast<size_t>(spectrum.size()));
+  for (int i = 0; i < spectrum.size(); ++i) {
+    values[static_cast<size_t>(i)] = spectrum[i].toDouble();
+  }
+  return values;
+}
+
+void setRange(SpectrumRecordInfo *info, const std::vector<double> &values) {
+  info->length = static_cast<int>(values.size());
+  info->minVal = values.empty() ? 0.0 : *std::min_element(values.begin(), values.end());
+  info->maxVal = values.empty() ? 0.0 : *std::max_element(values.begin(), values.end());
+}
+
+QString defaultSpillDirectory() {
+  QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (base.isEmpty()) {
+    base = QDir::tempPath();
+  }
+  return QDir(base).filePath(QStringLiteral("spill"));
+}
+
+}  // namespace
+
+SpectrumRecordStore::SpectrumRecordStore(QObject *parent)
+    : QAbstractListModel(parent),
+      stride_(SpectrumFrame::kPixelCount),
+      slotCount_(0),
+      capacity_(DEFAULT_MEMORY_CAPACITY),
+      inMemory_(0),
+      spillDir_(defaultSpillDirectory()),
+      spillDirPrepared_(false),
+      spillSerial_(0),
+      bulkLoading_(false) {
+}
+
+SpectrumRecordStore::~SpectrumRecordStore() {
+  resetRows();
+}
+
+int SpectrumRecordStore::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) {
+    return 0;
+  }
+  return static_cast<int>(rows_.size());
+}
+
+QVariant SpectrumRecordStore::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() < 0 || index.row() >= rowCount()) {
+    return QVariant();
+  }
+  const Row &row = rows_[static_cast<size_t>(index.row())];
+  switch (role) {
+    case IndexRole:
+      return static_cast<int>(row.info.index);
+    case LabelRole:
+    case Qt::DisplayRole:
+      return row.info.label;
+    case TimeRole:
+      return row.info.time;
+    case LengthRole:
+      return row.info.length;
+    case MinValRole:
+      return row.info.minVal;
+    case MaxValRole:
+      return row.info.maxVal;
+    case MoistureRole:
+      return row.info.moisture;
+    case InMemoryRole:
+      return row.slot >= 0;
+    default:
+      return QVariant();
+  }
+}
+
+bool SpectrumRecordStore::setData(const QModelIndex &index, const QVariant &value, int role) {
+  if (!index.isValid() || index.row() < 0 || index.row() >= rowCount()) {
+    return false;
+  }
+  Row &row = rows_[static_cast<size_t>(index.row())];
+  if (role == LabelRole) {
+    row.info.label = value.toString();
+  } else if (role == MoistureRole) {
+    bool ok = false;
+    const double moisture = value.toDouble(&ok);
+    if (!ok) {
+      return false;
+    }
+    row.info.moisture = moisture;
+  } else {
+    return false;
+  }
+  emit dataChanged(index, index, {role});
+  return true;
+}
+
+Qt::ItemFlags SpectrumRecordStore::flags(const QModelIndex &index) const {
+  return QAbstractListModel::flags(index) | Qt::ItemIsEditable;
+}
+
+QHash<int, QByteArray> SpectrumRecordStore::roleNames() const {
+  QHash<int, QByteArray> roles;
+  roles.insert(IndexRole, "recordIndex");
+  roles.insert(LabelRole, "label");
+  roles.insert(TimeRole, "time");
+  roles.insert(LengthRole, "length");
+  roles.insert(MinValRole, "minVal");
+  roles.insert(MaxValRole, "maxVal");
+  roles.insert(MoistureRole, "moisture");
+  roles.insert(InMemoryRole, "inMemory");
+  return roles;
+}
+
+void SpectrumRecordStore::setMemoryCapacity(int records) {
+  records = qMax(1, records);
+  if (records == capacity_) {
+    return;
+  }
+  capacity_ = records;
+  if (inMemory_ > capacity_) {
+    spillOldest(inMemory_ - capacity_);
+  }
+  // 收回超出上限的槽位（溢出失败时保留仍在使用的部分）
+  if (slotCount_ > capacity_) {
+    relayout(stride_, qMax(inMemory_, capacity_));
+  }
+  emit memoryUsageChanged();
+}
+
+void SpectrumRecordStore::setSpillDirectory(const QString &path) {
+  if (path == spillDir_) {
+    return;
+  }
+  spillDir_ = path;
+  spillDirPrepared_ = false;
+  emit spillDirectoryChanged();
+  setSpillError(QString());
+}
+
+void SpectrumRecordStore::setSpillError(const QString &reason) {
+  if (reason == spillError_) {
+    return;
+  }
+  spillError_ = reason;
+  if (!reason.isEmpty()) {
+    qWarning() << "[SpectrumRecordStore] Spill failed, keeping records in memory:" << reason;
+  }
+  emit spillErrorChanged();
+}
+
+void SpectrumRecordStore::relayout(int stride, int slotCount) {
+  std::vector<float> arena(static_cast<size_t>(slotCount) * static_cast<size_t>(stride), 0.0f);
+  int next = 0;
+  for (Row &row : rows_) {
+    if (row.slot < 0) {
+      continue;
+    }
+    const int points = qMin(row.info.length, qMin(stride_, stride));
+    std::memcpy(arena.data() + static_cast<size_t>(next) * static_cast<size_t>(stride), slotData(row.slot),
+                static_cast<size_t>(points) * sizeof(float));
+    row.slot = next++;
+  }
+  arena_.swap(arena);
+  stride_ = stride;
+  slotCount_ = slotCount;
+  // 空槽按降序存放，pop_back 先取到低位槽位
+  freeSlots_.clear();
+  for (int slot = slotCount - 1; slot >= next; --slot) {
+    freeSlots_.push_back(slot);
+  }
+}
+
+int SpectrumRecordStore::acquireSlot(int length) {
+  if (length > stride_) {
+    relayout(length, slotCount_);
+  }
+  if (freeSlots_.empty()) {
+    if (slotCount_ < capacity_) {
+      relayout(stride_, qMin(capacity_, qMax(kInitialSlots, slotCount_ * 2)));
+    } else {
+      // 溢出失败期间池超过了上限：恢复后的首次溢出把超出的部分一并写出，再把池收回到上限
+      const bool overCapacity = slotCount_ > capacity_;
+      const int batch = qMax(1, capacity_ / 4);
+      if (!spillOldest(overCapacity ? inMemory_ - capacity_ + batch : batch)) {
+        // 无法写出溢出段时暂时超过上限，保证不丢记录；按倍数扩容，池再次填满前不重试溢出
+        relayout(stride_, slotCount_ * 2);
+      } else if (overCapacity) {
+        relayout(stride_, capacity_);
+      }
+    }
+  }
+  const int slot = freeSlots_.back();
+  freeSlots_.pop_back();
+  ++inMemory_;
+  return slot;
+}
+
+void SpectrumRecordStore::releaseSlot(int slot) {
+  freeSlots_.push_back(slot);
+  --inMemory_;
+}
+
+void SpectrumRecordStore::storeSpectrum(Row &row, int slot, const double *values, int length) {
+  float *out = slotData(slot);
+  for (int i = 0; i < length; ++i) {
+    out[i] = static_cast<float>(values[i]);
+  }
+  row.slot = slot;
+}
+
+bool SpectrumRecordStore::spillOldest(int count) {
+  std::vector<int> picked;
+  for (int r = 0; r < static_cast<int>(rows_.size()) && static_cast<int>(picked.size()) < count; ++r) {
+    if (rows_[static_cast<size_t>(r)].slot >= 0) {
+      picked.push_back(r);
+    }
+  }
+  if (picked.empty()) {
+    return false;
+  }
+
+  if (!spillDirPrepared_) {
+    QDir dir(spillDir_);
+    if (!dir.mkpath(QStringLiteral("."))) {
+      setSpillError(QStringLiteral("无法创建溢出目录 %1").arg(spillDir_));
+      return false;
+    }
+    // 上次异常退出时残留的溢出段（本进程的段仍在使用，跳过）
+    const QString ownPrefix = QStringLiteral("records_%1_").arg(QCoreApplication::applicationPid());
+    for (const QString &name : dir.entryList({QStringLiteral("records_*.spa")}, QDir::Files)) {
+      if (!name.startsWith(ownPrefix)) {
+        dir.remove(name);
+      }
+    }
+    spillDirPrepared_ = true;
+  }
+
+  const QString path = QDir(spillDir_).filePath(
+      QStringLiteral("records_%1_%2.spa").arg(QCoreApplication::applicationPid()).arg(spillSerial_++));
+  auto archive = std::make_unique<SpectrumArchive>();
+  if (!SpectrumArchive::write(path, RowSubset(*this, picked), SpectrumArchive::Float32Samples) ||
+      !archive->open(path)) {
+    QFile::remove(path);
+    setSpillError(QStringLiteral("无法写入溢出段 %1").arg(path));
+    return false;
+  }
+  setSpillError(QString());
+
+  const int segment = addSegment(std::move(archive), true);
+  for (size_t k = 0; k < picked.size(); ++k) {
+    Row &row = rows_[static_cast<size_t>(picked[k])];
+    releaseSlot(row.slot);
+    row.slot = -1;
+    row.segment = segment;
+    row.segmentIndex = static_cast<qint64>(k);
+    segments_[static_cast<size_t>(segment)].refs++;
+  }
+  if (!bulkLoading_) {
+    emit dataChanged(index(picked.front()), index(picked.back()), {InMemoryRole});
+  }
+  qDebug() << "[SpectrumRecordStore] Spilled" << picked.size() << "records to" << path;
+  return true;
+}
+
+int SpectrumRecordStore::addSegment(std::unique_ptr<SpectrumArchive> archive, bool spill) {
+  Segment segment;
+  segment.archive = std::move(archive);
+  segment.spill = spill;
+  segments_.push_back(std::move(segment));
+  return static_cast<int>(segments_.size()) - 1;
+}
+
+void SpectrumRecordStore::releaseSegment(int segment) {
+  Segment &seg = segments_[static_cast<size_t>(segment)];
+  if (--seg.refs > 0 || !seg.archive) {
+    return;
+  }
+  const QString path = seg.archive->filePath();
+  seg.archive.reset();
+  if (seg.spill) {
+    QFile::remove(path);
+  }
+}
+
+void SpectrumRecordStore::releaseRow(Row &row) {
+  if (row.slot >= 0) {
+    releaseSlot(row.slot);
+  }
+  if (row.segment >= 0) {
+    releaseSegment(row.segment);
+  }
+  row.slot = -1;
+  row.segment = -1;
+  row.segmentIndex = 0;
+}
+
+void SpectrumRecordStore::resetRows() {
+  for (Row &row : rows_) {
+    releaseRow(row);
+  }
+  rows_.clear();
+  segments_.clear();
+  std::vector<float>().swap(arena_);
+  freeSlots_.clear();
+  slotCount_ = 0;
+  inMemory_ = 0;
+  stride_ = SpectrumFrame::kPixelCount;
+}
+
+int SpectrumRecordStore::append(const QVariantList &spectrum, const QString &label, double moisture) {
+  if (spectrum.size() > MAX_SPECTRUM_POINTS) {
+    qWarning() << "[SpectrumRecordStore] Spectrum too long, not appended:" << spectrum.size() << "points";
+    return -1;
+  }
+  const std::vector<double> values = toValues(spectrum);
+  Row row;
+  row.info.index = static_cast<qint64>(rows_.size()) + 1;
+  row.info.label = label;
+  row.info.time = QDateTime::currentDateTime();
+  row.info.moisture = moisture;
+  setRange(&row.info, values);
+  storeSpectrum(row, acquireSlot(row.info.length), values.data(), row.info.length);
+
+  const int position = static_cast<int>(rows_.size());
+  beginInsertRows(QModelIndex(), position, position);
+  rows_.push_back(std::move(row));
+  endInsertRows();
+  emit countChanged();
+  emit memoryUsageChanged();
+  return position;
+}
+
+QVariantMap SpectrumRecordStore::get(int row) const {
+  if (row < 0 || row >= rowCount()) {
+    return QVariantMap();
+  }
+  QVariantMap recMap = rows_[static_cast<size_t>(row)].info.toVariantMap();
+  recMap.insert(QStringLiteral("inMemory"), rows_[static_cast<size_t>(row)].slot >= 0);
+  return recMap;
+}
+
+QVariantList SpectrumRecordStore::spectrum(int row) const {
+  QVariantList result;
+  if (row < 0 || row >= rowCount()) {
+    return result;
+  }
+  std::vector<double> values(static_cast<size_t>(rows_[static_cast<size_t>(row)].info.length));
+  const int n = readSpectrum(row, values.data(), static_cast<int>(values.size()));
+  result.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    result.append(values[static_cast<size_t>(i)]);
+  }
+  return result;
+}
+
+bool SpectrumRecordStore::setSpectrum(int row, const QVariantList &spectrum) {
+  if (row < 0 || row >= rowCount()) {
+    return false;
+  }
+  if (spectrum.size() > MAX_SPECTRUM_POINTS) {
+    qWarning() << "[SpectrumRecordStore] Spectrum too long, row" << row << "unchanged:" << spectrum.size() << "points";
+    return false;
+  }
+  const std::vector<double> values = toValues(spectrum);
+  // 先释放旧光谱，腾出的槽位可直接复用，也避免本行在 acquireSlot 中被溢出
+  releaseRow(rows_[static_cast<size_t>(row)]);
+  const int slot = acquireSlot(static_cast<int>(values.size()));
+  Row &target = rows_[static_cast<size_t>(row)];
+  setRange(&target.info, values);
+  storeSpectrum(target, slot, values.data(), target.info.length);
+  emit dataChanged(index(row), index(row));
+  emit memoryUsageChanged();
+  return true;
+}
+
+void SpectrumRecordStore::remove(int row) {
+  if (row < 0 || row >= rowCount()) {
+    return;
+  }
+  beginRemoveRows(QModelIndex(), row, row);
+  releaseRow(rows_[static_cast<size_t>(row)]);
+  rows_.erase(rows_.begin() + row);
+  endRemoveRows();
+  emit countChanged();
+  emit memoryUsageChanged();
+}
+
+void SpectrumRecordStore::clear() {
+  if (rows_.empty() && segments_.empty()) {
+    return;
+  }
+  beginResetModel();
+  resetRows();
+  endResetModel();
+  emit countChanged();
+  emit memoryUsageChanged();
+}
+
+SpectrumRecordInfo SpectrumRecordStore::recordInfo(qint64 r) const {
+  if (r < 0 || r >= recordCount()) {
+    return SpectrumRecordInfo();
+  }
+  return rows_[static_cast<size_t>(r)].info;
+}
+
+int SpectrumRecordStore::readSpectrum(qint64 r, double *out, int maxPoints) const {
+  if (r < 0 || r >= recordCount()) {
+    return 0;
+  }
+  const Row &row = rows_[static_cast<size_t>(r)];
+  const int n = qMin(row.info.length, maxPoints);
+  if (row.slot >= 0) {
+    const float *values = slotData(row.slot);
+    for (int i = 0; i < n; ++i) {
+      out[i] = values[i];
+    }
+    return n;
+  }
+  if (row.segment >= 0) {
+    const SpectrumArchive *archive = segments_[static_cast<size_t>(row.segment)].archive.get();
+    return archive ? archive->readSpectrum(row.segmentIndex, out, n) : 0;
+  }
+  return 0;
+}
+
+bool SpectrumRecordStore::writeReplacing(const QString &filePath,
+                                         const std::function<bool(const QString &path)> &writer) const {
+  // 目标正是某个已挂载的段时不能原地截断（mmap 会失效），先写到临时文件再替换
+  const QString target = QFileInfo(filePath).absoluteFilePath();
+  const bool mapped = std::any_of(segments_.begin(), segments_.end(), [&target](const Segment &seg) {
+    return seg.archive && QFileInfo(seg.archive->filePath()).absoluteFilePath() == target;
+  });
+  if (!mapped) {
+    return writer(filePath);
+  }
+  const QString partial = filePath + QStringLiteral(".part");
+  if (!writer(partial)) {
+    QFile::remove(partial);
+    return false;
+  }
+  // 已映射的旧文件被删除后内容仍然有效，直到段关闭
+  return QFile::remove(filePath) && QFile::rename(partial, filePath);
+}
+
+bool SpectrumRecordStore::exportArchive(const QString &filePath, bool rawCounts) const {
+  const SpectrumArchive::SampleType sampleType =
+      rawCounts ? SpectrumArchive::UInt16Samples : SpectrumArchive::Float32Samples;
+  return writeReplacing(filePath, [this, sampleType](const QString &path) {
+    return SpectrumArchive::write(path, *this, sampleType);
+  });
+}
+
+bool SpectrumRecordStore::exportCsv(const QString &filePath) const {
+  return writeReplacing(filePath, [this](const QString &path) {
+    return SpectrumFileManager::saveSpectraTableToCsv(*this, path);
+  });
+}
+
+int SpectrumRecordStore::importFile(const QString &filePath, bool append) {
+  if (filePath.endsWith(QStringLiteral(".spa"), Qt::CaseInsensitive)) {
+    // 归档先打开成功再清空，失败时保留现有记录
+    auto archive = std::make_unique<SpectrumArchive>();
+    if (!archive->open(filePath)) {
+      return -1;
+    }
+    const qint64 count = archive->recordCount();
+    beginResetModel();
+    if (!append) {
+      resetRows();
+    }
+    const SpectrumArchive *source = archive.get();
+    const int segment = addSegment(std::move(archive), false);
+    rows_.reserve(rows_.size() + static_cast<size_t>(count));
+    for (qint64 i = 0; i < count; ++i) {
+      Row row;
+      row.info = source->recordInfo(i);
+      row.segment = segment;
+      row.segmentIndex = i;
+      rows_.push_back(std::move(row));
+    }
+    segments_[static_cast<size_t>(segment)].refs = static_cast<int>(count);
+    if (count == 0) {
+      segments_[static_cast<size_t>(segment)].archive.reset();
+    }
+    endResetModel();
+    emit countChanged();
+    emit memoryUsageChanged();
+    return static_cast<int>(count);
+  }
+
+  // CSV 逐行写入池，超过上限时照常溢出；表头有效后才清空现有记录
+  beginResetModel();
+  bulkLoading_ = true;
+  bool cleared = append;
+  qint64 skipped = 0;
+  const qint64 count = SpectrumFileManager::readSpectraTable(
+      filePath, [this, &cleared, &skipped](const SpectrumRecordInfo &info, const double *values, int points) {
+        if (!cleared) {
+          resetRows();
+          cleared = true;
+        }
+        if (points > MAX_SPECTRUM_POINTS) {
+          skipped++;
+          return;
+        }
+        Row row;
+        row.info = info;
+        row.info.length = points;
+        storeSpectrum(row, acquireSlot(points), values, points);
+        rows_.push_back(std::move(row));
+      });
+  if (count == 0 && !cleared) {
+    resetRows();
+  }
+  bulkLoading_ = false;
+  endResetModel();
+  if (skipped > 0) {
+    qWarning() << "[SpectrumRecordStore] Skipped" << skipped << "spectra longer than" << MAX_SPECTRUM_POINTS
+               << "points in" << filePath;
+  }
+  emit countChanged();
+  emit memoryUsageChanged();
+  return static_cast<int>(count - skipped);
+}
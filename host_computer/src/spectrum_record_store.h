@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVariant>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "spectrum_record.h"
+
+class SpectrumArchive;
+
+// 单条光谱采集窗口的记录列表模型，供 QML ListView 显示（角色只含元数据，光谱通过 spectrum(row) 按需读取）
+// - 内存中的光谱存放在一块连续的 float 池中（固定步长的槽位，空槽复用），最多 memoryCapacity 条
+// - 超过上限时把最旧的一批内存光谱写成 .spa 溢出段（spillDirectory 下），之后按需从 mmap 读取
+// - 导入的 .spa 归档直接挂为只读段，光谱留在文件中；导入的 CSV 逐行写入池，超限时同样溢出
+// - 导出 CSV / 归档时逐条从池或段中读取，不构造完整的 QVariantList
+// - 只能在主线程访问
+class SpectrumRecordStore : public QAbstractListModel, public SpectrumRecordSource {
+  Q_OBJECT
+  Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+  Q_PROPERTY(int memoryCapacity READ memoryCapacity WRITE setMemoryCapacity NOTIFY memoryUsageChanged)
+  Q_PROPERTY(int inMemoryCount READ inMemoryCount NOTIFY memoryUsageChanged)
+  Q_PROPERTY(QString spillDirectory READ spillDirectory WRITE setSpillDirectory NOTIFY spillDirectoryChanged)
+  Q_PROPERTY(QString spillError READ spillError NOTIFY spillErrorChanged)
+
+ public:
+  enum Roles {
+    IndexRole = Qt::UserRole + 1,
+    LabelRole,
+    TimeRole,
+    LengthRole,
+    MinValRole,
+    MaxValRole,
+    MoistureRole,
+    InMemoryRole
+  };
+
+  static const int DEFAULT_MEMORY_CAPACITY = 2048;  // 1024 点时约 8 MB
+  // 池的步长取最长的光谱，单条光谱超过此点数时拒绝写入（默认上限下池最多约 64 MB）
+  static const int MAX_SPECTRUM_POINTS = 8192;
+
+  explicit SpectrumRecordStore(QObject *parent = nullptr);
+  ~SpectrumRecordStore() override;
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+  Qt::ItemFlags flags(const QModelIndex &index) const override;
+  QHash<int, QByteArray> roleNames() const override;
+
+  // 内存中最多保留的光谱条数（>= 1），调小时立即溢出多余的部分
+  int memoryCapacity() const { return capacity_; }
+  void setMemoryCapacity(int records);
+  int inMemoryCount() const { return inMemory_; }
+
+  // 溢出段所在目录（默认 <缓存目录>/spill，无法确定缓存目录时为 <临时目录>/spill），
+  // 目录中残留的 records_*.spa 会在首次溢出时删除
+  QString spillDirectory() const { return spillDir_; }
+  void setSpillDirectory(const QString &path);
+  // 最近一次溢出失败的原因，为空表示正常。失败时内存池按倍数扩容，记录不丢失但会超过上限；
+  // 溢出恢复后的首次溢出写出超出上限的记录，内存池收回到上限
+  QString spillError() const { return spillError_; }
+
+  // 追加一条记录（时间取当前时间，序号为上一条 + 1，最小/最大值由光谱计算），返回行号；
+  // 光谱超过 MAX_SPECTRUM_POINTS 点时返回 -1
+  Q_INVOKABLE int append(const QVariantList &spectrum, const QString &label, double moisture);
+
+  // 单条记录的元数据（键同表格 CSV），越界返回空
+  Q_INVOKABLE QVariantMap get(int row) const;
+  // 单条光谱，内存中直接复制，已溢出或来自归档时从 mmap 读取
+  Q_INVOKABLE QVariantList spectrum(int row) const;
+  // 替换一条记录的光谱并更新长度与最小/最大值（超过 MAX_SPECTRUM_POINTS 点时返回 false）
+  Q_INVOKABLE bool setSpectrum(int row, const QVariantList &spectrum);
+
+  Q_INVOKABLE void remove(int row);
+  Q_INVOKABLE void clear();
+
+  // 流式导出：.spa 归档（rawCounts 为 true 时以 uint16 保存）或表格 CSV（格式同 saveAllSpectraTableToCsv）
+  Q_INVOKABLE bool exportArchive(const QString &filePath, bool rawCounts = false) const;
+  Q_INVOKABLE bool exportCsv(const QString &filePath) const;
+
+  // 导入 .spa 归档（按需读取）或表格 CSV，append 为 false 时先清空，返回导入的条数，失败返回 -1；
+  // CSV 中超过 MAX_SPECTRUM_POINTS 点的行被跳过
+  Q_INVOKABLE int importFile(const QString &filePath, bool append);
+
+  // SpectrumRecordSource
+  qint64 recordCount() const override { return static_cast<qint64>(rows_.size()); }
+  SpectrumRecordInfo recordInfo(qint64 r) const override;
+  int readSpectrum(qint64 r, double *out, int maxPoints) const override;
+
+ signals:
+  void countChanged();
+  void memoryUsageChanged();
+  void spillDirectoryChanged();
+  void spillErrorChanged();
+
+ private:
+  struct Row {
+    SpectrumRecordInfo info;
+    int slot = -1;  // 光谱在池中的槽位，-1 表示在段中
+    int segment = -1;  // 所在段（溢出文件或导入的归档）
+    qint64 segmentIndex = 0;
+  };
+
+  struct Segment {
+    std::unique_ptr<SpectrumArchive> archive;  // 不再被引用时关闭并置空
+    int refs = 0;
+    bool spill = false;  // 溢出文件在释放时删除，导入的归档保持原样
+  };
+
+  // 取得一个空槽位（必要时先溢出最旧的记录），并保证步长不小于 length
+  int acquireSlot(int length);
+  void releaseSlot(int slot);
+  float *slotData(int slot) { return arena_.data() + static_cast<size_t>(slot) * static_cast<size_t>(stride_); }
+  const float *slotData(int slot) const {
+    return arena_.data() + static_cast<size_t>(slot) * static_cast<size_t>(stride_);
+  }
+  // 按新步长 / 槽位数重排池，内存中的记录依次放到前面的槽位
+  void relayout(int stride, int slotCount);
+  // 把最旧的 count 条内存记录写成一个溢出段，失败时返回 false（记录仍留在内存中）
+  bool spillOldest(int count);
+  // 记录溢出失败的原因（只在状态变化时告警一次），reason 为空表示已恢复
+  void setSpillError(const QString &reason);
+  int addSegment(std::unique_ptr<SpectrumArchive> archive, bool spill);
+  void releaseSegment(int segment);
+  void releaseRow(Row &row);
+  void storeSpectrum(Row &row, int slot, const double *values, int length);
+  bool writeReplacing(const QString &filePath, const std::function<bool(const QString &path)> &writer) const;
+  void resetRows();
+
+  std::vector<Row> rows_;
+  std::vector<float> arena_;  // slotCount_ × stride_ 个 float
+  int stride_;
+  int slotCount_;
+  std::vector<int> freeSlots_;
+  int capacity_;
+  int inMemory_;
+  std::vector<Segment> segments_;  // 下标即段号
+  QString spillDir_;
+  bool spillDirPrepared_;
+  int spillSerial_;
+  QString spillError_;
+  bool bulkLoading_;  // 批量导入期间（模型已在重置中）不发出逐行的 dataChanged
+};
@@ -0,0 +1,182 @@
+#include "spectrum_worker_pool.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+#include "spectrum_frame_queue.h"
+#include "spectrum_processor.h"
+#include "thread_placement.h"
+
+namespace {
+
+constexpr int kIdleTimeoutMs = 500;  // 无唤醒时的最长等待，兼作停止检查周期
+
+}  // namespace
+
+class SpectrumWorkerPool::Worker : public QThread {
+ public:
+  Worker() : wakeFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), version_(0), stopRequested_(false) {}
+
+  ~Worker() override {
+    stopRequested_ = true;
+    wake();
+    wait();
+    if (wakeFd_ >= 0) {
+      close(wakeFd_);
+    }
+  }
+
+  int processorCount() {
+    QMutexLocker locker(&mutex_);
+    return static_cast<int>(processors_.size());
+  }
+
+  void add(SpectrumProcessor *processor) {
+    {
+      QMutexLocker locker(&mutex_);
+      processors_.push_back({processor, processor->inputQueue()});
+      version_.fetch_add(1, std::memory_order_release);
+    }
+    wake();
+  }
+
+  bool remove(SpectrumProcessor *processor) {
+    // 工作线程只在持有 mutex_ 时调用处理器，拿到锁即说明它已不在使用中
+    QMutexLocker locker(&mutex_);
+    auto it = std::find_if(processors_.begin(), processors_.end(),
+                           [processor](const Entry &entry) { return entry.processor == processor; });
+    if (it == processors_.end()) {
+      return false;
+    }
+    processors_.erase(it);
+    version_.fetch_add(1, std::memory_order_release);
+    wake();
+    return true;
+  }
+
+ protected:
+  void run() override {
+    ThreadPlacement::applyToCurrentThread(ThreadPlacement::Processor);
+    std::vector<Entry> local;  // 仅工作线程访问；队列由共享指针保活，等待期间处理器被移除也不会失效
+    quint64 localVersion = ~0ULL;
+    std::vector<struct pollfd> fds;
+
+    while (!stopRequested_) {
+      bool busy = false;
+      {
+        QMutexLocker locker(&mutex_);
+        const quint64 version = version_.load(std::memory_order_acquire);
+        if (version != localVersion) {
+          localVersion = version;
+          local = processors_;
+        }
+        for (const Entry &entry : local) {
+          if (entry.processor->processPending(kSliceFrames) > 0) {
+            busy = true;
+          }
+        }
+      }
+      if (busy) {
+        continue;
+      }
+      waitForFrames(local, &fds);
+    }
+  }
+
+ private:
+  struct Entry {
+    SpectrumProcessor *processor;
+    std::shared_ptr<SpectrumFrameQueue> queue;
+  };
+
+  void wake() {
+    if (wakeFd_ >= 0) {
+      uint64_t one = 1;
+      ssize_t ret = write(wakeFd_, &one, sizeof(one));
+      (void)ret;
+    }
+  }
+
+  void waitForFrames(const std::vector<Entry> &local, std::vector<struct pollfd> *fds) {
+    fds->clear();
+    auto add = [fds](int fd) {
+      struct pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      fds->push_back(pfd);
+    };
+    add(wakeFd_);
+    // 先在全部队列上置等待标志再检查是否为空，与生产者的“写入 → 检查标志”配对，不会丢失唤醒
+    bool empty = true;
+    for (const Entry &entry : local) {
+      empty = entry.queue->beginWait() && empty;
+      add(entry.queue->eventFd());
+    }
+    if (empty && !stopRequested_) {
+      while (poll(fds->data(), static_cast<nfds_t>(fds->size()), kIdleTimeoutMs) < 0 && errno == EINTR) {
+      }
+    }
+    if ((*fds)[0].revents & POLLIN) {
+      uint64_t counter = 0;
+      ssize_t ret = read(wakeFd_, &counter, sizeof(counter));
+      (void)ret;
+    }
+    for (size_t i = 0; i < local.size(); ++i) {
+      local[i].queue->endWait(((*fds)[i + 1].revents & POLLIN) != 0);
+    }
+  }
+
+  QMutex mutex_;  // 保护 processors_；工作线程每轮处理期间持有
+  std::vector<Entry> processors_;
+  int wakeFd_;
+  std::atomic<quint64> version_;
+  std::atomic<bool> stopRequested_;
+};
+
+SpectrumWorkerPool::SpectrumWorkerPool(int workers) {
+  const int count = workers > 0 ? workers : defaultWorkerCount();
+  for (int i = 0; i < count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+    workers_.back()->start();
+  }
+}
+
+SpectrumWorkerPool::~SpectrumWorkerPool() {
+  workers_.clear();
+}
+
+int SpectrumWorkerPool::defaultWorkerCount() {
+  return qBound(1, QThread::idealThreadCount() / 2, 4);
+}
+
+void SpectrumWorkerPool::addProcessor(SpectrumProcessor *processor) {
+  if (!processor || workers_.empty()) {
+    return;
+  }
+  QMutexLocker locker(&mutex_);
+  Worker *target = workers_.front().get();
+  int least = target->processorCount();
+  for (const auto &worker : workers_) {
+    const int count = worker->processorCount();
+    if (count < least) {
+      least = count;
+      target = worker.get();
+    }
+  }
+  target->add(processor);
+}
+
+bool SpectrumWorkerPool::removeProcessor(SpectrumProcessor *processor) {
+  QMutexLocker locker(&mutex_);
+  for (const auto &worker : workers_) {
+    if (worker->remove(processor)) {
+      return true;
+    }
+  }
+  return false;
+}
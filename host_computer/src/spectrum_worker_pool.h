@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class SpectrumProcessor;
+class SpectrumFrameQueue;
+
+// 光谱处理工作线程池：多台光谱仪（见 DeviceRegistry）的 SpectrumProcessor 共用固定数量的线程
+// - 每个处理器固定分配给当前负责处理器最少的工作线程，同一处理器始终在同一线程上处理（累积状态无需加锁）
+// - 工作线程轮流处理自己负责的各处理器，每轮每个处理器最多 kSliceFrames 帧，一台设备积压时不会饿死其它设备
+// - 全部输入队列为空时，工作线程在各队列的 eventfd 上一起 poll，生产者仍只在消费者等待时才唤醒
+class SpectrumWorkerPool {
+ public:
+  static constexpr int kSliceFrames = 64;
+
+  // workers <= 0 时使用 defaultWorkerCount()
+  explicit SpectrumWorkerPool(int workers = 0);
+  ~SpectrumWorkerPool();
+
+  SpectrumWorkerPool(const SpectrumWorkerPool &) = delete;
+  SpectrumWorkerPool &operator=(const SpectrumWorkerPool &) = delete;
+
+  // 在线 CPU 的一半，1~4 个
+  static int defaultWorkerCount();
+  int workerCount() const { return static_cast<int>(workers_.size()); }
+
+  // 把处理器交给负担最轻的工作线程（主线程调用）
+  void addProcessor(SpectrumProcessor *processor);
+  // 移除处理器：返回后工作线程不会再调用它，调用方可以立即销毁；未加入过时返回 false
+  bool removeProcessor(SpectrumProcessor *processor);
+
+ private:
+  class Worker;
+
+  QMutex mutex_;  // 保护分配关系（只在增删处理器时加锁）
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 有界单生产者/单消费者无锁环形队列
+// - 容量向上取整为 2 的幂，下标按位与取模
+// - push 只能在一个生产者线程调用，pop 只能在一个消费者线程调用
+// - 队列满时 push 返回 false，由调用方决定丢弃策略
+template <typename T>
+class SpscRing {
+ public:
+  explicit SpscRing(size_t capacity)
+      : mask_(roundUpPow2(capacity < 2 ? 2 : capacity) - 1), slots_(mask_ + 1) {}
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // 生产者调用
+  bool push(const T &value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ > mask_) {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+      if (tail - cachedHead_ > mask_) {
+        return false;  // 已满
+      }
+    }
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 消费者调用：最多取出 maxCount 个元素，返回实际数量
+  size_t pop(T *out, size_t maxCount) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    size_t available = cachedTail_ - head;
+    if (available == 0) {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      available = cachedTail_ - head;
+      if (available == 0) {
+        return 0;
+      }
+    }
+    const size_t n = available < maxCount ? available : maxCount;
+    for (size_t i = 0; i < n; ++i) {
+      T &slot = slots_[(head + i) & mask_];
+      out[i] = std::move(slot);
+      slot = T();  // 释放槽位持有的资源（例如共享指针引用）
+    }
+    head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // 任意线程调用，结果仅供参考
+  size_t sizeApprox() const {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t head = head_.load(std::memory_order_acquire);
+    return tail - head;
+  }
+
+  bool emptyApprox() const { return sizeApprox() == 0; }
+
+ private:
+  static size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  const size_t mask_;
+  std::vector<T> slots_;
+
+  // 生产者与消费者各自的下标放在不同缓存行，避免伪共享
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t cachedHead_ = 0;  // 生产者缓存的 head_
+  alignas(64) std::atomic<size_t> head_{0};
+  size_t cachedTail_ = 0;  // 消费者缓存的 tail_
+};
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <QObject>
-#include <QTimer>
+#include <QVariantList>
 #include <QVariantMap>
 
+#include "system_sampler.h"
+
 // 简单系统监控：
-// - 周期性读取 CPU 占用率、CPU 温度、内存占用、磁盘占用等
-// - 通过只读属性暴露给 QML，用于实时展示
+// - 采样在后台线程（SystemSampler）中进行，文件保持打开并用 pread 读取，不占用 GUI 线程
+// - 除整机 CPU 占用率、CPU 温度、内存占用、磁盘占用外，还统计本进程的逐线程 CPU、
+//   常驻内存、上下文切换速率与 UDP 套接字接收队列深度
+// - 通过只读属性暴露给 QML，metricsUpdated 按 updateIntervalMs 发出
 class SystemMonitor : public QObject {
   Q_OBJECT
   Q_PROPERTY(double cpuUsage READ cpuUsage NOTIFY metricsUpdated)
@@ -15,21 +19,39 @@ class SystemMonitor : public QObject {
   Q_PROPERTY(double memoryTotal READ memoryTotal NOTIFY metricsUpdated)
   Q_PROPERTY(double diskUsage READ diskUsage NOTIFY metricsUpdated)
   Q_PROPERTY(double diskTotal READ diskTotal NOTIFY metricsUpdated)
+  Q_PROPERTY(double processCpuUsage READ processCpuUsage NOTIFY metricsUpdated)
+  Q_PROPERTY(double processRssMb READ processRssMb NOTIFY metricsUpdated)
+  Q_PROPERTY(double voluntarySwitchesPerSecond READ voluntarySwitchesPerSecond NOTIFY metricsUpdated)
+  Q_PROPERTY(double involuntarySwitchesPerSecond READ involuntarySwitchesPerSecond NOTIFY metricsUpdated)
+  Q_PROPERTY(double udpReceiveQueueBytes READ udpReceiveQueueBytes NOTIFY metricsUpdated)
+  Q_PROPERTY(QVariantList threadStats READ threadStats NOTIFY metricsUpdated)
   Q_PROPERTY(int updateIntervalMs READ updateIntervalMs WRITE setUpdateIntervalMs NOTIFY updateIntervalChanged)
 
  public:
   explicit SystemMonitor(QObject *parent = nullptr);
+  ~SystemMonitor() override;
+
+  double cpuUsage() const { return sample_.cpuUsage; }             // 0~100 %
+  double cpuTemperature() const { return sample_.cpuTemperature; } // 摄氏度
+  double memoryUsage() const { return sample_.memoryUsage; }       // 已用内存 MB
+  double memoryTotal() const { return sample_.memoryTotal; }       // 总内存 MB
+  double diskUsage() const { return sample_.diskUsage; }           // 已用磁盘 GB
+  double diskTotal() const { return sample_.diskTotal; }           // 总磁盘 GB
 
-  double cpuUsage() const { return cpuUsage_; }             // 0~100 %
-  double cpuTemperature() const { return cpuTemperature_; } // 摄氏度
-  double memoryUsage() const { return memoryUsage_; }       // 已用内存 MB
-  double memoryTotal() const { return memoryTotal_; }       // 总内存 MB
-  double diskUsage() const { return diskUsage_; }           // 已用磁盘 GB
-  double diskTotal() const { return diskTotal_; }           // 总磁盘 GB
+  double processCpuUsage() const { return sample_.processCpuUsage; }  // 单核 %，多线程时可超过 100
+  double processRssMb() const { return sample_.processRssMb; }        // MB
+  double voluntarySwitchesPerSecond() const { return sample_.voluntarySwitchesPerSecond; }
+  double involuntarySwitchesPerSecond() const { return sample_.involuntarySwitchesPerSecond; }
+  double udpReceiveQueueBytes() const { return static_cast<double>(sample_.udpReceiveQueueBytes); }
+  // 每项：{ tid, name, cpu, voluntarySwitches, involuntarySwitches }，按 CPU 从高到低
+  QVariantList threadStats() const { return threadStats_; }
 
   int updateIntervalMs() const { return updateIntervalMs_; }
   void setUpdateIntervalMs(int ms);
 
+  // 按线程名查询 CPU 占用（单核 %），未找到返回 -1
+  Q_INVOKABLE double threadCpuUsage(const QString &name) const;
+
  signals:
   void metricsUpdated();
   void updateIntervalChanged();
@@ -38,32 +60,8 @@ class SystemMonitor : public QObject {
   void updateMetrics();
 
  private:
-  // CPU 相关
-  bool readCpuTimes(qulonglong &user, qulonglong &nice,
-                    qulonglong &system, qulonglong &idle,
-                    qulonglong &iowait, qulonglong &irq,
-                    qulonglong &softirq);
-
-  // 其它指标
-  void updateCpuUsage();
-  void updateCpuTemperature();
-  void updateMemory();
-  void updateDisk();
-
-  QTimer timer_;
+  SystemSampler sampler_;
   int updateIntervalMs_;
-
-  // 上一次 CPU 时间，用于计算利用率
-  bool hasPrevCpuTimes_;
-  qulonglong prevUser_, prevNice_, prevSystem_, prevIdle_, prevIowait_, prevIrq_, prevSoftIrq_;
-
-  // 当前值
-  double cpuUsage_;
-  double cpuTemperature_;
-  double memoryUsage_;
-  double memoryTotal_;
-  double diskUsage_;
-  double diskTotal_;
+  SystemSample sample_;
+  QVariantList threadStats_;
 };
-
-
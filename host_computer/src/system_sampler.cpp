@@ -0,0 +1,426 @@
+#include "system_sampler.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QStorageInfo>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+int openProc(const char *path) {
+  return ::open(path, O_RDONLY | O_CLOEXEC);
+}
+
+void closeFd(int &fd) {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+// 在 text 中查找 "key" 后的第一个无符号整数
+bool findValue(const char *text, const char *key, unsigned long long *value) {
+  const char *p = std::strstr(text, key);
+  if (!p) {
+    return false;
+  }
+  p += std::strlen(key);
+  char *end = nullptr;
+  *value = std::strtoull(p, &end, 10);
+  return end != p;
+}
+
+// stat 文件中 ')' 之后第 index 个字段（从 state 字段开始计 0）
+unsigned long long statField(const char *afterComm, int index) {
+  const char *p = afterComm;
+  for (int i = 0; i < index && *p; i++) {
+    while (*p == ' ') p++;
+    while (*p && *p != ' ') p++;
+  }
+  return std::strtoull(p, nullptr, 10);
+}
+
+}  // namespace
+
+SystemSampler::SystemSampler(QObject *parent)
+    : QThread(parent), stopRequested_(false), intervalMs_(1000),
+      buffer_(16384), statFd_(-1), meminfoFd_(-1), temperatureFd_(-1), selfStatFd_(-1),
+      selfStatmFd_(-1), udpFd_(-1), udp6Fd_(-1), clockTicks_(sysconf(_SC_CLK_TCK)),
+      pageSize_(sysconf(_SC_PAGESIZE)), prevCpuIdle_(0), prevCpuTotal_(0), hasPrevCpu_(false),
+      latestCpuUsage_(0.0), prevProcessTicks_(0), hasPrevProcess_(false), prevVoluntary_(0),
+      prevInvoluntary_(0), hasPrevSwitches_(false), socketRefreshCountdown_(0) {
+  if (clockTicks_ <= 0) {
+    clockTicks_ = 100;
+  }
+  if (pageSize_ <= 0) {
+    pageSize_ = 4096;
+  }
+}
+
+SystemSampler::~SystemSampler() {
+  stopSampling();
+}
+
+void SystemSampler::setIntervalMs(int ms) {
+  QMutexLocker locker(&mutex_);
+  intervalMs_ = qMax(50, ms);
+  wake_.wakeAll();
+}
+
+void SystemSampler::stopSampling() {
+  {
+    QMutexLocker locker(&mutex_);
+    stopRequested_ = true;
+    wake_.wakeAll();
+  }
+  wait();
+}
+
+SystemSample SystemSampler::latestSample() const {
+  QMutexLocker locker(&mutex_);
+  return latest_;
+}
+
+void SystemSampler::run() {
+  {
+    QMutexLocker locker(&mutex_);
+    stopRequested_ = false;
+  }
+  openFiles();
+
+  QElapsedTimer elapsed;
+  elapsed.start();
+  while (true) {
+    const double elapsedSec = static_cast<double>(elapsed.restart()) / 1000.0;
+    SystemSample result;
+    sample(result, elapsedSec);
+
+    QMutexLocker locker(&mutex_);
+    latest_ = std::move(result);
+    locker.unlock();
+    emit sampleReady();
+    locker.relock();
+
+    if (stopRequested_) {
+      break;
+    }
+    wake_.wait(&mutex_, static_cast<unsigned long>(intervalMs_));
+    if (stopRequested_) {
+      break;
+    }
+  }
+
+  closeFiles();
+}
+
+void SystemSampler::openFiles() {
+  statFd_ = openProc("/proc/stat");
+  meminfoFd_ = openProc("/proc/meminfo");
+  selfStatFd_ = openProc("/proc/self/stat");
+  selfStatmFd_ = openProc("/proc/self/statm");
+  udpFd_ = openProc("/proc/net/udp");
+  udp6Fd_ = openProc("/proc/net/udp6");
+
+  // 树莓派等 Linux 通常在 /sys/class/thermal/thermal_zone0/temp
+  const char *temperaturePaths[] = {
+      "/sys/class/thermal/thermal_zone0/temp",
+      "/sys/class/hwmon/hwmon0/temp1_input"};
+  for (const char *path : temperaturePaths) {
+    temperatureFd_ = openProc(path);
+    if (temperatureFd_ >= 0) {
+      break;
+    }
+  }
+}
+
+void SystemSampler::closeFiles() {
+  closeFd(statFd_);
+  closeFd(meminfoFd_);
+  closeFd(temperatureFd_);
+  closeFd(selfStatFd_);
+  closeFd(selfStatmFd_);
+  closeFd(udpFd_);
+  closeFd(udp6Fd_);
+  for (auto &entry : tasks_) {
+    closeFd(entry.second.statFd);
+    closeFd(entry.second.statusFd);
+  }
+  tasks_.clear();
+  hasPrevCpu_ = false;
+  hasPrevProcess_ = false;
+  hasPrevSwitches_ = false;
+}
+
+ssize_t SystemSampler::readFd(int fd) {
+  if (fd < 0) {
+    return -1;
+  }
+  // /proc 文件大小未知：缓冲区不够时加倍后从头重读
+  while (true) {
+    const ssize_t n = ::pread(fd, buffer_.data(), buffer_.size() - 1, 0);
+    if (n < 0) {
+      return -1;
+    }
+    if (static_cast<size_t>(n) < buffer_.size() - 1) {
+      buffer_[static_cast<size_t>(n)] = '\0';
+      return n;
+    }
+    buffer_.resize(buffer_.size() * 2);
+  }
+}
+
+void SystemSampler::sample(SystemSample &out, double elapsedSec) {
+  sampleCpu(out);
+  sampleTemperature(out);
+  sampleMemory(out);
+  sampleDisk(out);
+  sampleProcess(out, elapsedSec);
+  sampleThreads(out, elapsedSec);
+  sampleUdpQueue(out);
+}
+
+void SystemSampler::sampleCpu(SystemSample &out) {
+  // 期望格式：cpu  user nice system idle iowait irq softirq ...
+  if (readFd(statFd_) <= 0 || std::strncmp(buffer_.data(), "cpu ", 4) != 0) {
+    return;
+  }
+  unsigned long long values[7] = {0};
+  const char *p = buffer_.data() + 4;
+  for (auto &value : values) {
+    char *end = nullptr;
+    value = std::strtoull(p, &end, 10);
+    p = end;
+  }
+  const unsigned long long idle = values[3] + values[4];
+  const unsigned long long total = idle + values[0] + values[1] + values[2] + values[5] + values[6];
+  if (hasPrevCpu_ && total > prevCpuTotal_) {
+    const unsigned long long totalDelta = total - prevCpuTotal_;
+    const unsigned long long idleDelta = idle - prevCpuIdle_;
+    latestCpuUsage_ = static_cast<double>(totalDelta - idleDelta) * 100.0 / static_cast<double>(totalDelta);
+  }
+  hasPrevCpu_ = true;
+  prevCpuTotal_ = total;
+  prevCpuIdle_ = idle;
+  out.cpuUsage = latestCpuUsage_;
+}
+
+void SystemSampler::sampleTemperature(SystemSample &out) {
+  if (readFd(temperatureFd_) <= 0) {
+    return;
+  }
+  out.cpuTemperature = static_cast<double>(std::atoi(buffer_.data())) / 1000.0;  // 毫摄氏度转为摄氏度
+}
+
+void SystemSampler::sampleMemory(SystemSample &out) {
+  if (readFd(meminfoFd_) <= 0) {
+    return;
+  }
+  unsigned long long totalKb = 0;
+  unsigned long long availableKb = 0;
+  if (!findValue(buffer_.data(), "MemTotal:", &totalKb) || totalKb == 0) {
+    return;
+  }
+  if (!findValue(buffer_.data(), "MemAvailable:", &availableKb)) {
+    // 某些系统可能没有 MemAvailable 字段，退化为：可用 ≈ 空闲 + 缓冲 + 缓存
+    unsigned long long freeKb = 0;
+    unsigned long long buffersKb = 0;
+    unsigned long long cachedKb = 0;
+    findValue(buffer_.data(), "MemFree:", &freeKb);
+    findValue(buffer_.data(), "Buffers:", &buffersKb);
+    findValue(buffer_.data(), "\nCached:", &cachedKb);
+    availableKb = freeKb + buffersKb + cachedKb < totalKb ? freeKb + buffersKb + cachedKb : freeKb;
+  }
+  out.memoryTotal = static_cast<double>(totalKb) / 1024.0;
+  out.memoryUsage = static_cast<double>(totalKb - qMin(availableKb, totalKb)) / 1024.0;
+}
+
+void SystemSampler::sampleDisk(SystemSample &out) {
+  QStorageInfo storage = QStorageInfo::root();
+  if (!storage.isValid() || !storage.isReady()) {
+    return;
+  }
+  const qint64 totalBytes = storage.bytesTotal();
+  const qint64 freeBytes = storage.bytesAvailable();
+  if (totalBytes > 0) {
+    out.diskTotal = static_cast<double>(totalBytes) / (1024.0 * 1024.0 * 1024.0);
+    out.diskUsage = static_cast<double>(totalBytes - freeBytes) / (1024.0 * 1024.0 * 1024.0);
+  }
+}
+
+void SystemSampler::sampleProcess(SystemSample &out, double elapsedSec) {
+  if (readFd(selfStatFd_) > 0) {
+    const char *afterComm = std::strrchr(buffer_.data(), ')');
+    if (afterComm) {
+      // utime / stime 为第 14、15 个字段（包含所有线程）
+      const unsigned long long ticks = statField(afterComm + 2, 11) + statField(afterComm + 2, 12);
+      if (hasPrevProcess_ && elapsedSec > 0.0 && ticks >= prevProcessTicks_) {
+        out.processCpuUsage = static_cast<double>(ticks - prevProcessTicks_) * 100.0 /
+                              (static_cast<double>(clockTicks_) * elapsedSec);
+      }
+      prevProcessTicks_ = ticks;
+      hasPrevProcess_ = true;
+    }
+  }
+  if (readFd(selfStatmFd_) > 0) {
+    // statm：size resident shared ...（单位为页）
+    char *end = nullptr;
+    std::strtoull(buffer_.data(), &end, 10);
+    const unsigned long long residentPages = std::strtoull(end, nullptr, 10);
+    out.processRssMb = static_cast<double>(residentPages) * static_cast<double>(pageSize_) / (1024.0 * 1024.0);
+  }
+}
+
+void SystemSampler::sampleThreads(SystemSample &out, double elapsedSec) {
+  // 只枚举目录项；已知线程的文件保持打开，新线程才打开
+  DIR *dir = ::opendir("/proc/self/task");
+  if (!dir) {
+    return;
+  }
+  for (auto &entry : tasks_) {
+    entry.second.seen = false;
+  }
+  while (struct dirent *ent = ::readdir(dir)) {
+    const int tid = std::atoi(ent->d_name);
+    if (tid <= 0) {
+      continue;
+    }
+    TaskFiles &task = tasks_[tid];
+    task.seen = true;
+    if (task.statFd < 0) {
+      char path[64];
+      std::snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+      task.statFd = openProc(path);
+      std::snprintf(path, sizeof(path), "/proc/self/task/%d/status", tid);
+      task.statusFd = openProc(path);
+    }
+  }
+  ::closedir(dir);
+
+  unsigned long long totalVoluntary = 0;
+  unsigned long long totalInvoluntary = 0;
+  for (auto it = tasks_.begin(); it != tasks_.end();) {
+    TaskFiles &task = it->second;
+    // 线程已退出：关闭文件
+    if (!task.seen || readFd(task.statFd) <= 0) {
+      closeFd(task.statFd);
+      closeFd(task.statusFd);
+      hasPrevSwitches_ = false;  // 退出线程的计数不再计入合计，跳过一次速率计算
+      it = tasks_.erase(it);
+      continue;
+    }
+
+    ThreadSample thread;
+    thread.tid = it->first;
+    const char *open = std::strchr(buffer_.data(), '(');
+    const char *close = std::strrchr(buffer_.data(), ')');
+    if (!open || !close || close < open) {
+      ++it;
+      continue;
+    }
+    // 线程名可能在运行中被修改（pthread_setname_np），每次都重新取
+    task.name = QString::fromUtf8(open + 1, static_cast<int>(close - open - 1));
+    thread.name = task.name;
+    const unsigned long long ticks = statField(close + 2, 11) + statField(close + 2, 12);
+
+    unsigned long long voluntary = 0;
+    unsigned long long involuntary = 0;
+    if (readFd(task.statusFd) > 0) {
+      findValue(buffer_.data(), "\nvoluntary_ctxt_switches:", &voluntary);
+      findValue(buffer_.data(), "nonvoluntary_ctxt_switches:", &involuntary);
+    }
+    totalVoluntary += voluntary;
+    totalInvoluntary += involuntary;
+
+    if (task.hasPrev && elapsedSec > 0.0) {
+      thread.cpuUsage = static_cast<double>(ticks - qMin(task.prevTicks, ticks)) * 100.0 /
+                        (static_cast<double>(clockTicks_) * elapsedSec);
+      thread.voluntarySwitchesPerSecond =
+          static_cast<double>(voluntary - qMin(task.prevVoluntary, voluntary)) / elapsedSec;
+      thread.involuntarySwitchesPerSecond =
+          static_cast<double>(involuntary - qMin(task.prevInvoluntary, involuntary)) / elapsedSec;
+    }
+    task.prevTicks = ticks;
+    task.prevVoluntary = voluntary;
+    task.prevInvoluntary = involuntary;
+    task.hasPrev = true;
+    out.threads.append(thread);
+    ++it;
+  }
+
+  // 进程级上下文切换速率：所有存活线程之和（/proc/self/status 只包含主线程）
+  if (hasPrevSwitches_ && elapsedSec > 0.0) {
+    out.voluntarySwitchesPerSecond =
+        static_cast<double>(totalVoluntary - qMin(prevVoluntary_, totalVoluntary)) / elapsedSec;
+    out.involuntarySwitchesPerSecond =
+        static_cast<double>(totalInvoluntary - qMin(prevInvoluntary_, totalInvoluntary)) / elapsedSec;
+  }
+  prevVoluntary_ = totalVoluntary;
+  prevInvoluntary_ = totalInvoluntary;
+  hasPrevSwitches_ = true;
+
+  std::sort(out.threads.begin(), out.threads.end(),
+            [](const ThreadSample &a, const ThreadSample &b) { return a.cpuUsage > b.cpuUsage; });
+}
+
+void SystemSampler::refreshSocketInodes() {
+  socketInodes_.clear();
+  DIR *dir = ::opendir("/proc/self/fd");
+  if (!dir) {
+    return;
+  }
+  char path[64];
+  char target[64];
+  while (struct dirent *ent = ::readdir(dir)) {
+    if (ent->d_name[0] == '.') {
+      continue;
+    }
+    std::snprintf(path, sizeof(path), "/proc/self/fd/%s", ent->d_name);
+    const ssize_t n = ::readlink(path, target, sizeof(target) - 1);
+    if (n <= 0) {
+      continue;
+    }
+    target[n] = '\0';
+    unsigned long inode = 0;
+    if (std::sscanf(target, "socket:[%lu]", &inode) == 1) {
+      socketInodes_.push_back(inode);
+    }
+  }
+  ::closedir(dir);
+  std::sort(socketInodes_.begin(), socketInodes_.end());
+}
+
+void SystemSampler::sampleUdpQueue(SystemSample &out) {
+  // 套接字很少变化：fd 表每 5 次采样重新扫描一次
+  if (socketRefreshCountdown_-- <= 0) {
+    refreshSocketInodes();
+    socketRefreshCountdown_ = 4;
+  }
+  if (socketInodes_.empty()) {
+    return;
+  }
+
+  qint64 maxQueue = 0;
+  for (int fd : {udpFd_, udp6Fd_}) {
+    if (readFd(fd) <= 0) {
+      continue;
+    }
+    // 每行：sl local rem st tx_queue:rx_queue tr:tm retrnsmt uid timeout inode ...
+    const char *line = std::strchr(buffer_.data(), '\n');  // 跳过表头
+    while (line && *++line) {
+      unsigned long rxQueue = 0;
+      unsigned long inode = 0;
+      if (std::sscanf(line, "%*s %*s %*s %*s %*x:%lx %*s %*s %*s %*s %lu", &rxQueue, &inode) == 2 &&
+          std::binary_search(socketInodes_.begin(), socketInodes_.end(), inode)) {
+        maxQueue = qMax(maxQueue, static_cast<qint64>(rxQueue));
+      }
+      line = std::strchr(line, '\n');
+    }
+  }
+  out.udpReceiveQueueBytes = maxQueue;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <map>
+#include <sys/types.h>
+#include <vector>
+
+// 单个线程的采样结果
+struct ThreadSample {
+  int tid = 0;
+  QString name;                            // /proc/self/task/<tid>/comm（即 pthread_setname_np 设置的名称）
+  double cpuUsage = 0.0;                   // 占用单个核心的百分比
+  double voluntarySwitchesPerSecond = 0.0;   // 主动上下文切换（阻塞等待）
+  double involuntarySwitchesPerSecond = 0.0; // 被动上下文切换（被抢占）
+};
+
+// 一次完整采样的结果
+struct SystemSample {
+  double cpuUsage = 0.0;        // 整机 CPU 占用 %
+  double cpuTemperature = 0.0;  // 摄氏度
+  double memoryUsage = 0.0;     // 已用内存 MB
+  double memoryTotal = 0.0;     // 总内存 MB
+  double diskUsage = 0.0;       // 已用磁盘 GB
+  double diskTotal = 0.0;       // 总磁盘 GB
+
+  double processCpuUsage = 0.0;  // 本进程 CPU 占用（单核百分比，可超过 100）
+  double processRssMb = 0.0;     // 本进程常驻内存 MB
+  double voluntarySwitchesPerSecond = 0.0;
+  double involuntarySwitchesPerSecond = 0.0;
+  qint64 udpReceiveQueueBytes = 0;  // 本进程 UDP 套接字接收队列中尚未读取的字节数（最大者）
+
+  QVector<ThreadSample> threads;  // 按 CPU 占用从高到低排序
+};
+
+// 后台采样线程：
+// - 所有 /proc、/sys 文件只打开一次，之后用 pread 从偏移 0 重新读取，避免每次 open/close
+// - 逐线程 CPU 与上下文切换来自 /proc/self/task/<tid>/stat 与 status，线程增减时增量打开/关闭
+// - UDP 接收队列深度：从 /proc/self/fd 找到本进程的套接字 inode，再在 /proc/net/udp(6) 中匹配
+// - 每次采样完成后发出 sampleReady()，由主线程取走最新结果
+class SystemSampler : public QThread {
+  Q_OBJECT
+
+ public:
+  explicit SystemSampler(QObject *parent = nullptr);
+  ~SystemSampler() override;
+
+  void setIntervalMs(int ms);
+  void stopSampling();
+
+  // 主线程调用：取出最近一次采样结果
+  SystemSample latestSample() const;
+
+ signals:
+  void sampleReady();
+
+ protected:
+  void run() override;
+
+ private:
+  struct TaskFiles {
+    int statFd = -1;
+    int statusFd = -1;
+    QString name;
+    unsigned long long prevTicks = 0;
+    unsigned long long prevVoluntary = 0;
+    unsigned long long prevInvoluntary = 0;
+    bool hasPrev = false;
+    bool seen = false;
+  };
+
+  void openFiles();
+  void closeFiles();
+  void sample(SystemSample &out, double elapsedSec);
+  void sampleCpu(SystemSample &out);
+  void sampleTemperature(SystemSample &out);
+  void sampleMemory(SystemSample &out);
+  void sampleDisk(SystemSample &out);
+  void sampleProcess(SystemSample &out, double elapsedSec);
+  void sampleThreads(SystemSample &out, double elapsedSec);
+  void sampleUdpQueue(SystemSample &out);
+  void refreshSocketInodes();
+
+  // 读取整个文件内容到 buffer_（以 '\0' 结尾），失败返回 -1
+  ssize_t readFd(int fd);
+
+  mutable QMutex mutex_;
+  QWaitCondition wake_;
+  bool stopRequested_;
+  int intervalMs_;
+  SystemSample latest_;
+
+  // 以下成员只在采样线程中访问
+  std::vector<char> buffer_;
+  int statFd_;
+  int meminfoFd_;
+  int temperatureFd_;
+  int selfStatFd_;
+  int selfStatmFd_;
+  int udpFd_;
+  int udp6Fd_;
+  long clockTicks_;
+  long pageSize_;
+  unsigned long long prevCpuIdle_;
+  unsigned long long prevCpuTotal_;
+  bool hasPrevCpu_;
+  double latestCpuUsage_;
+  unsigned long long prevProcessTicks_;
+  bool hasPrevProcess_;
+  unsigned long long prevVoluntary_;
+  unsigned long long prevInvoluntary_;
+  bool hasPrevSwitches_;
+  std::map<int, TaskFiles> tasks_;
+  std::vector<unsigned long> socketInodes_;
+  int socketRefreshCountdown_;
+};
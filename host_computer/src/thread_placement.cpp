@@ -0,0 +1,332 @@
+#include "thread_placement.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// 当前生效的配置；线程启动时读取，install() 时替换
+QMutex g_mutex;
+ThreadPlacement g_current;
+std::atomic<int> g_generation{0};
+
+cpu_set_t toCpuSet(const QVector<int> &cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return set;
+}
+
+// 在线 CPU 编号不一定连续（热插拔下线、部分核心被关闭），按 sysfs 的列表（如 "0-3,6,8-11"）读取；
+// 不用 sched_getaffinity：调用线程可能已继承被隔离后的亲和性
+QVector<int> onlineCpus() {
+  QVector<int> cpus;
+  QFile file(QStringLiteral("/sys/devices/system/cpu/online"));
+  if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    const QString list = QString::fromLatin1(file.readLine()).trimmed();
+    for (const QString &part : list.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+      const QStringList bounds = part.split(QLatin1Char('-'));
+      bool firstOk = false;
+      bool lastOk = true;
+      const int first = bounds.first().toInt(&firstOk);
+      const int last = bounds.size() > 1 ? bounds.last().toInt(&lastOk) : first;
+      if (!firstOk || !lastOk) {
+        cpus.clear();
+        break;
+      }
+      for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+        cpus.append(cpu);
+      }
+    }
+  }
+  if (!cpus.isEmpty()) {
+    return cpus;
+  }
+  // 无法读取 sysfs 时退回 0..N-1
+  const long count = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i = 0; i < count && i < CPU_SETSIZE; i++) {
+    cpus.append(i);
+  }
+  return cpus;
+}
+
+QString cpuList(const QVector<int> &cpus) {
+  if (cpus.isEmpty()) {
+    return QStringLiteral("*");
+  }
+  QStringList parts;
+  for (int cpu : cpus) {
+    parts.append(QString::number(cpu));
+  }
+  return parts.join(QLatin1Char(','));
+}
+
+}  // namespace
+
+ThreadPlacement::ThreadPlacement() : isolateAcquisitionCores_(true) {
+  rules_[Receiver].name = QStringLiteral("spec-udp-rx");
+  rules_[Replay].name = QStringLiteral("spec-replay");
+  rules_[Processor].name = QStringLiteral("spec-proc");
+  rules_[Recorder].name = QStringLiteral("spec-recorder");
+  rules_[Inference].name = QStringLiteral("spec-infer");
+  rules_[InferenceFanout].name = QStringLiteral("spec-infer-fan");
+}
+
+QString ThreadPlacement::defaultConfigPath() {
+  return QCoreApplication::applicationDirPath() + QStringLiteral("/thread_placement.json");
+}
+
+bool ThreadPlacement::parseRule(const QString &key, const QJsonObject &root, Rule *rule, QString *error) {
+  if (!root.contains(key)) {
+    return true;
+  }
+  const QJsonValue value = root.value(key);
+  if (!value.isObject()) {
+    if (error) {
+      *error = QStringLiteral("\"%1\" 应为对象").arg(key);
+    }
+    return false;
+  }
+  const QJsonObject object = value.toObject();
+  if (object.contains(QStringLiteral("name"))) {
+    rule->name = object.value(QStringLiteral("name")).toString().left(15);
+  }
+  if (object.contains(QStringLiteral("cpus"))) {
+    rule->cpus.clear();
+    const QJsonArray cpus = object.value(QStringLiteral("cpus")).toArray();
+    for (const QJsonValue &cpu : cpus) {
+      const int index = cpu.toInt(-1);
+      if (index < 0 || index >= CPU_SETSIZE) {
+        if (error) {
+          *error = QStringLiteral("\"%1.cpus\" 包含无效的 CPU 编号").arg(key);
+        }
+        return false;
+      }
+      rule->cpus.append(index);
+    }
+  }
+  rule->realtime = object.value(QStringLiteral("realtime")).toBool(rule->realtime);
+  rule->priority = qBound(1, object.value(QStringLiteral("priority")).toInt(50), 99);
+  if (object.contains(QStringLiteral("nice"))) {
+    rule->hasNice = true;
+    rule->nice = qBound(-20, object.value(QStringLiteral("nice")).toInt(), 19);
+  }
+  return true;
+}
+
+bool ThreadPlacement::load(const QString &path, QString *error) {
+  QFile file(path);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) {
+      *error = file.errorString();
+    }
+    return false;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (document.isNull() || !document.isObject()) {
+    if (error) {
+      *error = parseError.errorString();
+    }
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  ThreadPlacement parsed;
+  // 回放与接收、扇出线程与推理线程共用同一项配置，线程名各自保留
+  Rule receiver = parsed.rules_[Receiver];
+  Rule inference = parsed.rules_[Inference];
+  if (!parseRule(QStringLiteral("receiver"), root, &receiver, error) ||
+      !parseRule(QStringLiteral("processor"), root, &parsed.rules_[Processor], error) ||
+      !parseRule(QStringLiteral("recorder"), root, &parsed.rules_[Recorder], error) ||
+      !parseRule(QStringLiteral("inference"), root, &inference, error)) {
+    return false;
+  }
+  auto share = [](const Rule &from, Rule *to, const QString &name) {
+    *to = from;
+    to->name = name;
+  };
+  share(receiver, &parsed.rules_[Replay], parsed.rules_[Replay].name);
+  parsed.rules_[Receiver] = receiver;
+  share(inference, &parsed.rules_[InferenceFanout], parsed.rules_[InferenceFanout].name);
+  parsed.rules_[Inference] = inference;
+  parsed.isolateAcquisitionCores_ =
+      root.value(QStringLiteral("isolateAcquisitionCores")).toBool(parsed.isolateAcquisitionCores_);
+
+  *this = parsed;
+  return true;
+}
+
+QVector<int> ThreadPlacement::acquisitionCpus() const {
+  QVector<int> cpus;
+  for (Role role : {Receiver, Replay, Processor, Recorder}) {
+    for (int cpu : rules_[role].cpus) {
+      if (!cpus.contains(cpu)) {
+        cpus.append(cpu);
+      }
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  return cpus;
+}
+
+QVector<int> ThreadPlacement::generalCpus() const {
+  if (!rules_[Inference].cpus.isEmpty()) {
+    return rules_[Inference].cpus;
+  }
+  const QVector<int> acquisition = acquisitionCpus();
+  QVector<int> cpus;
+  for (int cpu : onlineCpus()) {
+    if (!acquisition.contains(cpu)) {
+      cpus.append(cpu);
+    }
+  }
+  return cpus;
+}
+
+QString ThreadPlacement::describe() const {
+  QStringList parts;
+  for (int i = 0; i < RoleCount; i++) {
+    const Rule &r = rules_[i];
+    QString text = r.name + QStringLiteral("@") + cpuList(r.cpus);
+    if (r.realtime) {
+      text += QStringLiteral("(FIFO %1)").arg(r.priority);
+    } else if (r.hasNice) {
+      text += QStringLiteral("(nice %1)").arg(r.nice);
+    }
+    parts.append(text);
+  }
+  return parts.join(QStringLiteral(" "));
+}
+
+void ThreadPlacement::install(const ThreadPlacement &placement) {
+  {
+    QMutexLocker locker(&g_mutex);
+    g_current = placement;
+  }
+  g_generation.fetch_add(1, std::memory_order_release);
+
+  const QVector<int> acquisition = placement.acquisitionCpus();
+  if (!placement.isolateAcquisitionCores_ || acquisition.isEmpty()) {
+    return;
+  }
+  const QVector<int> general = placement.generalCpus();
+  if (general.isEmpty()) {
+    qWarning() << "线程放置：采集线程占用了全部 CPU，其它线程不做隔离";
+    return;
+  }
+
+  // 已存在的非采集线程（GUI、渲染、推理线程池）移到非采集核心；
+  // 已按配置命名的采集线程（例如正在运行的处理线程）保持不变
+  QStringList pipelineNames;
+  for (Role role : {Receiver, Replay, Processor, Recorder}) {
+    pipelineNames.append(placement.rules_[role].name);
+  }
+  const cpu_set_t set = toCpuSet(general);
+  DIR *dir = ::opendir("/proc/self/task");
+  if (!dir) {
+    return;
+  }
+  int moved = 0;
+  while (struct dirent *ent = ::readdir(dir)) {
+    const pid_t tid = static_cast<pid_t>(std::atoi(ent->d_name));
+    if (tid <= 0) {
+      continue;
+    }
+    QFile comm(QStringLiteral("/proc/self/task/%1/comm").arg(tid));
+    if (comm.open(QIODevice::ReadOnly) &&
+        pipelineNames.contains(QString::fromUtf8(comm.readAll()).trimmed())) {
+      continue;
+    }
+    if (sched_setaffinity(tid, sizeof(set), &set) == 0) {
+      moved++;
+    }
+  }
+  ::closedir(dir);
+  qDebug() << "线程放置：" << moved << "个非采集线程限制在 CPU" << cpuList(general);
+}
+
+void ThreadPlacement::applyToCurrentThread(Role role) {
+  if (role < 0 || role >= RoleCount) {
+    return;
+  }
+  Rule rule;
+  QVector<int> cpus;
+  {
+    QMutexLocker locker(&g_mutex);
+    rule = g_current.rules_[role];
+    // 推理线程未单独配置时也要避开采集核心
+    const bool isolated = g_current.isolateAcquisitionCores_ && !g_current.acquisitionCpus().isEmpty();
+    if (role == Inference || role == InferenceFanout) {
+      cpus = isolated ? g_current.generalCpus() : rule.cpus;
+    } else {
+      // 未配置 CPU 的采集线程恢复为全部在线 CPU（不继承创建者被隔离后的亲和性）
+      cpus = rule.cpus.isEmpty() && isolated ? onlineCpus() : rule.cpus;
+    }
+  }
+
+  const pthread_t self = pthread_self();
+  const QByteArray name = rule.name.toUtf8().left(15);
+  if (!name.isEmpty()) {
+    pthread_setname_np(self, name.constData());
+  }
+
+  if (!cpus.isEmpty()) {
+    const cpu_set_t set = toCpuSet(cpus);
+    const int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+    if (rc != 0) {
+      qWarning() << "线程放置：" << rule.name << "设置 CPU 亲和性失败:" << std::strerror(rc);
+    }
+  }
+
+  if (rule.realtime) {
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = rule.priority;
+    const int rc = pthread_setschedparam(self, SCHED_FIFO, &param);
+    if (rc != 0) {
+      // 没有实时调度权限时退回普通调度，不影响采集
+      qWarning() << "线程放置：" << rule.name << "无法使用 SCHED_FIFO:" << std::strerror(rc)
+                 << "（需要 CAP_SYS_NICE 或 /etc/security/limits.conf 中的 rtprio）";
+    }
+  } else if (rule.hasNice) {
+    const pid_t tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), rule.nice) != 0) {
+      qWarning() << "线程放置：" << rule.name << "设置 nice 失败:" << std::strerror(errno);
+    }
+  }
+}
+
+void ThreadPlacement::applyToCurrentThreadOnce(Role role) {
+  thread_local int appliedGeneration = -1;
+  const int generation = g_generation.load(std::memory_order_acquire);
+  if (appliedGeneration != generation) {
+    appliedGeneration = generation;
+    applyToCurrentThread(role);
+  }
+}
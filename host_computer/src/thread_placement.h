@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+class QJsonObject;
+
+// 采集流水线线程的放置配置：线程名、CPU 亲和性与调度策略
+// - 配置文件为 JSON（默认 <程序目录>/thread_placement.json），不存在时只设置线程名
+// - UdpCommunicator::startReceiving 读取配置并调用 install()；各线程在 run() 开头调用 applyToCurrentThread()
+// - install() 同时把进程内其它线程（GUI、QML 渲染、ONNX Runtime / libtorch 线程池等）移出采集核心，
+//   之后由这些线程创建的新线程会继承同样的亲和性
+//
+// 配置示例：
+// {
+//   "receiver":  { "cpus": [2], "realtime": true, "priority": 50 },
+//   "processor": { "cpus": [3] },
+//   "recorder":  { "cpus": [1], "nice": 5 },
+//   "inference": { "cpus": [0, 1] },
+//   "isolateAcquisitionCores": true
+// }
+class ThreadPlacement {
+ public:
+  enum Role {
+    Receiver = 0,     // UDP 接收线程（可选 SCHED_FIFO）
+    Replay,           // 回放线程（与接收线程共用 receiver 配置）
+    Processor,        // 光谱处理线程（同时承担黑白参考累积、录制与显示分发）
+    Recorder,         // 原始帧录制线程
+    Inference,        // 推理执行线程
+    InferenceFanout,  // 多预测器扇出线程池（inference 配置）
+    RoleCount
+  };
+
+  struct Rule {
+    QString name;      // 线程名（pthread_setname_np，最长 15 字节）
+    QVector<int> cpus; // 允许运行的 CPU；为空表示不限制
+    bool realtime = false;  // SCHED_FIFO（需要 CAP_SYS_NICE 或 rtprio 限额）
+    int priority = 0;       // SCHED_FIFO 优先级 1~99
+    bool hasNice = false;
+    int nice = 0;           // 普通调度下的 nice 值
+  };
+
+  ThreadPlacement();
+
+  static QString defaultConfigPath();
+
+  // 读取配置文件；文件不存在返回 true 并保留默认值，格式错误返回 false 并写入 error
+  bool load(const QString &path, QString *error = nullptr);
+
+  const Rule &rule(Role role) const { return rules_[role]; }
+  // 采集线程（接收、处理、录制）占用的 CPU 并集
+  QVector<int> acquisitionCpus() const;
+  // 非采集线程可用的 CPU：配置了 inference 时使用其 cpus，否则为在线 CPU 去掉采集核心
+  QVector<int> generalCpus() const;
+  QString describe() const;
+
+  // 安装为进程当前配置（主线程调用）
+  static void install(const ThreadPlacement &placement);
+  // 在目标线程内调用：按当前配置设置本线程
+  static void applyToCurrentThread(Role role);
+  // 线程池线程在每个任务开头调用：同一线程只在配置变化后才重新设置
+  static void applyToCurrentThreadOnce(Role role);
+
+ private:
+  static bool parseRule(const QString &key, const QJsonObject &root, Rule *rule, QString *error);
+
+  Rule rules_[RoleCount];
+  bool isolateAcquisitionCores_;
+};
@@ -1,120 +1,276 @@
 #include "udp_communicator.h"
 #include "udp_receiver.h"
+#include "udp_receiver_hub.h"
+#include "link_stats.h"
+#include "pipeline_stats.h"
+#include "replay_source.h"
+#include "spectral_calibration.h"
 #include "spectrum_processor.h"
 #include "reference_processor.h"
+#include "raw_frame_recorder.h"
 #include "spectrum_predictor_manager.h"
+#include "thread_placement.h"
 
 #include <QVariant>
 #include <QTimer>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 
 UdpCommunicator::UdpCommunicator(QObject *parent)
-    : QObject(parent), udpReceiver_(nullptr), spectrumProcessor_(nullptr),
-      blackReferenceProcessor_(nullptr), whiteReferenceProcessor_(nullptr),
-      receiving_(false), packetCount_(0), packetsPerSecond_(0), packetsThisSecond_(0), 
+    : QObject(parent), frameSource_(nullptr), spectrumProcessor_(nullptr),
+      displayFeed_(nullptr),
+      receiving_(false), replaying_(false), packetCount_(0), packetsPerSecond_(0), packetsThisSecond_(0),
+      droppedFrames_(0), lastReceivedPackets_(0), frameCounterTrailer_(false), lastLinkDatagrams_(0),
+      lostFrames_(0), reorderedPackets_(0), runtPackets_(0), kernelDrops_(0),
+      framePeriodUs_(0.0), jitterUs_(0.0), reportedLinkLosses_(0), lastProcessedFrames_(0), processedFramesPerSecond_(0),
+      predictionsThisSecond_(0), predictionsPerSecond_(0), totalPredictions_(0),
       blackReferenceAccumulating_(false), blackReferenceProgress_(0),
       whiteReferenceAccumulating_(false), whiteReferenceProgress_(0),
-      predictorManager_(nullptr), currentPredictorIndex_(-1) {
+      spectrumThreshold_(SpectrumProcessor::DEFAULT_SPECTRUM_THRESHOLD),
+      referenceThreshold_(ReferenceProcessor::DEFAULT_REFERENCE_THRESHOLD),
+      averagingMode_(SpectrumProcessor::BlockMode),
+      outputInterval_(SpectrumProcessor::DEFAULT_OUTPUT_INTERVAL),
+      emaTimeConstant_(SpectrumProcessor::DEFAULT_EMA_TIME_CONSTANT),
+      adaptiveTargetSnr_(SpectrumProcessor::DEFAULT_ADAPTIVE_TARGET_SNR), adaptiveTargetStdError_(0.0),
+      adaptiveMinPackets_(SpectrumProcessor::DEFAULT_ADAPTIVE_MIN_PACKETS),
+      adaptiveMaxPackets_(SpectrumProcessor::DEFAULT_ADAPTIVE_MAX_PACKETS), referenceTargetStdError_(0.0),
+      recorder_(nullptr), recordedFrames_(0), recordingDroppedFrames_(0), reportedRecordingDrops_(0),
+      integrationTimeUs_(0.0), darkBias_(0.0), interpolateBadPixels_(true),
+      blackFromCache_(false), whiteFromCache_(false), calibrationMaxAgeHours_(24.0), useStaleCalibration_(false),
+      predictorManager_(nullptr), streamId_(0), workerPool_(nullptr), receiverHub_(nullptr) {
+  // 注册帧类型，用于跨线程的排队信号
+  qRegisterMetaType<SpectrumFramePtr>("SpectrumFramePtr");
+  threadPlacementPath_ = ThreadPlacement::defaultConfigPath();
+  calibrationCachePath_ = CalibrationCache::defaultPath();
+
+  // 曲线显示数据源：按显示帧率合并刷新，不随光谱输出频率重绘
+  displayFeed_ = new DisplayFeed(this);
+
   // 创建每秒统计定时器
   secondTimer_ = new QTimer(this);
   secondTimer_->setInterval(1000);  // 1秒
   connect(secondTimer_, &QTimer::timeout, this, &UdpCommunicator::onSecondTimer);
+
+  // 帧数据不再经过主线程，界面计数改为定期读取接收线程的原子计数器
+  pollTimer_ = new QTimer(this);
+  pollTimer_->setInterval(100);
+  connect(pollTimer_, &QTimer::timeout, this, &UdpCommunicator::onPollTimer);
 }
 
 UdpCommunicator::~UdpCommunicator() {
   stopReceiving();
-  if (blackReferenceProcessor_) {
-    blackReferenceProcessor_->stopProcessing();
-    delete blackReferenceProcessor_;
-    blackReferenceProcessor_ = nullptr;
+  stopRecording();
+  releaseReferenceProcessor(blackReferenceProcessor_);
+  releaseReferenceProcessor(whiteReferenceProcessor_);
+}
+
+bool UdpCommunicator::startReceiving(int port, const QString &bindAddress,
+                                     int batchSize, bool kernelTimestamps) {
+  if (receiving_) {
+    emit statusChanged(replaying_ ? QStringLiteral("✗ 请先停止回放")
+                                  : QStringLiteral("UDP接收已在运行"));
+    return false;
   }
-  if (whiteReferenceProcessor_) {
-    whiteReferenceProcessor_->stopProcessing();
-    delete whiteReferenceProcessor_;
-    whiteReferenceProcessor_ = nullptr;
+
+  applyThreadPlacement();
+  ensureSpectrumProcessor();
+  bool started = false;
+  if (receiverHub_) {
+    // 多光谱仪：套接字注册到共享的接收线程
+    UdpHubEndpoint *endpoint = new UdpHubEndpoint(receiverHub_, this);
+    endpoint->setFrameCounterTrailer(frameCounterTrailer_);
+    attachFrameSource(endpoint);
+    started = endpoint->startReceiving(port, bindAddress, batchSize, kernelTimestamps);
+  } else {
+    UdpReceiverThread *receiver = new UdpReceiverThread(this);
+    receiver->setFrameCounterTrailer(frameCounterTrailer_);
+    attachFrameSource(receiver);
+    started = receiver->startReceiving(port, bindAddress, batchSize, kernelTimestamps);
+  }
+
+  if (started) {
+    replaying_ = false;
+    onFrameSourceStarted();
+    return true;
+  } else {
+    abortFrameSource();
+    return false;
   }
 }
 
-bool UdpCommunicator::startReceiving(int port, const QString &bindAddress) {
+bool UdpCommunicator::startReplay(const QString &path, double speed, bool loop) {
   if (receiving_) {
-    emit statusChanged(QStringLiteral("UDP接收已在运行"));
+    emit statusChanged(replaying_ ? QStringLiteral("回放已在运行")
+                                  : QStringLiteral("✗ 请先停止UDP接收"));
+    return false;
+  }
+  if (path.isEmpty()) {
+    emit statusChanged(QStringLiteral("✗ 回放文件路径为空"));
     return false;
   }
 
-  if (udpReceiver_) {
-    delete udpReceiver_;
+  applyThreadPlacement();
+  ensureSpectrumProcessor();
+  ReplaySource *replay = new ReplaySource(this);
+  attachFrameSource(replay);
+  connect(replay, &ReplaySource::replayFinished,
+          this, &UdpCommunicator::onReplayFinished, Qt::QueuedConnection);
+
+  if (replay->open(path) && replay->startReplay(speed, loop)) {
+    replaying_ = true;
+    onFrameSourceStarted();
+    emit replayingChanged(true);
+    return true;
+  } else {
+    abortFrameSource();
+    return false;
+  }
+}
+
+void UdpCommunicator::stopReplay() {
+  if (replaying_) {
+    stopReceiving();
+  }
+}
+
+void UdpCommunicator::releaseReferenceProcessor(std::shared_ptr<ReferenceProcessor> &processor) {
+  if (!processor) {
+    return;
+  }
+  // removeConsumer 返回后处理线程不再访问它，可以在主线程安全释放
+  if (spectrumProcessor_) {
+    spectrumProcessor_->removeConsumer(processor);
+  }
+  processor.reset();
+}
+
+void UdpCommunicator::applyThreadPlacement() {
+  // 配置错误时仍使用默认值（只设置线程名），不阻止采集
+  ThreadPlacement placement;
+  QString error;
+  if (!placement.load(threadPlacementPath_, &error)) {
+    qWarning() << "线程放置配置无效:" << threadPlacementPath_ << error;
+    emit statusChanged(QStringLiteral("⚠ 线程放置配置无效，已使用默认设置: ") + error);
+    placement = ThreadPlacement();
+  }
+  ThreadPlacement::install(placement);
+  qDebug() << "线程放置:" << placement.describe();
+}
+
+void UdpCommunicator::ensureSpectrumProcessor() {
+  if (frameSource_) {
+    delete frameSource_;
+    frameSource_ = nullptr;
   }
 
   // 创建光谱处理线程（仅在启动UDP接收时创建）
   if (!spectrumProcessor_) {
     spectrumProcessor_ = new SpectrumProcessor(this);
+    spectrumProcessor_->setSpectrumThreshold(spectrumThreshold_);
+    spectrumProcessor_->setAveragingMode(averagingMode_);
+    spectrumProcessor_->setOutputInterval(outputInterval_);
+    spectrumProcessor_->setEmaTimeConstant(emaTimeConstant_);
+    applyAdaptiveAveraging();
+    spectrumProcessor_->setDisplayFeed(displayFeed_);
+    spectrumProcessor_->setStreamId(streamId_);
+    spectrumProcessor_->setWorkerPool(workerPool_);
     connect(spectrumProcessor_, &SpectrumProcessor::spectrumReady,
             this, &UdpCommunicator::onSpectrumProcessed, Qt::QueuedConnection);
-    connect(spectrumProcessor_, &SpectrumProcessor::predictionReady,
-            this, &UdpCommunicator::onPredictionReady, Qt::QueuedConnection);
     // 设置预测器管理器（如果已设置）
     if (predictorManager_) {
       spectrumProcessor_->setPredictorManager(predictorManager_);
     }
     
-    // 恢复已保存的黑白参考数据（如果存在）
-    // 原因：停止获取光谱时会删除 spectrumProcessor_，但黑白参考数据仍保存在 UdpCommunicator 中
-    //       重新开始获取光谱时创建了新的 spectrumProcessor_，需要将之前保存的数据传递给它
-    const int dataPoints = 1024;
-    if (!blackReferenceData_.empty() && blackReferenceData_.size() == dataPoints) {
-      spectrumProcessor_->setBlackReferenceData(blackReferenceData_);
-    }
-    if (!whiteReferenceData_.empty() && whiteReferenceData_.size() == dataPoints) {
-      spectrumProcessor_->setWhiteReferenceData(whiteReferenceData_);
-    }
+    // 恢复已构建的黑白校正标定（如果存在）
+    // 原因：停止获取光谱时会删除 spectrumProcessor_，但标定仍保存在 UdpCommunicator 中
+    //       重新开始获取光谱时创建了新的 spectrumProcessor_，需要将之前的标定传递给它
+    spectrumProcessor_->setCalibration(calibration_);
     
     // 恢复预测器索引（如果之前已启用）
     // 原因：停止获取光谱时会删除 spectrumProcessor_，但预测器索引仍保存在 UdpCommunicator 中
     //       重新开始获取光谱时创建了新的 spectrumProcessor_，需要将之前保存的预测器索引传递给它
-    if (currentPredictorIndex_ >= 0) {
-      spectrumProcessor_->setPredictorIndex(currentPredictorIndex_);
+    if (!predictorIndices_.isEmpty()) {
+      spectrumProcessor_->setPredictorIndices(predictorIndices_);
+    }
+
+    // 处理线程是唯一的采集阶段：参考累积、录制与显示都从它取帧
+    if (blackReferenceProcessor_) {
+      spectrumProcessor_->addConsumer(blackReferenceProcessor_);
+    }
+    if (whiteReferenceProcessor_) {
+      spectrumProcessor_->addConsumer(whiteReferenceProcessor_);
+    }
+    if (recorder_) {
+      spectrumProcessor_->addConsumer(recorder_->inputQueue());
     }
+    spectrumProcessor_->addConsumer(displayFeed_->frameSink());
     
-    spectrumProcessor_->start();  // 启动处理线程
+    spectrumProcessor_->startProcessing();  // 启动处理线程（或加入共享线程池）
   }
+}
 
-  udpReceiver_ = new UdpReceiverThread(this);
-  // 使用QueuedConnection确保信号在主线程的事件循环中处理，不阻塞接收线程
-  connect(udpReceiver_, &UdpReceiverThread::packetReceived,
-          this, &UdpCommunicator::onUdpPacketReceived, Qt::QueuedConnection);
-  connect(udpReceiver_, &UdpReceiverThread::statusChanged,
+void UdpCommunicator::attachFrameSource(SpectrumFrameSource *source) {
+  frameSource_ = source;
+  // 来源线程只把帧写入处理线程的无锁队列，其余消费者由处理线程分发，不经过主线程事件循环
+  frameSource_->addFrameSink(spectrumProcessor_->inputQueue());
+  // 使用QueuedConnection确保信号在主线程的事件循环中处理，不阻塞来源线程
+  connect(frameSource_, &SpectrumFrameSource::statusChanged,
           this, &UdpCommunicator::onUdpStatusChanged, Qt::QueuedConnection);
-  connect(udpReceiver_, &UdpReceiverThread::errorOccurred,
+  connect(frameSource_, &SpectrumFrameSource::errorOccurred,
           this, &UdpCommunicator::onUdpErrorOccurred, Qt::QueuedConnection);
+}
 
-  if (udpReceiver_->startReceiving(port, bindAddress)) {
-    receiving_ = true;
-    packetCount_ = 0;  // 重置计数器
-    packetsPerSecond_ = 0;
-    packetsThisSecond_ = 0;
-    secondTimer_->start();  // 启动每秒统计定时器
-    emit receivingChanged(true);
-    emit packetCountChanged(0);
-    emit packetsPerSecondChanged(0);
-    return true;
-  } else {
-    delete udpReceiver_;
-    udpReceiver_ = nullptr;
-    // 如果UDP接收启动失败，停止并删除光谱处理线程
-    if (spectrumProcessor_) {
-      spectrumProcessor_->stopProcessing();
-      delete spectrumProcessor_;
-      spectrumProcessor_ = nullptr;
-    }
-    return false;
+void UdpCommunicator::onFrameSourceStarted() {
+  receiving_ = true;
+  packetCount_ = 0;  // 重置计数器
+  packetsPerSecond_ = 0;
+  packetsThisSecond_ = 0;
+  droppedFrames_ = 0;
+  lastReceivedPackets_ = 0;
+  lastLinkDatagrams_ = 0;
+  lostFrames_ = 0;
+  reorderedPackets_ = 0;
+  runtPackets_ = 0;
+  kernelDrops_ = 0;
+  framePeriodUs_ = 0.0;
+  jitterUs_ = 0.0;
+  arrivalHistogram_.clear();
+  reportedLinkLosses_ = 0;
+  lastProcessedFrames_ = spectrumProcessor_->processedFrames();
+  processedFramesPerSecond_ = 0;
+  predictionsThisSecond_ = 0;
+  predictionsPerSecond_ = 0;
+  totalPredictions_ = 0;
+  secondTimer_->start();  // 启动每秒统计定时器
+  pollTimer_->start();
+  displayFeed_->start();
+  emit receivingChanged(true);
+  emit packetCountChanged(0);
+  emit packetsPerSecondChanged(0);
+  emit droppedFramesChanged(0);
+  emit linkStatsChanged();
+  emit throughputChanged();
+}
+
+void UdpCommunicator::abortFrameSource() {
+  delete frameSource_;
+  frameSource_ = nullptr;
+  // 如果来源启动失败，停止并删除光谱处理线程
+  if (spectrumProcessor_) {
+    spectrumProcessor_->stopProcessing();
+    delete spectrumProcessor_;
+    spectrumProcessor_ = nullptr;
   }
 }
 
 void UdpCommunicator::stopReceiving() {
-  if (udpReceiver_) {
-    udpReceiver_->stopReceiving();
-    delete udpReceiver_;
-    udpReceiver_ = nullptr;
+  if (frameSource_) {
+    frameSource_->stopSource();
+    onPollTimer();  // 读取最后一次计数
+    delete frameSource_;
+    frameSource_ = nullptr;
   }
   
   // 停止并删除光谱处理线程（仅在停止UDP接收时删除）
@@ -125,11 +281,334 @@ void UdpCommunicator::stopReceiving() {
   }
   
   secondTimer_->stop();  // 停止统计定时器
+  pollTimer_->stop();
+  displayFeed_->stop();
   receiving_ = false;
   packetsPerSecond_ = 0;
   packetsThisSecond_ = 0;
+  processedFramesPerSecond_ = 0;
+  predictionsPerSecond_ = 0;
   emit receivingChanged(false);
   emit packetsPerSecondChanged(0);
+  emit throughputChanged();
+  if (replaying_) {
+    replaying_ = false;
+    emit replayingChanged(false);
+  }
+}
+
+void UdpCommunicator::setSpectrumThreshold(int packets) {
+  packets = qMax(1, packets);
+  if (packets == spectrumThreshold_) {
+    return;
+  }
+  spectrumThreshold_ = packets;
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setSpectrumThreshold(packets);
+  }
+  emit spectrumThresholdChanged(packets);
+}
+
+void UdpCommunicator::setReferenceThreshold(int packets) {
+  packets = qMax(1, packets);
+  if (packets == referenceThreshold_) {
+    return;
+  }
+  referenceThreshold_ = packets;
+  emit referenceThresholdChanged(packets);
+}
+
+void UdpCommunicator::setAveragingMode(int mode) {
+  if (mode < SpectrumProcessor::BlockMode || mode > SpectrumProcessor::AdaptiveMode) {
+    mode = SpectrumProcessor::BlockMode;
+  }
+  if (mode == averagingMode_) {
+    return;
+  }
+  averagingMode_ = mode;
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setAveragingMode(mode);
+  }
+  emit averagingModeChanged(mode);
+}
+
+void UdpCommunicator::setOutputInterval(int packets) {
+  packets = qMax(1, packets);
+  if (packets == outputInterval_) {
+    return;
+  }
+  outputInterval_ = packets;
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setOutputInterval(packets);
+  }
+  emit outputIntervalChanged(packets);
+}
+
+void UdpCommunicator::setEmaTimeConstant(double packets) {
+  packets = qMax(1.0, packets);
+  if (qFuzzyCompare(packets, emaTimeConstant_)) {
+    return;
+  }
+  emaTimeConstant_ = packets;
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setEmaTimeConstant(packets);
+  }
+  emit emaTimeConstantChanged(packets);
+}
+
+void UdpCommunicator::setAdaptiveTargetSnr(double snr) {
+  snr = qMax(0.0, snr);
+  if (qFuzzyCompare(snr + 1.0, adaptiveTargetSnr_ + 1.0)) {
+    return;
+  }
+  adaptiveTargetSnr_ = snr;
+  applyAdaptiveAveraging();
+  emit adaptiveAveragingChanged();
+}
+
+void UdpCommunicator::setAdaptiveTargetStdError(double stdError) {
+  stdError = qMax(0.0, stdError);
+  if (qFuzzyCompare(stdError + 1.0, adaptiveTargetStdError_ + 1.0)) {
+    return;
+  }
+  adaptiveTargetStdError_ = stdError;
+  applyAdaptiveAveraging();
+  emit adaptiveAveragingChanged();
+}
+
+void UdpCommunicator::setAdaptiveMinPackets(int packets) {
+  packets = qMax(2, packets);
+  if (packets == adaptiveMinPackets_) {
+    return;
+  }
+  adaptiveMinPackets_ = packets;
+  adaptiveMaxPackets_ = qMax(adaptiveMaxPackets_, packets);
+  applyAdaptiveAveraging();
+  emit adaptiveAveragingChanged();
+}
+
+void UdpCommunicator::setAdaptiveMaxPackets(int packets) {
+  packets = qMax(2, packets);
+  if (packets == adaptiveMaxPackets_) {
+    return;
+  }
+  adaptiveMaxPackets_ = packets;
+  adaptiveMinPackets_ = qMin(adaptiveMinPackets_, packets);
+  applyAdaptiveAveraging();
+  emit adaptiveAveragingChanged();
+}
+
+void UdpCommunicator::setReferenceTargetStdError(double stdError) {
+  stdError = qMax(0.0, stdError);
+  if (qFuzzyCompare(stdError + 1.0, referenceTargetStdError_ + 1.0)) {
+    return;
+  }
+  referenceTargetStdError_ = stdError;
+  emit adaptiveAveragingChanged();
+}
+
+void UdpCommunicator::applyAdaptiveAveraging() {
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setAdaptiveTarget(adaptiveTargetSnr_, adaptiveTargetStdError_);
+    spectrumProcessor_->setAdaptiveLimits(adaptiveMinPackets_, adaptiveMaxPackets_);
+  }
+}
+
+void UdpCommunicator::setIntegrationTimeUs(double us) {
+  us = qMax(0.0, us);
+  if (qFuzzyCompare(us + 1.0, integrationTimeUs_ + 1.0)) {
+    return;
+  }
+  integrationTimeUs_ = us;
+  rebuildCalibration();
+}
+
+void UdpCommunicator::setDarkBias(double counts) {
+  if (qFuzzyCompare(counts + 1.0, darkBias_ + 1.0)) {
+    return;
+  }
+  darkBias_ = counts;
+  rebuildCalibration();
+}
+
+void UdpCommunicator::setInterpolateBadPixels(bool enabled) {
+  if (enabled == interpolateBadPixels_) {
+    return;
+  }
+  interpolateBadPixels_ = enabled;
+  rebuildCalibration();
+}
+
+int UdpCommunicator::badPixelCount() const {
+  return calibration_ ? calibration_->badPixelCount() : 0;
+}
+
+void UdpCommunicator::rebuildCalibration() {
+  const int dataPoints = SpectralCalibration::kPixelCount;
+  std::shared_ptr<const SpectralCalibration> calibration;
+  if (blackCalibration_.mean.size() == dataPoints && whiteCalibration_.mean.size() == dataPoints) {
+    SpectralCalibration::Options options;
+    options.interpolateBadPixels = interpolateBadPixels_;
+    options.darkBias = darkBias_;
+    options.darkIntegrationUs = blackCalibration_.integrationUs;
+    options.integrationUs = integrationTimeUs_;
+    calibration = SpectralCalibration::build(blackCalibration_.mean.constData(),
+                                             whiteCalibration_.mean.constData(), options);
+    qDebug() << "黑白校正标定已更新，坏像素:" << calibration->badPixelCount()
+             << "暗电流缩放:" << calibration->darkScale();
+  }
+  calibration_ = calibration;
+  // 处理线程在下一条光谱开始时取用新标定，正在使用旧标定的光谱不受影响
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setCalibration(calibration_);
+  }
+  emit calibrationChanged();
+}
+
+// 参考数据在主线程解包一次，之后只以 double 数组保存
+static QVector<double> toDoubleVector(const QVariantList &data) {
+  QVector<double> values;
+  values.reserve(data.size());
+  for (const QVariant &v : data) {
+    values.append(v.toDouble());
+  }
+  return values;
+}
+
+static QVariantList toVariantList(const QVector<double> &data) {
+  QVariantList values;
+  values.reserve(data.size());
+  for (double v : data) {
+    values.append(v);
+  }
+  return values;
+}
+
+bool UdpCommunicator::loadCalibrationCache() {
+  CalibrationCacheContents contents;
+  QString error;
+  if (!CalibrationCache::load(calibrationCachePath_, &contents, &error)) {
+    if (!error.isEmpty()) {
+      qWarning() << "读取标定缓存失败:" << calibrationCachePath_ << error;
+    }
+    return false;
+  }
+  if (!deviceId_.isEmpty() && contents.deviceId != deviceId_) {
+    qWarning() << "标定缓存属于设备" << contents.deviceId << "，与当前设备" << deviceId_ << "不符，已忽略";
+    return false;
+  }
+
+  auto accept = [this](const CalibrationReference &reference, const QString &name) {
+    if (!reference.isValid()) {
+      return false;
+    }
+    if (isReferenceStale(reference) && !useStaleCalibration_) {
+      qWarning() << "缓存的" << name << "已超过" << calibrationMaxAgeHours_ << "小时，需要重新采集";
+      return false;
+    }
+    return true;
+  };
+  const bool black = accept(contents.black, QStringLiteral("黑参考"));
+  const bool white = accept(contents.white, QStringLiteral("白参考"));
+  if (!black && !white) {
+    return false;
+  }
+  if (black) {
+    blackCalibration_ = contents.black;
+    blackFromCache_ = true;
+  }
+  if (white) {
+    whiteCalibration_ = contents.white;
+    whiteFromCache_ = true;
+  }
+  rebuildCalibration();
+
+  qDebug() << "已从标定缓存恢复" << (black && white ? "黑白参考" : (black ? "黑参考" : "白参考"))
+           << "采集于" << calibrationCapturedAt() << (calibrationStale() ? "（已过期，请尽快重新采集）" : "");
+  return true;
+}
+
+void UdpCommunicator::saveCalibrationCache() {
+  if (calibrationCachePath_.isEmpty()) {
+    return;
+  }
+  CalibrationCacheContents contents;
+  contents.deviceId = deviceId_;
+  contents.black = blackCalibration_;
+  contents.white = whiteCalibration_;
+  QString error;
+  if (!CalibrationCache::save(calibrationCachePath_, contents, &error)) {
+    qWarning() << "写入标定缓存失败:" << calibrationCachePath_ << error;
+  }
+}
+
+void UdpCommunicator::setDeviceId(const QString &id) {
+  if (id == deviceId_) {
+    return;
+  }
+  deviceId_ = id;
+  emit calibrationChanged();
+}
+
+void UdpCommunicator::setCalibrationMaxAgeHours(double hours) {
+  hours = qMax(0.0, hours);
+  if (qFuzzyCompare(hours + 1.0, calibrationMaxAgeHours_ + 1.0)) {
+    return;
+  }
+  calibrationMaxAgeHours_ = hours;
+  emit calibrationChanged();
+}
+
+void UdpCommunicator::setUseStaleCalibration(bool enabled) {
+  if (enabled == useStaleCalibration_) {
+    return;
+  }
+  useStaleCalibration_ = enabled;
+  emit calibrationChanged();
+}
+
+bool UdpCommunicator::isReferenceStale(const CalibrationReference &reference) const {
+  if (calibrationMaxAgeHours_ <= 0.0 || !reference.isValid()) {
+    return false;
+  }
+  const qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - reference.capturedWallMs;
+  return ageMs > static_cast<qint64>(calibrationMaxAgeHours_ * 3600.0 * 1000.0);
+}
+
+bool UdpCommunicator::calibrationStale() const {
+  return isReferenceStale(blackCalibration_) || isReferenceStale(whiteCalibration_);
+}
+
+QString UdpCommunicator::calibrationCapturedAt() const {
+  qint64 capturedMs = 0;
+  for (const CalibrationReference *reference : {&blackCalibration_, &whiteCalibration_}) {
+    if (reference->isValid() && (capturedMs == 0 || reference->capturedWallMs < capturedMs)) {
+      capturedMs = reference->capturedWallMs;
+    }
+  }
+  if (capturedMs == 0) {
+    return QString();
+  }
+  return QDateTime::fromMSecsSinceEpoch(capturedMs).toString(QStringLiteral("yyyy-MM-dd HH:mm:ss"));
+}
+
+QVariantList UdpCommunicator::blackReference() const {
+  return toVariantList(blackCalibration_.mean);
+}
+
+QVariantList UdpCommunicator::whiteReference() const {
+  return toVariantList(whiteCalibration_.mean);
+}
+
+void UdpCommunicator::setFrameCounterTrailer(bool enabled) {
+  if (enabled == frameCounterTrailer_) {
+    return;
+  }
+  frameCounterTrailer_ = enabled;
+  emit frameCounterTrailerChanged(enabled);
+  if (receiving_ && !replaying_) {
+    emit statusChanged(QStringLiteral("帧计数设置将在下次启动UDP接收时生效"));
+  }
 }
 
 void UdpCommunicator::resetPacketCount() {
@@ -137,29 +616,155 @@ void UdpCommunicator::resetPacketCount() {
   emit packetCountChanged(0);
 }
 
-void UdpCommunicator::onUdpPacketReceived(const QVariantList &data) {
-  // 增加计数器
-  packetCount_++;
-  packetsThisSecond_++;  // 当前秒内的计数
-  emit packetCountChanged(packetCount_);
-  
-  // 将数据添加到后台处理线程（非阻塞）
+void UdpCommunicator::onPollTimer() {
+  updateRecordingStats();
+  if (!frameSource_) {
+    return;
+  }
+
+  // 增加计数器（按轮询周期通知，不随数据包频率触发）
+  const quint64 received = frameSource_->receivedPackets();
+  const int newPackets = static_cast<int>(received - lastReceivedPackets_);
+  lastReceivedPackets_ = received;
+  if (newPackets > 0) {
+    packetCount_ += newPackets;
+    packetsThisSecond_ += newPackets;  // 当前秒内的计数
+    emit packetCountChanged(packetCount_);
+    emit packetReceived(frameSource_->lastPacketLength());
+  }
+
+  updateLinkStats();
+
+  // 汇总各处理队列的溢出计数
+  quint64 dropped = 0;
   if (spectrumProcessor_) {
-    spectrumProcessor_->addSpectrumData(data);
+    dropped += spectrumProcessor_->inputQueue()->overflowCount();
   }
-  
-  // 如果正在累积黑参考数据，添加到黑参考处理线程
-  if (blackReferenceProcessor_ && blackReferenceAccumulating_) {
-    blackReferenceProcessor_->addSpectrumData(data);
+  if (static_cast<int>(dropped) != droppedFrames_) {
+    droppedFrames_ = static_cast<int>(dropped);
+    emit droppedFramesChanged(droppedFrames_);
   }
-  
-  // 如果正在累积白参考数据，添加到白参考处理线程
-  if (whiteReferenceProcessor_ && whiteReferenceAccumulating_) {
-    whiteReferenceProcessor_->addSpectrumData(data);
+}
+
+bool UdpCommunicator::startRecording(const QString &basePath, int maxFileMB, bool directIo) {
+  if (recorder_) {
+    emit statusChanged(QStringLiteral("原始帧录制已在运行"));
+    return false;
   }
-  
-  // 数据已经在接收线程中转换完成，直接转发给QML
-  emit packetReceived(data);
+  if (basePath.isEmpty()) {
+    emit statusChanged(QStringLiteral("✗ 录制文件路径为空"));
+    return false;
+  }
+
+  // 录制目录不存在时自动创建
+  QDir().mkpath(QFileInfo(basePath).absolutePath());
+
+  recorder_ = new RawFrameRecorder(this);
+  recorder_->configure(basePath, static_cast<qint64>(qMax(1, maxFileMB)) * 1024 * 1024, directIo);
+  connect(recorder_, &RawFrameRecorder::errorOccurred,
+          this, &UdpCommunicator::onRecorderError, Qt::QueuedConnection);
+  recorder_->start();
+  if (spectrumProcessor_) {
+    spectrumProcessor_->addConsumer(recorder_->inputQueue());
+  }
+
+  recordedFrames_ = 0;
+  recordingDroppedFrames_ = 0;
+  reportedRecordingDrops_ = 0;
+  recordingFile_.clear();
+  emit recordingChanged(true);
+  emit recordingStatsChanged();
+  emit statusChanged(QStringLiteral("✓ 原始帧录制已开始: ") + basePath);
+  return true;
+}
+
+void UdpCommunicator::stopRecording() {
+  if (!recorder_) {
+    return;
+  }
+  if (spectrumProcessor_) {
+    spectrumProcessor_->removeConsumer(recorder_->inputQueue());
+  }
+  // 等待已入队的帧全部写盘
+  recorder_->stopRecording();
+  updateRecordingStats();
+  const int segments = recorder_->segmentCount();
+  delete recorder_;
+  recorder_ = nullptr;
+  emit recordingChanged(false);
+  emit statusChanged(QStringLiteral("原始帧录制已停止，共 %1 帧，%2 个文件，丢弃 %3 帧")
+                         .arg(recordedFrames_).arg(segments).arg(recordingDroppedFrames_));
+}
+
+void UdpCommunicator::updateRecordingStats() {
+  if (!recorder_) {
+    return;
+  }
+  const int recorded = static_cast<int>(recorder_->recordedFrames());
+  const int dropped = static_cast<int>(recorder_->droppedFrames());
+  const QString file = recorder_->currentFile();
+  if (recorded == recordedFrames_ && dropped == recordingDroppedFrames_ && file == recordingFile_) {
+    return;
+  }
+  recordedFrames_ = recorded;
+  recordingDroppedFrames_ = dropped;
+  recordingFile_ = file;
+  emit recordingStatsChanged();
+}
+
+void UdpCommunicator::updateLinkStats() {
+  const LinkStats *stats = frameSource_ ? frameSource_->linkStats() : nullptr;
+  if (!stats) {
+    return;
+  }
+  const LinkStats::Snapshot snapshot = stats->snapshot();
+  if (snapshot.datagrams == lastLinkDatagrams_ &&
+      static_cast<int>(snapshot.kernelDrops) == kernelDrops_) {
+    return;
+  }
+  lastLinkDatagrams_ = snapshot.datagrams;
+  lostFrames_ = static_cast<int>(snapshot.lostFrames + snapshot.inferredLostFrames);
+  reorderedPackets_ = static_cast<int>(snapshot.reordered);
+  runtPackets_ = static_cast<int>(snapshot.runts);
+  kernelDrops_ = static_cast<int>(snapshot.kernelDrops);
+  framePeriodUs_ = snapshot.periodUs;
+  jitterUs_ = snapshot.jitterUs;
+
+  // 只输出到最后一个非空桶，溢出桶之外的空尾部不显示
+  int lastBucket = -1;
+  for (int i = 0; i < LinkStats::kHistogramBuckets; ++i) {
+    if (snapshot.histogram[i] > 0) {
+      lastBucket = i;
+    }
+  }
+  arrivalHistogram_.clear();
+  for (int i = 0; i <= lastBucket; ++i) {
+    QVariantMap bucket;
+    bucket.insert(QStringLiteral("lowerUs"), LinkStats::bucketLowerBoundUs(i));
+    bucket.insert(QStringLiteral("count"), static_cast<double>(snapshot.histogram[i]));
+    arrivalHistogram_.append(bucket);
+  }
+  emit linkStatsChanged();
+}
+
+void UdpCommunicator::onRecorderError(const QString &error) {
+  emit statusChanged(QStringLiteral("✗ 原始帧录制: ") + error);
+}
+
+void UdpCommunicator::onReplayFinished(quint64 frames, qint64 elapsedNs) {
+  if (!replaying_) {
+    return;
+  }
+  const double seconds = qMax(elapsedNs, static_cast<qint64>(1)) / 1e9;
+  const double framesPerSecond = static_cast<double>(frames) / seconds;
+  const double predictionRate = static_cast<double>(totalPredictions_) / seconds;
+  emit statusChanged(QStringLiteral("✓ 回放完成：%1 帧，用时 %2 s，%3 帧/s，%4 次预测/s")
+                         .arg(static_cast<int>(frames))
+                         .arg(seconds, 0, 'f', 2)
+                         .arg(framesPerSecond, 0, 'f', 0)
+                         .arg(predictionRate, 0, 'f', 1));
+  emit replayFinished(static_cast<int>(frames), framesPerSecond, predictionRate);
+  stopReceiving();
 }
 
 void UdpCommunicator::onSecondTimer() {
@@ -167,6 +772,30 @@ void UdpCommunicator::onSecondTimer() {
   packetsPerSecond_ = packetsThisSecond_;
   packetsThisSecond_ = 0;  // 重置当前秒计数
   emit packetsPerSecondChanged(packetsPerSecond_);
+
+  // 处理线程的帧率与预测速率，回放不限速时即为流水线吞吐
+  if (spectrumProcessor_) {
+    const quint64 processed = spectrumProcessor_->processedFrames();
+    processedFramesPerSecond_ = static_cast<int>(processed - lastProcessedFrames_);
+    lastProcessedFrames_ = processed;
+  }
+  predictionsPerSecond_ = predictionsThisSecond_;
+  predictionsThisSecond_ = 0;
+  emit throughputChanged();
+
+  // 链路丢帧每秒最多提示一次，在它影响平均结果之前给出提示
+  const int linkLosses = lostFrames_ + kernelDrops_;
+  if (linkLosses > reportedLinkLosses_) {
+    emit statusChanged(QStringLiteral("⚠ UDP链路丢帧 %1（内核丢包 %2，短包 %3，乱序 %4）")
+                           .arg(lostFrames_).arg(kernelDrops_).arg(runtPackets_).arg(reorderedPackets_));
+    reportedLinkLosses_ = linkLosses;
+  }
+
+  // 录制丢帧每秒最多提示一次
+  if (recordingDroppedFrames_ > reportedRecordingDrops_) {
+    reportedRecordingDrops_ = recordingDroppedFrames_;
+    emit statusChanged(QStringLiteral("⚠ 原始帧录制跟不上，已丢弃 %1 帧").arg(recordingDroppedFrames_));
+  }
 }
 
 void UdpCommunicator::onUdpStatusChanged(const QString &message) {
@@ -180,13 +809,13 @@ void UdpCommunicator::onUdpErrorOccurred(const QString &error) {
 }
 
 void UdpCommunicator::onSpectrumProcessed(const QVariantList &averagedSpectrum, 
-                                          double minVal, double maxVal, int packetCount) {
+                                          double minVal, double maxVal, int packetCount, double snr) {
   // 在后端打印本次光谱的点数，便于确认长度（例如是否为 1024）
   qDebug() << "[UdpCommunicator] Single spectrum length:" << averagedSpectrum.size()
-           << ", min:" << minVal << ", max:" << maxVal << ", packetCount:" << packetCount;
+           << ", min:" << minVal << ", max:" << maxVal << ", packetCount:" << packetCount << ", snr:" << snr;
 
   // 数据已经在后台线程中处理完成（包括平均值计算和黑白校正），直接转发到QML
-  emit spectrumReady(averagedSpectrum, minVal, maxVal, packetCount);
+  emit spectrumReady(averagedSpectrum, minVal, maxVal, packetCount, snr);
 }
 
 void UdpCommunicator::startBlackReference() {
@@ -196,26 +825,43 @@ void UdpCommunicator::startBlackReference() {
   }
   
   if (!receiving_) {
-    emit statusChanged(QStringLiteral("✗ 请先启动UDP接收"));
+    emit statusChanged(QStringLiteral("✗ 请先启动UDP接收或回放"));
     return;
   }
   
-  // 如果线程不存在，创建并启动黑参考处理线程
+  // 创建黑参考累积器（信号从处理线程发出）
   if (!blackReferenceProcessor_) {
-    blackReferenceProcessor_ = new ReferenceProcessor(ReferenceProcessor::BlackReference, this);
-    connect(blackReferenceProcessor_, &ReferenceProcessor::progressChanged,
+    blackReferenceProcessor_ = std::make_shared<ReferenceProcessor>(ReferenceProcessor::BlackReference);
+    connect(blackReferenceProcessor_.get(), &ReferenceProcessor::progressChanged,
             this, &UdpCommunicator::onBlackReferenceProgressChanged, Qt::QueuedConnection);
-    connect(blackReferenceProcessor_, &ReferenceProcessor::blackReferenceReady,
+    connect(blackReferenceProcessor_.get(), &ReferenceProcessor::blackReferenceReady,
             this, &UdpCommunicator::onBlackReferenceProcessed, Qt::QueuedConnection);
-    blackReferenceProcessor_->start();  // 启动处理线程
+    // 噪声在 ready 信号之前到达，与随后的平均值一起写入缓存
+    connect(blackReferenceProcessor_.get(), &ReferenceProcessor::noiseReady, this,
+            [this](const QVariantList &pixelStdDev, double meanStdDev, double stdError) {
+              blackCalibration_.stdDev = toDoubleVector(pixelStdDev);
+              emit statusChanged(QStringLiteral("黑参考逐像素噪声（平均标准差）: ") +
+                                 QString::number(meanStdDev, 'f', 2) + QStringLiteral("，平均值标准误（中位数）: ") +
+                                 QString::number(stdError, 'f', 3));
+            }, Qt::QueuedConnection);
   }
   
+  blackReferenceProcessor_->setReferenceThreshold(referenceThreshold_);
+  blackReferenceProcessor_->setAdaptiveTarget(referenceTargetStdError_);
   blackReferenceProcessor_->startAccumulating();
+  // 与主光谱共用处理线程取出的同一批帧
+  if (spectrumProcessor_) {
+    spectrumProcessor_->addConsumer(blackReferenceProcessor_);
+  }
   blackReferenceAccumulating_ = true;
   blackReferenceProgress_ = 0;
   emit blackReferenceAccumulatingChanged(true);
   emit blackReferenceProgressChanged(0);
-  emit statusChanged(QStringLiteral("✓ 开始累积黑参考数据，需要39500个数据包"));
+  emit statusChanged(QStringLiteral("✓ 开始累积黑参考数据，需要") +
+                     QString::number(referenceThreshold_) + QStringLiteral("个数据包") +
+                     (referenceTargetStdError_ > 0.0
+                          ? QStringLiteral("（达到目标标准误 %1 时提前结束）").arg(referenceTargetStdError_)
+                          : QString()));
 }
 
 void UdpCommunicator::stopBlackReference() {
@@ -231,57 +877,55 @@ void UdpCommunicator::stopBlackReference() {
     emit blackReferenceProgressChanged(0);
     emit statusChanged(QStringLiteral("黑参考累积已停止"));
     
-    // 停止并删除黑参考处理线程（不再常驻）
-    blackReferenceProcessor_->stopProcessing();
-    delete blackReferenceProcessor_;
-    blackReferenceProcessor_ = nullptr;
+    // 释放黑参考累积器（不再常驻）
+    releaseReferenceProcessor(blackReferenceProcessor_);
   }
 }
 
 void UdpCommunicator::onBlackReferenceProgressChanged(int count, int total) {
+  // 每跨过1000个数据包更新一次状态（按批到达时计数不一定正好落在1000的整数倍上）
+  const bool crossedThousand = (count / 1000) != (blackReferenceProgress_ / 1000);
   blackReferenceProgress_ = count;
   emit blackReferenceProgressChanged(count);
   
-  // 每1000个数据包更新一次状态
-  if (count % 1000 == 0 || count == total) {
+  if (crossedThousand || count == total) {
     emit statusChanged(QStringLiteral("黑参考累积进度: ") + QString::number(count) + 
                        QStringLiteral("/") + QString::number(total));
   }
 }
 
 void UdpCommunicator::onBlackReferenceProcessed(const QVariantList &averagedSpectrum, 
-                                                 double minVal, double maxVal) {
+                                                 double minVal, double maxVal, int packetCount) {
   blackReferenceAccumulating_ = false;
   blackReferenceProgress_ = 0;
   emit blackReferenceAccumulatingChanged(false);
   emit blackReferenceProgressChanged(0);
   
-  // 保存黑参考数据
-  blackReferenceData_ = averagedSpectrum;
+  // 保存黑参考数据，并记录采集时间与积分时间（暗电流缩放的基准）
+  blackCalibration_.mean = toDoubleVector(averagedSpectrum);
+  blackCalibration_.capturedWallMs = QDateTime::currentMSecsSinceEpoch();
+  blackCalibration_.frameCount = packetCount;
+  blackCalibration_.integrationUs = integrationTimeUs_;
+  blackFromCache_ = false;
   
-  // 将黑参考数据传递给光谱处理线程（如果存在）
-  if (spectrumProcessor_) {
-    spectrumProcessor_->setBlackReferenceData(averagedSpectrum);
-  }
+  // 重建标定并传递给光谱处理线程（如果存在），再写回标定缓存
+  rebuildCalibration();
+  saveCalibrationCache();
   
   emit statusChanged(QStringLiteral("✓ 黑参考数据处理完成！平均值: ") + 
                      QString::number(minVal, 'f', 2) + QStringLiteral(" ~ ") + 
                      QString::number(maxVal, 'f', 2));
   
   // 检查是否可以进行黑白校正
-  if (!whiteReferenceData_.empty()) {
+  if (whiteCalibration_.isValid()) {
     emit statusChanged(QStringLiteral("✓ 黑白参考数据已就绪，光谱数据将在后台线程进行黑白校正"));
   }
   
   // 将处理好的黑参考数据发送到QML
   emit blackReferenceReady(averagedSpectrum, minVal, maxVal);
   
-  // 处理完成后，停止并删除黑参考处理线程（不再常驻）
-  if (blackReferenceProcessor_) {
-    blackReferenceProcessor_->stopProcessing();
-    delete blackReferenceProcessor_;
-    blackReferenceProcessor_ = nullptr;
-  }
+  // 处理完成后释放黑参考累积器（不再常驻）
+  releaseReferenceProcessor(blackReferenceProcessor_);
 }
 
 void UdpCommunicator::startWhiteReference() {
@@ -291,26 +935,43 @@ void UdpCommunicator::startWhiteReference() {
   }
   
   if (!receiving_) {
-    emit statusChanged(QStringLiteral("✗ 请先启动UDP接收"));
+    emit statusChanged(QStringLiteral("✗ 请先启动UDP接收或回放"));
     return;
   }
   
-  // 如果线程不存在，创建并启动白参考处理线程
+  // 创建白参考累积器（信号从处理线程发出）
   if (!whiteReferenceProcessor_) {
-    whiteReferenceProcessor_ = new ReferenceProcessor(ReferenceProcessor::WhiteReference, this);
-    connect(whiteReferenceProcessor_, &ReferenceProcessor::progressChanged,
+    whiteReferenceProcessor_ = std::make_shared<ReferenceProcessor>(ReferenceProcessor::WhiteReference);
+    connect(whiteReferenceProcessor_.get(), &ReferenceProcessor::progressChanged,
             this, &UdpCommunicator::onWhiteReferenceProgressChanged, Qt::QueuedConnection);
-    connect(whiteReferenceProcessor_, &ReferenceProcessor::whiteReferenceReady,
+    connect(whiteReferenceProcessor_.get(), &ReferenceProcessor::whiteReferenceReady,
             this, &UdpCommunicator::onWhiteReferenceProcessed, Qt::QueuedConnection);
-    whiteReferenceProcessor_->start();  // 启动处理线程
+    // 噪声在 ready 信号之前到达，与随后的平均值一起写入缓存
+    connect(whiteReferenceProcessor_.get(), &ReferenceProcessor::noiseReady, this,
+            [this](const QVariantList &pixelStdDev, double meanStdDev, double stdError) {
+              whiteCalibration_.stdDev = toDoubleVector(pixelStdDev);
+              emit statusChanged(QStringLiteral("白参考逐像素噪声（平均标准差）: ") +
+                                 QString::number(meanStdDev, 'f', 2) + QStringLiteral("，平均值标准误（中位数）: ") +
+                                 QString::number(stdError, 'f', 3));
+            }, Qt::QueuedConnection);
   }
   
+  whiteReferenceProcessor_->setReferenceThreshold(referenceThreshold_);
+  whiteReferenceProcessor_->setAdaptiveTarget(referenceTargetStdError_);
   whiteReferenceProcessor_->startAccumulating();
+  // 与主光谱共用处理线程取出的同一批帧
+  if (spectrumProcessor_) {
+    spectrumProcessor_->addConsumer(whiteReferenceProcessor_);
+  }
   whiteReferenceAccumulating_ = true;
   whiteReferenceProgress_ = 0;
   emit whiteReferenceAccumulatingChanged(true);
   emit whiteReferenceProgressChanged(0);
-  emit statusChanged(QStringLiteral("✓ 开始累积白参考数据，需要39500个数据包"));
+  emit statusChanged(QStringLiteral("✓ 开始累积白参考数据，需要") +
+                     QString::number(referenceThreshold_) + QStringLiteral("个数据包") +
+                     (referenceTargetStdError_ > 0.0
+                          ? QStringLiteral("（达到目标标准误 %1 时提前结束）").arg(referenceTargetStdError_)
+                          : QString()));
 }
 
 void UdpCommunicator::stopWhiteReference() {
@@ -326,61 +987,69 @@ void UdpCommunicator::stopWhiteReference() {
     emit whiteReferenceProgressChanged(0);
     emit statusChanged(QStringLiteral("白参考累积已停止"));
     
-    // 停止并删除白参考处理线程（不再常驻）
-    whiteReferenceProcessor_->stopProcessing();
-    delete whiteReferenceProcessor_;
-    whiteReferenceProcessor_ = nullptr;
+    // 释放白参考累积器（不再常驻）
+    releaseReferenceProcessor(whiteReferenceProcessor_);
   }
 }
 
 void UdpCommunicator::onWhiteReferenceProgressChanged(int count, int total) {
+  // 每跨过1000个数据包更新一次状态（按批到达时计数不一定正好落在1000的整数倍上）
+  const bool crossedThousand = (count / 1000) != (whiteReferenceProgress_ / 1000);
   whiteReferenceProgress_ = count;
   emit whiteReferenceProgressChanged(count);
   
-  // 每1000个数据包更新一次状态
-  if (count % 1000 == 0 || count == total) {
+  if (crossedThousand || count == total) {
     emit statusChanged(QStringLiteral("白参考累积进度: ") + QString::number(count) + 
                        QStringLiteral("/") + QString::number(total));
   }
 }
 
 void UdpCommunicator::onWhiteReferenceProcessed(const QVariantList &averagedSpectrum, 
-                                                 double minVal, double maxVal) {
+                                                 double minVal, double maxVal, int packetCount) {
   whiteReferenceAccumulating_ = false;
   whiteReferenceProgress_ = 0;
   emit whiteReferenceAccumulatingChanged(false);
   emit whiteReferenceProgressChanged(0);
   
-  // 保存白参考数据
-  whiteReferenceData_ = averagedSpectrum;
+  // 保存白参考数据，并记录采集时间与积分时间（暗电流缩放的基准）
+  whiteCalibration_.mean = toDoubleVector(averagedSpectrum);
+  whiteCalibration_.capturedWallMs = QDateTime::currentMSecsSinceEpoch();
+  whiteCalibration_.frameCount = packetCount;
+  whiteCalibration_.integrationUs = integrationTimeUs_;
+  whiteFromCache_ = false;
   
-  // 将白参考数据传递给光谱处理线程（如果存在）
-  if (spectrumProcessor_) {
-    spectrumProcessor_->setWhiteReferenceData(averagedSpectrum);
-  }
+  // 重建标定并传递给光谱处理线程（如果存在），再写回标定缓存
+  rebuildCalibration();
+  saveCalibrationCache();
   
   emit statusChanged(QStringLiteral("✓ 白参考数据处理完成！平均值: ") + 
                      QString::number(minVal, 'f', 2) + QStringLiteral(" ~ ") + 
                      QString::number(maxVal, 'f', 2));
   
   // 检查是否可以进行黑白校正
-  if (!blackReferenceData_.empty()) {
+  if (blackCalibration_.isValid()) {
     emit statusChanged(QStringLiteral("✓ 黑白参考数据已就绪，光谱数据将在后台线程进行黑白校正"));
   }
   
   // 将处理好的白参考数据发送到QML
   emit whiteReferenceReady(averagedSpectrum, minVal, maxVal);
   
-  // 处理完成后，停止并删除白参考处理线程（不再常驻）
-  if (whiteReferenceProcessor_) {
-    whiteReferenceProcessor_->stopProcessing();
-    delete whiteReferenceProcessor_;
-    whiteReferenceProcessor_ = nullptr;
-  }
+  // 处理完成后释放白参考累积器（不再常驻）
+  releaseReferenceProcessor(whiteReferenceProcessor_);
 }
 
 void UdpCommunicator::setPredictorManager(SpectrumPredictorManager *manager) {
+  if (predictorManager_) {
+    disconnect(predictorManager_->inferenceExecutor(), nullptr, this, nullptr);
+  }
   predictorManager_ = manager;
+  // 预测结果由推理执行器的工作线程发出
+  if (manager) {
+    connect(manager->inferenceExecutor(), &InferenceExecutor::predictionReady,
+            this, &UdpCommunicator::onPredictionReady, Qt::QueuedConnection);
+    connect(manager->inferenceExecutor(), &InferenceExecutor::multiPredictionReady,
+            this, &UdpCommunicator::onMultiPredictionReady, Qt::QueuedConnection);
+  }
   // 如果光谱处理线程已创建，设置预测器管理器
   if (spectrumProcessor_) {
     spectrumProcessor_->setPredictorManager(manager);
@@ -389,16 +1058,56 @@ void UdpCommunicator::setPredictorManager(SpectrumPredictorManager *manager) {
 
 void UdpCommunicator::setPredictorIndex(int index) {
   // 保存预测器索引
-  currentPredictorIndex_ = index;
+  predictorIndices_.clear();
+  if (index >= 0) {
+    predictorIndices_.append(index);
+  }
   
   // 设置预测器索引到光谱处理线程（如果存在）
   if (spectrumProcessor_) {
-    spectrumProcessor_->setPredictorIndex(index);
+    spectrumProcessor_->setPredictorIndices(predictorIndices_);
   }
 }
 
-void UdpCommunicator::onPredictionReady(int predictorIndex, double predictionValue) {
+void UdpCommunicator::setPredictorIndices(const QVariantList &indices) {
+  predictorIndices_.clear();
+  for (const QVariant &v : indices) {
+    const int index = v.toInt();
+    if (index >= 0 && !predictorIndices_.contains(index)) {
+      predictorIndices_.append(index);
+    }
+  }
+  
+  if (spectrumProcessor_) {
+    spectrumProcessor_->setPredictorIndices(predictorIndices_);
+  }
+}
+
+void UdpCommunicator::onPredictionReady(int predictorIndex, double predictionValue, qint64 windowTimestampNs,
+                                        qint64 completedNs, int streamId) {
+  // 多台光谱仪共用推理执行器，只转发本设备提交的请求
+  if (streamId != streamId_) {
+    return;
+  }
+  // 排队信号送达主线程的耗时，以及从窗口最后一帧到达起的端到端延迟
+  const qint64 nowNs = SpectrumFrame::nowNs();
+  const quint64 traceId = static_cast<quint64>(windowTimestampNs);
+  PipelineStats::record(PipelineStats::Delivery, completedNs, nowNs, traceId);
+  PipelineStats::record(PipelineStats::EndToEnd, windowTimestampNs, nowNs, traceId);
+  predictionsThisSecond_++;
+  totalPredictions_++;
   // 转发预测结果信号到 QML
   emit predictionReady(predictorIndex, predictionValue);
 }
 
+void UdpCommunicator::onMultiPredictionReady(const QVariantList &predictorIndices,
+                                             const QVariantList &predictionValues,
+                                             double ensembleMean, qint64 windowTimestampNs, qint64 completedNs,
+                                             int streamId) {
+  Q_UNUSED(windowTimestampNs);
+  Q_UNUSED(completedNs);
+  if (streamId != streamId_) {
+    return;
+  }
+  emit multiPredictionReady(predictorIndices, predictionValues, ensembleMean);
+}
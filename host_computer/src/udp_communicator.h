@@ -3,11 +3,20 @@
 #include <QObject>
 #include <QVariant>
 #include <QTimer>
+#include <QVector>
 
-class UdpReceiverThread;
+#include "calibration_cache.h"
+#include "display_feed.h"
+#include "spectrum_frame.h"
+
+class SpectrumFrameSource;
 class SpectrumProcessor;
+class SpectrumWorkerPool;
+class UdpReceiverHub;
 class ReferenceProcessor;
+class RawFrameRecorder;
 class SpectrumPredictorManager;
+class SpectralCalibration;
 
 // UDP通信管理类，负责UDP数据包接收
 class UdpCommunicator : public QObject {
@@ -15,10 +24,49 @@ class UdpCommunicator : public QObject {
   Q_PROPERTY(bool receiving READ isReceiving NOTIFY receivingChanged)
   Q_PROPERTY(int packetCount READ packetCount NOTIFY packetCountChanged)
   Q_PROPERTY(int packetsPerSecond READ packetsPerSecond NOTIFY packetsPerSecondChanged)
+  Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY droppedFramesChanged)
+  Q_PROPERTY(bool frameCounterTrailer READ frameCounterTrailer WRITE setFrameCounterTrailer NOTIFY frameCounterTrailerChanged)
+  Q_PROPERTY(int lostFrames READ lostFrames NOTIFY linkStatsChanged)
+  Q_PROPERTY(int reorderedPackets READ reorderedPackets NOTIFY linkStatsChanged)
+  Q_PROPERTY(int runtPackets READ runtPackets NOTIFY linkStatsChanged)
+  Q_PROPERTY(int kernelDrops READ kernelDrops NOTIFY linkStatsChanged)
+  Q_PROPERTY(double framePeriodUs READ framePeriodUs NOTIFY linkStatsChanged)
+  Q_PROPERTY(double jitterUs READ jitterUs NOTIFY linkStatsChanged)
+  Q_PROPERTY(QVariantList arrivalHistogram READ arrivalHistogram NOTIFY linkStatsChanged)
   Q_PROPERTY(bool blackReferenceAccumulating READ isBlackReferenceAccumulating NOTIFY blackReferenceAccumulatingChanged)
   Q_PROPERTY(int blackReferenceProgress READ blackReferenceProgress NOTIFY blackReferenceProgressChanged)
   Q_PROPERTY(bool whiteReferenceAccumulating READ isWhiteReferenceAccumulating NOTIFY whiteReferenceAccumulatingChanged)
   Q_PROPERTY(int whiteReferenceProgress READ whiteReferenceProgress NOTIFY whiteReferenceProgressChanged)
+  Q_PROPERTY(int spectrumThreshold READ spectrumThreshold WRITE setSpectrumThreshold NOTIFY spectrumThresholdChanged)
+  Q_PROPERTY(int referenceThreshold READ referenceThreshold WRITE setReferenceThreshold NOTIFY referenceThresholdChanged)
+  Q_PROPERTY(int averagingMode READ averagingMode WRITE setAveragingMode NOTIFY averagingModeChanged)
+  Q_PROPERTY(int outputInterval READ outputInterval WRITE setOutputInterval NOTIFY outputIntervalChanged)
+  Q_PROPERTY(double emaTimeConstant READ emaTimeConstant WRITE setEmaTimeConstant NOTIFY emaTimeConstantChanged)
+  Q_PROPERTY(double adaptiveTargetSnr READ adaptiveTargetSnr WRITE setAdaptiveTargetSnr NOTIFY adaptiveAveragingChanged)
+  Q_PROPERTY(double adaptiveTargetStdError READ adaptiveTargetStdError WRITE setAdaptiveTargetStdError NOTIFY adaptiveAveragingChanged)
+  Q_PROPERTY(int adaptiveMinPackets READ adaptiveMinPackets WRITE setAdaptiveMinPackets NOTIFY adaptiveAveragingChanged)
+  Q_PROPERTY(int adaptiveMaxPackets READ adaptiveMaxPackets WRITE setAdaptiveMaxPackets NOTIFY adaptiveAveragingChanged)
+  Q_PROPERTY(double referenceTargetStdError READ referenceTargetStdError WRITE setReferenceTargetStdError NOTIFY adaptiveAveragingChanged)
+  Q_PROPERTY(double integrationTimeUs READ integrationTimeUs WRITE setIntegrationTimeUs NOTIFY calibrationChanged)
+  Q_PROPERTY(double darkBias READ darkBias WRITE setDarkBias NOTIFY calibrationChanged)
+  Q_PROPERTY(bool interpolateBadPixels READ interpolateBadPixels WRITE setInterpolateBadPixels NOTIFY calibrationChanged)
+  Q_PROPERTY(int badPixelCount READ badPixelCount NOTIFY calibrationChanged)
+  Q_PROPERTY(QString deviceId READ deviceId WRITE setDeviceId NOTIFY calibrationChanged)
+  Q_PROPERTY(double calibrationMaxAgeHours READ calibrationMaxAgeHours WRITE setCalibrationMaxAgeHours NOTIFY calibrationChanged)
+  Q_PROPERTY(bool useStaleCalibration READ useStaleCalibration WRITE setUseStaleCalibration NOTIFY calibrationChanged)
+  Q_PROPERTY(bool calibrationFromCache READ calibrationFromCache NOTIFY calibrationChanged)
+  Q_PROPERTY(bool calibrationStale READ calibrationStale NOTIFY calibrationChanged)
+  Q_PROPERTY(QString calibrationCapturedAt READ calibrationCapturedAt NOTIFY calibrationChanged)
+  Q_PROPERTY(QVariantList blackReference READ blackReference NOTIFY calibrationChanged)
+  Q_PROPERTY(QVariantList whiteReference READ whiteReference NOTIFY calibrationChanged)
+  Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+  Q_PROPERTY(int recordedFrames READ recordedFrames NOTIFY recordingStatsChanged)
+  Q_PROPERTY(int recordingDroppedFrames READ recordingDroppedFrames NOTIFY recordingStatsChanged)
+  Q_PROPERTY(QString recordingFile READ recordingFile NOTIFY recordingStatsChanged)
+  Q_PROPERTY(bool replaying READ isReplaying NOTIFY replayingChanged)
+  Q_PROPERTY(DisplayFeed *displayFeed READ displayFeed CONSTANT)
+  Q_PROPERTY(int processedFramesPerSecond READ processedFramesPerSecond NOTIFY throughputChanged)
+  Q_PROPERTY(int predictionsPerSecond READ predictionsPerSecond NOTIFY throughputChanged)
 
  public:
   explicit UdpCommunicator(QObject *parent = nullptr);
@@ -27,12 +75,120 @@ class UdpCommunicator : public QObject {
   bool isReceiving() const { return receiving_; }
   int packetCount() const { return packetCount_; }
   int packetsPerSecond() const { return packetsPerSecond_; }
+  int droppedFrames() const { return droppedFrames_; }
   bool isBlackReferenceAccumulating() const { return blackReferenceAccumulating_; }
   int blackReferenceProgress() const { return blackReferenceProgress_; }
   bool isWhiteReferenceAccumulating() const { return whiteReferenceAccumulating_; }
   int whiteReferenceProgress() const { return whiteReferenceProgress_; }
+  int spectrumThreshold() const { return spectrumThreshold_; }
+  int referenceThreshold() const { return referenceThreshold_; }
+
+  // 每条光谱累积的数据包数（运行中修改从下一个窗口开始生效）
+  void setSpectrumThreshold(int packets);
+  // 黑白参考累积的数据包数（从下一次开始累积时生效）
+  void setReferenceThreshold(int packets);
+
+  // 光谱平均方式：0 分块平均（默认），1 滑动窗口，2 指数移动平均，3 自适应（见 SpectrumProcessor::AveragingMode）
+  int averagingMode() const { return averagingMode_; }
+  void setAveragingMode(int mode);
+  // 滚动模式（滑动窗口 / 指数移动平均）每隔多少个数据包输出一次
+  int outputInterval() const { return outputInterval_; }
+  void setOutputInterval(int packets);
+  // 指数移动平均的时间常数（以数据包数计）
+  double emaTimeConstant() const { return emaTimeConstant_; }
+  void setEmaTimeConstant(double packets);
+  // 自适应平均：中位数信噪比达到 adaptiveTargetSnr 且中位数标准误不超过 adaptiveTargetStdError 时输出一条光谱
+  // （<= 0 表示不使用该项），每条光谱累积 adaptiveMinPackets ~ adaptiveMaxPackets 个数据包
+  double adaptiveTargetSnr() const { return adaptiveTargetSnr_; }
+  void setAdaptiveTargetSnr(double snr);
+  double adaptiveTargetStdError() const { return adaptiveTargetStdError_; }
+  void setAdaptiveTargetStdError(double stdError);
+  int adaptiveMinPackets() const { return adaptiveMinPackets_; }
+  void setAdaptiveMinPackets(int packets);
+  int adaptiveMaxPackets() const { return adaptiveMaxPackets_; }
+  void setAdaptiveMaxPackets(int packets);
+  // 黑白参考的目标标准误（计数）：> 0 时达到该值即结束累积，referenceThreshold 作为上限（从下一次开始累积时生效）
+  double referenceTargetStdError() const { return referenceTargetStdError_; }
+  void setReferenceTargetStdError(double stdError);
+
+  // 黑白校正标定（见 SpectralCalibration），黑白参考完成或以下参数变化时在主线程重建一次
+  // 当前积分时间（微秒，0 表示未知）：与黑参考采集时不同时按比例缩放黑参考中的暗电流部分
+  double integrationTimeUs() const { return integrationTimeUs_; }
+  void setIntegrationTimeUs(double us);
+  // 暗电流模型中与积分时间无关的电子偏置（计数）
+  double darkBias() const { return darkBias_; }
+  void setDarkBias(double counts);
+  // 坏像素是否用相邻正常像素插值（否则保留原始值）
+  bool interpolateBadPixels() const { return interpolateBadPixels_; }
+  void setInterpolateBadPixels(bool enabled);
+  int badPixelCount() const;
+
+  // 标定缓存（见 CalibrationCache）：黑/白参考完成后写入，启动时 loadCalibrationCache() 读取
+  // - deviceId 非空时只接受同一设备的缓存
+  // - 超过 calibrationMaxAgeHours（0 表示不过期）的参考视为过期：默认丢弃；
+  //   useStaleCalibration 为 true 时仍然使用并标记 calibrationStale，直到重新采集
+  // - 重新采集期间继续使用当前（缓存的）标定，新参考完成后才替换并写回缓存
+  Q_INVOKABLE bool loadCalibrationCache();
+  void setCalibrationCachePath(const QString &path) { calibrationCachePath_ = path; }
+  QString calibrationCachePath() const { return calibrationCachePath_; }
+  QString deviceId() const { return deviceId_; }
+  void setDeviceId(const QString &id);
+  double calibrationMaxAgeHours() const { return calibrationMaxAgeHours_; }
+  void setCalibrationMaxAgeHours(double hours);
+  bool useStaleCalibration() const { return useStaleCalibration_; }
+  void setUseStaleCalibration(bool enabled);
+  bool calibrationFromCache() const { return blackFromCache_ || whiteFromCache_; }
+  bool calibrationStale() const;
+  // 较早一条参考的采集时间（本地时间文本，没有参考时为空）
+  QString calibrationCapturedAt() const;
+  // 当前黑/白参考的逐像素平均值（没有时为空），界面启动时用于恢复参考状态
+  QVariantList blackReference() const;
+  QVariantList whiteReference() const;
+
+  // 原始帧录制状态
+  bool isRecording() const { return recorder_ != nullptr; }
+  int recordedFrames() const { return recordedFrames_; }
+  int recordingDroppedFrames() const { return recordingDroppedFrames_; }
+  QString recordingFile() const { return recordingFile_; }
 
-  Q_INVOKABLE bool startReceiving(int port, const QString &bindAddress = QString());
+  // 开始录制原始帧：每一帧（含接收序号与时间戳）写入 <basePath>_NNNN.sfr
+  // maxFileMB: 单个分段文件的大小上限（MB），写满后滚动到下一个文件
+  // directIo: 是否使用 O_DIRECT 绕过页缓存（文件系统不支持时自动回退）
+  // 录制与接收相互独立，可以在接收前后任意时刻开始或停止
+  Q_INVOKABLE bool startRecording(const QString &basePath, int maxFileMB = 1024, bool directIo = false);
+  Q_INVOKABLE void stopRecording();
+
+  // 链路质量（见 LinkStats）：丢帧 = 按帧计数检测 + 无帧计数时按到达间隔推断
+  // 到达间隔与抖动需要逐包时间戳，批量接收时请启用内核时间戳
+  bool frameCounterTrailer() const { return frameCounterTrailer_; }
+  void setFrameCounterTrailer(bool enabled);
+  int lostFrames() const { return lostFrames_; }
+  int reorderedPackets() const { return reorderedPackets_; }
+  int runtPackets() const { return runtPackets_; }
+  int kernelDrops() const { return kernelDrops_; }
+  double framePeriodUs() const { return framePeriodUs_; }
+  double jitterUs() const { return jitterUs_; }
+  // 到达间隔直方图，每个元素为 { lowerUs, count }（第 k 桶覆盖 [2^(k-1), 2^k) 微秒）
+  QVariantList arrivalHistogram() const { return arrivalHistogram_; }
+
+  // 实时曲线的显示数据源：按显示帧率合并、按像素宽度抽取后的光谱与原始帧
+  DisplayFeed *displayFeed() const { return displayFeed_; }
+
+  // 回放状态与吞吐统计（接收和回放时均按秒更新）
+  bool isReplaying() const { return replaying_; }
+  int processedFramesPerSecond() const { return processedFramesPerSecond_; }
+  int predictionsPerSecond() const { return predictionsPerSecond_; }
+
+  // 用录制文件代替光谱仪输入：.sfr 原始帧录制（自动接上后续分段）或 saveAllSpectraTableToCsv 导出的 CSV
+  // speed: 1 为实时，N 为 N 倍速，0 为不限速（按处理队列反压，用于测量流水线吞吐）
+  // 回放期间 receiving 为 true，黑白参考累积、预测与录制的用法与 UDP 接收相同；播完后自动停止并报告吞吐
+  Q_INVOKABLE bool startReplay(const QString &path, double speed = 1.0, bool loop = false);
+  Q_INVOKABLE void stopReplay();
+
+  // batchSize: 每次唤醒通过 recvmmsg 最多接收的数据包数（1 表示逐包接收）
+  // kernelTimestamps: 是否使用 SO_TIMESTAMPNS 内核时间戳
+  Q_INVOKABLE bool startReceiving(int port, const QString &bindAddress = QString(),
+                                  int batchSize = 32, bool kernelTimestamps = false);
   Q_INVOKABLE void stopReceiving();
   Q_INVOKABLE void resetPacketCount();
   Q_INVOKABLE void startBlackReference();
@@ -42,18 +198,41 @@ class UdpCommunicator : public QObject {
   
   // 设置预测器管理器
   void setPredictorManager(SpectrumPredictorManager *manager);
+
+  // 多光谱仪（见 DeviceRegistry），均在开始接收之前设置：
+  // - streamId：本设备的光谱来源编号，推理执行器的结果只转发 streamId 相同的（单光谱仪为 0）
+  // - workerPool：处理器由共享的工作线程池驱动，不启动自己的处理线程（空表示自己的线程）
+  // - receiverHub：接收套接字注册到共享的 epoll 接收线程，不启动自己的接收线程（空表示自己的线程）
+  void setStreamId(int streamId) { streamId_ = streamId; }
+  int streamId() const { return streamId_; }
+  void setWorkerPool(SpectrumWorkerPool *pool) { workerPool_ = pool; }
+  void setReceiverHub(UdpReceiverHub *hub) { receiverHub_ = hub; }
+
+  // 线程放置配置文件（默认 <程序目录>/thread_placement.json），每次启动接收或回放时重新读取
+  void setThreadPlacementPath(const QString &path) { threadPlacementPath_ = path; }
+  QString threadPlacementPath() const { return threadPlacementPath_; }
   
   // 设置使用的预测器索引（-1 表示不使用预测）
   Q_INVOKABLE void setPredictorIndex(int index);
+  
+  // 多预测器模式：每条光谱同时交给多个预测器并行预测（空列表表示不使用预测）
+  // 结果除逐个发出 predictionReady 外，还会发出一次 multiPredictionReady
+  Q_INVOKABLE void setPredictorIndices(const QVariantList &indices);
 
  signals:
-  void packetReceived(const QVariantList &data);
+  // 统计定时器发现新数据包时发送，只携带最新一帧的点数（帧数据不经过主线程）
+  void packetReceived(int dataLength);
   void statusChanged(const QString &message);
   void receivingChanged(bool receiving);
   void packetCountChanged(int count);
   void packetsPerSecondChanged(int rate);
-  // 光谱曲线数据准备好（在后台线程处理完成后发送）
-  void spectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
+  // 处理线程跟不上时队列溢出丢弃的帧数
+  void droppedFramesChanged(int count);
+  void frameCounterTrailerChanged(bool enabled);
+  void linkStatsChanged();
+  // 光谱曲线数据准备好（在后台线程处理完成后发送）；snr 为自适应模式实际达到的中位数信噪比，其它模式为 0
+  void spectrumReady(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount,
+                     double snr);
   // 黑参考数据累积状态改变
   void blackReferenceAccumulatingChanged(bool accumulating);
   // 黑参考累积进度更新
@@ -66,39 +245,142 @@ class UdpCommunicator : public QObject {
   void whiteReferenceProgressChanged(int progress);
   // 白参考数据处理完成
   void whiteReferenceReady(const QVariantList &averagedSpectrum, double minVal, double maxVal);
+  void spectrumThresholdChanged(int packets);
+  void referenceThresholdChanged(int packets);
+  void averagingModeChanged(int mode);
+  void outputIntervalChanged(int packets);
+  void emaTimeConstantChanged(double packets);
+  void adaptiveAveragingChanged();
+  void calibrationChanged();
+  void recordingChanged(bool recording);
+  void recordingStatsChanged();
+  void replayingChanged(bool replaying);
+  void throughputChanged();
+  // 回放完成：回放帧数、端到端帧率与预测速率（从开始回放到处理队列排空）
+  void replayFinished(int frames, double framesPerSecond, double predictionsPerSecond);
   
   // 预测完成信号（预测器索引，预测值）
   void predictionReady(int predictorIndex, double predictionValue);
+  
+  // 多预测器预测完成（各预测器索引、预测值（失败为空）、成功结果的平均值）
+  void multiPredictionReady(const QVariantList &predictorIndices, const QVariantList &predictionValues,
+                            double ensembleMean);
 
  private slots:
-  void onUdpPacketReceived(const QVariantList &data);
+  void onPollTimer();
+  void onRecorderError(const QString &error);
+  void onReplayFinished(quint64 frames, qint64 elapsedNs);
   void onUdpStatusChanged(const QString &message);
   void onUdpErrorOccurred(const QString &error);
   void onSecondTimer();
-  void onSpectrumProcessed(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
+  void onSpectrumProcessed(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount,
+                           double snr);
   void onBlackReferenceProgressChanged(int count, int total);
-  void onBlackReferenceProcessed(const QVariantList &averagedSpectrum, double minVal, double maxVal);
+  void onBlackReferenceProcessed(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
   void onWhiteReferenceProgressChanged(int count, int total);
-  void onWhiteReferenceProcessed(const QVariantList &averagedSpectrum, double minVal, double maxVal);
-  void onPredictionReady(int predictorIndex, double predictionValue);
+  void onWhiteReferenceProcessed(const QVariantList &averagedSpectrum, double minVal, double maxVal, int packetCount);
+  void onPredictionReady(int predictorIndex, double predictionValue, qint64 windowTimestampNs, qint64 completedNs,
+                         int streamId);
+  void onMultiPredictionReady(const QVariantList &predictorIndices, const QVariantList &predictionValues,
+                              double ensembleMean, qint64 windowTimestampNs, qint64 completedNs, int streamId);
 
  private:
-  UdpReceiverThread *udpReceiver_;
+  // 读取录制线程的计数器并更新属性
+  void updateRecordingStats();
+
+  // 读取接收线程的链路统计并更新属性
+  void updateLinkStats();
+
+  // 按当前黑白参考与暗电流参数重建标定并交给处理线程（参考不全时清除标定）
+  void rebuildCalibration();
+
+  // 把当前黑白参考写入标定缓存
+  void saveCalibrationCache();
+
+  // 参考是否超过 calibrationMaxAgeHours
+  bool isReferenceStale(const CalibrationReference &reference) const;
+
+  // 把自适应平均参数交给处理线程
+  void applyAdaptiveAveraging();
+
+  // 从处理线程上摘下参考累积器并释放
+  void releaseReferenceProcessor(std::shared_ptr<ReferenceProcessor> &processor);
+
+  // 读取并安装线程放置配置（须在创建采集线程之前调用）
+  void applyThreadPlacement();
+
+  // 接收与回放共用的启动流程：创建处理线程 → 连接帧来源 → 启动来源 → 重置统计
+  void ensureSpectrumProcessor();
+  void attachFrameSource(SpectrumFrameSource *source);
+  void onFrameSourceStarted();
+  void abortFrameSource();
+
+  QString threadPlacementPath_;
+  SpectrumFrameSource *frameSource_;  // 当前帧来源（UDP 接收线程或回放线程）
   SpectrumProcessor *spectrumProcessor_;  // 后台处理线程
-  ReferenceProcessor *blackReferenceProcessor_;  // 黑参考处理线程
-  ReferenceProcessor *whiteReferenceProcessor_;  // 白参考处理线程
+  // 黑白参考累积器：累积期间作为消费者挂在处理线程上，完成或停止后释放
+  std::shared_ptr<ReferenceProcessor> blackReferenceProcessor_;
+  std::shared_ptr<ReferenceProcessor> whiteReferenceProcessor_;
+  DisplayFeed *displayFeed_;  // 曲线显示数据源
   bool receiving_;
+  bool replaying_;  // 当前帧来源是否为录制回放
   int packetCount_;
   int packetsPerSecond_;
   int packetsThisSecond_;  // 当前秒内接收的数据包数
+  int droppedFrames_;  // 各处理队列累计溢出的帧数
+  quint64 lastReceivedPackets_;  // 上次轮询时接收线程的累计包数
+  bool frameCounterTrailer_;  // 数据包是否附带帧计数
+  quint64 lastLinkDatagrams_;  // 上次更新链路统计时的数据包数
+  int lostFrames_;
+  int reorderedPackets_;
+  int runtPackets_;
+  int kernelDrops_;
+  double framePeriodUs_;
+  double jitterUs_;
+  QVariantList arrivalHistogram_;
+  int reportedLinkLosses_;  // 已提示过的丢帧（含内核丢包）数
+  quint64 lastProcessedFrames_;  // 上一秒处理线程的累计帧数
+  int processedFramesPerSecond_;
+  int predictionsThisSecond_;  // 当前秒内完成的预测数（多预测器模式按每个预测器计）
+  int predictionsPerSecond_;
+  quint64 totalPredictions_;  // 本次接收/回放以来完成的预测数
   QTimer *secondTimer_;   // 每秒统计一次的定时器
+  QTimer *pollTimer_;     // 定期读取接收线程计数器的定时器
   bool blackReferenceAccumulating_;  // 是否正在累积黑参考数据
   int blackReferenceProgress_;  // 黑参考累积进度
   bool whiteReferenceAccumulating_;  // 是否正在累积白参考数据
   int whiteReferenceProgress_;  // 白参考累积进度
-  QVariantList blackReferenceData_;  // 存储黑参考数据
-  QVariantList whiteReferenceData_;  // 存储白参考数据
+  int spectrumThreshold_;  // 每条光谱累积的数据包数
+  int referenceThreshold_;  // 黑白参考累积的数据包数
+  int averagingMode_;  // 光谱平均方式
+  int outputInterval_;  // 滚动模式的输出间隔
+  double emaTimeConstant_;  // 指数移动平均的时间常数
+  double adaptiveTargetSnr_;  // 自适应平均的目标信噪比
+  double adaptiveTargetStdError_;  // 自适应平均的目标标准误
+  int adaptiveMinPackets_;
+  int adaptiveMaxPackets_;
+  double referenceTargetStdError_;  // 黑白参考的目标标准误（计数）
+  RawFrameRecorder *recorder_;  // 原始帧录制线程（未录制时为空）
+  int recordedFrames_;  // 已录制的帧数
+  int recordingDroppedFrames_;  // 录制队列溢出或写盘失败丢弃的帧数
+  int reportedRecordingDrops_;  // 已提示过的录制丢帧数
+  QString recordingFile_;  // 当前写入的分段文件
+  CalibrationReference blackCalibration_;  // 黑参考（平均值、噪声、采集时间与积分时间）
+  CalibrationReference whiteCalibration_;  // 白参考
+  bool blackFromCache_;  // 当前黑参考来自标定缓存
+  bool whiteFromCache_;
+  QString calibrationCachePath_;
+  QString deviceId_;
+  double calibrationMaxAgeHours_;
+  bool useStaleCalibration_;
+  double integrationTimeUs_;
+  double darkBias_;
+  bool interpolateBadPixels_;
+  std::shared_ptr<const SpectralCalibration> calibration_;  // 当前标定（空表示不校正）
   SpectrumPredictorManager *predictorManager_;  // 预测器管理器
-  int currentPredictorIndex_;  // 当前使用的预测器索引（-1表示未启用）
+  QVector<int> predictorIndices_;  // 当前使用的预测器索引（空表示未启用）
+  int streamId_;  // 光谱来源编号（多光谱仪时区分设备）
+  SpectrumWorkerPool *workerPool_;  // 共享处理线程池（可为空）
+  UdpReceiverHub *receiverHub_;  // 共享接收线程（可为空）
 };
 
@@ -1,29 +1,210 @@
 #include "udp_receiver.h"
+#include "thread_placement.h"
 
 #include <QDebug>
-#include <QVariant>
 #include <QtEndian>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
 #include <cerrno>
+#include <ctime>
 
-const int NUM_COUNT = 1024;  // 每个数据包最多包含1024个数字
+const int NUM_COUNT = SpectrumFrame::kPixelCount;  // 每个数据包最多包含1024个数字
 const int BUFFER_SIZE = 2100;  // 接收缓冲区大小（1024*2+4+余量）
+const int FRAME_BYTES = NUM_COUNT * static_cast<int>(sizeof(uint16_t));  // 帧缓冲区字节数
+const int OVERFLOW_BYTES = BUFFER_SIZE - FRAME_BYTES;  // 超出帧长度部分的暂存区大小
+
+UdpBatchReader::UdpBatchReader(int batchSize, bool kernelTimestamps, bool frameCounterTrailer,
+                               LinkStats *linkStats)
+    : batchSize_(batchSize), kernelTimestamps_(kernelTimestamps), frameCounterTrailer_(frameCounterTrailer),
+      perPacketTime_(kernelTimestamps || batchSize == 1),
+      controlSize_(CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t))),
+      linkStats_(linkStats), nextSequence_(0), ringPos_(0),
+      msgs_(static_cast<size_t>(batchSize)), iovecs_(static_cast<size_t>(batchSize) * 2),
+      overflowBuffers_(static_cast<size_t>(batchSize) * OVERFLOW_BYTES),
+      controlBuffers_(static_cast<size_t>(batchSize) * controlSize_) {
+  // 预分配帧环（环大小为批大小的数倍，下游短暂持有帧时也能原地复用）
+  frameRing_.resize(static_cast<size_t>(qMax(batchSize * 4, 64)));
+  for (auto &slot : frameRing_) {
+    slot = std::make_shared<SpectrumFrame>();
+  }
+}
+
+UdpBatchReader::~UdpBatchReader() = default;
+
+int UdpBatchReader::openSocket(int port, const QString &bindAddress, bool *kernelTimestamps, QString *error,
+                               QString *warning) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    *error = QStringLiteral("无法创建socket: ") + QString::fromLocal8Bit(strerror(errno));
+    return -1;
+  }
+  auto fail = [fd, error](const QString &message) {
+    *error = message;
+    close(fd);
+    return -1;
+  };
+
+  // 设置socket选项：重用地址
+  int reuse = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+    return fail(QStringLiteral("设置SO_REUSEADDR失败: ") + QString::fromLocal8Bit(strerror(errno)));
+  }
+
+  // 增加接收缓冲区
+  int recvBufSize = 4 * 1024 * 1024;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &recvBufSize, sizeof(recvBufSize));
+
+  // 可选：启用内核接收时间戳（纳秒精度）
+  if (*kernelTimestamps) {
+    int enable = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+      *warning = QStringLiteral("SO_TIMESTAMPNS 不可用，使用用户态时间戳: ") +
+                 QString::fromLocal8Bit(strerror(errno));
+      *kernelTimestamps = false;
+    }
+  }
+
+  // 请求内核在每个数据包上附带接收队列溢出的累计丢包数（不支持时只是没有该统计）
+  int enableOverflow = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &enableOverflow, sizeof(enableOverflow)) < 0) {
+    qWarning() << "[UdpBatchReader] SO_RXQ_OVFL unavailable:" << strerror(errno);
+  }
+
+  // 绑定地址和端口
+  struct sockaddr_in serverAddr;
+  memset(&serverAddr, 0, sizeof(serverAddr));
+  serverAddr.sin_family = AF_INET;
+  serverAddr.sin_port = htons(port);
+
+  if (bindAddress.isEmpty()) {
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+  } else {
+    QByteArray addrBytes = bindAddress.toLocal8Bit();
+    if (inet_aton(addrBytes.constData(), &serverAddr.sin_addr) == 0) {
+      return fail(QStringLiteral("无效的绑定地址: ") + bindAddress);
+    }
+  }
+
+  if (bind(fd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+    return fail(QStringLiteral("无法绑定UDP端口 ") + QString::number(port) +
+                QStringLiteral(": ") + QString::fromLocal8Bit(strerror(errno)));
+  }
+  return fd;
+}
+
+std::shared_ptr<SpectrumFrame> &UdpBatchReader::acquireSlot(size_t index) {
+  std::shared_ptr<SpectrumFrame> &slot = frameRing_[index % frameRing_.size()];
+  if (slot && slot.use_count() == 1) {
+    // 下游已全部释放该帧，与其最后一次读取建立先后关系后即可原地复用
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } else {
+    // 该帧仍被下游持有（例如正在累积），为槽位分配新帧，旧帧由下游自行释放
+    slot = std::make_shared<SpectrumFrame>();
+  }
+  return slot;
+}
+
+int UdpBatchReader::receive(int fd, std::vector<SpectrumFramePtr> *batch) {
+  // 为本批次准备接收槽位：数据包前 2048 字节直接写入帧缓冲区，多余部分写入暂存区
+  for (int i = 0; i < batchSize_; ++i) {
+    SpectrumFrame *frame = acquireSlot(ringPos_ + static_cast<size_t>(i)).get();
+    struct iovec *iov = &iovecs_[static_cast<size_t>(i) * 2];
+    iov[0].iov_base = frame->data;
+    iov[0].iov_len = FRAME_BYTES;
+    iov[1].iov_base = &overflowBuffers_[static_cast<size_t>(i) * OVERFLOW_BYTES];
+    iov[1].iov_len = OVERFLOW_BYTES;
+
+    struct msghdr &hdr = msgs_[static_cast<size_t>(i)].msg_hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = iov;
+    hdr.msg_iovlen = 2;
+    hdr.msg_control = &controlBuffers_[static_cast<size_t>(i) * controlSize_];
+    hdr.msg_controllen = controlSize_;
+    msgs_[static_cast<size_t>(i)].msg_len = 0;
+  }
+
+  // 一次系统调用接收本次唤醒已到达的全部数据包（最多 batchSize 个）
+  const int received = recvmmsg(fd, msgs_.data(), static_cast<unsigned int>(batchSize_), MSG_DONTWAIT, nullptr);
+  if (received <= 0) {
+    return received;
+  }
+
+  // 内核时间戳为 CLOCK_REALTIME，换算到帧使用的单调时钟
+  const qint64 monoNow = SpectrumFrame::nowNs();
+  qint64 realToMono = 0;
+  if (kernelTimestamps_) {
+    struct timespec realNow;
+    clock_gettime(CLOCK_REALTIME, &realNow);
+    realToMono = monoNow - (static_cast<qint64>(realNow.tv_sec) * 1000000000LL + realNow.tv_nsec);
+  }
+
+  for (int i = 0; i < received; ++i) {
+    const unsigned int receivedBytes = msgs_[static_cast<size_t>(i)].msg_len;
+    std::shared_ptr<SpectrumFrame> &slot = frameRing_[(ringPos_ + static_cast<size_t>(i)) % frameRing_.size()];
+    SpectrumFrame *frame = slot.get();
+
+    // 接收时间戳与内核丢包计数
+    qint64 arrivalNs = monoNow;
+    struct msghdr &hdr = msgs_[static_cast<size_t>(i)].msg_hdr;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET) {
+        continue;
+      }
+      if (cmsg->cmsg_type == SCM_TIMESTAMPNS && kernelTimestamps_) {
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        arrivalNs = static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec + realToMono;
+      } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+        uint32_t drops = 0;
+        memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+        linkStats_->recordKernelDrops(drops);
+      }
+    }
+    linkStats_->recordDatagram(arrivalNs, perPacketTime_, receivedBytes, static_cast<unsigned int>(FRAME_BYTES));
+    if (frameCounterTrailer_ && receivedBytes == static_cast<unsigned int>(FRAME_BYTES) + sizeof(uint16_t)) {
+      const unsigned char *trailer = &overflowBuffers_[static_cast<size_t>(i) * OVERFLOW_BYTES];
+      linkStats_->recordFrameCounter(static_cast<uint16_t>((trailer[0] << 8) | trailer[1]));
+    }
+
+    if (receivedBytes < 2) {  // 至少需要2字节（1个uint16_t）
+      continue;
+    }
+
+    // 计算实际接收到的数据数量（最多1024个数字）
+    size_t totalUint16Count = receivedBytes / sizeof(uint16_t);
+    size_t actualDataCount = (totalUint16Count < static_cast<size_t>(NUM_COUNT)) ? totalUint16Count : static_cast<size_t>(NUM_COUNT);
+
+    // 原地转换字节序（网络字节序转主机字节序，只解码这一次）
+    for (size_t k = 0; k < actualDataCount; ++k) {
+      frame->data[k] = qFromBigEndian<quint16>(frame->data[k]);
+    }
+    frame->count = static_cast<int>(actualDataCount);
+    frame->sequence = nextSequence_++;
+    frame->timestampNs = arrivalNs;
+
+    batch->push_back(slot);
+  }
+  ringPos_ += static_cast<size_t>(received);
+  return received;
+}
 
 UdpReceiverThread::UdpReceiverThread(QObject *parent)
-    : QThread(parent), running_(false), port_(1234), socket_fd_(-1), stop_pipe_{-1, -1} {
+    : SpectrumFrameSource(parent), running_(false), port_(1234), socket_fd_(-1), stop_pipe_{-1, -1},
+      batchSize_(kDefaultBatchSize), kernelTimestamps_(false), frameCounterTrailer_(false) {
 }
 
 UdpReceiverThread::~UdpReceiverThread() {
   stopReceiving();
 }
 
-bool UdpReceiverThread::startReceiving(int port, const QString &bindAddress) {
+bool UdpReceiverThread::startReceiving(int port, const QString &bindAddress,
+                                       int batchSize, bool kernelTimestamps) {
   if (running_) {
     emit statusChanged(QStringLiteral("UDP接收已在运行"));
     return false;
@@ -31,6 +212,10 @@ bool UdpReceiverThread::startReceiving(int port, const QString &bindAddress) {
 
   port_ = port;
   bindAddress_ = bindAddress;
+  resetCounters();
+  linkStats_.reset();
+  batchSize_ = qBound(1, batchSize, kMaxBatchSize);
+  kernelTimestamps_ = kernelTimestamps;
   running_ = true;
   start();
   return true;
@@ -68,6 +253,7 @@ void UdpReceiverThread::stopReceiving() {
 }
 
 void UdpReceiverThread::run() {
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Receiver);
   // 创建管道，用于立即唤醒select()
   if (pipe(stop_pipe_) < 0) {
     QString error = QStringLiteral("无法创建管道: ") + QString::fromLocal8Bit(strerror(errno));
@@ -79,62 +265,16 @@ void UdpReceiverThread::run() {
   int flags = fcntl(stop_pipe_[0], F_GETFL, 0);
   fcntl(stop_pipe_[0], F_SETFL, flags | O_NONBLOCK);
   
-  // 创建UDP socket
-  socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
-  if (socket_fd_ < 0) {
-    QString error = QStringLiteral("无法创建socket: ") + QString::fromLocal8Bit(strerror(errno));
-    emit errorOccurred(error);
-    close(stop_pipe_[0]);
-    close(stop_pipe_[1]);
-    stop_pipe_[0] = stop_pipe_[1] = -1;
-    return;
+  // 创建并绑定UDP socket
+  bool kernelTimestamps = kernelTimestamps_;
+  QString error;
+  QString warning;
+  socket_fd_ = UdpBatchReader::openSocket(port_, bindAddress_, &kernelTimestamps, &error, &warning);
+  if (!warning.isEmpty()) {
+    emit statusChanged(warning);
   }
-
-  // 设置socket选项：重用地址
-  int reuse = 1;
-  if (setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
-    QString error = QStringLiteral("设置SO_REUSEADDR失败: ") + QString::fromLocal8Bit(strerror(errno));
-    emit errorOccurred(error);
-    close(socket_fd_);
-    socket_fd_ = -1;
-    close(stop_pipe_[0]);
-    close(stop_pipe_[1]);
-    stop_pipe_[0] = stop_pipe_[1] = -1;
-    return;
-  }
-
-  // 增加接收缓冲区
-  int recvBufSize = 4 * 1024 * 1024;
-  setsockopt(socket_fd_, SOL_SOCKET, SO_RCVBUF, &recvBufSize, sizeof(recvBufSize));
-
-  // 绑定地址和端口
-  struct sockaddr_in serverAddr;
-  memset(&serverAddr, 0, sizeof(serverAddr));
-  serverAddr.sin_family = AF_INET;
-  serverAddr.sin_port = htons(port_);
-  
-  if (bindAddress_.isEmpty()) {
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-  } else {
-    QByteArray addrBytes = bindAddress_.toLocal8Bit();
-    if (inet_aton(addrBytes.constData(), &serverAddr.sin_addr) == 0) {
-      QString error = QStringLiteral("无效的绑定地址: ") + bindAddress_;
-      emit errorOccurred(error);
-      close(socket_fd_);
-      socket_fd_ = -1;
-      close(stop_pipe_[0]);
-      close(stop_pipe_[1]);
-      stop_pipe_[0] = stop_pipe_[1] = -1;
-      return;
-    }
-  }
-
-  if (bind(socket_fd_, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-    QString error = QStringLiteral("无法绑定UDP端口 ") + QString::number(port_) + 
-                     QStringLiteral(": ") + QString::fromLocal8Bit(strerror(errno));
+  if (socket_fd_ < 0) {
     emit errorOccurred(error);
-    close(socket_fd_);
-    socket_fd_ = -1;
     close(stop_pipe_[0]);
     close(stop_pipe_[1]);
     stop_pipe_[0] = stop_pipe_[1] = -1;
@@ -143,9 +283,9 @@ void UdpReceiverThread::run() {
 
   emit statusChanged(QStringLiteral("✓ UDP接收已启动，端口: ") + QString::number(port_));
 
-  unsigned char buffer[BUFFER_SIZE];
-  struct sockaddr_in clientAddr;
-  socklen_t clientLen = sizeof(clientAddr);
+  UdpBatchReader reader(batchSize_, kernelTimestamps, frameCounterTrailer_, &linkStats_);
+  std::vector<SpectrumFramePtr> batch;
+  batch.reserve(static_cast<size_t>(batchSize_));
 
   while (running_) {
     fd_set readFds;
@@ -189,38 +329,27 @@ void UdpReceiverThread::run() {
       continue;  // 没有UDP数据，继续循环
     }
 
-    // 接收数据
-    ssize_t receivedBytes = recvfrom(socket_fd_, 
-                                      buffer, 
-                                      BUFFER_SIZE, 
-                                      0,
-                                      (struct sockaddr*)&clientAddr, 
-                                      &clientLen);
-
-    if (receivedBytes < 2) {  // 至少需要2字节（1个uint16_t）
+    const int received = reader.receive(socket_fd_, &batch);
+    if (received <= 0) {
+      if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        if (errno == EBADF) {
+          break;
+        }
+        emit errorOccurred(QStringLiteral("recvmmsg错误: ") + QString::fromLocal8Bit(strerror(errno)));
+        break;
+      }
       continue;
     }
 
-    // 解析数据包：直接处理为原始光谱数据（1024个uint16_t）
-    const uint16_t *dataPtr = reinterpret_cast<const uint16_t *>(buffer);
-    size_t totalUint16Count = receivedBytes / sizeof(uint16_t);
-    
-    // 计算实际接收到的数据数量（最多1024个数字）
-    size_t actualDataCount = (totalUint16Count < static_cast<size_t>(NUM_COUNT)) ? totalUint16Count : static_cast<size_t>(NUM_COUNT);
-
-    // 转换字节序并转换为QVariantList（在接收线程中完成，避免阻塞主线程）
-    QVariantList variantData;
-    variantData.reserve(static_cast<int>(actualDataCount));
-    
-    for (size_t i = 0; i < actualDataCount; ++i) {
-      uint16_t value = qFromBigEndian<quint16>(dataPtr[i]);  // 网络字节序转主机字节序
-      variantData.append(QVariant::fromValue(value));
+    // 每次唤醒只分发一次：直接写入各处理线程的无锁队列（共享指针，不拷贝帧数据）
+    if (!batch.empty()) {
+      dispatchFrames(batch.data(), static_cast<int>(batch.size()));
+      batch.clear();  // 释放本地引用，便于帧环原地复用
     }
-
-    // 发送信号到主线程（数据已转换完成）
-    emit packetReceived(variantData);
   }
 
+  sinks_.releaseSnapshot();
+
   if (socket_fd_ >= 0) {
     close(socket_fd_);
     socket_fd_ = -1;
@@ -238,4 +367,3 @@ void UdpReceiverThread::run() {
 
   emit statusChanged(QStringLiteral("UDP接收已停止"));
 }
-
@@ -1,25 +1,79 @@
 #pragma once
 
 #include <QObject>
-#include <QThread>
-#include <QVariant>
 #include <atomic>
+#include <memory>
+#include <vector>
+
+#include "link_stats.h"
+#include "spectrum_frame_source.h"
+
+struct mmsghdr;
+struct iovec;
+
+// 一个 UDP 套接字的批量接收与解码：recvmmsg 直接写入预分配的帧环，
+// 解析内核时间戳、内核丢包计数与帧计数尾，并按网络字节序原地解码
+// UdpReceiverThread（每个套接字一个线程）与 UdpReceiverHub（多个套接字共用一个 epoll 线程）共用
+class UdpBatchReader {
+ public:
+  UdpBatchReader(int batchSize, bool kernelTimestamps, bool frameCounterTrailer, LinkStats *linkStats);
+  ~UdpBatchReader();
+
+  UdpBatchReader(const UdpBatchReader &) = delete;
+  UdpBatchReader &operator=(const UdpBatchReader &) = delete;
+
+  // 创建并绑定接收套接字（失败返回 -1 并写入 error）
+  // kernelTimestamps 为 true 但 SO_TIMESTAMPNS 不可用时改为 false，并把原因写入 warning
+  static int openSocket(int port, const QString &bindAddress, bool *kernelTimestamps, QString *error,
+                        QString *warning);
+
+  // 从非阻塞套接字接收本次已到达的数据包（最多 batchSize 个），解码后的帧追加到 batch
+  // 返回 recvmmsg 的返回值：-1 且 errno 为 EAGAIN / EINTR 表示暂时没有数据
+  int receive(int fd, std::vector<SpectrumFramePtr> *batch);
+
+ private:
+  // 槽位中的帧仍被下游持有时，会为该槽位重新分配一帧，不会覆盖下游正在读取的数据
+  std::shared_ptr<SpectrumFrame> &acquireSlot(size_t index);
+
+  const int batchSize_;
+  const bool kernelTimestamps_;
+  const bool frameCounterTrailer_;
+  const bool perPacketTime_;  // 是否有逐包时间戳（内核时间戳，或逐包接收时的用户态时间戳）
+  const size_t controlSize_;
+  LinkStats *linkStats_;
+  quint64 nextSequence_;  // 下一帧的接收序号
+  std::vector<std::shared_ptr<SpectrumFrame>> frameRing_;
+  size_t ringPos_;
+  std::vector<struct mmsghdr> msgs_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<unsigned char> overflowBuffers_;
+  std::vector<unsigned char> controlBuffers_;
+};
 
 // UDP接收线程类，在独立线程中接收UDP数据包
-class UdpReceiverThread : public QThread {
+class UdpReceiverThread : public SpectrumFrameSource {
   Q_OBJECT
 
  public:
+  // 默认每次唤醒最多接收的数据包数（recvmmsg 批大小）
+  static constexpr int kDefaultBatchSize = 32;
+  static constexpr int kMaxBatchSize = 256;
+
   explicit UdpReceiverThread(QObject *parent = nullptr);
   ~UdpReceiverThread();
 
-  bool startReceiving(int port, const QString &bindAddress = QString());
+  // batchSize: 每次唤醒通过 recvmmsg 最多接收的数据包数（1 表示逐包接收）
+  // kernelTimestamps: 是否使用 SO_TIMESTAMPNS 内核时间戳作为帧接收时间
+  bool startReceiving(int port, const QString &bindAddress = QString(),
+                      int batchSize = kDefaultBatchSize, bool kernelTimestamps = false);
   void stopReceiving();
+  void stopSource() override { stopReceiving(); }
+
+  // 数据包末尾是否附带 16 位大端帧计数（1024 点数据之后的 2 字节，共 2050 字节）
+  // 启用后按帧计数检测丢帧与乱序，否则按到达间隔推断（在 startReceiving 之前设置）
+  void setFrameCounterTrailer(bool enabled) { frameCounterTrailer_ = enabled; }
 
- signals:
-  void packetReceived(const QVariantList &data);
-  void statusChanged(const QString &message);
-  void errorOccurred(const QString &error);
+  const LinkStats *linkStats() const override { return &linkStats_; }
 
  protected:
   void run() override;
@@ -30,5 +84,9 @@ class UdpReceiverThread : public QThread {
   QString bindAddress_;
   int socket_fd_;
   int stop_pipe_[2];  // 管道，用于立即唤醒select()
+  int batchSize_;  // 每次唤醒最多接收的数据包数
+  bool kernelTimestamps_;  // 是否启用 SO_TIMESTAMPNS
+  bool frameCounterTrailer_;  // 数据包是否附带帧计数
+  LinkStats linkStats_;
 };
 
@@ -0,0 +1,197 @@
+#include "udp_receiver_hub.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "thread_placement.h"
+#include "udp_receiver.h"
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+
+}  // namespace
+
+UdpReceiverHub::UdpReceiverHub(QObject *parent)
+    : QThread(parent), epollFd_(epoll_create1(EPOLL_CLOEXEC)), wakeFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      stopRequested_(false), endpointCount_(0) {
+  if (epollFd_ >= 0 && wakeFd_ >= 0) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;  // 空指针表示唤醒 eventfd
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+  }
+}
+
+UdpReceiverHub::~UdpReceiverHub() {
+  stopRequested_ = true;
+  wake();
+  wait();
+  if (epollFd_ >= 0) {
+    close(epollFd_);
+  }
+  if (wakeFd_ >= 0) {
+    close(wakeFd_);
+  }
+}
+
+void UdpReceiverHub::wake() {
+  if (wakeFd_ >= 0) {
+    uint64_t one = 1;
+    ssize_t ret = write(wakeFd_, &one, sizeof(one));
+    (void)ret;
+  }
+}
+
+bool UdpReceiverHub::addEndpoint(UdpHubEndpoint *endpoint, QString *error) {
+  if (epollFd_ < 0 || wakeFd_ < 0) {
+    *error = QStringLiteral("无法创建 epoll: ") + QString::fromLocal8Bit(strerror(errno));
+    return false;
+  }
+  QMutexLocker locker(&mutex_);
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.ptr = endpoint;
+  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, endpoint->socketFd_, &event) != 0) {
+    *error = QStringLiteral("epoll 注册失败: ") + QString::fromLocal8Bit(strerror(errno));
+    return false;
+  }
+  endpoints_.push_back(endpoint);
+  endpointCount_ = static_cast<int>(endpoints_.size());
+  locker.unlock();
+  if (!isRunning()) {
+    stopRequested_ = false;
+    start();
+  }
+  return true;
+}
+
+void UdpReceiverHub::removeEndpoint(UdpHubEndpoint *endpoint) {
+  // 接收线程只在持有 mutex_ 时访问端点，拿到锁即说明它已不在使用中
+  QMutexLocker locker(&mutex_);
+  auto it = std::find(endpoints_.begin(), endpoints_.end(), endpoint);
+  if (it == endpoints_.end()) {
+    return;
+  }
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, endpoint->socketFd_, nullptr);
+  endpoints_.erase(it);
+  endpointCount_ = static_cast<int>(endpoints_.size());
+}
+
+void UdpReceiverHub::run() {
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Receiver);
+  struct epoll_event events[kMaxEvents];
+  while (!stopRequested_) {
+    const int ready = epoll_wait(epollFd_, events, kMaxEvents, -1);
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < ready; ++i) {
+      auto *endpoint = static_cast<UdpHubEndpoint *>(events[i].data.ptr);
+      if (!endpoint) {
+        uint64_t counter = 0;
+        ssize_t ret = read(wakeFd_, &counter, sizeof(counter));
+        (void)ret;
+        continue;
+      }
+      // 等待期间可能已被注销
+      auto it = std::find(endpoints_.begin(), endpoints_.end(), endpoint);
+      if (it == endpoints_.end()) {
+        continue;
+      }
+      if (!endpoint->receiveReady()) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, endpoint->socketFd_, nullptr);
+        endpoints_.erase(it);
+        endpointCount_ = static_cast<int>(endpoints_.size());
+        // 端点的状态只在它所在的线程修改：回到该线程走正常的停止流程（关闭套接字、清除注册状态），
+        // 之后可以重新 startReceiving；端点先被销毁时此调用自动取消
+        QMetaObject::invokeMethod(endpoint, [endpoint]() { endpoint->stopReceiving(); }, Qt::QueuedConnection);
+      }
+    }
+  }
+  QMutexLocker locker(&mutex_);
+  for (UdpHubEndpoint *endpoint : endpoints_) {
+    endpoint->sinks_.releaseSnapshot();
+  }
+}
+
+UdpHubEndpoint::UdpHubEndpoint(UdpReceiverHub *hub, QObject *parent)
+    : SpectrumFrameSource(parent), hub_(hub), socketFd_(-1), port_(0), frameCounterTrailer_(false),
+      registered_(false) {
+}
+
+UdpHubEndpoint::~UdpHubEndpoint() {
+  stopReceiving();
+}
+
+bool UdpHubEndpoint::startReceiving(int port, const QString &bindAddress, int batchSize, bool kernelTimestamps) {
+  if (registered_) {
+    emit statusChanged(QStringLiteral("UDP接收已在运行"));
+    return false;
+  }
+  resetCounters();
+  linkStats_.reset();
+  batchSize = qBound(1, batchSize, UdpReceiverThread::kMaxBatchSize);
+
+  QString error;
+  QString warning;
+  socketFd_ = UdpBatchReader::openSocket(port, bindAddress, &kernelTimestamps, &error, &warning);
+  if (!warning.isEmpty()) {
+    emit statusChanged(warning);
+  }
+  if (socketFd_ < 0) {
+    emit errorOccurred(error);
+    return false;
+  }
+  reader_ = std::make_unique<UdpBatchReader>(batchSize, kernelTimestamps, frameCounterTrailer_, &linkStats_);
+  batch_.reserve(static_cast<size_t>(batchSize));
+  port_ = port;
+  if (!hub_->addEndpoint(this, &error)) {
+    close(socketFd_);
+    socketFd_ = -1;
+    reader_.reset();
+    emit errorOccurred(error);
+    return false;
+  }
+  registered_ = true;
+  emit statusChanged(QStringLiteral("✓ UDP接收已启动，端口: ") + QString::number(port_));
+  return true;
+}
+
+void UdpHubEndpoint::stopReceiving() {
+  if (!registered_) {
+    return;
+  }
+  hub_->removeEndpoint(this);
+  registered_ = false;
+  sinks_.releaseSnapshot();
+  batch_.clear();
+  reader_.reset();
+  close(socketFd_);
+  socketFd_ = -1;
+  emit statusChanged(QStringLiteral("UDP接收已停止"));
+}
+
+bool UdpHubEndpoint::receiveReady() {
+  const int received = reader_->receive(socketFd_, &batch_);
+  if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    emit errorOccurred(QStringLiteral("recvmmsg错误: ") + QString::fromLocal8Bit(strerror(errno)));
+    return false;
+  }
+  if (!batch_.empty()) {
+    dispatchFrames(batch_.data(), static_cast<int>(batch_.size()));
+    batch_.clear();  // 释放本地引用，便于帧环原地复用
+  }
+  return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "link_stats.h"
+#include "spectrum_frame_source.h"
+
+class UdpBatchReader;
+class UdpHubEndpoint;
+
+// 多台光谱仪共用的 UDP 接收线程：各设备的接收套接字注册到同一个 epoll，
+// 一个线程轮流接收，而不是每台设备一个接收线程（见 DeviceRegistry）
+// - 每个套接字每次可读时最多接收一批（batchSize）数据包，一台设备流量大时不会饿死其它设备
+// - 帧直接分发给该设备自己的处理队列，与 UdpReceiverThread 相同
+class UdpReceiverHub : public QThread {
+  Q_OBJECT
+
+ public:
+  explicit UdpReceiverHub(QObject *parent = nullptr);
+  ~UdpReceiverHub() override;
+
+  int endpointCount() const { return endpointCount_.load(std::memory_order_relaxed); }
+
+ protected:
+  void run() override;
+
+ private:
+  friend class UdpHubEndpoint;
+
+  // 主线程调用：注册 / 注销一个已绑定的套接字；注销返回后接收线程不会再访问该端点
+  bool addEndpoint(UdpHubEndpoint *endpoint, QString *error);
+  void removeEndpoint(UdpHubEndpoint *endpoint);
+  void wake();
+
+  QMutex mutex_;  // 保护 endpoints_；接收线程处理一批就绪事件期间持有
+  std::vector<UdpHubEndpoint *> endpoints_;
+  int epollFd_;
+  int wakeFd_;
+  std::atomic<bool> stopRequested_;
+  std::atomic<int> endpointCount_;
+};
+
+// 注册在 UdpReceiverHub 上的一路 UDP 接收：用法与 UdpReceiverThread 相同，但不启动自己的线程
+// （SpectrumFrameSource 的线程接口不使用，帧在共享接收线程中分发）
+class UdpHubEndpoint : public SpectrumFrameSource {
+  Q_OBJECT
+
+ public:
+  explicit UdpHubEndpoint(UdpReceiverHub *hub, QObject *parent = nullptr);
+  ~UdpHubEndpoint() override;
+
+  bool startReceiving(int port, const QString &bindAddress = QString(), int batchSize = 32,
+                      bool kernelTimestamps = false);
+  void stopReceiving();
+  void stopSource() override { stopReceiving(); }
+
+  // 数据包末尾是否附带 16 位大端帧计数（在 startReceiving 之前设置）
+  void setFrameCounterTrailer(bool enabled) { frameCounterTrailer_ = enabled; }
+
+  const LinkStats *linkStats() const override { return &linkStats_; }
+
+ protected:
+  void run() override {}
+
+ private:
+  friend class UdpReceiverHub;
+
+  // 接收线程调用：接收并分发一批数据包；套接字出错时返回 false（由接收线程注销，再在端点所在线程停止）
+  bool receiveReady();
+
+  UdpReceiverHub *hub_;
+  int socketFd_;
+  int port_;
+  bool frameCounterTrailer_;
+  bool registered_;
+  LinkStats linkStats_;
+  std::unique_ptr<UdpBatchReader> reader_;  // 仅接收线程访问
+  std::vector<SpectrumFramePtr> batch_;
+};